@@ -34,6 +34,10 @@ option(
 option(WITH_LOGGING_TIMING_DATA
        "Build with logging all Add and Erase Segment calls." OFF)
 
+# Turn this option on to count heap allocations per frame in --benchmark runs.
+option(WITH_ALLOCATION_COUNTS
+       "Build with a counting operator new for the gameplay benchmark." OFF)
+
 if(NOT MSVC)
   # Change this number to utilize a different number of jobs for building
   # FFMPEG.
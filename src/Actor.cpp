@@ -2,6 +2,7 @@
 #include "Actor.h"
 #include "ActorFrame.h"
 #include "RageDisplay.h"
+#include "RageProfiler.h"
 #include "RageUtil.h"
 #include "RageMath.h"
 #include "RageLog.h"
@@ -1352,6 +1353,7 @@ void Actor::RunCommands( const LuaReference& cmds, const LuaReference *pParamTab
 		return;
 	}
 
+	ProfileScope scope( ProfilePhase_Lua, m_sName.c_str() );
 	Lua *L = LUA->Get();
 
 	// function
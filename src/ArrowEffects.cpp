@@ -16,6 +16,7 @@
 #include <cfloat>
 #include <cmath>
 #include <cstddef>
+#include <initializer_list>
 #include <vector>
 
 
@@ -85,7 +86,20 @@ static ThemeMetric<float>	TINY_PERCENT_GATE( "ArrowEffects", "TinyPercentGate" )
 
 static const PlayerOptions* curr_options= nullptr;
 
-float ArrowGetPercentVisible(float fYPosWithoutReverse, int iCol, float fYOffset);
+// Which groups of mods are on in curr_options.  SetCurrentOptions works this
+// out once, so the batched functions can skip a whole group for a column with
+// one test, instead of checking every mod in it for every note.
+enum
+{
+	ACTIVE_ACCELS= 1<<0, // anything GetYOffset does past the scroll speed
+	ACTIVE_Y_EFFECTS= 1<<1,
+	ACTIVE_X_EFFECTS= 1<<2,
+	ACTIVE_Z_EFFECTS= 1<<3,
+	ACTIVE_ROTATION= 1<<4,
+	ACTIVE_APPEARANCE= 1<<5,
+	ACTIVE_ZOOM= 1<<6
+};
+static unsigned curr_active_mods= 0;
 
 static float GetNoteFieldHeight()
 {
@@ -152,10 +166,13 @@ static float SelectTanType(float angle, bool is_cosec)
 	    return RageFastTan(angle);
 }
 
-static float CalculateTornadoOffsetFromMagnitude(int dimension, int col_id,
+// Add the tornado offset for each y offset to out.  The column's place in
+// the tornado doesn't depend on the note, so it's only worked out once.
+static void AddTornadoOffsets(int dimension, int col_id,
 	float magnitude, float effect_offset, float period,
 	const Style::ColumnInfo* pCols, float field_zoom,
-	PerPlayerData& data, float y_offset, bool is_tan)
+	PerPlayerData& data, const float* y_offsets, int count, float* out,
+	bool is_tan)
 {
 	float const real_pixel_offset= pCols[col_id].fXOffset * field_zoom;
 	float const position_between= SCALE(real_pixel_offset,
@@ -163,25 +180,43 @@ static float CalculateTornadoOffsetFromMagnitude(int dimension, int col_id,
 		data.m_MaxTornado[dimension][col_id] * field_zoom,
 		tornado_position_scale_to_low[dimension],
 		tornado_position_scale_to_high[dimension]);
-	float rads= std::acos(position_between);
-	float frequency= tornado_offset_frequency[dimension];
-	rads+= (y_offset + effect_offset) * ((period * frequency) + frequency) / SCREEN_HEIGHT;
-	float processed_rads = is_tan ? SelectTanType(rads, curr_options->m_bCosecant) : RageFastCos(rads);
-
-	float const adjusted_pixel_offset= SCALE(processed_rads,
-		tornado_offset_scale_from_low[dimension],
-		tornado_offset_scale_from_high[dimension],
-		data.m_MinTornado[dimension][col_id] * field_zoom,
-		data.m_MaxTornado[dimension][col_id] * field_zoom);
-	return (adjusted_pixel_offset - real_pixel_offset) * magnitude;
+	float const base_rads= std::acos(position_between);
+	float const frequency= tornado_offset_frequency[dimension];
+	float const rads_per_pixel= (period * frequency) + frequency;
+	float const screen_height= SCREEN_HEIGHT;
+	float const min_offset= data.m_MinTornado[dimension][col_id] * field_zoom;
+	float const max_offset= data.m_MaxTornado[dimension][col_id] * field_zoom;
+	for(int i= 0; i < count; ++i)
+	{
+		float rads= base_rads;
+		rads+= (y_offsets[i] + effect_offset) * rads_per_pixel / screen_height;
+		float processed_rads = is_tan ? SelectTanType(rads, curr_options->m_bCosecant) : RageFastCos(rads);
+
+		float const adjusted_pixel_offset= SCALE(processed_rads,
+			tornado_offset_scale_from_low[dimension],
+			tornado_offset_scale_from_high[dimension],
+			min_offset, max_offset);
+		out[i]+= (adjusted_pixel_offset - real_pixel_offset) * magnitude;
+	}
 }
 
-static float CalculateDrunkAngle(float speed, int col, float offset,
-	float col_frequency, float y_offset, float period, float offset_frequency)
+// Add the drunk offset for each y offset to out.  The part of the angle that
+// comes from the time and the column is the same for every note.
+static void AddDrunkOffsets(float magnitude, float speed, int col,
+	float offset, float col_frequency, float period, float offset_frequency,
+	float arrow_magnitude, const float* y_offsets, int count, float* out,
+	bool is_tan)
 {
-	float time = ArrowEffects::GetTime();
-	return time * (1+speed) + col*( (offset*col_frequency) + col_frequency)
-		+ y_offset * ( (period*offset_frequency) + offset_frequency) / SCREEN_HEIGHT;
+	float const time= ArrowEffects::GetTime();
+	float const base_angle= time * (1+speed) + col*( (offset*col_frequency) + col_frequency);
+	float const angle_per_pixel= (period*offset_frequency) + offset_frequency;
+	float const screen_height= SCREEN_HEIGHT;
+	for(int i= 0; i < count; ++i)
+	{
+		float const angle= base_angle + y_offsets[i] * angle_per_pixel / screen_height;
+		float const wave= is_tan ? SelectTanType(angle, curr_options->m_bCosecant) : RageFastCos(angle);
+		out[i]+= magnitude * ( wave * ARROW_SIZE*arrow_magnitude );
+	}
 }
 
 static float CalculateBumpyAngle(float y_offset, float offset, float period)
@@ -429,81 +464,170 @@ void ArrowEffects::Update()
 	fLastTime = fTime;
 }
 
-void ArrowEffects::SetCurrentOptions(const PlayerOptions* options)
+static bool AnyNonZero(const float* values, std::initializer_list<int> indices)
 {
-	curr_options= options;
+	for(int i : indices)
+	{
+		if(values[i] != 0)
+		{
+			return true;
+		}
+	}
+	return false;
 }
 
-static float GetDisplayedBeat( const PlayerState* pPlayerState, float beat )
+static bool AnyColumnNonZero(const float (&values)[MAX_COLS_PER_PLAYER])
 {
-	// do a binary search here
-	const std::vector<CacheDisplayedBeat> &data = pPlayerState->m_CacheDisplayedBeat;
-	int max = data.size() - 1;
-	int l = 0, r = max;
-	while( l <= r )
-	{
-		int m = ( l + r ) / 2;
-		if( ( m == 0 || data[m].beat <= beat ) && ( m == max || beat < data[m + 1].beat ) )
-		{
-			return data[m].displayedBeat + data[m].velocity * (beat - data[m].beat);
-		}
-		else if( data[m].beat <= beat )
-		{
-			l = m + 1;
-		}
-		else
+	for(int col= 0; col < MAX_COLS_PER_PLAYER; ++col)
+	{
+		if(values[col] != 0)
 		{
-			r = m - 1;
+			return true;
 		}
 	}
-	return beat;
+	return false;
+}
+
+void ArrowEffects::SetCurrentOptions(const PlayerOptions* options)
+{
+	curr_options= options;
+	curr_active_mods= 0;
+	if(options == nullptr)
+	{
+		return;
+	}
+
+	const float* accels= options->m_fAccels;
+	const float* effects= options->m_fEffects;
+	const float* appearances= options->m_fAppearances;
+	if(AnyNonZero(accels, {PlayerOptions::ACCEL_BOOST, PlayerOptions::ACCEL_BRAKE,
+		PlayerOptions::ACCEL_WAVE, PlayerOptions::ACCEL_BOOMERANG,
+		PlayerOptions::ACCEL_EXPAND, PlayerOptions::ACCEL_TAN_EXPAND}) ||
+		effects[PlayerOptions::EFFECT_PARABOLA_Y] != 0)
+	{
+		curr_active_mods|= ACTIVE_ACCELS;
+	}
+	if(AnyNonZero(effects, {PlayerOptions::EFFECT_TIPSY, PlayerOptions::EFFECT_TAN_TIPSY,
+		PlayerOptions::EFFECT_ATTENUATE_Y, PlayerOptions::EFFECT_BEAT_Y}))
+	{
+		curr_active_mods|= ACTIVE_Y_EFFECTS;
+	}
+	if(AnyNonZero(effects, {PlayerOptions::EFFECT_TORNADO, PlayerOptions::EFFECT_TAN_TORNADO,
+		PlayerOptions::EFFECT_BUMPY_X, PlayerOptions::EFFECT_TAN_BUMPY_X,
+		PlayerOptions::EFFECT_DRUNK, PlayerOptions::EFFECT_TAN_DRUNK,
+		PlayerOptions::EFFECT_FLIP, PlayerOptions::EFFECT_INVERT,
+		PlayerOptions::EFFECT_BEAT, PlayerOptions::EFFECT_ZIGZAG,
+		PlayerOptions::EFFECT_SAWTOOTH, PlayerOptions::EFFECT_PARABOLA_X,
+		PlayerOptions::EFFECT_ATTENUATE_X, PlayerOptions::EFFECT_DIGITAL,
+		PlayerOptions::EFFECT_TAN_DIGITAL, PlayerOptions::EFFECT_SQUARE,
+		PlayerOptions::EFFECT_BOUNCE, PlayerOptions::EFFECT_XMODE,
+		PlayerOptions::EFFECT_TINY}))
+	{
+		curr_active_mods|= ACTIVE_X_EFFECTS;
+	}
+	if(AnyNonZero(effects, {PlayerOptions::EFFECT_TORNADO_Z, PlayerOptions::EFFECT_TAN_TORNADO_Z,
+		PlayerOptions::EFFECT_BUMPY, PlayerOptions::EFFECT_TAN_BUMPY,
+		PlayerOptions::EFFECT_ZIGZAG_Z, PlayerOptions::EFFECT_SAWTOOTH_Z,
+		PlayerOptions::EFFECT_PARABOLA_Z, PlayerOptions::EFFECT_ATTENUATE_Z,
+		PlayerOptions::EFFECT_DRUNK_Z, PlayerOptions::EFFECT_TAN_DRUNK_Z,
+		PlayerOptions::EFFECT_BEAT_Z, PlayerOptions::EFFECT_DIGITAL_Z,
+		PlayerOptions::EFFECT_TAN_DIGITAL_Z, PlayerOptions::EFFECT_SQUARE_Z,
+		PlayerOptions::EFFECT_BOUNCE_Z}) ||
+		AnyColumnNonZero(options->m_fBumpy))
+	{
+		curr_active_mods|= ACTIVE_Z_EFFECTS;
+	}
+	if(AnyNonZero(effects, {PlayerOptions::EFFECT_CONFUSION, PlayerOptions::EFFECT_CONFUSION_OFFSET,
+		PlayerOptions::EFFECT_CONFUSION_X, PlayerOptions::EFFECT_CONFUSION_X_OFFSET,
+		PlayerOptions::EFFECT_CONFUSION_Y, PlayerOptions::EFFECT_CONFUSION_Y_OFFSET,
+		PlayerOptions::EFFECT_ROLL, PlayerOptions::EFFECT_TWIRL,
+		PlayerOptions::EFFECT_DIZZY}) ||
+		AnyColumnNonZero(options->m_fConfusionX) ||
+		AnyColumnNonZero(options->m_fConfusionY) ||
+		AnyColumnNonZero(options->m_fConfusionZ))
+	{
+		curr_active_mods|= ACTIVE_ROTATION;
+	}
+	if(AnyNonZero(appearances, {PlayerOptions::APPEARANCE_HIDDEN, PlayerOptions::APPEARANCE_SUDDEN,
+		PlayerOptions::APPEARANCE_STEALTH, PlayerOptions::APPEARANCE_BLINK,
+		PlayerOptions::APPEARANCE_RANDOMVANISH}) ||
+		AnyColumnNonZero(options->m_fStealth))
+	{
+		curr_active_mods|= ACTIVE_APPEARANCE;
+	}
+	if(AnyNonZero(effects, {PlayerOptions::EFFECT_PULSE_INNER, PlayerOptions::EFFECT_PULSE_OUTER,
+		PlayerOptions::EFFECT_SHRINK_TO_MULT, PlayerOptions::EFFECT_SHRINK_TO_LINEAR,
+		PlayerOptions::EFFECT_TINY}) ||
+		AnyColumnNonZero(options->m_fTiny))
+	{
+		curr_active_mods|= ACTIVE_ZOOM;
+	}
 }
 
-/* For visibility testing: if bAbsolute is false, random modifiers must return
- * the minimum possible scroll speed. */
 float ArrowEffects::GetYOffset( const PlayerState* pPlayerState, int iCol, float fNoteBeat, float &fPeakYOffsetOut, bool &bIsPastPeakOut, bool bAbsolute )
 {
-	// Default values that are returned if boomerang is off.
-	fPeakYOffsetOut = FLT_MAX;
-	bIsPastPeakOut = true;
+	float fYOffset;
+	GetYOffsets( pPlayerState, iCol, &fNoteBeat, 1, &fYOffset, &fPeakYOffsetOut, &bIsPastPeakOut, bAbsolute );
+	return fYOffset;
+}
 
-	float fYOffset = 0;
+/* For visibility testing: if bAbsolute is false, random modifiers must return
+ * the minimum possible scroll speed. */
+void ArrowEffects::GetYOffsets( const PlayerState* pPlayerState, int iCol, const float *pNoteBeats, int iCount, float *pYOffsetsOut, float *pPeakYOffsetsOut, bool *pIsPastPeakOut, bool bAbsolute )
+{
 	const SongPosition &position = pPlayerState->GetDisplayedPosition();
 
 	float fSongBeat = position.m_fSongBeatVisible;
 
 	Steps *pCurSteps = GAMESTATE->m_pCurSteps[pPlayerState->m_PlayerNumber];
 
+	for( int i = 0; i < iCount; ++i )
+		pYOffsetsOut[i] = 0;
+
 	/* Usually, fTimeSpacing is 0 or 1, in which case we use entirely beat spacing or
 	 * entirely time spacing (respectively). Occasionally, we tween between them. */
 	if( curr_options->m_fTimeSpacing != 1.0f )
 	{
 		if( GAMESTATE->m_bInStepEditor ) {
 			// Use constant spacing in step editor
-			fYOffset = fNoteBeat - fSongBeat;
+			for( int i = 0; i < iCount; ++i )
+				pYOffsetsOut[i] = pNoteBeats[i] - fSongBeat;
 		} else {
-			fYOffset = GetDisplayedBeat(pPlayerState, fNoteBeat) - GetDisplayedBeat(pPlayerState, fSongBeat);
-			fYOffset *= pCurSteps->GetTimingData()->GetDisplayedSpeedPercent(
+			const TimingData &timing = pPlayerState->GetDisplayedTiming();
+			const float fDisplayedSongBeat = timing.GetDisplayedBeat( fSongBeat );
+			const float fSpeedPercent = pCurSteps->GetTimingData()->GetDisplayedSpeedPercent(
 								     position.m_fSongBeatVisible,
 								     position.m_fMusicSecondsVisible );
+			timing.GetDisplayedBeats( pNoteBeats, iCount, pYOffsetsOut );
+			for( int i = 0; i < iCount; ++i )
+			{
+				pYOffsetsOut[i] -= fDisplayedSongBeat;
+				pYOffsetsOut[i] *= fSpeedPercent;
+			}
 		}
-		fYOffset *= 1 - curr_options->m_fTimeSpacing;
+		const float fBeatSpacing = 1 - curr_options->m_fTimeSpacing;
+		for( int i = 0; i < iCount; ++i )
+			pYOffsetsOut[i] *= fBeatSpacing;
 	}
 
 	if( curr_options->m_fTimeSpacing != 0.0f )
 	{
+		const TimingData *pTiming = pCurSteps->GetTimingData();
 		float fSongSeconds = pPlayerState->m_Position.m_fMusicSecondsVisible;
-		float fNoteSeconds = pCurSteps->GetTimingData()->GetElapsedTimeFromBeat(fNoteBeat);
-		float fSecondsUntilStep = fNoteSeconds - fSongSeconds;
 		float fBPM = curr_options->m_fScrollBPM;
 		float fBPS = fBPM/60.f / GAMESTATE->m_SongOptions.GetCurrent().m_fMusicRate;
-		float fYOffsetTimeSpacing = fSecondsUntilStep * fBPS;
-		fYOffset += fYOffsetTimeSpacing * curr_options->m_fTimeSpacing;
+		for( int i = 0; i < iCount; ++i )
+		{
+			float fNoteSeconds = pTiming->GetElapsedTimeFromBeat(pNoteBeats[i]);
+			float fSecondsUntilStep = fNoteSeconds - fSongSeconds;
+			float fYOffsetTimeSpacing = fSecondsUntilStep * fBPS;
+			pYOffsetsOut[i] += fYOffsetTimeSpacing * curr_options->m_fTimeSpacing;
+		}
 	}
 
 	// TODO: If we allow noteskins to have metricable row spacing
 	// (per issue 24), edit this to reflect that. -aj
-	fYOffset *= ARROW_SPACING;
+	const float fArrowSpacing = ARROW_SPACING;
 
 	// Factor in scroll speed
 	float fScrollSpeed = curr_options->m_fScrollSpeed;
@@ -513,10 +637,21 @@ float ArrowEffects::GetYOffset( const PlayerState* pPlayerState, int iCol, float
 			(pPlayerState->m_fReadBPM * GAMESTATE->m_SongOptions.GetCurrent().m_fMusicRate);
 	}
 
-	// don't mess with the arrows after they've crossed 0
-	if( fYOffset < 0 )
+	const bool bRandomSpeed = curr_options->m_fRandomSpeed > 0 && !bAbsolute;
+	if( !(curr_active_mods & ACTIVE_ACCELS) && !bRandomSpeed )
 	{
-		return fYOffset * fScrollSpeed;
+		// Nothing depends on how far away the note is, which is the usual case.
+		for( int i = 0; i < iCount; ++i )
+		{
+			const float fYOffset = pYOffsetsOut[i] * fArrowSpacing;
+			pYOffsetsOut[i] = fYOffset * fScrollSpeed;
+			// Boomerang is off, so there's no peak.
+			if( pPeakYOffsetsOut != nullptr )
+				pPeakYOffsetsOut[i] = fYOffset < 0 ? FLT_MAX : FLT_MAX * fScrollSpeed;
+			if( pIsPastPeakOut != nullptr )
+				pIsPastPeakOut[i] = true;
+		}
+		return;
 	}
 
 	const float* fAccels = curr_options->m_fAccels;
@@ -525,86 +660,120 @@ float ArrowEffects::GetYOffset( const PlayerState* pPlayerState, int iCol, float
 	// TODO: Don't index by PlayerNumber.
 	PerPlayerData &data = g_EffectData[pPlayerState->m_PlayerNumber];
 
-	float fYAdjust = 0;	// fill this in depending on PlayerOptions
-
-	if( fAccels[PlayerOptions::ACCEL_BOOST] != 0 )
-	{
-		float fEffectHeight = GetNoteFieldHeight();
-		float fNewYOffset = fYOffset * 1.5f / ((fYOffset+fEffectHeight/1.2f)/fEffectHeight);
-		float fAccelYAdjust =	fAccels[PlayerOptions::ACCEL_BOOST] * (fNewYOffset - fYOffset);
-		// TRICKY: Clamp this value, or else BOOST+BOOMERANG will draw a ton of arrows on the screen.
-		CLAMP( fAccelYAdjust, BOOST_MOD_MIN_CLAMP, BOOST_MOD_MAX_CLAMP );
-		fYAdjust += fAccelYAdjust;
-	}
-	if( fAccels[PlayerOptions::ACCEL_BRAKE] != 0 )
-	{
-		float fEffectHeight = GetNoteFieldHeight();
-		float fScale = SCALE( fYOffset, 0.f, fEffectHeight, 0, 1.f );
-		float fNewYOffset = fYOffset * fScale;
-		float fBrakeYAdjust = fAccels[PlayerOptions::ACCEL_BRAKE] * (fNewYOffset - fYOffset);
-		// TRICKY: Clamp this value the same way as BOOST so that in BOOST+BRAKE, BRAKE doesn't overpower BOOST
-		CLAMP( fBrakeYAdjust, BRAKE_MOD_MIN_CLAMP, BRAKE_MOD_MAX_CLAMP );
-		fYAdjust += fBrakeYAdjust;
-	}
-	if( fAccels[PlayerOptions::ACCEL_WAVE] != 0 )
-		fYAdjust +=	fAccels[PlayerOptions::ACCEL_WAVE] * WAVE_MOD_MAGNITUDE *RageFastSin( fYOffset/((fAccels[PlayerOptions::ACCEL_WAVE_PERIOD]*WAVE_MOD_HEIGHT)+WAVE_MOD_HEIGHT) );
-
-	if( fEffects[PlayerOptions::EFFECT_PARABOLA_Y] != 0 )
-		fYAdjust += fEffects[PlayerOptions::EFFECT_PARABOLA_Y] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE);
-
-	fYOffset += fYAdjust;
-
-	// Factor in boomerang
-	if( fAccels[PlayerOptions::ACCEL_BOOMERANG] != 0 )
-	{
-		float fPeakAtYOffset = SCREEN_HEIGHT * BOOMERANG_PEAK_PERCENTAGE;	// zero point of boomerang function
-		fPeakYOffsetOut = (-1*fPeakAtYOffset*fPeakAtYOffset/SCREEN_HEIGHT) + 1.5f*fPeakAtYOffset;
-		bIsPastPeakOut = fYOffset < fPeakAtYOffset;
-
-		fYOffset = (-1*fYOffset*fYOffset/SCREEN_HEIGHT) + 1.5f*fYOffset;
-	}
-
-	if( curr_options->m_fRandomSpeed > 0 && !bAbsolute )
-	{
-		// Generate a deterministically "random" speed for each arrow.
-		unsigned seed = GAMESTATE->m_iStageSeed + ( BeatToNoteRow( fNoteBeat ) << 8 ) + (iCol * 100);
-
-		for( int i = 0; i < 3; ++i )
-			seed = ((seed * 1664525u) + 1013904223u) & 0xFFFFFFFF;
-		float fRandom = seed / 4294967296.0f;
-
-		/* Random speed always increases speed: a random speed of 10 indicates
-		 * [1,11]. This keeps it consistent with other mods: 0 means no effect. */
-		fScrollSpeed *=
-				SCALE( fRandom,
-						0.0f, 1.0f,
-						1.0f, curr_options->m_fRandomSpeed + 1.0f );
-	}
+	// Everything below that doesn't depend on the note.
+	const float fEffectHeight = GetNoteFieldHeight();
+	const float fWaveMagnitude = fAccels[PlayerOptions::ACCEL_WAVE] * WAVE_MOD_MAGNITUDE;
+	const float fWaveHeight = (fAccels[PlayerOptions::ACCEL_WAVE_PERIOD]*WAVE_MOD_HEIGHT)+WAVE_MOD_HEIGHT;
+	const float fBoostMin = BOOST_MOD_MIN_CLAMP, fBoostMax = BOOST_MOD_MAX_CLAMP;
+	const float fBrakeMin = BRAKE_MOD_MIN_CLAMP, fBrakeMax = BRAKE_MOD_MAX_CLAMP;
+	const float fPeakAtYOffset = SCREEN_HEIGHT * BOOMERANG_PEAK_PERCENTAGE;	// zero point of boomerang function
 
+	float fExpandSpeed = 1;
 	if( fAccels[PlayerOptions::ACCEL_EXPAND] != 0 )
 	{
 		float fExpandMultiplier = SCALE( RageFastCos(data.m_fExpandSeconds*EXPAND_MULTIPLIER_FREQUENCY*(fAccels[PlayerOptions::ACCEL_EXPAND_PERIOD]+1)),
 						EXPAND_MULTIPLIER_SCALE_FROM_LOW, EXPAND_MULTIPLIER_SCALE_FROM_HIGH,
 						EXPAND_MULTIPLIER_SCALE_TO_LOW, EXPAND_MULTIPLIER_SCALE_TO_HIGH );
-		fScrollSpeed *=	SCALE( fAccels[PlayerOptions::ACCEL_EXPAND],
+		fExpandSpeed = SCALE( fAccels[PlayerOptions::ACCEL_EXPAND],
 				      EXPAND_SPEED_SCALE_FROM_LOW, EXPAND_SPEED_SCALE_FROM_HIGH,
 				      EXPAND_SPEED_SCALE_TO_LOW, fExpandMultiplier );
 	}
 
+	float fTanExpandSpeed = 1;
 	if( fAccels[PlayerOptions::ACCEL_TAN_EXPAND] != 0 )
 	{
 		float fTanExpandMultiplier = SCALE( SelectTanType(data.m_fTanExpandSeconds*EXPAND_MULTIPLIER_FREQUENCY*(fAccels[PlayerOptions::ACCEL_TAN_EXPAND_PERIOD]+1), curr_options->m_bCosecant),
 						EXPAND_MULTIPLIER_SCALE_FROM_LOW, EXPAND_MULTIPLIER_SCALE_FROM_HIGH,
 						EXPAND_MULTIPLIER_SCALE_TO_LOW, EXPAND_MULTIPLIER_SCALE_TO_HIGH );
-		fScrollSpeed *=	SCALE( fAccels[PlayerOptions::ACCEL_TAN_EXPAND],
+		fTanExpandSpeed = SCALE( fAccels[PlayerOptions::ACCEL_TAN_EXPAND],
 				      EXPAND_SPEED_SCALE_FROM_LOW, EXPAND_SPEED_SCALE_FROM_HIGH,
 				      EXPAND_SPEED_SCALE_TO_LOW, fTanExpandMultiplier );
 	}
 
-	fYOffset *= fScrollSpeed;
-	fPeakYOffsetOut *= fScrollSpeed;
+	for( int i = 0; i < iCount; ++i )
+	{
+		// Default values that are returned if boomerang is off.
+		float fPeakYOffset = FLT_MAX;
+		bool bIsPastPeak = true;
 
-	return fYOffset;
+		float fYOffset = pYOffsetsOut[i] * fArrowSpacing;
+
+		// don't mess with the arrows after they've crossed 0
+		if( fYOffset < 0 )
+		{
+			pYOffsetsOut[i] = fYOffset * fScrollSpeed;
+			if( pPeakYOffsetsOut != nullptr )
+				pPeakYOffsetsOut[i] = fPeakYOffset;
+			if( pIsPastPeakOut != nullptr )
+				pIsPastPeakOut[i] = bIsPastPeak;
+			continue;
+		}
+
+		float fYAdjust = 0;	// fill this in depending on PlayerOptions
+
+		if( fAccels[PlayerOptions::ACCEL_BOOST] != 0 )
+		{
+			float fNewYOffset = fYOffset * 1.5f / ((fYOffset+fEffectHeight/1.2f)/fEffectHeight);
+			float fAccelYAdjust =	fAccels[PlayerOptions::ACCEL_BOOST] * (fNewYOffset - fYOffset);
+			// TRICKY: Clamp this value, or else BOOST+BOOMERANG will draw a ton of arrows on the screen.
+			CLAMP( fAccelYAdjust, fBoostMin, fBoostMax );
+			fYAdjust += fAccelYAdjust;
+		}
+		if( fAccels[PlayerOptions::ACCEL_BRAKE] != 0 )
+		{
+			float fScale = SCALE( fYOffset, 0.f, fEffectHeight, 0, 1.f );
+			float fNewYOffset = fYOffset * fScale;
+			float fBrakeYAdjust = fAccels[PlayerOptions::ACCEL_BRAKE] * (fNewYOffset - fYOffset);
+			// TRICKY: Clamp this value the same way as BOOST so that in BOOST+BRAKE, BRAKE doesn't overpower BOOST
+			CLAMP( fBrakeYAdjust, fBrakeMin, fBrakeMax );
+			fYAdjust += fBrakeYAdjust;
+		}
+		if( fAccels[PlayerOptions::ACCEL_WAVE] != 0 )
+			fYAdjust +=	fWaveMagnitude *RageFastSin( fYOffset/fWaveHeight );
+
+		if( fEffects[PlayerOptions::EFFECT_PARABOLA_Y] != 0 )
+			fYAdjust += fEffects[PlayerOptions::EFFECT_PARABOLA_Y] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE);
+
+		fYOffset += fYAdjust;
+
+		// Factor in boomerang
+		if( fAccels[PlayerOptions::ACCEL_BOOMERANG] != 0 )
+		{
+			fPeakYOffset = (-1*fPeakAtYOffset*fPeakAtYOffset/SCREEN_HEIGHT) + 1.5f*fPeakAtYOffset;
+			bIsPastPeak = fYOffset < fPeakAtYOffset;
+
+			fYOffset = (-1*fYOffset*fYOffset/SCREEN_HEIGHT) + 1.5f*fYOffset;
+		}
+
+		float fNoteScrollSpeed = fScrollSpeed;
+		if( bRandomSpeed )
+		{
+			// Generate a deterministically "random" speed for each arrow.
+			unsigned seed = GAMESTATE->m_iStageSeed + ( BeatToNoteRow( pNoteBeats[i] ) << 8 ) + (iCol * 100);
+
+			for( int j = 0; j < 3; ++j )
+				seed = ((seed * 1664525u) + 1013904223u) & 0xFFFFFFFF;
+			float fRandom = seed / 4294967296.0f;
+
+			/* Random speed always increases speed: a random speed of 10 indicates
+			 * [1,11]. This keeps it consistent with other mods: 0 means no effect. */
+			fNoteScrollSpeed *=
+					SCALE( fRandom,
+							0.0f, 1.0f,
+							1.0f, curr_options->m_fRandomSpeed + 1.0f );
+		}
+
+		if( fAccels[PlayerOptions::ACCEL_EXPAND] != 0 )
+			fNoteScrollSpeed *= fExpandSpeed;
+		if( fAccels[PlayerOptions::ACCEL_TAN_EXPAND] != 0 )
+			fNoteScrollSpeed *= fTanExpandSpeed;
+
+		pYOffsetsOut[i] = fYOffset * fNoteScrollSpeed;
+		if( pPeakYOffsetsOut != nullptr )
+			pPeakYOffsetsOut[i] = fPeakYOffset * fNoteScrollSpeed;
+		if( pIsPastPeakOut != nullptr )
+			pIsPastPeakOut[i] = bIsPastPeak;
+	}
 }
 
 static void ArrowGetReverseShiftAndScale(int iCol, float fYReverseOffsetPixels, float &fShiftOut, float &fScaleOut)
@@ -627,47 +796,77 @@ static void ArrowGetReverseShiftAndScale(int iCol, float fYReverseOffsetPixels,
 
 float ArrowEffects::GetYPos( const PlayerState* pPlayerState, int iCol, float fYOffset, float fYReverseOffsetPixels, bool WithReverse)
 {
-	float f = fYOffset;
+	float fYPos;
+	GetYPositions( pPlayerState, iCol, &fYOffset, 1, &fYPos, fYReverseOffsetPixels, WithReverse );
+	return fYPos;
+}
 
+void ArrowEffects::GetYPositions( const PlayerState* pPlayerState, int iCol, const float *pYOffsets, int iCount, float *pYPosOut, float fYReverseOffsetPixels, bool WithReverse )
+{
 	if( WithReverse )
 	{
 		float fShift, fScale;
 		ArrowGetReverseShiftAndScale(iCol, fYReverseOffsetPixels, fShift, fScale);
 
-		f *= fScale;
-		f += fShift;
+		for( int i = 0; i < iCount; ++i )
+		{
+			pYPosOut[i] = pYOffsets[i] * fScale;
+			pYPosOut[i] += fShift;
+		}
 	}
-
-	// TODO: Don't index by PlayerNumber.
-	const Style* pStyle = GAMESTATE->GetCurrentStyle(pPlayerState->m_PlayerNumber);
-	const Style::ColumnInfo* pCols = pStyle->m_ColumnInfo[pPlayerState->m_PlayerNumber];
-	const float* fEffects = curr_options->m_fEffects;
-
-	// Doing the math with a precalculated result of 0 should be faster than
-	// checking whether tipsy is on. -Kyz
-	// TODO: Don't index by PlayerNumber.
-	PerPlayerData& data= g_EffectData[curr_options->m_pn];
-	f+= fEffects[PlayerOptions::EFFECT_TIPSY] * data.m_tipsy_result[iCol];
-	f+= fEffects[PlayerOptions::EFFECT_TAN_TIPSY] * data.m_tan_tipsy_result[iCol];
-
-	if( fEffects[PlayerOptions::EFFECT_ATTENUATE_Y] != 0 )
+	else
 	{
-		const float fXOffset = pCols[iCol].fXOffset;
-		f += fEffects[PlayerOptions::EFFECT_ATTENUATE_Y] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE) * (fXOffset/ARROW_SIZE);
+		for( int i = 0; i < iCount; ++i )
+			pYPosOut[i] = pYOffsets[i];
 	}
 
-
-	if( fEffects[PlayerOptions::EFFECT_BEAT_Y] != 0 )
+	if( curr_active_mods & ACTIVE_Y_EFFECTS )
 	{
-		const float fShift = data.m_fBeatFactor[dim_y]*RageFastSin( fYOffset / ((fEffects[PlayerOptions::EFFECT_BEAT_Y_PERIOD]*BEAT_Y_OFFSET_HEIGHT)+BEAT_Y_OFFSET_HEIGHT) + PI/BEAT_Y_PI_HEIGHT );
-		f += fEffects[PlayerOptions::EFFECT_BEAT_Y] * fShift;
+		// TODO: Don't index by PlayerNumber.
+		const Style* pStyle = GAMESTATE->GetCurrentStyle(pPlayerState->m_PlayerNumber);
+		const Style::ColumnInfo* pCols = pStyle->m_ColumnInfo[pPlayerState->m_PlayerNumber];
+		const float* fEffects = curr_options->m_fEffects;
+
+		// Doing the math with a precalculated result of 0 should be faster than
+		// checking whether tipsy is on. -Kyz
+		// TODO: Don't index by PlayerNumber.
+		PerPlayerData& data= g_EffectData[curr_options->m_pn];
+		const float fTipsy = fEffects[PlayerOptions::EFFECT_TIPSY] * data.m_tipsy_result[iCol];
+		const float fTanTipsy = fEffects[PlayerOptions::EFFECT_TAN_TIPSY] * data.m_tan_tipsy_result[iCol];
+		for( int i = 0; i < iCount; ++i )
+		{
+			pYPosOut[i] += fTipsy;
+			pYPosOut[i] += fTanTipsy;
+		}
+
+		if( fEffects[PlayerOptions::EFFECT_ATTENUATE_Y] != 0 )
+		{
+			const float fXOffset = pCols[iCol].fXOffset;
+			for( int i = 0; i < iCount; ++i )
+				pYPosOut[i] += fEffects[PlayerOptions::EFFECT_ATTENUATE_Y] * (pYOffsets[i]/ARROW_SIZE) * (pYOffsets[i]/ARROW_SIZE) * (fXOffset/ARROW_SIZE);
+		}
+
+		if( fEffects[PlayerOptions::EFFECT_BEAT_Y] != 0 )
+		{
+			const float fHeight = (fEffects[PlayerOptions::EFFECT_BEAT_Y_PERIOD]*BEAT_Y_OFFSET_HEIGHT)+BEAT_Y_OFFSET_HEIGHT;
+			const float fPhase = PI/BEAT_Y_PI_HEIGHT;
+			for( int i = 0; i < iCount; ++i )
+			{
+				const float fShift = data.m_fBeatFactor[dim_y]*RageFastSin( pYOffsets[i] / fHeight + fPhase );
+				pYPosOut[i] += fEffects[PlayerOptions::EFFECT_BEAT_Y] * fShift;
+			}
+		}
 	}
 
 	// In beware's DDR Extreme-focused fork of StepMania 3.9, this value is
 	// floored, making arrows show on integer Y coordinates. Supposedly it makes
 	// the arrows look better, but testing needs to be done.
 	// todo: make this a noteskin metric instead of a theme metric? -aj
-	return QUANTIZE_ARROW_Y ? std::floor(f) : f;
+	if( QUANTIZE_ARROW_Y )
+	{
+		for( int i = 0; i < iCount; ++i )
+			pYPosOut[i] = std::floor(pYPosOut[i]);
+	}
 }
 
 float ArrowEffects::GetYOffsetFromYPos(int iCol, float YPos, float fYReverseOffsetPixels)
@@ -696,59 +895,83 @@ float ArrowEffects::GetYOffsetFromYPos(int iCol, float YPos, float fYReverseOffs
 
 float ArrowEffects::GetXPos( const PlayerState* pPlayerState, int iColNum, float fYOffset )
 {
-	float fPixelOffsetFromCenter = 0; // fill this in below
+	float fXPos;
+	GetXPositions( pPlayerState, iColNum, &fYOffset, 1, &fXPos );
+	return fXPos;
+}
 
+void ArrowEffects::GetXPositions( const PlayerState* pPlayerState, int iColNum, const float *pYOffsets, int iCount, float *pXPosOut )
+{
 	const Style* pStyle = GAMESTATE->GetCurrentStyle(pPlayerState->m_PlayerNumber);
-	const float* fEffects = curr_options->m_fEffects;
 
 	// TODO: Don't index by PlayerNumber.
 	const Style::ColumnInfo* pCols = pStyle->m_ColumnInfo[pPlayerState->m_PlayerNumber];
+	const float fColumnOffset = pCols[iColNum].fXOffset * pPlayerState->m_NotefieldZoom;
+
+	if( !(curr_active_mods & ACTIVE_X_EFFECTS) )
+	{
+		for( int i = 0; i < iCount; ++i )
+			pXPosOut[i] = fColumnOffset;
+		return;
+	}
+
+	for( int i = 0; i < iCount; ++i )
+		pXPosOut[i] = 0; // fill this in below
+
+	const float* fEffects = curr_options->m_fEffects;
 	PerPlayerData &data = g_EffectData[pPlayerState->m_PlayerNumber];
 
 	if( fEffects[PlayerOptions::EFFECT_TORNADO] != 0 )
 	{
-		fPixelOffsetFromCenter += CalculateTornadoOffsetFromMagnitude(dim_x,
-			iColNum, fEffects[PlayerOptions::EFFECT_TORNADO],
+		AddTornadoOffsets(dim_x, iColNum, fEffects[PlayerOptions::EFFECT_TORNADO],
 			fEffects[PlayerOptions::EFFECT_TORNADO_OFFSET],
 			fEffects[PlayerOptions::EFFECT_TORNADO_PERIOD],
-			pCols, pPlayerState->m_NotefieldZoom, data, fYOffset, false);
+			pCols, pPlayerState->m_NotefieldZoom, data, pYOffsets, iCount, pXPosOut, false);
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_TAN_TORNADO] != 0 )
 	{
-		fPixelOffsetFromCenter += CalculateTornadoOffsetFromMagnitude(dim_x,
-			iColNum, fEffects[PlayerOptions::EFFECT_TAN_TORNADO],
+		AddTornadoOffsets(dim_x, iColNum, fEffects[PlayerOptions::EFFECT_TAN_TORNADO],
 			fEffects[PlayerOptions::EFFECT_TAN_TORNADO_OFFSET],
 			fEffects[PlayerOptions::EFFECT_TAN_TORNADO_PERIOD],
-			pCols, pPlayerState->m_NotefieldZoom, data, fYOffset, true);
+			pCols, pPlayerState->m_NotefieldZoom, data, pYOffsets, iCount, pXPosOut, true);
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_BUMPY_X] != 0 )
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_BUMPY_X] *
-			40*RageFastSin( CalculateBumpyAngle(fYOffset,
-			fEffects[PlayerOptions::EFFECT_BUMPY_X_OFFSET],
-			fEffects[PlayerOptions::EFFECT_BUMPY_X_PERIOD]) );
+	{
+		for( int i = 0; i < iCount; ++i )
+			pXPosOut[i] += fEffects[PlayerOptions::EFFECT_BUMPY_X] *
+				40*RageFastSin( CalculateBumpyAngle(pYOffsets[i],
+				fEffects[PlayerOptions::EFFECT_BUMPY_X_OFFSET],
+				fEffects[PlayerOptions::EFFECT_BUMPY_X_PERIOD]) );
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X] != 0 )
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X] *
-			40*SelectTanType( CalculateBumpyAngle(fYOffset,
-			fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X_OFFSET],
-			fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X_PERIOD]), curr_options->m_bCosecant );
+	{
+		for( int i = 0; i < iCount; ++i )
+			pXPosOut[i] += fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X] *
+				40*SelectTanType( CalculateBumpyAngle(pYOffsets[i],
+				fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X_OFFSET],
+				fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X_PERIOD]), curr_options->m_bCosecant );
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_DRUNK] != 0 )
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_DRUNK] *
-			( RageFastCos( CalculateDrunkAngle(fEffects[PlayerOptions::EFFECT_DRUNK_SPEED], iColNum,
-					fEffects[PlayerOptions::EFFECT_DRUNK_OFFSET], DRUNK_COLUMN_FREQUENCY,
-					fYOffset, fEffects[PlayerOptions::EFFECT_DRUNK_PERIOD],
-					DRUNK_OFFSET_FREQUENCY) ) * ARROW_SIZE*DRUNK_ARROW_MAGNITUDE );
+	{
+		AddDrunkOffsets(fEffects[PlayerOptions::EFFECT_DRUNK],
+			fEffects[PlayerOptions::EFFECT_DRUNK_SPEED], iColNum,
+			fEffects[PlayerOptions::EFFECT_DRUNK_OFFSET], DRUNK_COLUMN_FREQUENCY,
+			fEffects[PlayerOptions::EFFECT_DRUNK_PERIOD], DRUNK_OFFSET_FREQUENCY,
+			DRUNK_ARROW_MAGNITUDE, pYOffsets, iCount, pXPosOut, false);
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_TAN_DRUNK] != 0 )
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_TAN_DRUNK] *
-			( SelectTanType( CalculateDrunkAngle(fEffects[PlayerOptions::EFFECT_TAN_DRUNK_SPEED],
-					iColNum, fEffects[PlayerOptions::EFFECT_TAN_DRUNK_OFFSET],
-					DRUNK_COLUMN_FREQUENCY, fYOffset,
-					fEffects[PlayerOptions::EFFECT_TAN_DRUNK_PERIOD], DRUNK_OFFSET_FREQUENCY)
-					, curr_options->m_bCosecant) * ARROW_SIZE*DRUNK_ARROW_MAGNITUDE );
+	{
+		AddDrunkOffsets(fEffects[PlayerOptions::EFFECT_TAN_DRUNK],
+			fEffects[PlayerOptions::EFFECT_TAN_DRUNK_SPEED], iColNum,
+			fEffects[PlayerOptions::EFFECT_TAN_DRUNK_OFFSET], DRUNK_COLUMN_FREQUENCY,
+			fEffects[PlayerOptions::EFFECT_TAN_DRUNK_PERIOD], DRUNK_OFFSET_FREQUENCY,
+			DRUNK_ARROW_MAGNITUDE, pYOffsets, iCount, pXPosOut, true);
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_FLIP] != 0 )
 	{
@@ -758,74 +981,105 @@ float ArrowEffects::GetXPos( const PlayerState* pPlayerState, int iColNum, float
 		const float fOldPixelOffset = pCols[iColNum].fXOffset * pPlayerState->m_NotefieldZoom;
 		const float fNewPixelOffset = pCols[iNewCol].fXOffset * pPlayerState->m_NotefieldZoom;
 		const float fDistance = fNewPixelOffset - fOldPixelOffset;
-		fPixelOffsetFromCenter += fDistance * fEffects[PlayerOptions::EFFECT_FLIP];
+		for( int i = 0; i < iCount; ++i )
+			pXPosOut[i] += fDistance * fEffects[PlayerOptions::EFFECT_FLIP];
 	}
 	if( fEffects[PlayerOptions::EFFECT_INVERT] != 0 )
-		fPixelOffsetFromCenter += data.m_fInvertDistance[iColNum] * fEffects[PlayerOptions::EFFECT_INVERT];
+	{
+		for( int i = 0; i < iCount; ++i )
+			pXPosOut[i] += data.m_fInvertDistance[iColNum] * fEffects[PlayerOptions::EFFECT_INVERT];
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_BEAT] != 0 )
 	{
-		const float fShift = data.m_fBeatFactor[dim_x]*RageFastSin( fYOffset / ((fEffects[PlayerOptions::EFFECT_BEAT_PERIOD]*BEAT_OFFSET_HEIGHT)+BEAT_OFFSET_HEIGHT) + PI/BEAT_PI_HEIGHT );
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_BEAT] * fShift;
+		const float fHeight = (fEffects[PlayerOptions::EFFECT_BEAT_PERIOD]*BEAT_OFFSET_HEIGHT)+BEAT_OFFSET_HEIGHT;
+		const float fPhase = PI/BEAT_PI_HEIGHT;
+		for( int i = 0; i < iCount; ++i )
+		{
+			const float fShift = data.m_fBeatFactor[dim_x]*RageFastSin( pYOffsets[i] / fHeight + fPhase );
+			pXPosOut[i] += fEffects[PlayerOptions::EFFECT_BEAT] * fShift;
+		}
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_ZIGZAG] != 0 )
 	{
-		float fResult = RageTriangle( (PI * (1/(fEffects[PlayerOptions::EFFECT_ZIGZAG_PERIOD]+1)) *
-		((fYOffset+(100.0f*(fEffects[PlayerOptions::EFFECT_ZIGZAG_OFFSET])))/ARROW_SIZE) ) );
+		for( int i = 0; i < iCount; ++i )
+		{
+			float fResult = RageTriangle( (PI * (1/(fEffects[PlayerOptions::EFFECT_ZIGZAG_PERIOD]+1)) *
+			((pYOffsets[i]+(100.0f*(fEffects[PlayerOptions::EFFECT_ZIGZAG_OFFSET])))/ARROW_SIZE) ) );
 
-		fPixelOffsetFromCenter += (fEffects[PlayerOptions::EFFECT_ZIGZAG]*ARROW_SIZE/2) * fResult;
+			pXPosOut[i] += (fEffects[PlayerOptions::EFFECT_ZIGZAG]*ARROW_SIZE/2) * fResult;
+		}
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_SAWTOOTH] != 0 )
-		fPixelOffsetFromCenter += (fEffects[PlayerOptions::EFFECT_SAWTOOTH]*ARROW_SIZE) *
-			((0.5f / (fEffects[PlayerOptions::EFFECT_SAWTOOTH_PERIOD]+1) * fYOffset) / ARROW_SIZE -
-			std::floor((0.5f / (fEffects[PlayerOptions::EFFECT_SAWTOOTH_PERIOD]+1) * fYOffset) / ARROW_SIZE) );
+	{
+		for( int i = 0; i < iCount; ++i )
+			pXPosOut[i] += (fEffects[PlayerOptions::EFFECT_SAWTOOTH]*ARROW_SIZE) *
+				((0.5f / (fEffects[PlayerOptions::EFFECT_SAWTOOTH_PERIOD]+1) * pYOffsets[i]) / ARROW_SIZE -
+				std::floor((0.5f / (fEffects[PlayerOptions::EFFECT_SAWTOOTH_PERIOD]+1) * pYOffsets[i]) / ARROW_SIZE) );
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_PARABOLA_X] != 0 )
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_PARABOLA_X] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE);
+	{
+		for( int i = 0; i < iCount; ++i )
+			pXPosOut[i] += fEffects[PlayerOptions::EFFECT_PARABOLA_X] * (pYOffsets[i]/ARROW_SIZE) * (pYOffsets[i]/ARROW_SIZE);
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_ATTENUATE_X] != 0 )
 	{
 		const float fXOffset = pCols[iColNum].fXOffset;
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_ATTENUATE_X] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE) * (fXOffset/ARROW_SIZE);
+		for( int i = 0; i < iCount; ++i )
+			pXPosOut[i] += fEffects[PlayerOptions::EFFECT_ATTENUATE_X] * (pYOffsets[i]/ARROW_SIZE) * (pYOffsets[i]/ARROW_SIZE) * (fXOffset/ARROW_SIZE);
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_DIGITAL] != 0 )
-		fPixelOffsetFromCenter += (fEffects[PlayerOptions::EFFECT_DIGITAL] * ARROW_SIZE * 0.5f) *
-			std::round((fEffects[PlayerOptions::EFFECT_DIGITAL_STEPS]+1) * RageFastSin(
-				CalculateDigitalAngle(fYOffset,
-				fEffects[PlayerOptions::EFFECT_DIGITAL_OFFSET],
-				fEffects[PlayerOptions::EFFECT_DIGITAL_PERIOD]) ) )/(fEffects[PlayerOptions::EFFECT_DIGITAL_STEPS]+1);
+	{
+		for( int i = 0; i < iCount; ++i )
+			pXPosOut[i] += (fEffects[PlayerOptions::EFFECT_DIGITAL] * ARROW_SIZE * 0.5f) *
+				std::round((fEffects[PlayerOptions::EFFECT_DIGITAL_STEPS]+1) * RageFastSin(
+					CalculateDigitalAngle(pYOffsets[i],
+					fEffects[PlayerOptions::EFFECT_DIGITAL_OFFSET],
+					fEffects[PlayerOptions::EFFECT_DIGITAL_PERIOD]) ) )/(fEffects[PlayerOptions::EFFECT_DIGITAL_STEPS]+1);
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_TAN_DIGITAL] != 0 )
-		fPixelOffsetFromCenter += (fEffects[PlayerOptions::EFFECT_TAN_DIGITAL] * ARROW_SIZE * 0.5f) *
-			std::round((fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_STEPS]+1) * SelectTanType(
-				CalculateDigitalAngle(fYOffset,
-				fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_OFFSET],
-				fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_PERIOD]), curr_options->m_bCosecant ) )/(fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_STEPS]+1);
-
+	{
+		for( int i = 0; i < iCount; ++i )
+			pXPosOut[i] += (fEffects[PlayerOptions::EFFECT_TAN_DIGITAL] * ARROW_SIZE * 0.5f) *
+				std::round((fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_STEPS]+1) * SelectTanType(
+					CalculateDigitalAngle(pYOffsets[i],
+					fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_OFFSET],
+					fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_PERIOD]), curr_options->m_bCosecant ) )/(fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_STEPS]+1);
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_SQUARE] != 0 )
 	{
-		float fResult = RageSquare( (PI * (fYOffset+(1.0f*(fEffects[PlayerOptions::EFFECT_SQUARE_OFFSET]))) /
-			(ARROW_SIZE+(fEffects[PlayerOptions::EFFECT_SQUARE_PERIOD]*ARROW_SIZE))) );
+		for( int i = 0; i < iCount; ++i )
+		{
+			float fResult = RageSquare( (PI * (pYOffsets[i]+(1.0f*(fEffects[PlayerOptions::EFFECT_SQUARE_OFFSET]))) /
+				(ARROW_SIZE+(fEffects[PlayerOptions::EFFECT_SQUARE_PERIOD]*ARROW_SIZE))) );
 
-		fPixelOffsetFromCenter += (fEffects[PlayerOptions::EFFECT_SQUARE] * ARROW_SIZE * 0.5f) * fResult;
+			pXPosOut[i] += (fEffects[PlayerOptions::EFFECT_SQUARE] * ARROW_SIZE * 0.5f) * fResult;
+		}
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_BOUNCE] != 0 )
 	{
-		float fBounceAmt = std::abs( RageFastSin( ( (fYOffset + (1.0f * (fEffects[PlayerOptions::EFFECT_BOUNCE_OFFSET]) ) ) /
-			( 60 + (fEffects[PlayerOptions::EFFECT_BOUNCE_PERIOD]*60) ) ) ) );
+		for( int i = 0; i < iCount; ++i )
+		{
+			float fBounceAmt = std::abs( RageFastSin( ( (pYOffsets[i] + (1.0f * (fEffects[PlayerOptions::EFFECT_BOUNCE_OFFSET]) ) ) /
+				( 60 + (fEffects[PlayerOptions::EFFECT_BOUNCE_PERIOD]*60) ) ) ) );
 
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_BOUNCE] * ARROW_SIZE * 0.5f * fBounceAmt;
+			pXPosOut[i] += fEffects[PlayerOptions::EFFECT_BOUNCE] * ARROW_SIZE * 0.5f * fBounceAmt;
+		}
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_XMODE] != 0 )
 	{
 		// based off of code by v1toko for StepNXA, except it should work on
 		// any gametype now.
+		bool bReverse = false;
 		switch( pStyle->m_StyleType )
 		{
 			case StyleType_OnePlayerTwoSides:
@@ -834,89 +1088,122 @@ float ArrowEffects::GetXPos( const PlayerState* pPlayerState, int iColNum, float
 					// find the middle, and split based on iColNum
 					// it's unknown if this will work for routine.
 					const int iMiddleColumn = std::floor(pStyle->m_iColsPerPlayer/2.0f);
-					if( iColNum > iMiddleColumn-1 )
-						fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_XMODE]*-(fYOffset);
-					else
-						fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_XMODE]*fYOffset;
+					bReverse = iColNum > iMiddleColumn-1;
 				}
 				break;
 			case StyleType_OnePlayerOneSide:
 			case StyleType_TwoPlayersTwoSides:
 				{
 					// the code was the same for both of these cases in StepNXA.
-					if( pPlayerState->m_PlayerNumber == PLAYER_2 )
-						fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_XMODE]*-(fYOffset);
-					else
-						fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_XMODE]*fYOffset;
+					bReverse = pPlayerState->m_PlayerNumber == PLAYER_2;
 				}
 				break;
 			DEFAULT_FAIL(pStyle->m_StyleType);
 		}
+		for( int i = 0; i < iCount; ++i )
+		{
+			if( bReverse )
+				pXPosOut[i] += fEffects[PlayerOptions::EFFECT_XMODE]*-(pYOffsets[i]);
+			else
+				pXPosOut[i] += fEffects[PlayerOptions::EFFECT_XMODE]*pYOffsets[i];
+		}
 	}
 
-	fPixelOffsetFromCenter += pCols[iColNum].fXOffset * pPlayerState->m_NotefieldZoom;
+	for( int i = 0; i < iCount; ++i )
+		pXPosOut[i] += fColumnOffset;
 
 	if( fEffects[PlayerOptions::EFFECT_TINY] != 0 )
 	{
 		// Allow Tiny to pull tracks together, but not to push them apart.
 		float fTinyPercent = fEffects[PlayerOptions::EFFECT_TINY];
 		fTinyPercent = std::min( std::pow(TINY_PERCENT_BASE, fTinyPercent), (float)TINY_PERCENT_GATE );
-		fPixelOffsetFromCenter *= fTinyPercent;
+		for( int i = 0; i < iCount; ++i )
+			pXPosOut[i] *= fTinyPercent;
 	}
-
-	return fPixelOffsetFromCenter;
 }
 
 float ArrowEffects::GetRotationX(const PlayerState* pPlayerState, float fYOffset, bool bIsHoldCap, int iCol)
+{
+	float fRotation;
+	GetRotationsX( pPlayerState, &fYOffset, 1, bIsHoldCap, iCol, &fRotation );
+	return fRotation;
+}
+
+void ArrowEffects::GetRotationsX(const PlayerState* pPlayerState, const float *pYOffsets, int iCount, bool bIsHoldCap, int iCol, float *pRotationOut)
 {
 	const float* fEffects = curr_options->m_fEffects;
 	float fRotation = 0;
-	if( fEffects[PlayerOptions::EFFECT_CONFUSION_X] != 0 || fEffects[PlayerOptions::EFFECT_CONFUSION_X_OFFSET] != 0 ||
-	curr_options->m_fConfusionX[iCol] != 0
+	if( (curr_active_mods & ACTIVE_ROTATION) && (
+		fEffects[PlayerOptions::EFFECT_CONFUSION_X] != 0 || fEffects[PlayerOptions::EFFECT_CONFUSION_X_OFFSET] != 0 ||
+		curr_options->m_fConfusionX[iCol] != 0 )
 	)
 		fRotation += ReceptorGetRotationX( pPlayerState, iCol );
+	for( int i = 0; i < iCount; ++i )
+		pRotationOut[i] = fRotation;
 	if( fEffects[PlayerOptions::EFFECT_ROLL] != 0 && !bIsHoldCap )
 	{
-		fRotation += fEffects[PlayerOptions::EFFECT_ROLL] * fYOffset/2;
+		for( int i = 0; i < iCount; ++i )
+			pRotationOut[i] += fEffects[PlayerOptions::EFFECT_ROLL] * pYOffsets[i]/2;
 	}
-	return fRotation;
 }
 
 float ArrowEffects::GetRotationY(const PlayerState* pPlayerState, float fYOffset, int iCol)
+{
+	float fRotation;
+	GetRotationsY( pPlayerState, &fYOffset, 1, iCol, &fRotation );
+	return fRotation;
+}
+
+void ArrowEffects::GetRotationsY(const PlayerState* pPlayerState, const float *pYOffsets, int iCount, int iCol, float *pRotationOut)
 {
 	const float* fEffects = curr_options->m_fEffects;
 	float fRotation = 0;
-	if( fEffects[PlayerOptions::EFFECT_CONFUSION_Y] != 0 || fEffects[PlayerOptions::EFFECT_CONFUSION_Y_OFFSET] != 0 ||
-	curr_options->m_fConfusionY[iCol] != 0
+	if( (curr_active_mods & ACTIVE_ROTATION) && (
+		fEffects[PlayerOptions::EFFECT_CONFUSION_Y] != 0 || fEffects[PlayerOptions::EFFECT_CONFUSION_Y_OFFSET] != 0 ||
+		curr_options->m_fConfusionY[iCol] != 0 )
 	)
 		fRotation += ReceptorGetRotationY( pPlayerState, iCol );
+	for( int i = 0; i < iCount; ++i )
+		pRotationOut[i] = fRotation;
 	if( fEffects[PlayerOptions::EFFECT_TWIRL] != 0 )
 	{
-		fRotation += fEffects[PlayerOptions::EFFECT_TWIRL] * fYOffset/2;
+		for( int i = 0; i < iCount; ++i )
+			pRotationOut[i] += fEffects[PlayerOptions::EFFECT_TWIRL] * pYOffsets[i]/2;
 	}
-	return fRotation;
 }
 
 float ArrowEffects::GetRotationZ( const PlayerState* pPlayerState, float fNoteBeat, bool bIsHoldHead, int iCol )
+{
+	float fRotation;
+	GetRotationsZ( pPlayerState, &fNoteBeat, 1, bIsHoldHead, iCol, &fRotation );
+	return fRotation;
+}
+
+void ArrowEffects::GetRotationsZ( const PlayerState* pPlayerState, const float *pNoteBeats, int iCount, bool bIsHoldHead, int iCol, float *pRotationOut )
 {
 	const float* fEffects = curr_options->m_fEffects;
 	float fRotation = 0;
-	if( fEffects[PlayerOptions::EFFECT_CONFUSION] != 0 || fEffects[PlayerOptions::EFFECT_CONFUSION_OFFSET] != 0 ||
-	curr_options->m_fConfusionZ[iCol] != 0
+	if( (curr_active_mods & ACTIVE_ROTATION) && (
+		fEffects[PlayerOptions::EFFECT_CONFUSION] != 0 || fEffects[PlayerOptions::EFFECT_CONFUSION_OFFSET] != 0 ||
+		curr_options->m_fConfusionZ[iCol] != 0 )
 	)
 		fRotation += ReceptorGetRotationZ( pPlayerState, iCol );
+	for( int i = 0; i < iCount; ++i )
+		pRotationOut[i] = fRotation;
 
 	// As usual, enable dizzy hold heads at your own risk. -Wolfman2000
 	if( fEffects[PlayerOptions::EFFECT_DIZZY] != 0 && ( curr_options->m_bDizzyHolds || !bIsHoldHead ) )
 	{
 		const float fSongBeat = pPlayerState->m_Position.m_fSongBeatVisible;
-		float fDizzyRotation = fNoteBeat - fSongBeat;
-		fDizzyRotation *= fEffects[PlayerOptions::EFFECT_DIZZY];
-		fDizzyRotation = std::fmod( fDizzyRotation, 2*PI );
-		fDizzyRotation *= 180/PI;
-		fRotation += fDizzyRotation;
+		for( int i = 0; i < iCount; ++i )
+		{
+			float fDizzyRotation = pNoteBeats[i] - fSongBeat;
+			fDizzyRotation *= fEffects[PlayerOptions::EFFECT_DIZZY];
+			fDizzyRotation = std::fmod( fDizzyRotation, 2*PI );
+			fDizzyRotation *= 180/PI;
+			pRotationOut[i] += fDizzyRotation;
+		}
 	}
-	return fRotation;
 }
 
 float ArrowEffects::ReceptorGetRotationZ( const PlayerState* pPlayerState, int iCol )
@@ -1074,91 +1361,134 @@ static float GetSuddenStartLine()
 		GetCenterLine() * curr_options->m_fAppearances[PlayerOptions::APPEARANCE_SUDDEN_OFFSET];
 }
 
-// used by ArrowGetAlpha and ArrowGetGlow below
-float ArrowGetPercentVisible(float fYPosWithoutReverse, int iCol, float fYOffset)
+// used by GetAlphasAndGlows below
+static void ArrowGetPercentVisible(const float* pYPosWithoutReverse, const float* pYOffsets, int iCount, int iCol, float* pPercentVisibleOut)
 {
-	const float fDistFromCenterLine = fYPosWithoutReverse - GetCenterLine();
-
-	float fYPos;
-	if( curr_options->m_bStealthType )
-		fYPos = fYOffset;
-	else
-		fYPos = fYPosWithoutReverse;
-
-
-	if( fYPos < 0 && curr_options->m_bStealthPastReceptors == false)	// past Gray Arrows
-		return 1;	// totally visible
-
-	const float* fAppearances = curr_options->m_fAppearances;
-
-	float fVisibleAdjust = 0;
-
-	if( fAppearances[PlayerOptions::APPEARANCE_HIDDEN] != 0 )
+	if( !(curr_active_mods & ACTIVE_APPEARANCE) )
 	{
-		float fHiddenVisibleAdjust = SCALE( fYPos, GetHiddenStartLine(), GetHiddenEndLine(), 0, -1 );
-		CLAMP( fHiddenVisibleAdjust, -1, 0 );
-		fVisibleAdjust += fAppearances[PlayerOptions::APPEARANCE_HIDDEN] * fHiddenVisibleAdjust;
-	}
-	if( fAppearances[PlayerOptions::APPEARANCE_SUDDEN] != 0 )
-	{
-		float fSuddenVisibleAdjust = SCALE( fYPos, GetSuddenStartLine(), GetSuddenEndLine(), -1, 0 );
-		CLAMP( fSuddenVisibleAdjust, -1, 0 );
-		fVisibleAdjust += fAppearances[PlayerOptions::APPEARANCE_SUDDEN] * fSuddenVisibleAdjust;
+		// Nothing would take any visibility away.
+		for( int i = 0; i < iCount; ++i )
+			pPercentVisibleOut[i] = 1;
+		return;
 	}
 
-	if( fAppearances[PlayerOptions::APPEARANCE_STEALTH] != 0 )
-		fVisibleAdjust -= fAppearances[PlayerOptions::APPEARANCE_STEALTH];
-	if( curr_options->m_fStealth[iCol] != 0 ){
-		fVisibleAdjust -= curr_options->m_fStealth[iCol];
-	}
+	const float* fAppearances = curr_options->m_fAppearances;
+
+	// None of these lines move from note to note.
+	const float fCenterLine = GetCenterLine();
+	const float fHiddenStartLine = GetHiddenStartLine();
+	const float fHiddenEndLine = GetHiddenEndLine();
+	const float fSuddenStartLine = GetSuddenStartLine();
+	const float fSuddenEndLine = GetSuddenEndLine();
+	float fBlinkAdjust = 0;
 	if( fAppearances[PlayerOptions::APPEARANCE_BLINK] != 0 )
 	{
 		float f = RageFastSin(ArrowEffects::GetTime()*10);
 		f = Quantize( f, BLINK_MOD_FREQUENCY );
-		fVisibleAdjust += SCALE( f, 0, 1, -1, 0 );
+		fBlinkAdjust = SCALE( f, 0, 1, -1, 0 );
 	}
-	if( fAppearances[PlayerOptions::APPEARANCE_RANDOMVANISH] != 0 )
+
+	for( int i = 0; i < iCount; ++i )
 	{
-		const float fRealFadeDist = 80;
-		fVisibleAdjust += SCALE( std::abs(fDistFromCenterLine), fRealFadeDist, 2*fRealFadeDist, -1, 0 )
-			* fAppearances[PlayerOptions::APPEARANCE_RANDOMVANISH];
-	}
+		const float fDistFromCenterLine = pYPosWithoutReverse[i] - fCenterLine;
 
-	return clamp(1 + fVisibleAdjust, 0.0f, 1.0f);
-}
+		float fYPos;
+		if( curr_options->m_bStealthType )
+			fYPos = pYOffsets[i];
+		else
+			fYPos = pYPosWithoutReverse[i];
 
-float ArrowEffects::GetAlpha( const PlayerState* pPlayerState, int iCol, float fYOffset, float fPercentFadeToFail, float fYReverseOffsetPixels, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar)
-{
-	// Get the YPos without reverse (that is, factor in EFFECT_TIPSY).
-	float fYPosWithoutReverse = ArrowEffects::GetYPos(pPlayerState, iCol, fYOffset, fYReverseOffsetPixels, false );
+		if( fYPos < 0 && curr_options->m_bStealthPastReceptors == false)	// past Gray Arrows
+		{
+			pPercentVisibleOut[i] = 1;	// totally visible
+			continue;
+		}
 
-	float fPercentVisible = ArrowGetPercentVisible(fYPosWithoutReverse, iCol, fYOffset);
+		float fVisibleAdjust = 0;
 
-	if( fPercentFadeToFail != -1 )
-		fPercentVisible = 1 - fPercentFadeToFail;
+		if( fAppearances[PlayerOptions::APPEARANCE_HIDDEN] != 0 )
+		{
+			float fHiddenVisibleAdjust = SCALE( fYPos, fHiddenStartLine, fHiddenEndLine, 0, -1 );
+			CLAMP( fHiddenVisibleAdjust, -1, 0 );
+			fVisibleAdjust += fAppearances[PlayerOptions::APPEARANCE_HIDDEN] * fHiddenVisibleAdjust;
+		}
+		if( fAppearances[PlayerOptions::APPEARANCE_SUDDEN] != 0 )
+		{
+			float fSuddenVisibleAdjust = SCALE( fYPos, fSuddenStartLine, fSuddenEndLine, -1, 0 );
+			CLAMP( fSuddenVisibleAdjust, -1, 0 );
+			fVisibleAdjust += fAppearances[PlayerOptions::APPEARANCE_SUDDEN] * fSuddenVisibleAdjust;
+		}
 
+		if( fAppearances[PlayerOptions::APPEARANCE_STEALTH] != 0 )
+			fVisibleAdjust -= fAppearances[PlayerOptions::APPEARANCE_STEALTH];
+		if( curr_options->m_fStealth[iCol] != 0 ){
+			fVisibleAdjust -= curr_options->m_fStealth[iCol];
+		}
+		if( fAppearances[PlayerOptions::APPEARANCE_BLINK] != 0 )
+			fVisibleAdjust += fBlinkAdjust;
+		if( fAppearances[PlayerOptions::APPEARANCE_RANDOMVANISH] != 0 )
+		{
+			const float fRealFadeDist = 80;
+			fVisibleAdjust += SCALE( std::abs(fDistFromCenterLine), fRealFadeDist, 2*fRealFadeDist, -1, 0 )
+				* fAppearances[PlayerOptions::APPEARANCE_RANDOMVANISH];
+		}
 
-	float fFullAlphaY = fDrawDistanceBeforeTargetsPixels*(1-fFadeInPercentOfDrawFar);
-	if( fYPosWithoutReverse > fFullAlphaY )
-	{
-		float f = SCALE( fYPosWithoutReverse, fFullAlphaY, fDrawDistanceBeforeTargetsPixels, 1.0f, 0.0f );
-		return f;
+		pPercentVisibleOut[i] = clamp(1 + fVisibleAdjust, 0.0f, 1.0f);
 	}
-	return (fPercentVisible>0.5f) ? 1.0f : 0.0f;
+}
+
+float ArrowEffects::GetAlpha( const PlayerState* pPlayerState, int iCol, float fYOffset, float fPercentFadeToFail, float fYReverseOffsetPixels, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar)
+{
+	float fAlpha;
+	GetAlphasAndGlows( pPlayerState, iCol, &fYOffset, &fPercentFadeToFail, 1, fYReverseOffsetPixels, fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar, &fAlpha, nullptr );
+	return fAlpha;
 }
 
 float ArrowEffects::GetGlow( const PlayerState* pPlayerState, int iCol, float fYOffset, float fPercentFadeToFail, float fYReverseOffsetPixels, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar)
 {
-	// Get the YPos without reverse (that is, factor in EFFECT_TIPSY).
-	float fYPosWithoutReverse = ArrowEffects::GetYPos(pPlayerState, iCol, fYOffset, fYReverseOffsetPixels, false );
+	float fGlow;
+	GetAlphasAndGlows( pPlayerState, iCol, &fYOffset, &fPercentFadeToFail, 1, fYReverseOffsetPixels, fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar, nullptr, &fGlow );
+	return fGlow;
+}
 
-	float fPercentVisible = ArrowGetPercentVisible(fYPosWithoutReverse, iCol, fYOffset);
+void ArrowEffects::GetAlphasAndGlows( const PlayerState* pPlayerState, int iCol, const float *pYOffsets, const float *pPercentFadeToFail, int iCount, float fYReverseOffsetPixels, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar, float *pAlphaOut, float *pGlowOut )
+{
+	const float fFullAlphaY = fDrawDistanceBeforeTargetsPixels*(1-fFadeInPercentOfDrawFar);
 
-	if( fPercentFadeToFail != -1 )
-		fPercentVisible = 1 - fPercentFadeToFail;
+	// Work through the notes a chunk at a time, so the scratch space can live
+	// on the stack.
+	const int CHUNK_SIZE = 64;
+	float fYPosWithoutReverse[CHUNK_SIZE];
+	float fPercentVisible[CHUNK_SIZE];
+	for( int iStart = 0; iStart < iCount; iStart += CHUNK_SIZE )
+	{
+		const int iChunk = std::min( iCount - iStart, CHUNK_SIZE );
+		const float *pChunkYOffsets = pYOffsets + iStart;
+
+		// Get the YPos without reverse (that is, factor in EFFECT_TIPSY).
+		GetYPositions( pPlayerState, iCol, pChunkYOffsets, iChunk, fYPosWithoutReverse, fYReverseOffsetPixels, false );
+		ArrowGetPercentVisible( fYPosWithoutReverse, pChunkYOffsets, iChunk, iCol, fPercentVisible );
+
+		for( int i = 0; i < iChunk; ++i )
+		{
+			if( pPercentFadeToFail[iStart+i] != -1 )
+				fPercentVisible[i] = 1 - pPercentFadeToFail[iStart+i];
+		}
 
-	const float fDistFromHalf = std::abs( fPercentVisible - 0.5f );
-	return SCALE( fDistFromHalf, 0, 0.5f, 1.3f, 0 );
+		for( int i = 0; pAlphaOut != nullptr && i < iChunk; ++i )
+		{
+			if( fYPosWithoutReverse[i] > fFullAlphaY )
+				pAlphaOut[iStart+i] = SCALE( fYPosWithoutReverse[i], fFullAlphaY, fDrawDistanceBeforeTargetsPixels, 1.0f, 0.0f );
+			else
+				pAlphaOut[iStart+i] = (fPercentVisible[i]>0.5f) ? 1.0f : 0.0f;
+		}
+
+		for( int i = 0; pGlowOut != nullptr && i < iChunk; ++i )
+		{
+			const float fDistFromHalf = std::abs( fPercentVisible[i] - 0.5f );
+			pGlowOut[iStart+i] = SCALE( fDistFromHalf, 0, 0.5f, 1.3f, 0 );
+		}
+	}
 }
 
 float ArrowEffects::GetBrightness( const PlayerState* pPlayerState, float fNoteBeat )
@@ -1177,7 +1507,19 @@ float ArrowEffects::GetBrightness( const PlayerState* pPlayerState, float fNoteB
 
 float ArrowEffects::GetZPos( const PlayerState* pPlayerState, int iCol, float fYOffset)
 {
-	float fZPos=0;
+	float fZPos;
+	GetZPositions( pPlayerState, iCol, &fYOffset, 1, &fZPos );
+	return fZPos;
+}
+
+void ArrowEffects::GetZPositions( const PlayerState* pPlayerState, int iCol, const float *pYOffsets, int iCount, float *pZPosOut )
+{
+	for( int i = 0; i < iCount; ++i )
+		pZPosOut[i] = 0;
+
+	if( !(curr_active_mods & ACTIVE_Z_EFFECTS) )
+		return;
+
 	const float* fEffects = curr_options->m_fEffects;
 	const Style* pStyle = GAMESTATE->GetCurrentStyle(pPlayerState->m_PlayerNumber);
 
@@ -1187,115 +1529,148 @@ float ArrowEffects::GetZPos( const PlayerState* pPlayerState, int iCol, float fY
 
 	if( fEffects[PlayerOptions::EFFECT_TORNADO_Z] != 0 )
 	{
-		fZPos += CalculateTornadoOffsetFromMagnitude(dim_z, iCol,
-			fEffects[PlayerOptions::EFFECT_TORNADO_Z],
+		AddTornadoOffsets(dim_z, iCol, fEffects[PlayerOptions::EFFECT_TORNADO_Z],
 			fEffects[PlayerOptions::EFFECT_TORNADO_Z_OFFSET],
 			fEffects[PlayerOptions::EFFECT_TORNADO_Z_PERIOD],
-			pCols, pPlayerState->m_NotefieldZoom, data, fYOffset, false);
+			pCols, pPlayerState->m_NotefieldZoom, data, pYOffsets, iCount, pZPosOut, false);
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z] != 0 )
 	{
-		fZPos += CalculateTornadoOffsetFromMagnitude(dim_z, iCol,
-			fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z],
+		AddTornadoOffsets(dim_z, iCol, fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z],
 			fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z_OFFSET],
 			fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z_PERIOD],
-			pCols, pPlayerState->m_NotefieldZoom, data, fYOffset, true);
+			pCols, pPlayerState->m_NotefieldZoom, data, pYOffsets, iCount, pZPosOut, true);
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_BUMPY] != 0 )
-		fZPos += fEffects[PlayerOptions::EFFECT_BUMPY] * 40*RageFastSin(
-			CalculateBumpyAngle(fYOffset,
-			fEffects[PlayerOptions::EFFECT_BUMPY_OFFSET],
-			fEffects[PlayerOptions::EFFECT_BUMPY_PERIOD]) );
+	{
+		for( int i = 0; i < iCount; ++i )
+			pZPosOut[i] += fEffects[PlayerOptions::EFFECT_BUMPY] * 40*RageFastSin(
+				CalculateBumpyAngle(pYOffsets[i],
+				fEffects[PlayerOptions::EFFECT_BUMPY_OFFSET],
+				fEffects[PlayerOptions::EFFECT_BUMPY_PERIOD]) );
+	}
 
 	if( curr_options->m_fBumpy[iCol] != 0 )
-		fZPos += curr_options->m_fBumpy[iCol] * 40*RageFastSin(
-			CalculateBumpyAngle(fYOffset,
-			fEffects[PlayerOptions::EFFECT_BUMPY_OFFSET],
-			fEffects[PlayerOptions::EFFECT_BUMPY_PERIOD]) );
+	{
+		for( int i = 0; i < iCount; ++i )
+			pZPosOut[i] += curr_options->m_fBumpy[iCol] * 40*RageFastSin(
+				CalculateBumpyAngle(pYOffsets[i],
+				fEffects[PlayerOptions::EFFECT_BUMPY_OFFSET],
+				fEffects[PlayerOptions::EFFECT_BUMPY_PERIOD]) );
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_TAN_BUMPY] != 0 )
-		fZPos += fEffects[PlayerOptions::EFFECT_TAN_BUMPY] * 40*SelectTanType(
-			CalculateBumpyAngle(fYOffset,
-			fEffects[PlayerOptions::EFFECT_TAN_BUMPY_OFFSET],
-			fEffects[PlayerOptions::EFFECT_TAN_BUMPY_PERIOD]), curr_options->m_bCosecant );
+	{
+		for( int i = 0; i < iCount; ++i )
+			pZPosOut[i] += fEffects[PlayerOptions::EFFECT_TAN_BUMPY] * 40*SelectTanType(
+				CalculateBumpyAngle(pYOffsets[i],
+				fEffects[PlayerOptions::EFFECT_TAN_BUMPY_OFFSET],
+				fEffects[PlayerOptions::EFFECT_TAN_BUMPY_PERIOD]), curr_options->m_bCosecant );
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_ZIGZAG_Z] != 0 )
 	{
-		float fResult = RageTriangle( (PI * (1/(fEffects[PlayerOptions::EFFECT_ZIGZAG_Z_PERIOD]+1)) *
-			((fYOffset+(100.0f*(fEffects[PlayerOptions::EFFECT_ZIGZAG_Z_OFFSET])))/ARROW_SIZE) ) );
+		for( int i = 0; i < iCount; ++i )
+		{
+			float fResult = RageTriangle( (PI * (1/(fEffects[PlayerOptions::EFFECT_ZIGZAG_Z_PERIOD]+1)) *
+				((pYOffsets[i]+(100.0f*(fEffects[PlayerOptions::EFFECT_ZIGZAG_Z_OFFSET])))/ARROW_SIZE) ) );
 
-		fZPos += (fEffects[PlayerOptions::EFFECT_ZIGZAG_Z]*ARROW_SIZE/2) * fResult;
+			pZPosOut[i] += (fEffects[PlayerOptions::EFFECT_ZIGZAG_Z]*ARROW_SIZE/2) * fResult;
+		}
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z] != 0 )
-		fZPos += (fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z]*ARROW_SIZE) *
-			((0.5f/(fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z_PERIOD]+1)*fYOffset)/ARROW_SIZE -
-				std::floor((0.5f/(fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z_PERIOD]+1)*fYOffset)/ARROW_SIZE));
+	{
+		for( int i = 0; i < iCount; ++i )
+			pZPosOut[i] += (fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z]*ARROW_SIZE) *
+				((0.5f/(fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z_PERIOD]+1)*pYOffsets[i])/ARROW_SIZE -
+					std::floor((0.5f/(fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z_PERIOD]+1)*pYOffsets[i])/ARROW_SIZE));
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_PARABOLA_Z] != 0 )
-		fZPos += fEffects[PlayerOptions::EFFECT_PARABOLA_Z] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE);
+	{
+		for( int i = 0; i < iCount; ++i )
+			pZPosOut[i] += fEffects[PlayerOptions::EFFECT_PARABOLA_Z] * (pYOffsets[i]/ARROW_SIZE) * (pYOffsets[i]/ARROW_SIZE);
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_ATTENUATE_Z] != 0 )
 	{
 		const float fXOffset = pCols[iCol].fXOffset;
-		fZPos += fEffects[PlayerOptions::EFFECT_ATTENUATE_Z] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE) * (fXOffset/ARROW_SIZE);
+		for( int i = 0; i < iCount; ++i )
+			pZPosOut[i] += fEffects[PlayerOptions::EFFECT_ATTENUATE_Z] * (pYOffsets[i]/ARROW_SIZE) * (pYOffsets[i]/ARROW_SIZE) * (fXOffset/ARROW_SIZE);
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_DRUNK_Z] != 0 )
-		fZPos += fEffects[PlayerOptions::EFFECT_DRUNK_Z] *
-			( RageFastCos( CalculateDrunkAngle(fEffects[PlayerOptions::EFFECT_DRUNK_Z_SPEED], iCol,
-					fEffects[PlayerOptions::EFFECT_DRUNK_Z_OFFSET], DRUNK_Z_COLUMN_FREQUENCY,
-					fYOffset, fEffects[PlayerOptions::EFFECT_DRUNK_Z_PERIOD],
-					DRUNK_Z_OFFSET_FREQUENCY) ) * ARROW_SIZE*DRUNK_Z_ARROW_MAGNITUDE );
+	{
+		AddDrunkOffsets(fEffects[PlayerOptions::EFFECT_DRUNK_Z],
+			fEffects[PlayerOptions::EFFECT_DRUNK_Z_SPEED], iCol,
+			fEffects[PlayerOptions::EFFECT_DRUNK_Z_OFFSET], DRUNK_Z_COLUMN_FREQUENCY,
+			fEffects[PlayerOptions::EFFECT_DRUNK_Z_PERIOD], DRUNK_Z_OFFSET_FREQUENCY,
+			DRUNK_Z_ARROW_MAGNITUDE, pYOffsets, iCount, pZPosOut, false);
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z] != 0 )
-		fZPos += fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z] *
-			( SelectTanType( CalculateDrunkAngle(fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z_SPEED],
-					iCol, fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z_OFFSET],
-					DRUNK_Z_COLUMN_FREQUENCY, fYOffset,
-					fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z_PERIOD],
-					DRUNK_Z_OFFSET_FREQUENCY)
-					, curr_options->m_bCosecant) * ARROW_SIZE*DRUNK_Z_ARROW_MAGNITUDE );
+	{
+		AddDrunkOffsets(fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z],
+			fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z_SPEED], iCol,
+			fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z_OFFSET], DRUNK_Z_COLUMN_FREQUENCY,
+			fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z_PERIOD], DRUNK_Z_OFFSET_FREQUENCY,
+			DRUNK_Z_ARROW_MAGNITUDE, pYOffsets, iCount, pZPosOut, true);
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_BEAT_Z] != 0 )
 	{
-		const float fShift = data.m_fBeatFactor[dim_z]*RageFastSin( fYOffset / ((fEffects[PlayerOptions::EFFECT_BEAT_Z_PERIOD]*BEAT_Z_OFFSET_HEIGHT)+BEAT_Z_OFFSET_HEIGHT) + PI/BEAT_Z_PI_HEIGHT );
-		fZPos += fEffects[PlayerOptions::EFFECT_BEAT_Z] * fShift;
+		const float fHeight = (fEffects[PlayerOptions::EFFECT_BEAT_Z_PERIOD]*BEAT_Z_OFFSET_HEIGHT)+BEAT_Z_OFFSET_HEIGHT;
+		const float fPhase = PI/BEAT_Z_PI_HEIGHT;
+		for( int i = 0; i < iCount; ++i )
+		{
+			const float fShift = data.m_fBeatFactor[dim_z]*RageFastSin( pYOffsets[i] / fHeight + fPhase );
+			pZPosOut[i] += fEffects[PlayerOptions::EFFECT_BEAT_Z] * fShift;
+		}
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_DIGITAL_Z] != 0 )
-		fZPos += (fEffects[PlayerOptions::EFFECT_DIGITAL_Z] * ARROW_SIZE * 0.5f) *
-			std::round((fEffects[PlayerOptions::EFFECT_DIGITAL_Z_STEPS]+1) * RageFastSin(
-				CalculateDigitalAngle(fYOffset,
-				fEffects[PlayerOptions::EFFECT_DIGITAL_Z_OFFSET],
-				fEffects[PlayerOptions::EFFECT_DIGITAL_Z_PERIOD]) ) ) /(fEffects[PlayerOptions::EFFECT_DIGITAL_Z_STEPS]+1);
+	{
+		for( int i = 0; i < iCount; ++i )
+			pZPosOut[i] += (fEffects[PlayerOptions::EFFECT_DIGITAL_Z] * ARROW_SIZE * 0.5f) *
+				std::round((fEffects[PlayerOptions::EFFECT_DIGITAL_Z_STEPS]+1) * RageFastSin(
+					CalculateDigitalAngle(pYOffsets[i],
+					fEffects[PlayerOptions::EFFECT_DIGITAL_Z_OFFSET],
+					fEffects[PlayerOptions::EFFECT_DIGITAL_Z_PERIOD]) ) ) /(fEffects[PlayerOptions::EFFECT_DIGITAL_Z_STEPS]+1);
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z] != 0 )
-		fZPos += (fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z] * ARROW_SIZE * 0.5f) *
-			std::round((fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_STEPS]+1) * SelectTanType(
-				CalculateDigitalAngle(fYOffset,
-				fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_OFFSET],
-				fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_PERIOD]), curr_options->m_bCosecant ) ) /(fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_STEPS]+1);
-
+	{
+		for( int i = 0; i < iCount; ++i )
+			pZPosOut[i] += (fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z] * ARROW_SIZE * 0.5f) *
+				std::round((fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_STEPS]+1) * SelectTanType(
+					CalculateDigitalAngle(pYOffsets[i],
+					fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_OFFSET],
+					fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_PERIOD]), curr_options->m_bCosecant ) ) /(fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_STEPS]+1);
+	}
 
 	if( fEffects[PlayerOptions::EFFECT_SQUARE_Z] != 0 )
 	{
-		float fResult = RageSquare( (PI * (fYOffset+(1.0f*(fEffects[PlayerOptions::EFFECT_SQUARE_Z_OFFSET]))) /
-			(ARROW_SIZE+(fEffects[PlayerOptions::EFFECT_SQUARE_Z_PERIOD]*ARROW_SIZE))) );
-		fZPos += (fEffects[PlayerOptions::EFFECT_SQUARE_Z] * ARROW_SIZE * 0.5f) * fResult;
+		for( int i = 0; i < iCount; ++i )
+		{
+			float fResult = RageSquare( (PI * (pYOffsets[i]+(1.0f*(fEffects[PlayerOptions::EFFECT_SQUARE_Z_OFFSET]))) /
+				(ARROW_SIZE+(fEffects[PlayerOptions::EFFECT_SQUARE_Z_PERIOD]*ARROW_SIZE))) );
+			pZPosOut[i] += (fEffects[PlayerOptions::EFFECT_SQUARE_Z] * ARROW_SIZE * 0.5f) * fResult;
+		}
 	}
 
 	if( fEffects[PlayerOptions::EFFECT_BOUNCE_Z] != 0 )
 	{
-		float fBounceAmt = std::abs( RageFastSin( ( (fYOffset + (1.0f * (fEffects[PlayerOptions::EFFECT_BOUNCE_Z_OFFSET]) ) ) /
-			( 60 + (fEffects[PlayerOptions::EFFECT_BOUNCE_Z_PERIOD]*60) ) ) ) );
+		for( int i = 0; i < iCount; ++i )
+		{
+			float fBounceAmt = std::abs( RageFastSin( ( (pYOffsets[i] + (1.0f * (fEffects[PlayerOptions::EFFECT_BOUNCE_Z_OFFSET]) ) ) /
+				( 60 + (fEffects[PlayerOptions::EFFECT_BOUNCE_Z_PERIOD]*60) ) ) ) );
 
-		fZPos += fEffects[PlayerOptions::EFFECT_BOUNCE_Z] * ARROW_SIZE * 0.5f * fBounceAmt;
+			pZPosOut[i] += fEffects[PlayerOptions::EFFECT_BOUNCE_Z] * ARROW_SIZE * 0.5f * fBounceAmt;
+		}
 	}
-
-	return fZPos;
 }
 
 bool ArrowEffects::NeedZBuffer()
@@ -1336,6 +1711,13 @@ bool ArrowEffects::NeedZBuffer()
 }
 
 float ArrowEffects::GetZoom( const PlayerState* pPlayerState, float fYOffset, int iCol )
+{
+	float fZoom;
+	GetZooms( pPlayerState, &fYOffset, 1, iCol, &fZoom );
+	return fZoom;
+}
+
+void ArrowEffects::GetZooms( const PlayerState* pPlayerState, const float *pYOffsets, int iCount, int iCol, float *pZoomOut )
 {
 	float fZoom = 1.0f;
 	// Design change:  Instead of having a flag in the style that toggles a
@@ -1344,20 +1726,29 @@ float ArrowEffects::GetZoom( const PlayerState* pPlayerState, float fYOffset, in
 	// PlayerState. -Kyz
 	fZoom*= pPlayerState->m_NotefieldZoom;
 
-	fZoom = GetZoomVariable( fYOffset, iCol, fZoom);
+	if( !(curr_active_mods & ACTIVE_ZOOM) )
+	{
+		for( int i = 0; i < iCount; ++i )
+			pZoomOut[i] = fZoom;
+		return;
+	}
+
+	for( int i = 0; i < iCount; ++i )
+		pZoomOut[i] = GetZoomVariable( pYOffsets[i], iCol, fZoom );
 
 	float fTinyPercent = curr_options->m_fEffects[PlayerOptions::EFFECT_TINY];
 	if( fTinyPercent != 0 )
 	{
 		fTinyPercent = std::pow( 0.5f, fTinyPercent );
-		fZoom *= fTinyPercent;
+		for( int i = 0; i < iCount; ++i )
+			pZoomOut[i] *= fTinyPercent;
 	}
 	if( curr_options->m_fTiny[iCol] != 0 )
 	{
 		fTinyPercent = std::pow( 0.5f, curr_options->m_fTiny[iCol] );
-		fZoom *= fTinyPercent;
+		for( int i = 0; i < iCount; ++i )
+			pZoomOut[i] *= fTinyPercent;
 	}
-	return fZoom;
 }
 
 float ArrowEffects::GetZoomVariable( float fYOffset, int iCol, float fCurZoom )
@@ -17,6 +17,8 @@ public:
 	// ArrowEffects doesn't have to reach through the PlayerState to check
 	// every option.  Also, it will make it easier to implement per-column
 	// mods later. -Kyz
+	// It also notes which groups of mods are on, so call it again after
+	// changing the options.
 	static void SetCurrentOptions(const PlayerOptions* options);
 
 	// fYOffset is a vertical position in pixels relative to the center
@@ -111,6 +113,23 @@ public:
 	static float GetPulseInner();
 
 	static float GetFrameWidthScale( const PlayerState* pPlayerState, float fYOffset, float fOverlappedTime );
+
+	// Batched versions of the functions above, for a run of notes in one
+	// column: entry i of each output is what the single note version returns
+	// for entry i of the inputs.  Each mod is applied to the whole run in one
+	// loop, the parts that only depend on the column are worked out once, and
+	// a group of mods that is off is skipped with one test.  Outputs must not
+	// overlap inputs.  The single note versions are just runs of one.
+	static void GetYOffsets( const PlayerState* pPlayerState, int iCol, const float *pNoteBeats, int iCount, float *pYOffsetsOut, float *pPeakYOffsetsOut=nullptr, bool *pIsPastPeakOut=nullptr, bool bAbsolute=false );
+	static void GetXPositions( const PlayerState* pPlayerState, int iCol, const float *pYOffsets, int iCount, float *pXPosOut );
+	static void GetYPositions( const PlayerState* pPlayerState, int iCol, const float *pYOffsets, int iCount, float *pYPosOut, float fYReverseOffsetPixels, bool WithReverse = true );
+	static void GetZPositions( const PlayerState* pPlayerState, int iCol, const float *pYOffsets, int iCount, float *pZPosOut );
+	static void GetRotationsX( const PlayerState* pPlayerState, const float *pYOffsets, int iCount, bool bIsHoldCap, int iCol, float *pRotationOut );
+	static void GetRotationsY( const PlayerState* pPlayerState, const float *pYOffsets, int iCount, int iCol, float *pRotationOut );
+	static void GetRotationsZ( const PlayerState* pPlayerState, const float *pNoteBeats, int iCount, bool bIsHoldHead, int iCol, float *pRotationOut );
+	// Alpha and glow share most of their work.  Either output may be null.
+	static void GetAlphasAndGlows( const PlayerState* pPlayerState, int iCol, const float *pYOffsets, const float *pPercentFadeToFail, int iCount, float fYReverseOffsetPixels, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar, float *pAlphaOut, float *pGlowOut );
+	static void GetZooms( const PlayerState* pPlayerState, const float *pYOffsets, int iCount, int iCol, float *pZoomOut );
 };
 
 #endif
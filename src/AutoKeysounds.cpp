@@ -28,6 +28,7 @@
 #include "RageSoundReader_PostBuffering.h"
 #include "RageSoundReader_ThreadedBuffer.h"
 #include "RageSoundManager.h"
+#include "RageSoundPCMCache.h"
 #include "RageLog.h"
 #include "RageSoundReader_FileReader.h"
 
@@ -131,8 +132,14 @@ void AutoKeysounds::LoadTracks( const Song *pSong, RageSoundReader *&pShared, Ra
 	std::vector<RageSoundReader *> vpSounds;
 	for (RString const &s : vsMusicFile)
 	{
-		RString sError;
-		RageSoundReader *pSongReader = RageSoundReader_FileReader::OpenFile( s, sError );
+		RageSoundReader *pSongReader = nullptr;
+		if( PCMCACHE != nullptr )
+			pSongReader = PCMCACHE->Open( s );
+		if( pSongReader == nullptr )
+		{
+			RString sError;
+			pSongReader = RageSoundReader_FileReader::OpenFile( s, sError );
+		}
 		vpSounds.push_back( pSongReader );
 	}
 
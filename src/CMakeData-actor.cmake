@@ -17,6 +17,7 @@ list(APPEND SMDATA_ACTOR_BASE_SRC
             "Quad.cpp"
             "RollingNumbers.cpp"
             "Sprite.cpp"
+            "SpriteBatch.cpp"
             "Tween.cpp")
 list(APPEND SMDATA_ACTOR_BASE_HPP
             "Actor.h"
@@ -37,6 +38,7 @@ list(APPEND SMDATA_ACTOR_BASE_HPP
             "Quad.h"
             "RollingNumbers.h"
             "Sprite.h"
+            "SpriteBatch.h"
             "Tween.h")
 
 source_group("Actors\\\\Base"
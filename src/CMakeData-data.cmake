@@ -125,6 +125,7 @@ source_group("Data Structures\\\\Score Keepers"
 
 list(APPEND SM_DATA_SONG_SRC
             "Song.cpp"
+            "SongCacheBinary.cpp"
             "SongCacheIndex.cpp"
             "SongOptions.cpp"
             "SongPosition.cpp"
@@ -132,6 +133,7 @@ list(APPEND SM_DATA_SONG_SRC
 
 list(APPEND SM_DATA_SONG_HPP
             "Song.h"
+            "SongCacheBinary.h"
             "SongCacheIndex.h"
             "SongOptions.h"
             "SongPosition.h"
@@ -217,6 +219,7 @@ list(APPEND SM_DATA_REST_HPP
             "BackgroundUtil.h"
             "ImageCache.h"
             "Character.h"
+            "ChartDensity.h"
             "CodeDetector.h"
             "CodeSet.h"
             "Command.h"
@@ -5,6 +5,7 @@ list(APPEND SMDATA_RAGE_UTILS_SRC
             "RageUtil_BackgroundLoader.cpp"
             "RageUtil_CharConversions.cpp"
             "RageUtil_FileDB.cpp"
+            "RageUtil_WorkerPool.cpp"
             "RageUtil_WorkerThread.cpp")
 
 list(APPEND SMDATA_RAGE_UTILS_HPP
@@ -15,6 +16,7 @@ list(APPEND SMDATA_RAGE_UTILS_HPP
             "RageUtil_CharConversions.h"
             "RageUtil_CircularBuffer.h"
             "RageUtil_FileDB.h"
+            "RageUtil_WorkerPool.h"
             "RageUtil_WorkerThread.h")
 
 source_group("Rage\\\\Utils"
@@ -26,6 +28,8 @@ list(APPEND SMDATA_RAGE_MISC_SRC
             "RageException.cpp"
             "RageInput.cpp"
             "RageInputDevice.cpp"
+            "RageLatency.cpp"
+            "RageProfiler.cpp"
             "RageLog.cpp"
             "RageMath.cpp"
             "RageTypes.cpp"
@@ -36,6 +40,8 @@ list(APPEND SMDATA_RAGE_MISC_HPP
             "RageException.h"
             "RageInput.h"
             "RageInputDevice.h"
+            "RageLatency.h"
+            "RageProfiler.h"
             "RageLog.h"
             "RageMath.h"
             "RageTypes.h"
@@ -155,6 +161,8 @@ list(APPEND SMDATA_RAGE_SOUND_SRC
             "RageSound.cpp"
             "RageSoundManager.cpp"
             "RageSoundMixBuffer.cpp"
+            "RageSoundMixKernels.cpp"
+            "RageSoundPCMCache.cpp"
             "RageSoundPosMap.cpp"
             "RageSoundReader.cpp"
             "RageSoundReader_Chain.cpp"
@@ -162,6 +170,7 @@ list(APPEND SMDATA_RAGE_SOUND_SRC
             "RageSoundReader_Extend.cpp"
             "RageSoundReader_FileReader.cpp"
             "RageSoundReader_MP3.cpp"
+            "RageSoundReader_MappedPCM.cpp"
             "RageSoundReader_Merge.cpp"
             "RageSoundReader_Pan.cpp"
             "RageSoundReader_PitchChange.cpp"
@@ -172,12 +181,15 @@ list(APPEND SMDATA_RAGE_SOUND_SRC
             "RageSoundReader_ThreadedBuffer.cpp"
             "RageSoundReader_Vorbisfile.cpp"
             "RageSoundReader_WAV.cpp"
+            "RageSoundReader_WSOLA.cpp"
             "RageSoundUtil.cpp")
 
 list(APPEND SMDATA_RAGE_SOUND_HPP
             "RageSound.h"
             "RageSoundManager.h"
             "RageSoundMixBuffer.h"
+            "RageSoundMixKernels.h"
+            "RageSoundPCMCache.h"
             "RageSoundPosMap.h"
             "RageSoundReader.h"
             "RageSoundReader_Chain.h"
@@ -186,6 +198,7 @@ list(APPEND SMDATA_RAGE_SOUND_HPP
             "RageSoundReader_FileReader.h"
             "RageSoundReader_Filter.h"
             "RageSoundReader_MP3.h"
+            "RageSoundReader_MappedPCM.h"
             "RageSoundReader_Merge.h"
             "RageSoundReader_Pan.h"
             "RageSoundReader_PitchChange.h"
@@ -194,8 +207,10 @@ list(APPEND SMDATA_RAGE_SOUND_HPP
             "RageSoundReader_Resample_Good.h"
             "RageSoundReader_SpeedChange.h"
             "RageSoundReader_ThreadedBuffer.h"
+            "RageSoundReader_TimeStretch.h"
             "RageSoundReader_Vorbisfile.h"
             "RageSoundReader_WAV.h"
+            "RageSoundReader_WSOLA.h"
             "RageSoundUtil.h")
 
 source_group("Rage\\\\Sound"
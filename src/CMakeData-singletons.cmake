@@ -6,6 +6,7 @@ list(APPEND SMDATA_GLOBAL_SINGLETON_SRC
             "CryptManager.cpp"
             "FontManager.cpp"
             "GameManager.cpp"
+            "GameplayBenchmark.cpp"
             "GameSoundManager.cpp"
             "GameState.cpp"
             "InputFilter.cpp"
@@ -32,6 +33,7 @@ list(APPEND SMDATA_GLOBAL_SINGLETON_HPP
             "CryptManager.h"
             "FontManager.h"
             "GameManager.h"
+            "GameplayBenchmark.h"
             "GameSoundManager.h"
             "GameState.h"
             "InputFilter.h"
@@ -0,0 +1,49 @@
+#ifndef CHART_DENSITY_H
+#define CHART_DENSITY_H
+
+#include <vector>
+
+/** @brief A measure with at least this many note rows counts as stream. */
+const int STREAM_NOTES_PER_MEASURE = 16;
+
+/**
+ * @brief How a chart's notes are spread out over time.
+ *
+ * A measure is 4 beats, regardless of the time signature, so that measure
+ * numbers line up with what players count in stream breakdowns. Only rows
+ * with a tap, hold head or lift count as notes, and jumps count once. */
+struct ChartDensity
+{
+	/** @brief A run of consecutive stream measures, or of consecutive break measures. */
+	struct Run
+	{
+		Run(): m_bStream(false), m_iFirstMeasure(0), m_iNumMeasures(0) { }
+		Run( bool bStream, int iFirstMeasure, int iNumMeasures ):
+			m_bStream(bStream), m_iFirstMeasure(iFirstMeasure), m_iNumMeasures(iNumMeasures) { }
+
+		bool m_bStream;
+		int m_iFirstMeasure;
+		int m_iNumMeasures;
+	};
+
+	ChartDensity(): m_fPeakNPS(0) { }
+
+	void Clear()
+	{
+		m_viNotesPerMeasure.clear();
+		m_vfNPSPerMeasure.clear();
+		m_vRuns.clear();
+		m_fPeakNPS = 0;
+	}
+
+	/** @brief The number of note rows in each measure, starting from beat 0. */
+	std::vector<int> m_viNotesPerMeasure;
+	/** @brief The notes per second of each measure, using the chart's timing. */
+	std::vector<float> m_vfNPSPerMeasure;
+	/** @brief Stream and break runs, from the first measure with notes to the last. */
+	std::vector<Run> m_vRuns;
+	/** @brief The highest value in m_vfNPSPerMeasure. */
+	float m_fPeakNPS;
+};
+
+#endif
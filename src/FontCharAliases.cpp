@@ -68,11 +68,8 @@ And here's one for a kanji page:
 
  */
 
-static void InitCharAliases()
+static bool LoadCharAliases()
 {
-	if(!CharAliases.empty())
-		return;
-
 	CharAliases["default"]		= FONT_DEFAULT_GLYPH;	// ?
 	CharAliases["invalid"]		= INVALID_CHAR;			// 0xFFFD
 
@@ -367,6 +364,14 @@ static void InitCharAliases()
 		from.MakeLower();
 		CharAliasRepl[from] = to;
 	}
+	return true;
+}
+
+/* Titles are translated while songs load, which may happen on several
+ * threads at once; a function-local static is only initialized once. */
+static void InitCharAliases()
+{
+	[[maybe_unused]] static const bool bLoaded = LoadCharAliases();
 }
 
 // Replace all &markers; and &#NNNN;s with UTF-8.
@@ -20,6 +20,9 @@
 #include "LightsManager.h"
 #include "RageTimer.h"
 #include "RageInput.h"
+#include "RageLatency.h"
+#include "RageProfiler.h"
+#include "GameplayBenchmark.h"
 
 #include <cmath>
 #include <vector>
@@ -272,6 +275,7 @@ void GameLoop::UpdateAllButDraw(bool bRunningFromVBLANK)
 		fDeltaTime = g_fConstantUpdateDeltaSeconds;
 
 	CheckGameLoopTimerSkips(fDeltaTime);
+	RageLatency::Update();
 
 	fDeltaTime *= g_fUpdateRate;
 
@@ -281,15 +285,30 @@ void GameLoop::UpdateAllButDraw(bool bRunningFromVBLANK)
 	/* Update song beat information -before- calling update on all the classes that
 	* depend on it. If you don't do this first, the classes are all acting on old
 	* information and will lag. (but no longer fatally, due to timestamping -glenn) */
-	SOUND->Update(fDeltaTime);
-	TEXTUREMAN->Update(fDeltaTime);
-	GAMESTATE->Update(fDeltaTime);
-	SCREENMAN->Update(fDeltaTime);
+	{
+		ProfileScope scope( ProfilePhase_Update, "Sound" );
+		SOUND->Update(fDeltaTime);
+	}
+	{
+		ProfileScope scope( ProfilePhase_Update, "Textures" );
+		TEXTUREMAN->Update(fDeltaTime);
+	}
+	{
+		ProfileScope scope( ProfilePhase_Update, "GameState" );
+		GAMESTATE->Update(fDeltaTime);
+	}
+	{
+		ProfileScope scope( ProfilePhase_Update, "Screens" );
+		SCREENMAN->Update(fDeltaTime);
+	}
 	MEMCARDMAN->Update();
 
 	/* Important: Process input AFTER updating game logic, or input will be
 	* acting on song beat from last frame */
-	HandleInputEvents(fDeltaTime);
+	{
+		ProfileScope scope( ProfilePhase_Input );
+		HandleInputEvents(fDeltaTime);
+	}
 
 	//bandaid for low max audio sample counter
 	SOUNDMAN->low_sample_count_workaround();
@@ -319,6 +338,7 @@ void GameLoop::RunGameLoop()
 
 		CheckFocus();
 
+		RageProfiler::BeginFrame();
 		UpdateAllButDraw(false);
 
 		if( INPUTMAN->DevicesChanged() )
@@ -331,6 +351,7 @@ void GameLoop::RunGameLoop()
 		}
 
 		SCREENMAN->Draw();
+		GameplayBenchmark::EndFrame();
 	}
 
 	// If we ended mid-game, finish up.
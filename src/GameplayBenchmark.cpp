@@ -0,0 +1,357 @@
+#include "global.h"
+#include "GameplayBenchmark.h"
+#include "GameManager.h"
+#include "GameState.h"
+#include "Preference.h"
+#include "RageFile.h"
+#include "RageLog.h"
+#include "RageProfiler.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+#include "Screen.h"
+#include "ScreenManager.h"
+#include "Song.h"
+#include "SongManager.h"
+#include "SongUtil.h"
+#include "Steps.h"
+#include "Style.h"
+#include "XmlFile.h"
+#include "arch/ArchHooks/ArchHooks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(ALLOCATION_COUNTS)
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/* Counts every operator new in the process, from any thread, so it's only
+ * built in with WITH_ALLOCATION_COUNTS. */
+static std::atomic<std::uint64_t> g_iAllocations( 0 );
+
+void *operator new( std::size_t iSize )
+{
+	g_iAllocations.fetch_add( 1, std::memory_order_relaxed );
+	void *p = std::malloc( iSize? iSize:1 );
+	if( p == nullptr )
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete( void *p ) noexcept
+{
+	std::free( p );
+}
+
+void operator delete( void *p, std::size_t ) noexcept
+{
+	std::free( p );
+}
+#endif
+
+static const RString GAMEPLAY_SCREEN = "ScreenGameplay";
+
+namespace
+{
+	struct Chart
+	{
+		RString m_sSongDir;
+		Difficulty m_Difficulty;
+	};
+
+	struct ChartResult
+	{
+		RString m_sSongDir;
+		Difficulty m_Difficulty;
+		float m_fSongLoadSeconds;
+		float m_fScreenLoadSeconds;
+		std::vector<float> m_vFrameSeconds;
+		std::vector<float> m_vPhaseSeconds[NUM_ProfilePhase];
+		std::vector<float> m_vAllocations;
+	};
+
+	enum State
+	{
+		STATE_IDLE,
+		STATE_LOADING,	// waiting for the gameplay screen to come up
+		STATE_PLAYING
+	};
+
+	State g_State = STATE_IDLE;
+	int g_iFramesPerSecond = 60;
+	RString g_sOutPath = "/Logs/Benchmark.json";
+	float g_fStartupSeconds = 0;
+
+	std::vector<Chart> g_vCharts;
+	unsigned g_iCurrentChart = 0;
+	std::vector<ChartResult> g_vResults;
+
+	RageTimer g_LoadTimer;
+	RageTimer g_FrameStart;
+	RageTimer g_NextFrame;
+	std::vector<ProfileEvent> g_vEvents;
+
+	std::uint64_t GetAllocations()
+	{
+#if defined(ALLOCATION_COUNTS)
+		return g_iAllocations.load( std::memory_order_relaxed );
+#else
+		return 0;
+#endif
+	}
+	std::uint64_t g_iAllocationsAtFrameStart = 0;
+}
+
+bool GameplayBenchmark::IsActive()
+{
+	return GetCommandlineArgument( "benchmark" );
+}
+
+void GameplayBenchmark::ApplyPreferences()
+{
+	RString sArg;
+	if( GetCommandlineArgument("benchmark-fps", &sArg) )
+	{
+		g_iFramesPerSecond = StringToInt( sArg );
+		if( g_iFramesPerSecond <= 0 )
+			RageException::Throw( "Invalid argument \"--benchmark-fps=%s\".", sArg.c_str() );
+	}
+	if( GetCommandlineArgument("benchmark-out", &sArg) )
+		g_sOutPath = sArg;
+
+	/* Read these like Static.ini, so they're never written back to
+	 * Preferences.ini when something saves preferences. */
+	XNode prefs( "Options" );
+	prefs.AppendAttr( "VideoRenderers", RString("null") );
+	prefs.AppendAttr( "SoundDrivers", RString("Null") );
+	prefs.AppendAttr( "ShowLoadingWindow", RString("0") );
+	prefs.AppendAttr( "EventMode", RString("1") );
+	prefs.AppendAttr( "AutoPlay", PlayerControllerToString(PC_AUTOPLAY) );
+	prefs.AppendAttr( "ConstantUpdateDeltaSeconds", 1.0f / g_iFramesPerSecond );
+	prefs.AppendAttr( "RefreshRate", g_iFramesPerSecond );
+	IPreference::ReadAllPrefsFromNode( &prefs, true );
+}
+
+static void LoadChartList( const RString &sPath )
+{
+	std::vector<RString> asLines;
+	if( !GetFileContents(sPath, asLines) )
+		RageException::Throw( "Couldn't read benchmark list \"%s\".", sPath.c_str() );
+
+	for( RString sLine : asLines )
+	{
+		TrimLeft( sLine );
+		TrimRight( sLine );
+		if( sLine.empty() || sLine[0] == '#' )
+			continue;
+
+		const std::size_t iSpace = sLine.find( ' ' );
+		if( iSpace == RString::npos )
+			RageException::Throw( "Benchmark list line \"%s\" should be a difficulty and a song directory.", sLine.c_str() );
+
+		Chart chart;
+		chart.m_Difficulty = StringToDifficulty( sLine.substr(0, iSpace) );
+		chart.m_sSongDir = sLine.substr( iSpace+1 );
+		TrimLeft( chart.m_sSongDir );
+		if( chart.m_Difficulty == Difficulty_Invalid )
+			RageException::Throw( "Benchmark list line \"%s\" has an unknown difficulty.", sLine.c_str() );
+		g_vCharts.push_back( chart );
+	}
+
+	if( g_vCharts.empty() )
+		RageException::Throw( "Benchmark list \"%s\" is empty.", sPath.c_str() );
+}
+
+static void StartChart()
+{
+	const Chart &chart = g_vCharts[g_iCurrentChart];
+	Song *pSong = SONGMAN->GetSongFromDir( chart.m_sSongDir );
+	if( pSong == nullptr )
+		RageException::Throw( "Benchmark song \"%s\" isn't loaded.", chart.m_sSongDir.c_str() );
+
+	std::vector<const Style*> vpStyles;
+	GAMEMAN->GetCompatibleStyles( GAMESTATE->GetCurrentGame(), 1, vpStyles );
+	ASSERT( !vpStyles.empty() );
+	const Style *pStyle = vpStyles[0];
+
+	Steps *pSteps = SongUtil::GetStepsByDifficulty( pSong, pStyle->m_StepsType, chart.m_Difficulty, false );
+	if( pSteps == nullptr )
+		RageException::Throw( "Benchmark song \"%s\" has no %s chart.", chart.m_sSongDir.c_str(), DifficultyToString(chart.m_Difficulty).c_str() );
+
+	ChartResult result;
+	result.m_sSongDir = pSong->GetSongDir();
+	result.m_Difficulty = chart.m_Difficulty;
+
+	// Load a copy, to time what the song loading at startup costs.
+	{
+		RageTimer timer;
+		Song song;
+		song.LoadFromSongDir( pSong->GetSongDir() );
+		result.m_fSongLoadSeconds = timer.GetDeltaTime();
+	}
+	g_vResults.push_back( result );
+
+	if( GAMESTATE->GetNumSidesJoined() == 0 )
+		GAMESTATE->JoinPlayer( PLAYER_1 );
+	GAMESTATE->SetCurrentStyle( pStyle, PLAYER_INVALID );
+	GAMESTATE->m_PlayMode.Set( PLAY_MODE_REGULAR );
+	GAMESTATE->m_pCurSong.Set( pSong );
+	GAMESTATE->m_pCurSteps[PLAYER_1].Set( pSteps );
+
+	LOG->Info( "Benchmark: %s %s", DifficultyToString(chart.m_Difficulty).c_str(), result.m_sSongDir.c_str() );
+	g_LoadTimer.Touch();
+	g_State = STATE_LOADING;
+	SCREENMAN->SetNewScreen( GAMEPLAY_SCREEN );
+}
+
+static RString GetStatsJson( std::vector<float> v, float fScale )
+{
+	if( v.empty() )
+		return "null";
+
+	std::sort( v.begin(), v.end() );
+	float fTotal = 0;
+	for( float f : v )
+		fTotal += f;
+	auto Percentile = [&]( float fPercent ) {
+		const int i = std::max( 0, int(std::ceil(v.size() * fPercent / 100)) - 1 );
+		return v[i] * fScale;
+	};
+	return ssprintf( "{\"Average\":%.3f,\"P50\":%.3f,\"P95\":%.3f,\"P99\":%.3f,\"Max\":%.3f}",
+		fTotal / v.size() * fScale, Percentile(50), Percentile(95), Percentile(99), v.back() * fScale );
+}
+
+static void WriteResults()
+{
+	RageFile f;
+	if( !f.Open(g_sOutPath, RageFile::WRITE) )
+	{
+		LOG->Warn( "Couldn't write benchmark results to %s: %s", g_sOutPath.c_str(), f.GetError().c_str() );
+		return;
+	}
+
+	f.PutLine( "{" );
+	f.PutLine( ssprintf("\"StartupSeconds\":%.3f,", g_fStartupSeconds) );
+	f.PutLine( ssprintf("\"FramesPerSecond\":%i,", g_iFramesPerSecond) );
+	f.PutLine( "\"Charts\":[" );
+	for( unsigned i = 0; i < g_vResults.size(); ++i )
+	{
+		const ChartResult &r = g_vResults[i];
+		RString sPhases;
+		FOREACH_ENUM( ProfilePhase, p )
+		{
+			if( !sPhases.empty() )
+				sPhases += ",";
+			sPhases += ssprintf( "\"%s\":%s", ProfilePhaseToString(p).c_str(), GetStatsJson(r.m_vPhaseSeconds[p], 1000).c_str() );
+		}
+
+		RString sSongDir = r.m_sSongDir;
+		sSongDir.Replace( "\\", "\\\\" );
+		sSongDir.Replace( "\"", "\\\"" );
+
+		f.PutLine( ssprintf("{\"Song\":\"%s\",\"Difficulty\":\"%s\",\"SongLoadSeconds\":%.3f,\"ScreenLoadSeconds\":%.3f,\"Frames\":%i,",
+			sSongDir.c_str(), DifficultyToString(r.m_Difficulty).c_str(),
+			r.m_fSongLoadSeconds, r.m_fScreenLoadSeconds, (int) r.m_vFrameSeconds.size()) );
+		f.PutLine( ssprintf("\"FrameMilliseconds\":%s,", GetStatsJson(r.m_vFrameSeconds, 1000).c_str()) );
+		f.PutLine( ssprintf("\"PhaseMilliseconds\":{%s},", sPhases.c_str()) );
+#if defined(ALLOCATION_COUNTS)
+		f.PutLine( ssprintf("\"AllocationsPerFrame\":%s}%s", GetStatsJson(r.m_vAllocations, 1).c_str(), i+1 < g_vResults.size()? ",":"") );
+#else
+		f.PutLine( ssprintf("\"AllocationsPerFrame\":null}%s", i+1 < g_vResults.size()? ",":"") );
+#endif
+	}
+	f.PutLine( "]}" );
+
+	if( f.Flush() == -1 )
+		LOG->Warn( "Couldn't write benchmark results to %s: %s", g_sOutPath.c_str(), f.GetError().c_str() );
+	else
+		LOG->Info( "Wrote benchmark results to %s", g_sOutPath.c_str() );
+}
+
+void GameplayBenchmark::Start()
+{
+	g_fStartupSeconds = RageTimer::GetTimeSinceStart();
+
+	RString sList;
+	GetCommandlineArgument( "benchmark", &sList );
+	LoadChartList( sList );
+
+	RageProfiler::SetEnabled( true );
+	g_iCurrentChart = 0;
+	StartChart();
+
+	g_FrameStart.Touch();
+	g_NextFrame.Touch();
+	g_iAllocationsAtFrameStart = GetAllocations();
+}
+
+static void RecordFrame( ChartResult &r )
+{
+	r.m_vFrameSeconds.push_back( g_FrameStart.Ago() );
+	r.m_vAllocations.push_back( float(GetAllocations() - g_iAllocationsAtFrameStart) );
+
+	// Only the outermost scopes, so nested ones aren't counted twice.
+	std::int64_t iStart, iEnd;
+	RageProfiler::GetLastFrame( g_vEvents, iStart, iEnd );
+	float fPhaseSeconds[NUM_ProfilePhase] = { 0 };
+	for( const ProfileEvent &e : g_vEvents )
+	{
+		if( e.m_iDepth == 0 )
+			fPhaseSeconds[e.m_Phase] += (e.m_iEndMicroseconds - e.m_iStartMicroseconds) / 1000000.0f;
+	}
+	FOREACH_ENUM( ProfilePhase, p )
+		r.m_vPhaseSeconds[p].push_back( fPhaseSeconds[p] );
+}
+
+void GameplayBenchmark::EndFrame()
+{
+	if( g_State == STATE_IDLE )
+		return;
+
+	const Screen *pTop = SCREENMAN->GetTopScreen();
+	const bool bInGameplay = pTop != nullptr && pTop->GetName() == GAMEPLAY_SCREEN;
+	ChartResult &r = g_vResults.back();
+	switch( g_State )
+	{
+	case STATE_LOADING:
+		if( bInGameplay )
+		{
+			r.m_fScreenLoadSeconds = g_LoadTimer.Ago();
+			g_State = STATE_PLAYING;
+		}
+		break;
+	case STATE_PLAYING:
+		if( bInGameplay )
+		{
+			RecordFrame( r );
+			break;
+		}
+
+		// The chart is over.
+		if( ++g_iCurrentChart < g_vCharts.size() )
+		{
+			StartChart();
+			break;
+		}
+		g_State = STATE_IDLE;
+		RageProfiler::SetEnabled( false );
+		WriteResults();
+		ArchHooks::SetUserQuit();
+		return;
+	default:
+		break;
+	}
+
+	// Wait out the rest of the frame, as vsync would.
+	g_NextFrame += 1.0f / g_iFramesPerSecond;
+	const float fWait = -g_NextFrame.Ago();
+	if( fWait > 0 )
+		usleep( std::lrint(fWait * 1000000) );
+	else if( fWait < -0.1f )
+		g_NextFrame.Touch(); // far behind; don't try to catch up
+	g_FrameStart.Touch();
+	g_iAllocationsAtFrameStart = GetAllocations();
+}
@@ -0,0 +1,28 @@
+/* GameplayBenchmark - Plays a fixed list of charts on autoplay and reports frame times. */
+
+#ifndef GAMEPLAY_BENCHMARK_H
+#define GAMEPLAY_BENCHMARK_H
+
+/* Started with --benchmark=<list>, where each line of the list is a
+ * difficulty and a song directory, eg. "Hard /Songs/Group/Song/".  The game
+ * runs on the null renderer and sound driver, so no GPU or sound card is
+ * needed, plays each chart in turn, writes the results as JSON to
+ * --benchmark-out (default /Logs/Benchmark.json) and quits.
+ *
+ * Frames are paced to --benchmark-fps (default 60) and each update is given
+ * exactly one frame's time. */
+namespace GameplayBenchmark
+{
+	bool IsActive();
+
+	/* Switch to the null drivers.  Call once preferences are loaded. */
+	void ApplyPreferences();
+
+	/* Called instead of going to the initial screen. */
+	void Start();
+
+	/* Called by the game loop after each frame is drawn. */
+	void EndFrame();
+}
+
+#endif
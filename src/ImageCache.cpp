@@ -18,12 +18,22 @@
 #include "RageSurfaceUtils_Zoom.h"
 #include "SpecialFiles.h"
 #include "Banner.h"
+#include "RageUtil_WorkerPool.h"
+#include "arch/LoadingWindow/LoadingWindow.h"
+#include "LocalizedString.h"
 
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <set>
 
 static Preference<bool> g_bPalettedImageCache( "PalettedImageCache", false );
+/* The number of threads that create cache files during a batch.  0 means one
+ * per CPU core; 1 creates them one at a time on the thread that asks.  This
+ * defaults to 1, like SongLoadThreads: the two run at the same time, so
+ * raise them together with the cores available in mind. */
+static Preference<int> g_iImageCacheThreads( "ImageCacheThreads", 1 );
 
 /* Neither a global or a file scope static can be used for this because
  * the order of initialization of nonlocal objects is unspecified. */
@@ -55,6 +65,18 @@ ImageCache *IMAGECACHE; // global and accessible from anywhere in our program
 static std::map<RString, RageSurface*> g_ImagePathToImage;
 static int g_iDemandRefcount = 0;
 
+/* Songs may be loaded from several threads at once, and they cache their
+ * images as they go.  Lock before touching ImageData, g_ImagePathToImage or
+ * the batch state below.  Images are decoded and scaled without the lock. */
+static RageMutex g_ImageCacheMutex( "ImageCache" );
+
+/* While a batch is running, images waiting to be cached are queued here. */
+static RageWorkerPool *g_pCachePool = nullptr;
+static std::set<RString> g_PendingImages;
+
+static void UnloadAtlasPages();
+static void ForgetAtlasImage( const RString &sImagePath );
+
 RString ImageCache::GetImageCachePath( RString sImageDir ,RString sImagePath )
 {
 	return SongCacheIndex::GetCacheFilePath( sImageDir, sImagePath );
@@ -65,6 +87,7 @@ RString ImageCache::GetImageCachePath( RString sImageDir ,RString sImagePath )
  * by CacheImage or LoadImage on startup. */
 void ImageCache::Demand( RString sImageDir )
 {
+	LockMut( g_ImageCacheMutex );
 	++g_iDemandRefcount;
 	if( g_iDemandRefcount > 1 )
 		return;
@@ -93,6 +116,7 @@ void ImageCache::Demand( RString sImageDir )
 /* Release images loaded on demand. */
 void ImageCache::Undemand( RString sImageDir )
 {
+	LockMut( g_ImageCacheMutex );
 	--g_iDemandRefcount;
 	if( g_iDemandRefcount != 0 )
 		return;
@@ -115,42 +139,41 @@ void ImageCache::LoadImage( RString sImageDir, RString sImagePath )
 	    PREFSMAN->m_ImageCache != IMGCACHE_LOW_RES_LOAD_ON_DEMAND )
 		return;
 
-	/* Load it. */
-	const RString sCachePath = GetImageCachePath(sImageDir,sImagePath);
-
-	for( int tries = 0; tries < 2; ++tries )
 	{
+		LockMut( g_ImageCacheMutex );
 		if( g_ImagePathToImage.find(sImagePath) != g_ImagePathToImage.end() )
 			return; /* already loaded */
+		if( g_PendingImages.find(sImagePath) != g_PendingImages.end() )
+			return; /* being cached, and will be loaded when it's done */
+	}
 
-		CHECKPOINT_M( ssprintf( "ImageCache::LoadImage: %s", sCachePath.c_str() ) );
-		RageSurface *pImage = RageSurfaceUtils::LoadSurface( sCachePath );
-		if( pImage == nullptr )
-		{
-			if( tries == 0 )
-			{
-				/* The file doesn't exist.  It's possible that the image cache file is
-				 * missing, so try to create it.  Don't do this first, for efficiency. */
-				//LOG->Trace( "Cached image load of '%s' ('%s') failed, trying to cache ...", sImagePath.c_str(), sCachePath.c_str() );
-
-				/* Skip the up-to-date check; it failed to load, so it can't be up
-				 * to date. */
-				CacheImageInternal( sImageDir, sImagePath );
-				continue;
-			}
-			else
-			{
-				//LOG->Trace( "Cached image load of '%s' ('%s') failed", sImagePath.c_str(), sCachePath.c_str() );
-				return;
-			}
-		}
+	/* Load it. */
+	const RString sCachePath = GetImageCachePath(sImageDir,sImagePath);
+	CHECKPOINT_M( ssprintf( "ImageCache::LoadImage: %s", sCachePath.c_str() ) );
+	RageSurface *pImage = RageSurfaceUtils::LoadSurface( sCachePath );
+	if( pImage == nullptr )
+	{
+		/* The file doesn't exist.  It's possible that the image cache file is
+		 * missing, so try to create it.  Don't do this first, for efficiency.
+		 * Skip the up-to-date check; it failed to load, so it can't be up
+		 * to date. */
+		QueueCacheImage( sImageDir, sImagePath, true );
+		return;
+	}
 
-		g_ImagePathToImage[sImagePath] = pImage;
+	LockMut( g_ImageCacheMutex );
+	if( g_ImagePathToImage.find(sImagePath) != g_ImagePathToImage.end() )
+	{
+		/* Another thread loaded it while we did. */
+		delete pImage;
+		return;
 	}
+	g_ImagePathToImage[sImagePath] = pImage;
 }
 
 void ImageCache::OutputStats() const
 {
+	LockMut( g_ImageCacheMutex );
 	int iTotalSize = 0;
 	for (auto const &it : g_ImagePathToImage)
 	{
@@ -179,11 +202,13 @@ ImageCache::ImageCache()
 
 ImageCache::~ImageCache()
 {
+	UnloadAtlasPages();
 	UnloadAllImages();
 }
 
 void ImageCache::ReadFromDisk()
 {
+	LockMut( g_ImageCacheMutex );
 	ImageData.ReadFile( IMAGE_CACHE_INDEX );	// don't care if this fails
 }
 
@@ -269,9 +294,279 @@ struct ImageTexture: public RageTexture
 	}
 };
 
+/* In atlas mode, cached images are packed into a few large textures, one size
+ * of image per page, instead of each getting a texture of its own.  The music
+ * wheel then doesn't create a texture for every banner that scrolls by, and
+ * draws them all from the same few textures.  Images that don't fit get an
+ * ImageTexture as usual.  Effects that scroll texture coordinates, like
+ * texcoordvelocity, show the neighboring images, so this is off by default. */
+static Preference<bool> g_bImageCacheAtlas( "ImageCacheAtlas", false );
+static const int ATLAS_PAGE_SIZE = 2048;
+static const int MAX_ATLAS_PAGES_PER_SIZE = 4;
+
+struct AtlasTexture;
+
+/* One page of the atlas.  Pages are registered with TEXTUREMAN so they hear
+ * about lost rendering contexts, and g_AtlasPages holds their only reference. */
+struct AtlasPage: public RageTexture
+{
+	struct Cell
+	{
+		Cell(): m_pOwner(nullptr), m_iLastUsed(0) { }
+		RString m_sImagePath;	/* the image in this cell, or empty */
+		RString m_sCachePath;	/* its cache file, to reload it from */
+		AtlasTexture *m_pOwner;	/* the texture using this cell, if any */
+		unsigned m_iLastUsed;
+	};
+
+	std::uintptr_t m_uTexHandle;
+	int m_iCellWidth, m_iCellHeight;
+	int m_iColumns;
+	std::vector<Cell> m_Cells;
+
+	AtlasPage( RageTextureID id, int iCellWidth, int iCellHeight, int iPageSize ):
+		RageTexture(id), m_uTexHandle(0), m_iCellWidth(iCellWidth), m_iCellHeight(iCellHeight)
+	{
+		m_iSourceWidth = m_iTextureWidth = m_iImageWidth = iPageSize;
+		m_iSourceHeight = m_iTextureHeight = m_iImageHeight = iPageSize;
+		m_iColumns = iPageSize / iCellWidth;
+		m_Cells.resize( m_iColumns * (iPageSize / iCellHeight) );
+		Create();
+	}
+
+	~AtlasPage();
+
+	std::uintptr_t GetTexHandle() const { return m_uTexHandle; }
+
+	void Create();
+
+	void Destroy()
+	{
+		if( m_uTexHandle )
+			DISPLAY->DeleteTexture( m_uTexHandle );
+		m_uTexHandle = 0;
+	}
+
+	void Reload()
+	{
+		Destroy();
+		Create();
+	}
+
+	void Invalidate()
+	{
+		m_uTexHandle = 0; /* don't Destroy() */
+	}
+
+	void GetCellOrigin( int iCell, int &iX, int &iY ) const
+	{
+		iX = (iCell % m_iColumns) * m_iCellWidth;
+		iY = (iCell / m_iColumns) * m_iCellHeight;
+	}
+
+	void Upload( int iCell, RageSurface *pImage )
+	{
+		int iX, iY;
+		GetCellOrigin( iCell, iX, iY );
+		DISPLAY->UpdateTexture( m_uTexHandle, pImage, iX, iY, pImage->w, pImage->h );
+	}
+};
+
+static std::vector<AtlasPage *> g_AtlasPages;
+static unsigned g_iAtlasClock = 0;
+
+/* A cached image that lives in one cell of an AtlasPage. */
+struct AtlasTexture: public RageTexture
+{
+	AtlasPage *m_pPage;
+	int m_iCell;
+
+	AtlasTexture( RageTextureID id, AtlasPage *pPage, int iCell, int iWidth, int iHeight ):
+		RageTexture(id), m_pPage(pPage), m_iCell(iCell)
+	{
+		/* The source width is the width of the original file. */
+		m_iSourceWidth = iWidth;
+		m_iSourceHeight = iHeight;
+		m_iImageWidth = pPage->m_iCellWidth;
+		m_iImageHeight = pPage->m_iCellHeight;
+		m_iTextureWidth = pPage->GetTextureWidth();
+		m_iTextureHeight = pPage->GetTextureHeight();
+		pPage->GetCellOrigin( iCell, m_iImageOffsetX, m_iImageOffsetY );
+		pPage->m_Cells[iCell].m_pOwner = this;
+
+		CreateFrameRects();
+	}
+
+	~AtlasTexture()
+	{
+		/* Leave the image in the cell, in case it's wanted again soon.  The
+		 * cache threads look at the cells, too. */
+		LockMut( g_ImageCacheMutex );
+		if( m_pPage != nullptr )
+			m_pPage->m_Cells[m_iCell].m_pOwner = nullptr;
+	}
+
+	std::uintptr_t GetTexHandle() const { return m_pPage != nullptr? m_pPage->GetTexHandle():0; }
+
+	/* The page reloads our image along with its own. */
+};
+
+AtlasPage::~AtlasPage()
+{
+	LockMut( g_ImageCacheMutex );
+	for( Cell &cell : m_Cells )
+	{
+		if( cell.m_pOwner != nullptr )
+			cell.m_pOwner->m_pPage = nullptr;
+	}
+	Destroy();
+}
+
+void AtlasPage::Create()
+{
+	RagePixelFormat pf = RagePixelFormat_RGB5A1;
+	if( !DISPLAY->SupportsTextureFormat(pf) )
+		pf = RagePixelFormat_RGBA4;
+	const RageDisplay::RagePixelFormatDesc *pfd = DISPLAY->GetPixelFormatDesc( pf );
+
+	RageSurface *pBlank = CreateSurface( m_iTextureWidth, m_iTextureHeight, pfd->bpp,
+		pfd->masks[0], pfd->masks[1], pfd->masks[2], pfd->masks[3] );
+	std::memset( pBlank->pixels, 0, pBlank->pitch * pBlank->h );
+	m_uTexHandle = DISPLAY->CreateTexture( pf, pBlank, false );
+	delete pBlank;
+
+	/* If we're being reloaded, the old contents are gone, so put every image
+	 * back.  In on-demand mode the images may not be loaded right now; read
+	 * those from their cache files. */
+	LockMut( g_ImageCacheMutex );
+	for( unsigned i = 0; i < m_Cells.size(); ++i )
+	{
+		Cell &cell = m_Cells[i];
+		if( cell.m_sImagePath.empty() )
+			continue;
+
+		std::map<RString, RageSurface*>::const_iterator it = g_ImagePathToImage.find( cell.m_sImagePath );
+		if( it != g_ImagePathToImage.end() )
+		{
+			Upload( i, it->second );
+			continue;
+		}
+
+		RageSurface *pImage = RageSurfaceUtils::LoadSurface( cell.m_sCachePath );
+		if( pImage != nullptr && pImage->w == m_iCellWidth && pImage->h == m_iCellHeight )
+		{
+			Upload( i, pImage );
+		}
+		else if( cell.m_pOwner == nullptr )
+		{
+			/* It's gone; don't hand out a blank cell for it later. */
+			cell.m_sImagePath = RString();
+		}
+		delete pImage;
+	}
+}
+
+/* Find a cell for an image: the one it's already in, if it's still there, or
+ * an empty one, or a new page, or the least recently used cell that isn't in
+ * use.  Returns nullptr if the image shouldn't go in the atlas. */
+static AtlasPage *AllocateAtlasCell( const RString &sImagePath, const RString &sCachePath, RageSurface *pImage, int &iCellOut )
+{
+	const int iPageSize = std::min( ATLAS_PAGE_SIZE, DISPLAY->GetMaxTextureSize() );
+	/* Don't bother with images so big that only a few fit on a page. */
+	if( pImage->w > iPageSize/2 || pImage->h > iPageSize/2 )
+		return nullptr;
+
+	AtlasPage *pEmptyPage = nullptr, *pOldestPage = nullptr;
+	int iEmptyCell = -1, iOldestCell = -1;
+	int iNumPages = 0;
+	for( AtlasPage *pPage : g_AtlasPages )
+	{
+		if( pPage->m_iCellWidth != pImage->w || pPage->m_iCellHeight != pImage->h )
+			continue;
+		++iNumPages;
+
+		for( unsigned i = 0; i < pPage->m_Cells.size(); ++i )
+		{
+			AtlasPage::Cell &cell = pPage->m_Cells[i];
+			if( cell.m_sImagePath == sImagePath && cell.m_pOwner == nullptr )
+			{
+				/* It's still there from last time. */
+				cell.m_iLastUsed = ++g_iAtlasClock;
+				iCellOut = i;
+				return pPage;
+			}
+			if( cell.m_pOwner != nullptr )
+				continue;
+
+			if( cell.m_sImagePath.empty() )
+			{
+				if( pEmptyPage == nullptr )
+				{
+					pEmptyPage = pPage;
+					iEmptyCell = i;
+				}
+			}
+			else if( pOldestPage == nullptr || cell.m_iLastUsed < pOldestPage->m_Cells[iOldestCell].m_iLastUsed )
+			{
+				pOldestPage = pPage;
+				iOldestCell = i;
+			}
+		}
+	}
+
+	AtlasPage *pPage = pEmptyPage;
+	int iCell = iEmptyCell;
+	if( pPage == nullptr && iNumPages < MAX_ATLAS_PAGES_PER_SIZE )
+	{
+		RageTextureID ID( ssprintf("ImageCache atlas page %i (%i by %i)", int(g_AtlasPages.size()), pImage->w, pImage->h) );
+		pPage = new AtlasPage( ID, pImage->w, pImage->h, iPageSize );
+		TEXTUREMAN->RegisterTexture( ID, pPage );
+		g_AtlasPages.push_back( pPage );
+		iCell = 0;
+	}
+	if( pPage == nullptr )
+	{
+		pPage = pOldestPage;
+		iCell = iOldestCell;
+	}
+	if( pPage == nullptr )
+		return nullptr; /* every cell is on screen */
+
+	AtlasPage::Cell &cell = pPage->m_Cells[iCell];
+	cell.m_sImagePath = sImagePath;
+	cell.m_sCachePath = sCachePath;
+	cell.m_iLastUsed = ++g_iAtlasClock;
+	pPage->Upload( iCell, pImage );
+
+	iCellOut = iCell;
+	return pPage;
+}
+
+/* The image has been recached, so any copy in the atlas is out of date.  Lock
+ * before calling. */
+static void ForgetAtlasImage( const RString &sImagePath )
+{
+	for( AtlasPage *pPage : g_AtlasPages )
+	{
+		for( AtlasPage::Cell &cell : pPage->m_Cells )
+		{
+			if( cell.m_sImagePath == sImagePath )
+				cell.m_sImagePath = RString();
+		}
+	}
+}
+
+static void UnloadAtlasPages()
+{
+	for( AtlasPage *pPage : g_AtlasPages )
+		TEXTUREMAN->UnloadTexture( pPage );
+	g_AtlasPages.clear();
+}
+
 /* If a image is cached, get its ID for use. */
 RageTextureID ImageCache::LoadCachedImage( RString sImageDir, RString sImagePath )
 {
+	LockMut( g_ImageCacheMutex );
 	RageTextureID ID( GetImageCachePath(sImageDir,sImagePath) );
 
 	std::size_t Found = sImagePath.find("_blank");
@@ -317,7 +612,16 @@ RageTextureID ImageCache::LoadCachedImage( RString sImageDir, RString sImagePath
 
 	//LOG->Trace( "Loading image texture %s; src %ix%i; image %ix%i",
 	//	    ID.filename.c_str(), iSourceWidth, iSourceHeight, pImage->w, pImage->h );
-	RageTexture *pTexture = new ImageTexture( ID, pImage, iSourceWidth, iSourceHeight );
+	RageTexture *pTexture = nullptr;
+	if( g_bImageCacheAtlas )
+	{
+		int iCell;
+		AtlasPage *pPage = AllocateAtlasCell( sImagePath, GetImageCachePath(sImageDir,sImagePath), pImage, iCell );
+		if( pPage != nullptr )
+			pTexture = new AtlasTexture( ID, pPage, iCell, iSourceWidth, iSourceHeight );
+	}
+	if( pTexture == nullptr )
+		pTexture = new ImageTexture( ID, pImage, iSourceWidth, iSourceHeight );
 
 	ID.Policy = RageTextureID::TEX_VOLATILE;
 	TEXTUREMAN->RegisterTexture( ID, pTexture );
@@ -355,6 +659,7 @@ void ImageCache::CacheImage( RString sImageDir, RString sImagePath )
 		{
 			unsigned CurFullHash;
 			const unsigned FullHash = GetHashForFile( sImagePath );
+			LockMut( g_ImageCacheMutex );
 			if( ImageData.GetValue( sImagePath, "FullHash", CurFullHash ) && CurFullHash == FullHash )
 				bCacheUpToDate = true;
 		}
@@ -371,20 +676,82 @@ void ImageCache::CacheImage( RString sImageDir, RString sImagePath )
 
 	/* The cache file doesn't exist, or is out of date.  Cache it.  This
 	 * will also load the cache into memory if in PRELOAD. */
-	CacheImageInternal( sImageDir, sImagePath );
+	QueueCacheImage( sImageDir, sImagePath, PREFSMAN->m_ImageCache == IMGCACHE_LOW_RES_PRELOAD );
+}
+
+/* Cache the image on a batch thread, if a batch is running, or right away. */
+void ImageCache::QueueCacheImage( RString sImageDir, RString sImagePath, bool bKeepLoaded )
+{
+	{
+		LockMut( g_ImageCacheMutex );
+		if( g_pCachePool != nullptr )
+		{
+			if( !g_PendingImages.insert(sImagePath).second )
+				return; /* already queued */
+
+			g_pCachePool->AddJob( [this, sImageDir, sImagePath, bKeepLoaded]() {
+				CacheImageInternal( sImageDir, sImagePath, bKeepLoaded );
+
+				LockMut( g_ImageCacheMutex );
+				g_PendingImages.erase( sImagePath );
+			} );
+			return;
+		}
+	}
+
+	CacheImageInternal( sImageDir, sImagePath, bKeepLoaded );
+}
+
+void ImageCache::StartBatch()
+{
+	LockMut( g_ImageCacheMutex );
+	delay_save_cache = true;
+	if( g_pCachePool == nullptr && g_iImageCacheThreads != 1 )
+		g_pCachePool = new RageWorkerPool( "ImageCache", g_iImageCacheThreads );
 }
 
-void ImageCache::CacheImageInternal( RString sImageDir, RString sImagePath )
+static LocalizedString CACHING_BANNERS( "ImageCache", "Caching banners..." );
+void ImageCache::FinishBatch( LoadingWindow *ld )
+{
+	/* Don't hold the lock while waiting; the jobs need it.  Anything cached
+	 * from here on is done right away. */
+	RageWorkerPool *pPool;
+	{
+		LockMut( g_ImageCacheMutex );
+		pPool = g_pCachePool;
+		g_pCachePool = nullptr;
+	}
+	if( pPool != nullptr )
+	{
+		if( ld )
+			ld->SetIndeterminate( true );
+		while( !pPool->WaitForJobs(0.1f) )
+		{
+			if( ld )
+				ld->SetText( CACHING_BANNERS.GetValue() + ssprintf("\n%i", pPool->GetNumFinishedJobs()) );
+		}
+		delete pPool;
+	}
+
+	LockMut( g_ImageCacheMutex );
+	WriteToDisk();
+	delay_save_cache = false;
+}
+
+/* Load the image, make a low-res copy and save it to the cache.  This runs
+ * without the lock, so several images can be cached at once. */
+static RageSurface *CreateCachedImage( const RString &sImagePath, const RString &sCachePath, int &iSourceWidth, int &iSourceHeight )
 {
 	RString sError;
 	RageSurface *pImage = RageSurfaceUtils::LoadFile( sImagePath, sError );
 	if( pImage == nullptr )
 	{
 		LOG->UserLog( "Cache file", sImagePath, "couldn't be loaded: %s", sError.c_str() );
-		return;
+		return nullptr;
 	}
 
-	const int iSourceWidth = pImage->w, iSourceHeight = pImage->h;
+	iSourceWidth = pImage->w;
+	iSourceHeight = pImage->h;
 
 	int iWidth = pImage->w / 2, iHeight = pImage->h / 2;
 //	int iWidth = pImage->w, iHeight = pImage->h;
@@ -437,8 +804,22 @@ void ImageCache::CacheImageInternal( RString sImageDir, RString sImagePath )
 		pImage = dst;
 	}
 
-	const RString sCachePath = GetImageCachePath(sImageDir,sImagePath);
 	RageSurfaceUtils::SaveSurface( pImage, sCachePath );
+	return pImage;
+}
+
+void ImageCache::CacheImageInternal( RString sImageDir, RString sImagePath, bool bKeepLoaded )
+{
+	const RString sCachePath = GetImageCachePath(sImageDir,sImagePath);
+	int iSourceWidth = 0, iSourceHeight = 0;
+	RageSurface *pImage = CreateCachedImage( sImagePath, sCachePath, iSourceWidth, iSourceHeight );
+	if( pImage == nullptr )
+		return;
+	const unsigned iFullHash = GetHashForFile( sImagePath );
+
+	LockMut( g_ImageCacheMutex );
+
+	ForgetAtlasImage( sImagePath );
 
 	/* If an old image is loaded, free it. */
 	if( g_ImagePathToImage.find(sImagePath) != g_ImagePathToImage.end() )
@@ -448,7 +829,7 @@ void ImageCache::CacheImageInternal( RString sImageDir, RString sImagePath )
 		g_ImagePathToImage.erase(sImagePath);
 	}
 
-	if( PREFSMAN->m_ImageCache == IMGCACHE_LOW_RES_PRELOAD )
+	if( bKeepLoaded )
 	{
 		/* Keep it; we're just going to load it anyway. */
 		g_ImagePathToImage[sImagePath] = pImage;
@@ -460,13 +841,14 @@ void ImageCache::CacheImageInternal( RString sImageDir, RString sImagePath )
 	ImageData.SetValue( sImagePath, "Path", sCachePath );
 	ImageData.SetValue( sImagePath, "Width", iSourceWidth );
 	ImageData.SetValue( sImagePath, "Height", iSourceHeight );
-	ImageData.SetValue( sImagePath, "FullHash", GetHashForFile( sImagePath ) );
+	ImageData.SetValue( sImagePath, "FullHash", iFullHash );
 	if (!delay_save_cache)
 		WriteToDisk();
 }
 
 void ImageCache::WriteToDisk()
 {
+	LockMut( g_ImageCacheMutex );
 	ImageData.WriteFile(IMAGE_CACHE_INDEX);
 }
 
@@ -22,6 +22,12 @@ public:
 	void Demand( RString sImageDir );
 	void Undemand( RString sImageDir );
 
+	/* Between StartBatch and FinishBatch, images that need to be cached are
+	 * handed to worker threads, and the index is only written by FinishBatch,
+	 * which waits for them. */
+	void StartBatch();
+	void FinishBatch( LoadingWindow *ld = nullptr );
+
 	void OutputStats() const;
 
 	bool delay_save_cache;
@@ -29,7 +35,8 @@ public:
 private:
 	static RString GetImageCachePath( RString sImageDir, RString sImagePath );
 	void UnloadAllImages();
-	void CacheImageInternal( RString sImageDir, RString sImagePath );
+	void QueueCacheImage( RString sImageDir, RString sImagePath, bool bKeepLoaded );
+	void CacheImageInternal( RString sImageDir, RString sImagePath, bool bKeepLoaded );
 
 	IniFile ImageData;
 };
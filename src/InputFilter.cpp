@@ -5,6 +5,7 @@
 #include "RageInput.h"
 #include "RageUtil.h"
 #include "RageThreads.h"
+#include "RageLatency.h"
 #include "Preference.h"
 #include "GameInput.h"
 #include "InputMapper.h"
@@ -459,6 +460,16 @@ void InputFilter::GetInputEvents( std::vector<InputEvent> &array )
 	array.clear();
 	LockMut(*queuemutex);
 	array.swap( queue );
+
+	if( RageLatency::IsEnabled() )
+	{
+		for( const InputEvent &e : array )
+		{
+			// Repeats are made up here, not read from a device.
+			if( e.type != IET_REPEAT )
+				RageLatency::RecordSince( LatencyStage_InputFilter, e.di.ts );
+		}
+	}
 }
 
 void InputFilter::GetPressedButtons( std::vector<DeviceInput> &array ) const
@@ -18,9 +18,81 @@
 #include "RageLog.h"
 #include "RageUtil.h"
 
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MSD_SCAN_SSE2
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MSD_SCAN_NEON
+#endif
+
+static inline bool IsSpecialChar( char c )
+{
+	return c == '#' || c == ':' || c == ';' || c == '/' || c == '\\';
+}
+
+/* Return the first character in [p,end) that means something to the parser,
+ * or end.  Notes are long runs of ordinary characters, so look at 16 bytes
+ * at a time where we can. */
+static const char *FindSpecialChar( const char *p, const char *end )
+{
+#if defined(MSD_SCAN_SSE2)
+	const __m128i hash = _mm_set1_epi8( '#' );
+	const __m128i colon = _mm_set1_epi8( ':' );
+	const __m128i semicolon = _mm_set1_epi8( ';' );
+	const __m128i slash = _mm_set1_epi8( '/' );
+	const __m128i backslash = _mm_set1_epi8( '\\' );
+	while( end - p >= 16 )
+	{
+		const __m128i v = _mm_loadu_si128( (const __m128i *) p );
+		__m128i m = _mm_or_si128( _mm_cmpeq_epi8(v, hash), _mm_cmpeq_epi8(v, colon) );
+		m = _mm_or_si128( m, _mm_cmpeq_epi8(v, semicolon) );
+		m = _mm_or_si128( m, _mm_cmpeq_epi8(v, slash) );
+		m = _mm_or_si128( m, _mm_cmpeq_epi8(v, backslash) );
+		const unsigned iMask = _mm_movemask_epi8( m );
+		if( iMask != 0 )
+		{
+#if defined(_MSC_VER)
+			unsigned long iIndex;
+			_BitScanForward( &iIndex, iMask );
+			return p + iIndex;
+#else
+			return p + __builtin_ctz( iMask );
+#endif
+		}
+		p += 16;
+	}
+#elif defined(MSD_SCAN_NEON)
+	const uint8x16_t hash = vdupq_n_u8( '#' );
+	const uint8x16_t colon = vdupq_n_u8( ':' );
+	const uint8x16_t semicolon = vdupq_n_u8( ';' );
+	const uint8x16_t slash = vdupq_n_u8( '/' );
+	const uint8x16_t backslash = vdupq_n_u8( '\\' );
+	while( end - p >= 16 )
+	{
+		const uint8x16_t v = vld1q_u8( (const uint8_t *) p );
+		uint8x16_t m = vorrq_u8( vceqq_u8(v, hash), vceqq_u8(v, colon) );
+		m = vorrq_u8( m, vceqq_u8(v, semicolon) );
+		m = vorrq_u8( m, vceqq_u8(v, slash) );
+		m = vorrq_u8( m, vceqq_u8(v, backslash) );
+		if( vmaxvq_u8(m) != 0 )
+			break; // it's in this block; find it below
+		p += 16;
+	}
+#endif
+	while( p < end && !IsSpecialChar(*p) )
+		++p;
+	return p;
+}
+
 void MsdFile::AddParam( const char *buf, int len )
 {
-	values.back().params.push_back( RString(buf, len) );
+	values.back().params.push_back( std::string_view(buf, len) );
 }
 
 void MsdFile::AddValue() /* (no extra charge) */
@@ -29,24 +101,51 @@ void MsdFile::AddValue() /* (no extra charge) */
 	values.back().params.reserve( 32 );
 }
 
-void MsdFile::ReadBuf( const char *buf, int len, bool bUnescape )
+/* Params are unescaped into the same buffer they're read from.  Unescaping and
+ * skipping comments only ever remove characters, so the write position never
+ * passes the read position, and nothing is copied at all until the first
+ * escape or comment. */
+void MsdFile::ReadBuf( bool bUnescape )
 {
+	values.clear();
 	values.reserve( 64 );
 
+	char *buf = buffer.empty()? nullptr:&buffer[0];
+	const int len = buffer.size();
+
 	bool ReadingValue=false;
 	int i = 0;
-	char *cProcessed = new char[len];
+	char *cProcessed = buf;
 	int iProcessedLen = -1;
 	while( i < len )
 	{
-		if( i+1 < len && buf[i] == '/' && buf[i+1] == '/' )
+		/* Copy ordinary characters in bulk. */
+		if( ReadingValue )
 		{
-			/* Skip a comment entirely; don't copy the comment to the value/parameter */
-			do
+			const int iEnd = FindSpecialChar( buf + i, buf + len ) - buf;
+			const int iRun = iEnd - i;
+			if( iRun > 0 )
 			{
-				i++;
-			} while( i < len && buf[i] != '\n' );
+				if( cProcessed + iProcessedLen != buf + i )
+					memmove( cProcessed + iProcessedLen, buf + i, iRun );
+				iProcessedLen += iRun;
+				i = iEnd;
+				if( i == len )
+					break;
+			}
+		}
+		else
+		{
+			i = FindSpecialChar( buf + i, buf + len ) - buf;
+			if( i == len )
+				break;
+		}
 
+		if( i+1 < len && buf[i] == '/' && buf[i+1] == '/' )
+		{
+			/* Skip a comment entirely; don't copy the comment to the value/parameter */
+			const char *pEnd = (const char *) memchr( buf + i, '\n', len - i );
+			i = pEnd? pEnd - buf:len;
 			continue;
 		}
 
@@ -85,6 +184,7 @@ void MsdFile::ReadBuf( const char *buf, int len, bool bUnescape )
 				--iProcessedLen;
 
 			AddParam( cProcessed, iProcessedLen );
+			cProcessed += iProcessedLen;
 			iProcessedLen = 0;
 			ReadingValue=false;
 		}
@@ -109,9 +209,11 @@ void MsdFile::ReadBuf( const char *buf, int len, bool bUnescape )
 		if( iProcessedLen != -1 && (buf[i] == ':' || buf[i] == ';') )
 			AddParam( cProcessed, iProcessedLen );
 
-		/* # and : begin new params. */
+		/* # and : begin new params, after the end of the last one. */
 		if( buf[i] == '#' || buf[i] == ':' )
 		{
+			if( iProcessedLen != -1 )
+				cProcessed += iProcessedLen;
 			++i;
 			iProcessedLen = 0;
 			continue;
@@ -138,8 +240,6 @@ void MsdFile::ReadBuf( const char *buf, int len, bool bUnescape )
 	/* Add any unterminated value at the very end. */
 	if( ReadingValue )
 		AddParam( cProcessed, iProcessedLen );
-
-	delete [] cProcessed;
 }
 
 // returns true if successful, false otherwise
@@ -156,24 +256,25 @@ bool MsdFile::ReadFile( RString sNewPath, bool bUnescape )
 	}
 
 	// allocate a string to hold the file
-	RString FileString;
-	FileString.reserve( f.GetFileSize() );
+	buffer = RString();
+	buffer.reserve( f.GetFileSize() );
 
-	int iBytesRead = f.Read( FileString );
+	int iBytesRead = f.Read( buffer );
 	if( iBytesRead == -1 )
 	{
 		error = f.GetError();
 		return false;
 	}
 
-	ReadBuf( FileString.c_str(), iBytesRead, bUnescape );
+	ReadBuf( bUnescape );
 
 	return true;
 }
 
 void MsdFile::ReadFromString( const RString &sString, bool bUnescape )
 {
-	ReadBuf( sString.c_str(), sString.size(), bUnescape );
+	buffer = sString;
+	ReadBuf( bUnescape );
 }
 
 RString MsdFile::GetParam(unsigned val, unsigned par) const
@@ -181,7 +282,7 @@ RString MsdFile::GetParam(unsigned val, unsigned par) const
 	if( val >= GetNumValues() || par >= GetNumParams(val) )
 		return RString();
 
-	return values[val].params[par];
+	return values[val][par];
 }
 
 /*
@@ -1,10 +1,15 @@
 #ifndef MSDFILE_H
 #define MSDFILE_H
 
+#include <string_view>
 #include <vector>
 
 
-/** @brief The class that reads the various .SSC, .SM, .SMA, .DWI, and .MSD files. */
+/**
+ * @brief The class that reads the various .SSC, .SM, .SMA, .DWI, and .MSD files.
+ *
+ * The whole file is kept in one buffer, and is unescaped in place; params
+ * point into that buffer instead of being copied out one by one. */
 class MsdFile
 {
 public:
@@ -14,8 +19,8 @@ public:
 	 * Note that &#35;param:param:param:param; is one whole value. */
 	struct value_t
 	{
-		/** @brief The list of parameters. */
-		std::vector<RString> params;
+		/** @brief The list of parameters, pointing into the MsdFile's buffer. */
+		std::vector<std::string_view> params;
 		/** @brief Set up the parameters with default values. */
 		value_t(): params() {}
 
@@ -24,10 +29,21 @@ public:
 		 * @param i the index.
 		 * @return the proper parameter.
 		 */
-		RString operator[]( unsigned i ) const { if( i >= params.size() ) return RString(); return params[i]; }
+		RString operator[]( unsigned i ) const { if( i >= params.size() ) return RString(); return RString( params[i].data(), params[i].size() ); }
+		/**
+		 * @brief Access the proper parameter without copying it.
+		 *
+		 * This is only valid for as long as the MsdFile it came from.
+		 * @param i the index.
+		 * @return the proper parameter.
+		 */
+		std::string_view GetView( unsigned i ) const { if( i >= params.size() ) return std::string_view(); return params[i]; }
 	};
 
 	MsdFile(): values(), error("") {}
+	/* Params point into buffer, so copies would point into the wrong one. */
+	MsdFile( const MsdFile & ) = delete;
+	MsdFile &operator=( const MsdFile & ) = delete;
 
 	/** @brief Remove the MSDFile. */
 	virtual ~MsdFile() { }
@@ -79,12 +95,10 @@ public:
 
 private:
 	/**
-	 * @brief Attempt to read an MSD file from the buffer.
-	 * @param buf the buffer containing the MSD file.
-	 * @param len the length of the buffer.
+	 * @brief Parse the MSD file held in buffer, unescaping it in place.
 	 * @param bUnescape a flag to see if we need to unescape values.
 	 */
-	void ReadBuf( const char *buf, int len, bool bUnescape );
+	void ReadBuf( bool bUnescape );
 	/**
 	 * @brief Add a new parameter.
 	 * @param buf the new parameter.
@@ -96,6 +110,8 @@ private:
 	 */
 	void AddValue();
 
+	/** @brief The file being parsed.  Params point into this. */
+	RString buffer;
 	/** @brief The list of values. */
 	std::vector<value_t> values;
 	/** @brief The error string. */
@@ -12,6 +12,7 @@
 #include "GameState.h" // blame radar calculations.
 #include "RageUtil_AutoPtr.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <vector>
 
@@ -21,6 +22,7 @@ REGISTER_CLASS_TRAITS( NoteData, new NoteData(*pCopy) )
 void NoteData::Init()
 {
 	m_TapNotes = std::vector<TrackMap>();	// ensure that the memory is freed
+	m_Flat.Clear();
 }
 
 void NoteData::SetNumTracks( int iNewNumTracks )
@@ -28,6 +30,126 @@ void NoteData::SetNumTracks( int iNewNumTracks )
 	ASSERT( iNewNumTracks > 0 );
 
 	m_TapNotes.resize( iNewNumTracks );
+	m_Flat.bValid = false;
+}
+
+void NoteData::FlatStorage::Clear()
+{
+	bValid = false;
+	vviTrackRows = std::vector<std::vector<int>>();
+	vvTrackIters = std::vector<std::vector<iterator>>();
+	viRows = std::vector<int>();
+	viColumnMasks = std::vector<std::uint32_t>();
+	viFirstNote = std::vector<int>();
+	vpNotes = std::vector<TapNote *>();
+}
+
+void NoteData::SetFlatStorage( bool bEnable )
+{
+	m_Flat.bEnabled = bEnable;
+	if( bEnable )
+		BuildFlatStorage();
+	else
+		m_Flat.Clear();
+}
+
+void NoteData::BuildFlatStorage()
+{
+	FlatStorage &f = m_Flat;
+	f.bValid = false;
+
+	const int iNumTracks = GetNumTracks();
+	if( iNumTracks > MAX_NOTE_TRACKS )
+		return; // leave it to the maps
+
+	f.vviTrackRows.resize( iNumTracks );
+	f.vvTrackIters.resize( iNumTracks );
+	f.viRows.clear();
+	for( int t = 0; t < iNumTracks; ++t )
+	{
+		std::vector<int> &viTrackRows = f.vviTrackRows[t];
+		std::vector<iterator> &vTrackIters = f.vvTrackIters[t];
+		viTrackRows.clear();
+		vTrackIters.clear();
+
+		TrackMap &mapTrack = m_TapNotes[t];
+		for( iterator it = mapTrack.begin(); it != mapTrack.end(); ++it )
+		{
+			viTrackRows.push_back( it->first );
+			vTrackIters.push_back( it );
+		}
+		vTrackIters.push_back( mapTrack.end() );
+
+		f.viRows.insert( f.viRows.end(), viTrackRows.begin(), viTrackRows.end() );
+	}
+
+	const std::size_t iNumNotes = f.viRows.size();
+	std::sort( f.viRows.begin(), f.viRows.end() );
+	f.viRows.erase( std::unique(f.viRows.begin(), f.viRows.end()), f.viRows.end() );
+
+	f.viColumnMasks.assign( f.viRows.size(), 0 );
+	f.viFirstNote.clear();
+	f.viFirstNote.reserve( f.viRows.size()+1 );
+	f.vpNotes.clear();
+	f.vpNotes.reserve( iNumNotes );
+
+	// Each track's rows are sorted, so merge them a row at a time.
+	int aiNext[MAX_NOTE_TRACKS] = { 0 };
+	for( std::size_t i = 0; i < f.viRows.size(); ++i )
+	{
+		const int iRow = f.viRows[i];
+		f.viFirstNote.push_back( f.vpNotes.size() );
+		for( int t = 0; t < iNumTracks; ++t )
+		{
+			const std::vector<int> &viTrackRows = f.vviTrackRows[t];
+			if( aiNext[t] == int(viTrackRows.size()) || viTrackRows[aiNext[t]] != iRow )
+				continue;
+			f.viColumnMasks[i] |= 1u << t;
+			f.vpNotes.push_back( &f.vvTrackIters[t][aiNext[t]]->second );
+			++aiNext[t];
+		}
+	}
+	f.viFirstNote.push_back( f.vpNotes.size() );
+
+	f.bValid = true;
+}
+
+NoteData::iterator NoteData::FlatLowerBound( int iTrack, int iRow ) const
+{
+	const std::vector<int> &viTrackRows = m_Flat.vviTrackRows[iTrack];
+	const std::size_t i = std::lower_bound( viTrackRows.begin(), viTrackRows.end(), iRow ) - viTrackRows.begin();
+	return m_Flat.vvTrackIters[iTrack][i];
+}
+
+NoteData::iterator NoteData::FlatFind( int iTrack, int iRow ) const
+{
+	const std::vector<int> &viTrackRows = m_Flat.vviTrackRows[iTrack];
+	const std::size_t i = std::lower_bound( viTrackRows.begin(), viTrackRows.end(), iRow ) - viTrackRows.begin();
+	if( i == viTrackRows.size() || viTrackRows[i] != iRow )
+		return m_Flat.vvTrackIters[iTrack].back();
+	return m_Flat.vvTrackIters[iTrack][i];
+}
+
+bool NoteData::GetFlatRowNotes( int iRow, const TapNote *apNotes[MAX_NOTE_TRACKS] ) const
+{
+	if( !m_Flat.bValid )
+		return false;
+
+	std::fill( apNotes, apNotes + GetNumTracks(), &TAP_EMPTY );
+
+	const std::vector<int> &viRows = m_Flat.viRows;
+	const std::size_t i = std::lower_bound( viRows.begin(), viRows.end(), iRow ) - viRows.begin();
+	if( i == viRows.size() || viRows[i] != iRow )
+		return true;
+
+	const std::uint32_t iMask = m_Flat.viColumnMasks[i];
+	int iNote = m_Flat.viFirstNote[i];
+	for( int t = 0; t < GetNumTracks(); ++t )
+	{
+		if( iMask & (1u << t) )
+			apNotes[t] = m_Flat.vpNotes[iNote++];
+	}
+	return true;
 }
 
 bool NoteData::IsComposite() const
@@ -48,6 +170,7 @@ void NoteData::ClearRangeForTrack( int rowBegin, int rowEnd, int iTrack )
 	if( rowBegin == 0 && rowEnd == MAX_NOTE_ROW )
 	{
 		m_TapNotes[iTrack].clear();
+		m_Flat.bValid = false;
 		return;
 	}
 
@@ -111,6 +234,7 @@ void NoteData::ClearRangeForTrack( int rowBegin, int rowEnd, int iTrack )
 	}
 
 	m_TapNotes[iTrack].erase( lBegin, lEnd );
+	m_Flat.bValid = false;
 }
 
 void NoteData::ClearRange( int rowBegin, int rowEnd )
@@ -123,6 +247,7 @@ void NoteData::ClearAll()
 {
 	for( int t=0; t<GetNumTracks(); t++ )
 		m_TapNotes[t].clear();
+	m_Flat.bValid = false;
 }
 
 /* Copy [rowFromBegin,rowFromEnd) from pFrom to this. (Note that this does
@@ -177,8 +302,10 @@ void NoteData::CopyAll( const NoteData& from )
 
 bool NoteData::IsRowEmpty( int row ) const
 {
+	const TapNote *apNotes[MAX_NOTE_TRACKS];
+	const bool bFlat = GetFlatRowNotes( row, apNotes );
 	for( int t=0; t<GetNumTracks(); t++ )
-		if( GetTapNote(t, row).type != TapNoteType_Empty )
+		if( (bFlat? *apNotes[t]:GetTapNote( t, row )).type != TapNoteType_Empty )
 			return false;
 	return true;
 }
@@ -195,25 +322,31 @@ bool NoteData::IsRangeEmpty( int track, int rowBegin, int rowEnd ) const
 
 int NoteData::GetNumTapNonEmptyTracks( int row ) const
 {
+	const TapNote *apNotes[MAX_NOTE_TRACKS];
+	const bool bFlat = GetFlatRowNotes( row, apNotes );
 	int iNum = 0;
 	for( int t=0; t<GetNumTracks(); t++ )
-		if( GetTapNote(t, row).type != TapNoteType_Empty )
+		if( (bFlat? *apNotes[t]:GetTapNote( t, row )).type != TapNoteType_Empty )
 			iNum++;
 	return iNum;
 }
 
 void NoteData::GetTapNonEmptyTracks( int row, std::set<int>& addTo ) const
 {
+	const TapNote *apNotes[MAX_NOTE_TRACKS];
+	const bool bFlat = GetFlatRowNotes( row, apNotes );
 	for( int t=0; t<GetNumTracks(); t++ )
-		if( GetTapNote(t, row).type != TapNoteType_Empty )
+		if( (bFlat? *apNotes[t]:GetTapNote( t, row )).type != TapNoteType_Empty )
 			addTo.insert(t);
 }
 
 bool NoteData::GetTapFirstNonEmptyTrack( int row, int &iNonEmptyTrackOut ) const
 {
+	const TapNote *apNotes[MAX_NOTE_TRACKS];
+	const bool bFlat = GetFlatRowNotes( row, apNotes );
 	for( int t=0; t<GetNumTracks(); t++ )
 	{
-		if( GetTapNote( t, row ).type != TapNoteType_Empty )
+		if( (bFlat? *apNotes[t]:GetTapNote( t, row )).type != TapNoteType_Empty )
 		{
 			iNonEmptyTrackOut = t;
 			return true;
@@ -224,9 +357,11 @@ bool NoteData::GetTapFirstNonEmptyTrack( int row, int &iNonEmptyTrackOut ) const
 
 bool NoteData::GetTapFirstEmptyTrack( int row, int &iEmptyTrackOut ) const
 {
+	const TapNote *apNotes[MAX_NOTE_TRACKS];
+	const bool bFlat = GetFlatRowNotes( row, apNotes );
 	for( int t=0; t<GetNumTracks(); t++ )
 	{
-		if( GetTapNote( t, row ).type == TapNoteType_Empty )
+		if( (bFlat? *apNotes[t]:GetTapNote( t, row )).type == TapNoteType_Empty )
 		{
 			iEmptyTrackOut = t;
 			return true;
@@ -237,9 +372,11 @@ bool NoteData::GetTapFirstEmptyTrack( int row, int &iEmptyTrackOut ) const
 
 bool NoteData::GetTapLastEmptyTrack( int row, int &iEmptyTrackOut ) const
 {
+	const TapNote *apNotes[MAX_NOTE_TRACKS];
+	const bool bFlat = GetFlatRowNotes( row, apNotes );
 	for( int t=GetNumTracks()-1; t>=0; t-- )
 	{
-		if( GetTapNote( t, row ).type == TapNoteType_Empty )
+		if( (bFlat? *apNotes[t]:GetTapNote( t, row )).type == TapNoteType_Empty )
 		{
 			iEmptyTrackOut = t;
 			return true;
@@ -250,10 +387,12 @@ bool NoteData::GetTapLastEmptyTrack( int row, int &iEmptyTrackOut ) const
 
 int NoteData::GetNumTracksWithTap( int row ) const
 {
+	const TapNote *apNotes[MAX_NOTE_TRACKS];
+	const bool bFlat = GetFlatRowNotes( row, apNotes );
 	int iNum = 0;
 	for( int t=0; t<GetNumTracks(); t++ )
 	{
-		const TapNote &tn = GetTapNote( t, row );
+		const TapNote &tn = bFlat? *apNotes[t]:GetTapNote( t, row );
 		if( tn.type == TapNoteType_Tap || tn.type == TapNoteType_Lift )
 			iNum++;
 	}
@@ -262,10 +401,12 @@ int NoteData::GetNumTracksWithTap( int row ) const
 
 int NoteData::GetNumTracksWithTapOrHoldHead( int row ) const
 {
+	const TapNote *apNotes[MAX_NOTE_TRACKS];
+	const bool bFlat = GetFlatRowNotes( row, apNotes );
 	int iNum = 0;
 	for( int t=0; t<GetNumTracks(); t++ )
 	{
-		const TapNote &tn = GetTapNote( t, row );
+		const TapNote &tn = bFlat? *apNotes[t]:GetTapNote( t, row );
 		if( tn.type == TapNoteType_Tap || tn.type == TapNoteType_Lift || tn.type == TapNoteType_HoldHead )
 			iNum++;
 	}
@@ -280,9 +421,11 @@ void NoteData::LogNonEmptyRows() {
 
 int NoteData::GetFirstTrackWithTap( int row ) const
 {
+	const TapNote *apNotes[MAX_NOTE_TRACKS];
+	const bool bFlat = GetFlatRowNotes( row, apNotes );
 	for( int t=0; t<GetNumTracks(); t++ )
 	{
-		const TapNote &tn = GetTapNote( t, row );
+		const TapNote &tn = bFlat? *apNotes[t]:GetTapNote( t, row );
 		if( tn.type == TapNoteType_Tap || tn.type == TapNoteType_Lift )
 			return t;
 	}
@@ -291,9 +434,11 @@ int NoteData::GetFirstTrackWithTap( int row ) const
 
 int NoteData::GetFirstTrackWithTapOrHoldHead( int row ) const
 {
+	const TapNote *apNotes[MAX_NOTE_TRACKS];
+	const bool bFlat = GetFlatRowNotes( row, apNotes );
 	for( int t=0; t<GetNumTracks(); t++ )
 	{
-		const TapNote &tn = GetTapNote( t, row );
+		const TapNote &tn = bFlat? *apNotes[t]:GetTapNote( t, row );
 		if( tn.type == TapNoteType_Tap || tn.type == TapNoteType_Lift || tn.type == TapNoteType_HoldHead )
 			return t;
 	}
@@ -302,9 +447,11 @@ int NoteData::GetFirstTrackWithTapOrHoldHead( int row ) const
 
 int NoteData::GetLastTrackWithTapOrHoldHead( int row ) const
 {
+	const TapNote *apNotes[MAX_NOTE_TRACKS];
+	const bool bFlat = GetFlatRowNotes( row, apNotes );
 	for( int t=GetNumTracks()-1; t>=0; t-- )
 	{
-		const TapNote &tn = GetTapNote( t, row );
+		const TapNote &tn = bFlat? *apNotes[t]:GetTapNote( t, row );
 		if( tn.type == TapNoteType_Tap || tn.type == TapNoteType_Lift || tn.type == TapNoteType_HoldHead )
 			return t;
 	}
@@ -933,6 +1080,7 @@ void NoteData::LoadTransformed( const NoteData& in, int iNewNumTracks, const int
 			continue;
 		m_TapNotes[t] = in.m_TapNotes[iOriginalTrack];
 	}
+	m_Flat.bValid = false;
 }
 
 void NoteData::MoveTapNoteTrack( int dest, int src )
@@ -940,6 +1088,7 @@ void NoteData::MoveTapNoteTrack( int dest, int src )
 	if(dest == src) return;
 	m_TapNotes[dest] = m_TapNotes[src];
 	m_TapNotes[src].clear();
+	m_Flat.bValid = false;
 }
 
 void NoteData::SetTapNote( int track, int row, const TapNote& t )
@@ -949,6 +1098,8 @@ void NoteData::SetTapNote( int track, int row, const TapNote& t )
 	if( row < 0 )
 		return;
 
+	m_Flat.bValid = false;
+
 	// There's no point in inserting empty notes into the map.
 	// Any blank space in the map is defined to be empty.
 	// If we're trying to insert an empty at a spot where another note
@@ -975,8 +1126,7 @@ void NoteData::GetTracksHeldAtRow( int row, std::set<int>& addTo )
 
 int NoteData::GetNumTracksHeldAtRow( int row )
 {
-	static std::set<int> viTracks;
-	viTracks.clear();
+	std::set<int> viTracks;
 	GetTracksHeldAtRow( row, viTracks );
 	return viTracks.size();
 }
@@ -991,7 +1141,7 @@ bool NoteData::GetNextTapNoteRowForTrack( int track, int &rowInOut, bool ignoreA
 	// lower_bound "finds the first element whose key is not less than k" (>=);
 	// upper_bound "finds the first element whose key greater than k".  They don't
 	// have the same effect, but lower_bound(row+1) should equal upper_bound(row). -glenn
-	TrackMap::const_iterator iter = mapTrack.lower_bound( rowInOut+1 );	// "find the first note for which row+1 < key == false"
+	TrackMap::const_iterator iter = lower_bound( track, rowInOut+1 );	// "find the first note for which row+1 < key == false"
 	if( iter == mapTrack.end() )
 		return false;
 
@@ -1013,7 +1163,7 @@ bool NoteData::GetPrevTapNoteRowForTrack( int track, int &rowInOut ) const
 	const TrackMap &mapTrack = m_TapNotes[track];
 
 	// Find the first note >= rowInOut.
-	TrackMap::const_iterator iter = mapTrack.lower_bound( rowInOut );
+	TrackMap::const_iterator iter = lower_bound( track, rowInOut );
 
 	// If we're at the beginning, we can't move back any more.
 	if( iter == mapTrack.begin() )
@@ -1042,14 +1192,14 @@ void NoteData::GetTapNoteRange( int iTrack, int iStartRow, int iEndRow, TrackMap
 	else if( iStartRow >= MAX_NOTE_ROW )
 		lBegin = mapTrack.end(); // optimization
 	else
-		lBegin = mapTrack.lower_bound( iStartRow );
+		lBegin = lower_bound( iTrack, iStartRow );
 
 	if( iEndRow <= 0 )
 		lEnd = mapTrack.begin(); // optimization
 	else if( iEndRow >= MAX_NOTE_ROW )
 		lEnd = mapTrack.end(); // optimization
 	else
-		lEnd = mapTrack.lower_bound( iEndRow );
+		lEnd = lower_bound( iTrack, iEndRow );
 }
 
 
@@ -1136,6 +1286,15 @@ void NoteData::GetTapNoteRangeExclusive( int iTrack, int iStartRow, int iEndRow,
 
 bool NoteData::GetNextTapNoteRowForAllTracks( int &rowInOut ) const
 {
+	if( m_Flat.bValid )
+	{
+		std::vector<int>::const_iterator it = std::upper_bound( m_Flat.viRows.begin(), m_Flat.viRows.end(), rowInOut );
+		if( it == m_Flat.viRows.end() )
+			return false;
+		rowInOut = *it;
+		return true;
+	}
+
 	int iClosestNextRow = MAX_NOTE_ROW;
 	bool bAnyHaveNextNote = false;
 	for( int t=0; t<GetNumTracks(); t++ )
@@ -1162,6 +1321,15 @@ bool NoteData::GetNextTapNoteRowForAllTracks( int &rowInOut ) const
 
 bool NoteData::GetPrevTapNoteRowForAllTracks( int &rowInOut ) const
 {
+	if( m_Flat.bValid )
+	{
+		std::vector<int>::const_iterator it = std::lower_bound( m_Flat.viRows.begin(), m_Flat.viRows.end(), rowInOut );
+		if( it == m_Flat.viRows.begin() )
+			return false;
+		rowInOut = *--it;
+		return true;
+	}
+
 	int iClosestPrevRow = 0;
 	bool bAnyHavePrevNote = false;
 	for( int t=0; t<GetNumTracks(); t++ )
@@ -1238,6 +1406,10 @@ void NoteData::RemoveATIFromList(all_tracks_const_iterator* iter) const
 
 void NoteData::RevalidateATIs(std::vector<int> const& added_or_removed_tracks, bool added)
 {
+	// Transforms are done changing the notes, so flat storage can catch up.
+	if( m_Flat.bEnabled )
+		BuildFlatStorage();
+
 	for(std::set<all_tracks_iterator*>::iterator cur= m_atis.begin();
 			cur != m_atis.end(); ++cur)
 	{
@@ -3,6 +3,7 @@
 
 #include "NoteTypes.h"
 
+#include <cstdint>
 #include <map>
 #include <set>
 #include <iterator>
@@ -46,15 +47,17 @@ public:
 	const_iterator end( int iTrack ) const				{ return m_TapNotes[iTrack].end(); }
 	reverse_iterator rend( int iTrack )				{ return m_TapNotes[iTrack].rend(); }
 	const_reverse_iterator rend( int iTrack ) const			{ return m_TapNotes[iTrack].rend(); }
-	iterator lower_bound( int iTrack, int iRow )			{ return m_TapNotes[iTrack].lower_bound( iRow ); }
-	const_iterator lower_bound( int iTrack, int iRow ) const	{ return m_TapNotes[iTrack].lower_bound( iRow ); }
-	iterator upper_bound( int iTrack, int iRow )			{ return m_TapNotes[iTrack].upper_bound( iRow ); }
-	const_iterator upper_bound( int iTrack, int iRow ) const	{ return m_TapNotes[iTrack].upper_bound( iRow ); }
+	iterator lower_bound( int iTrack, int iRow )			{ return m_Flat.bValid? FlatLowerBound( iTrack, iRow ):m_TapNotes[iTrack].lower_bound( iRow ); }
+	const_iterator lower_bound( int iTrack, int iRow ) const	{ return m_Flat.bValid? FlatLowerBound( iTrack, iRow ):m_TapNotes[iTrack].lower_bound( iRow ); }
+	iterator upper_bound( int iTrack, int iRow )			{ return m_Flat.bValid? FlatLowerBound( iTrack, iRow+1 ):m_TapNotes[iTrack].upper_bound( iRow ); }
+	const_iterator upper_bound( int iTrack, int iRow ) const	{ return m_Flat.bValid? FlatLowerBound( iTrack, iRow+1 ):m_TapNotes[iTrack].upper_bound( iRow ); }
 	void swap( NoteData &nd )
 	{
 		m_TapNotes.swap(nd.m_TapNotes);
 		m_atis.swap(nd.m_atis);
 		m_const_atis.swap(nd.m_const_atis);
+		m_Flat.Clear();
+		nd.m_Flat.Clear();
 	}
 
 
@@ -112,6 +115,47 @@ private:
 	// Any blank space in the map is defined to be empty.
 	std::vector<TrackMap>	m_TapNotes;
 
+	/* Gameplay reads its notes far more often than it changes them, and walking
+	 * map nodes scattered over the heap is slow.  With flat storage on, the
+	 * layout of m_TapNotes is also kept in sorted arrays, which lookups
+	 * binary search instead.  The arrays point back into m_TapNotes, so notes
+	 * changed through either stay in sync; anything that adds or removes notes
+	 * drops the arrays until RevalidateATIs() rebuilds them, and lookups use
+	 * the maps in the meantime. */
+	struct FlatStorage
+	{
+		FlatStorage(): bEnabled(false), bValid(false) { }
+		// Copies start out unbuilt, since the arrays point into the original.
+		FlatStorage( const FlatStorage &other ): bEnabled(other.bEnabled), bValid(false) { }
+		// Assigning notes doesn't change how they're stored.
+		FlatStorage &operator=( const FlatStorage & ) { Clear(); return *this; }
+		void Clear();
+
+		bool bEnabled;
+		bool bValid;
+
+		// Per track: the rows of its notes, and their map iterators, plus end().
+		std::vector<std::vector<int>> vviTrackRows;
+		std::vector<std::vector<iterator>> vvTrackIters;
+
+		// Per row with any notes: the row, a bit per track with a note, and
+		// where that row's notes start in vpNotes.  viFirstNote ends with
+		// vpNotes.size().
+		std::vector<int> viRows;
+		std::vector<std::uint32_t> viColumnMasks;
+		std::vector<int> viFirstNote;
+		// Every note, by row and then by track.
+		std::vector<TapNote *> vpNotes;
+	};
+	mutable FlatStorage m_Flat;
+
+	void BuildFlatStorage();
+	iterator FlatLowerBound( int iTrack, int iRow ) const;
+	iterator FlatFind( int iTrack, int iRow ) const;
+	/* If flat storage is built, point apNotes at each track's note on iRow
+	 * (TAP_EMPTY if there's none) and return true. */
+	bool GetFlatRowNotes( int iRow, const TapNote *apNotes[MAX_NOTE_TRACKS] ) const;
+
 	/**
 	 * @brief Determine whether this note is for Player 1 or Player 2.
 	 * @param track the track/column the note is in.
@@ -167,6 +211,11 @@ private:
 public:
 	void Init();
 
+	/* Keep the notes in flat storage as well; see FlatStorage.  This is for
+	 * gameplay copies; the editor changes its notes too often to benefit. */
+	void SetFlatStorage( bool bEnable );
+	bool GetFlatStorage() const { return m_Flat.bEnabled; }
+
 	// Mina stuf (Used for chartkey hashing)
 	void LogNonEmptyRows();
 	std::vector<int>& GetNonEmptyRowVector() { return NonEmptyRowVector; };
@@ -182,7 +231,7 @@ public:
 	inline const TapNote &GetTapNote( unsigned track, int row ) const
 	{
 		const TrackMap &mapTrack = m_TapNotes[track];
-		TrackMap::const_iterator iter = mapTrack.find( row );
+		TrackMap::const_iterator iter = m_Flat.bValid? FlatFind( track, row ):mapTrack.find( row );
 		if( iter != mapTrack.end() )
 			return iter->second;
 		else
@@ -190,9 +239,9 @@ public:
 	}
 
 
-	inline iterator FindTapNote( unsigned iTrack, int iRow )	{ return m_TapNotes[iTrack].find( iRow ); }
-	inline const_iterator FindTapNote( unsigned iTrack, int iRow ) const { return m_TapNotes[iTrack].find( iRow ); }
-	void RemoveTapNote( unsigned iTrack, iterator it )		{ m_TapNotes[iTrack].erase( it ); }
+	inline iterator FindTapNote( unsigned iTrack, int iRow )	{ return m_Flat.bValid? FlatFind( iTrack, iRow ):m_TapNotes[iTrack].find( iRow ); }
+	inline const_iterator FindTapNote( unsigned iTrack, int iRow ) const { return m_Flat.bValid? FlatFind( iTrack, iRow ):m_TapNotes[iTrack].find( iRow ); }
+	void RemoveTapNote( unsigned iTrack, iterator it )		{ m_Flat.bValid = false; m_TapNotes[iTrack].erase( it ); }
 
 	/**
 	 * @brief Return an iterator range for [rowBegin,rowEnd).
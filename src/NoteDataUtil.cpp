@@ -8,6 +8,7 @@
 #include "Style.h"
 #include "GameState.h"
 #include "RadarValues.h"
+#include "ChartDensity.h"
 #include "TimingData.h"
 
 #include <cmath>
@@ -1180,6 +1181,57 @@ void NoteDataUtil::CalculateRadarValues( const NoteData &in, float fSongSeconds,
 	// attention here when adding new categories. -Kyz
 }
 
+void NoteDataUtil::CalculateDensity( const NoteData &in, const TimingData &timing, ChartDensity &out )
+{
+	out.Clear();
+
+	const int iRowsPerMeasure = BeatToNoteRow( 4 );
+	FOREACH_NONEMPTY_ROW_ALL_TRACKS( in, r )
+	{
+		if( !timing.IsJudgableAtRow(r) || in.GetNumTracksWithTapOrHoldHead(r) == 0 )
+			continue;
+		const unsigned iMeasure = r / iRowsPerMeasure;
+		if( iMeasure >= out.m_viNotesPerMeasure.size() )
+			out.m_viNotesPerMeasure.resize( iMeasure+1, 0 );
+		++out.m_viNotesPerMeasure[iMeasure];
+	}
+
+	const int iNumMeasures = out.m_viNotesPerMeasure.size();
+	out.m_vfNPSPerMeasure.resize( iNumMeasures, 0 );
+	float fStartSeconds = timing.GetElapsedTimeFromBeat( 0 );
+	int iFirstNoteMeasure = -1;
+	for( int m = 0; m < iNumMeasures; ++m )
+	{
+		// Each measure starts where the last one ended, so this is one lookup per measure.
+		const float fEndSeconds = timing.GetElapsedTimeFromBeat( NoteRowToBeat((m+1) * iRowsPerMeasure) );
+		const float fSeconds = fEndSeconds - fStartSeconds;
+		fStartSeconds = fEndSeconds;
+
+		const int iNotes = out.m_viNotesPerMeasure[m];
+		if( iNotes == 0 )
+			continue;
+		if( iFirstNoteMeasure == -1 )
+			iFirstNoteMeasure = m;
+
+		// Stops and warps can squash a measure to nothing; don't call that infinitely dense.
+		if( fSeconds > 0 )
+			out.m_vfNPSPerMeasure[m] = iNotes / fSeconds;
+		out.m_fPeakNPS = std::max( out.m_fPeakNPS, out.m_vfNPSPerMeasure[m] );
+	}
+
+	if( iFirstNoteMeasure == -1 )
+		return;
+
+	// The last measure always has notes, so the runs end there.
+	for( int m = iFirstNoteMeasure; m < iNumMeasures; ++m )
+	{
+		const bool bStream = out.m_viNotesPerMeasure[m] >= STREAM_NOTES_PER_MEASURE;
+		if( out.m_vRuns.empty() || out.m_vRuns.back().m_bStream != bStream )
+			out.m_vRuns.push_back( ChartDensity::Run(bStream, m, 0) );
+		++out.m_vRuns.back().m_iNumMeasures;
+	}
+}
+
 void NoteDataUtil::RemoveHoldNotes( NoteData &in, int iStartIndex, int iEndIndex )
 {
 	// turn all the HoldNotes into TapNotes
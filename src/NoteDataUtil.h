@@ -9,6 +9,7 @@
 
 class PlayerOptions;
 struct RadarValues;
+struct ChartDensity;
 class NoteData;
 class Song;
 struct AttackArray;
@@ -58,6 +59,8 @@ namespace NoteDataUtil
 	void AutogenKickbox(const NoteData& in, NoteData& out, const TimingData& timing, StepsType out_type, int nonrandom_seed);
 
 	void CalculateRadarValues( const NoteData &in, float fSongSeconds, RadarValues& out );
+	/** @brief Count notes per measure and find the chart's stream runs and peak NPS. */
+	void CalculateDensity( const NoteData &in, const TimingData &timing, ChartDensity &out );
 
 	/**
 	 * @brief Remove all of the Hold notes.
@@ -17,6 +17,7 @@
 #include "RageMath.h"
 #include "ReceptorArrowRow.h"
 #include "Sprite.h"
+#include "SpriteBatch.h"
 #include "Style.h"
 
 #include <cmath>
@@ -356,15 +357,17 @@ void NCSplineHandler::MakeWeightedAverage(NCSplineHandler& out,
 
 void NoteColumnRenderArgs::spae_pos_for_beat(const PlayerState* player_state,
 	float beat, float y_offset, float y_reverse_offset,
-	RageVector3& sp_pos, RageVector3& ae_pos) const
+	RageVector3& sp_pos, RageVector3& ae_pos, const NoteEffects* effects) const
 {
 	switch(pos_handler->m_spline_mode)
 	{
 		case NCSM_Disabled:
-			ArrowEffects::GetXYZPos(player_state, column, y_offset, y_reverse_offset, ae_pos);
+			if(effects != nullptr) { ae_pos= effects->pos; }
+			else { ArrowEffects::GetXYZPos(player_state, column, y_offset, y_reverse_offset, ae_pos); }
 			break;
 		case NCSM_Offset:
-			ArrowEffects::GetXYZPos(player_state, column, y_offset, y_reverse_offset, ae_pos);
+			if(effects != nullptr) { ae_pos= effects->pos; }
+			else { ArrowEffects::GetXYZPos(player_state, column, y_offset, y_reverse_offset, ae_pos); }
 			pos_handler->EvalForBeat(song_beat, beat, sp_pos);
 			break;
 		case NCSM_Position:
@@ -375,15 +378,16 @@ void NoteColumnRenderArgs::spae_pos_for_beat(const PlayerState* player_state,
 	}
 }
 void NoteColumnRenderArgs::spae_zoom_for_beat(const PlayerState* state, float beat,
-	RageVector3& sp_zoom, RageVector3& ae_zoom, int col_num, float y_offset) const
+	RageVector3& sp_zoom, RageVector3& ae_zoom, int col_num, float y_offset,
+	const NoteEffects* effects) const
 {
 	switch(zoom_handler->m_spline_mode)
 	{
 		case NCSM_Disabled:
-			ae_zoom.x= ae_zoom.y= ae_zoom.z= ArrowEffects::GetZoom(state, y_offset, col_num);
+			ae_zoom.x= ae_zoom.y= ae_zoom.z= effects != nullptr ? effects->zoom : ArrowEffects::GetZoom(state, y_offset, col_num);
 			break;
 		case NCSM_Offset:
-			ae_zoom.x= ae_zoom.y= ae_zoom.z= ArrowEffects::GetZoom(state, y_offset, col_num);
+			ae_zoom.x= ae_zoom.y= ae_zoom.z= effects != nullptr ? effects->zoom : ArrowEffects::GetZoom(state, y_offset, col_num);
 			zoom_handler->EvalForBeat(song_beat, beat, sp_zoom);
 			break;
 		case NCSM_Position:
@@ -542,25 +546,120 @@ bool NoteDisplay::DrawHoldsInRange(const NoteFieldRenderArgs& field_args,
 	return any_upcoming;
 }
 
+void NoteDisplay::CalculateTapEffects(const NoteFieldRenderArgs& field_args,
+	const NoteColumnRenderArgs& column_args,
+	const std::vector<NoteData::TrackMap::const_iterator>& tap_set)
+{
+	TapEffects& fx= m_TapEffects;
+	const int column= column_args.column;
+	const int num_taps= static_cast<int>(tap_set.size());
+	fx.index.resize(num_taps);
+	fx.beat.resize(num_taps);
+	fx.y_offset.resize(num_taps);
+	for(int i= 0; i < num_taps; ++i)
+	{
+		fx.beat[i]= NoteRowToBeat(tap_set[i]->first);
+	}
+	ArrowEffects::GetYOffsets(m_pPlayerState, column, fx.beat.data(), num_taps,
+		fx.y_offset.data());
+
+	// TRICKY: If boomerang is on, then all notes in the range
+	// [first_row,last_row] aren't necessarily visible.
+	// Test every note to make sure it's on screen, the same way IsOnScreen
+	// does, and only keep the ones that are.
+	const int draw_after= static_cast<int>(field_args.draw_pixels_after_targets);
+	const int draw_before= static_cast<int>(field_args.draw_pixels_before_targets);
+	int num_on_screen= 0;
+	for(int i= 0; i < num_taps; ++i)
+	{
+		if(fx.y_offset[i] > draw_before || fx.y_offset[i] < draw_after)
+		{
+			fx.index[i]= -1;
+			continue;
+		}
+		fx.beat[num_on_screen]= fx.beat[i];
+		fx.y_offset[num_on_screen]= fx.y_offset[i];
+		fx.index[i]= num_on_screen++;
+	}
+	fx.beat.resize(num_on_screen);
+	fx.y_offset.resize(num_on_screen);
+
+	fx.fade_to_fail.resize(num_on_screen);
+	for(int i= 0; i < num_taps; ++i)
+	{
+		if(fx.index[i] == -1)
+		{
+			continue;
+		}
+		const int tap_row= tap_set[i]->first;
+		bool in_selection_range = false;
+		if(*field_args.selection_begin_marker != -1 && *field_args.selection_end_marker != -1)
+		{
+			in_selection_range = *field_args.selection_begin_marker <= tap_row &&
+				tap_row < *field_args.selection_end_marker;
+		}
+		fx.fade_to_fail[fx.index[i]]= in_selection_range ? field_args.selection_glow : field_args.fail_fade;
+	}
+
+	const float* y_offsets= fx.y_offset.data();
+	fx.x.resize(num_on_screen);
+	fx.y.resize(num_on_screen);
+	fx.z.resize(num_on_screen);
+	fx.rot_x.resize(num_on_screen);
+	fx.rot_y.resize(num_on_screen);
+	fx.rot_z.resize(num_on_screen);
+	fx.zoom.resize(num_on_screen);
+	fx.alpha.resize(num_on_screen);
+	fx.glow.resize(num_on_screen);
+	ArrowEffects::GetXPositions(m_pPlayerState, column, y_offsets, num_on_screen, fx.x.data());
+	ArrowEffects::GetYPositions(m_pPlayerState, column, y_offsets, num_on_screen, fx.y.data(), m_fYReverseOffsetPixels);
+	ArrowEffects::GetZPositions(m_pPlayerState, column, y_offsets, num_on_screen, fx.z.data());
+	// Hold tails are hold caps, which DrawTap works out on its own.
+	ArrowEffects::GetRotationsX(m_pPlayerState, y_offsets, num_on_screen, false, column, fx.rot_x.data());
+	ArrowEffects::GetRotationsY(m_pPlayerState, y_offsets, num_on_screen, column, fx.rot_y.data());
+	ArrowEffects::GetRotationsZ(m_pPlayerState, fx.beat.data(), num_on_screen, false, column, fx.rot_z.data());
+	ArrowEffects::GetZooms(m_pPlayerState, y_offsets, num_on_screen, column, fx.zoom.data());
+	ArrowEffects::GetAlphasAndGlows(m_pPlayerState, column, y_offsets,
+		fx.fade_to_fail.data(), num_on_screen, m_fYReverseOffsetPixels,
+		field_args.draw_pixels_before_targets, field_args.fade_before_targets,
+		fx.alpha.data(), fx.glow.data());
+}
+
 bool NoteDisplay::DrawTapsInRange(const NoteFieldRenderArgs& field_args,
 	const NoteColumnRenderArgs& column_args,
 	const std::vector<NoteData::TrackMap::const_iterator>& tap_set)
 {
 	bool any_upcoming= false;
 
-	auto loop_body = [this, &field_args, &column_args, &any_upcoming](const NoteData::TrackMap::const_iterator& tapit)
+	// Work out the arrow effects for the whole column up front, rather than
+	// for each note as it's drawn.
+	CalculateTapEffects(field_args, column_args, tap_set);
+	const float move_x= ArrowEffects::GetMoveX(column_args.column);
+	const float move_y= ArrowEffects::GetMoveY(column_args.column);
+	const float move_z= ArrowEffects::GetMoveZ(column_args.column);
+
+	auto loop_body = [this, &field_args, &column_args, &any_upcoming, &tap_set,
+		move_x, move_y, move_z](int tap_index)
 	{
+		const NoteData::TrackMap::const_iterator& tapit= tap_set[tap_index];
 		int tap_row= tapit->first;
 		const TapNote& tn= tapit->second;
 
-		// TRICKY: If boomerang is on, then all notes in the range
-		// [first_row,last_row] aren't necessarily visible.
-		// Test every note to make sure it's on screen before drawing.
-		if(!IsOnScreen(NoteRowToBeat(tap_row), column_args.column,
-				field_args.draw_pixels_after_targets, field_args.draw_pixels_before_targets))
+		const int fx_index= m_TapEffects.index[tap_index];
+		if(fx_index == -1)
 		{
-			return; // skip
+			return; // skip, it's off screen
 		}
+		const TapEffects& fx= m_TapEffects;
+		NoteEffects effects;
+		effects.y_offset= fx.y_offset[fx_index];
+		effects.pos= RageVector3(move_x + fx.x[fx_index],
+			move_y + fx.y[fx_index], move_z + fx.z[fx_index]);
+		effects.rot= RageVector3(fx.rot_x[fx_index], fx.rot_y[fx_index],
+			fx.rot_z[fx_index]);
+		effects.zoom= fx.zoom[fx_index];
+		effects.alpha= fx.alpha[fx_index];
+		effects.glow= fx.glow[fx_index];
 
 		// Hm, this assert used to pass the first and last rows to draw, when it
 		// was in NoteField, but those aren't available here.
@@ -605,19 +704,12 @@ bool NoteDisplay::DrawTapsInRange(const NoteFieldRenderArgs& field_args,
 			}
 		}
 
-		bool in_selection_range = false;
-		if(*field_args.selection_begin_marker != -1 && *field_args.selection_end_marker != -1)
-		{
-			in_selection_range = *field_args.selection_begin_marker <= tap_row &&
-				tap_row < *field_args.selection_end_marker;
-		}
-
 		bool is_addition = (tn.source == TapNoteSource_Addition);
 		DrawTap(tn, field_args, column_args,
 			NoteRowToVisibleBeat(m_pPlayerState, tap_row),
 			hold_begins_on_this_beat, roll_begins_on_this_beat,
-			is_addition,
-			in_selection_range ? field_args.selection_glow : field_args.fail_fade);
+			is_addition, fx.fade_to_fail[fx_index],
+			tn.type == TapNoteType_HoldTail ? nullptr : &effects);
 
 		any_upcoming |= NoteRowToBeat(tap_row) >
 			m_pPlayerState->GetDisplayedPosition().m_fSongBeat;
@@ -631,12 +723,18 @@ bool NoteDisplay::DrawTapsInRange(const NoteFieldRenderArgs& field_args,
 	if (g_bRenderEarlierNotesOnTop.Get())
 	{
 		// draw notes from closest to furthest
-		std::for_each(tap_set.rbegin(), tap_set.rend(), loop_body);
+		for(int i= static_cast<int>(tap_set.size()) - 1; i >= 0; --i)
+		{
+			loop_body(i);
+		}
 	}
 	else
 	{
 		// draw notes from furthest to closest
-		std::for_each(tap_set.begin(), tap_set.end(), loop_body);
+		for(int i= 0; i < static_cast<int>(tap_set.size()); ++i)
+		{
+			loop_body(i);
+		}
 	}
 
 	return any_upcoming;
@@ -1128,6 +1226,11 @@ void NoteDisplay::DrawHoldBody(const TapNote& tn,
 		std::swap( pSpriteTop, pSpriteBottom );
 	}
 
+	// The body is drawn directly, so it has to go on top of any notes that
+	// were collected before it.
+	if( field_args.sprite_batch != nullptr )
+		field_args.sprite_batch->Flush();
+
 	const bool bWavyPartsNeedZBuffer = ArrowEffects::NeedZBuffer();
 	DISPLAY->SetZTestMode( bWavyPartsNeedZBuffer?ZTEST_WRITE_ON_PASS:ZTEST_OFF );
 	DISPLAY->SetZWrite( bWavyPartsNeedZBuffer );
@@ -1266,7 +1369,7 @@ void NoteDisplay::DrawHold(const TapNote& tn,
 void NoteDisplay::DrawActor(const TapNote& tn, Actor* pActor, NotePart part,
 	const NoteFieldRenderArgs& field_args, const NoteColumnRenderArgs& column_args, float fYOffset, float fBeat,
 	bool bIsAddition, float fPercentFadeToFail, float fColorScale,
-	bool is_being_held)
+	bool is_being_held, const NoteEffects* pEffects)
 {
 	if (tn.type == TapNoteType_AutoKeysound && !GAMESTATE->m_bInStepEditor) return;
 	if(fYOffset < field_args.draw_pixels_after_targets ||
@@ -1277,8 +1380,16 @@ void NoteDisplay::DrawActor(const TapNote& tn, Actor* pActor, NotePart part,
 	float spline_beat= fBeat;
 	if(is_being_held) { spline_beat= column_args.song_beat; }
 
-	const float fAlpha= ArrowEffects::GetAlpha(m_pPlayerState, column_args.column, fYOffset, fPercentFadeToFail, m_fYReverseOffsetPixels, field_args.draw_pixels_before_targets, field_args.fade_before_targets);
-	const float fGlow= ArrowEffects::GetGlow(m_pPlayerState, column_args.column, fYOffset, fPercentFadeToFail, m_fYReverseOffsetPixels, field_args.draw_pixels_before_targets, field_args.fade_before_targets);
+	float fAlpha, fGlow;
+	if( pEffects != nullptr )
+	{
+		fAlpha= pEffects->alpha;
+		fGlow= pEffects->glow;
+	}
+	else
+	{
+		ArrowEffects::GetAlphasAndGlows(m_pPlayerState, column_args.column, &fYOffset, &fPercentFadeToFail, 1, m_fYReverseOffsetPixels, field_args.draw_pixels_before_targets, field_args.fade_before_targets, &fAlpha, &fGlow);
+	}
 	const RageColor diffuse	= RageColor(
 		column_args.diffuse.r * fColorScale,
 		column_args.diffuse.g * fColorScale,
@@ -1316,20 +1427,26 @@ void NoteDisplay::DrawActor(const TapNote& tn, Actor* pActor, NotePart part,
 	RageVector3 ae_rot;
 	RageVector3 ae_zoom;
 	column_args.spae_pos_for_beat(m_pPlayerState, spline_beat,
-		fYOffset, m_fYReverseOffsetPixels, sp_pos, ae_pos);
+		fYOffset, m_fYReverseOffsetPixels, sp_pos, ae_pos, pEffects);
 
 	switch(column_args.rot_handler->m_spline_mode)
 	{
 		case NCSM_Disabled:
-			ae_rot.x= ArrowEffects::GetRotationX(m_pPlayerState, fYOffset, bIsHoldCap, column_args.column);
-			ae_rot.y= ArrowEffects::GetRotationY(m_pPlayerState, fYOffset, column_args.column);
-			ae_rot.z= ArrowEffects::GetRotationZ(m_pPlayerState, fBeat, bIsHoldHead, column_args.column);
-			break;
 		case NCSM_Offset:
-			ae_rot.x= ArrowEffects::GetRotationX(m_pPlayerState, fYOffset, bIsHoldCap, column_args.column);
-			ae_rot.y= ArrowEffects::GetRotationY(m_pPlayerState, fYOffset, column_args.column);
-			ae_rot.z= ArrowEffects::GetRotationZ(m_pPlayerState, fBeat, bIsHoldHead, column_args.column);
-			column_args.rot_handler->EvalForBeat(column_args.song_beat, spline_beat, sp_rot);
+			if( pEffects != nullptr )
+			{
+				ae_rot= pEffects->rot;
+			}
+			else
+			{
+				ae_rot.x= ArrowEffects::GetRotationX(m_pPlayerState, fYOffset, bIsHoldCap, column_args.column);
+				ae_rot.y= ArrowEffects::GetRotationY(m_pPlayerState, fYOffset, column_args.column);
+				ae_rot.z= ArrowEffects::GetRotationZ(m_pPlayerState, fBeat, bIsHoldHead, column_args.column);
+			}
+			if( column_args.rot_handler->m_spline_mode == NCSM_Offset )
+			{
+				column_args.rot_handler->EvalForBeat(column_args.song_beat, spline_beat, sp_rot);
+			}
 			break;
 		case NCSM_Position:
 			column_args.rot_handler->EvalForBeat(column_args.song_beat, spline_beat, sp_rot);
@@ -1337,7 +1454,7 @@ void NoteDisplay::DrawActor(const TapNote& tn, Actor* pActor, NotePart part,
 		default:
 			break;
 	}
-	column_args.spae_zoom_for_beat(m_pPlayerState, spline_beat, sp_zoom, ae_zoom, column_args.column, fYOffset);
+	column_args.spae_zoom_for_beat(m_pPlayerState, spline_beat, sp_zoom, ae_zoom, column_args.column, fYOffset, pEffects);
 	column_args.SetPRZForActor(pActor, sp_pos, ae_pos, sp_rot, ae_rot, sp_zoom, ae_zoom);
 	// [AJ] this two lines (and how they're handled) piss off many people:
 	pActor->SetDiffuse( diffuse );
@@ -1373,7 +1490,21 @@ void NoteDisplay::DrawActor(const TapNote& tn, Actor* pActor, NotePart part,
 		DISPLAY->TextureTranslate( (bIsAddition ? cache->m_fAdditionTextureCoordOffset[part] : RageVector2(0,0)) + cache->m_fNoteColorTextureCoordSpacing[part]*color );
 	}
 
+	// Plain sprites are collected into the field's batch.  Anything else, like
+	// an ActorFrame or a Model from the noteskin, is drawn right away, on top
+	// of what's been collected so far.
+	SpriteBatch *pBatch = field_args.sprite_batch;
+	if( pBatch != nullptr && dynamic_cast<Sprite*>(pActor) == nullptr )
+	{
+		pBatch->Flush();
+		pBatch = nullptr;
+	}
+
+	if( pBatch != nullptr )
+		pBatch->StartCollecting();
 	pActor->Draw();
+	if( pBatch != nullptr )
+		pBatch->StopCollecting();
 
 	if( bNeedsTranslate )
 	{
@@ -1385,7 +1516,7 @@ void NoteDisplay::DrawTap(const TapNote& tn,
 	const NoteFieldRenderArgs& field_args,
 	const NoteColumnRenderArgs& column_args, float fBeat,
 	bool bOnSameRowAsHoldStart, bool bOnSameRowAsRollStart,
-	bool bIsAddition, float fPercentFadeToFail)
+	bool bIsAddition, float fPercentFadeToFail, const NoteEffects* pEffects)
 {
 	Actor* pActor = nullptr;
 	NotePart part = NotePart_Tap;
@@ -1457,9 +1588,10 @@ void NoteDisplay::DrawTap(const TapNote& tn,
 		pActor->HandleMessage( msg );
 	}
 
-	const float fYOffset = ArrowEffects::GetYOffset( m_pPlayerState, column_args.column, fBeat );
+	const float fYOffset = pEffects != nullptr ? pEffects->y_offset :
+		ArrowEffects::GetYOffset( m_pPlayerState, column_args.column, fBeat );
 	// this is the line that forces the (1,1,1,x) part of the noteskin diffuse -aj
-	DrawActor(tn, pActor, part, field_args, column_args, fYOffset, fBeat, bIsAddition, fPercentFadeToFail, 1.0f, false);
+	DrawActor(tn, pActor, part, field_args, column_args, fYOffset, fBeat, bIsAddition, fPercentFadeToFail, 1.0f, false, pEffects);
 
 	if( tn.type == TapNoteType_Attack )
 		pActor->PlayCommand( "UnsetAttack" );
@@ -15,6 +15,7 @@ class Model;
 class PlayerState;
 class GhostArrowRow;
 class ReceptorArrowRow;
+class SpriteBatch;
 struct TapNote;
 struct HoldNoteResult;
 struct NoteMetricCache_t;
@@ -123,6 +124,8 @@ struct NoteFieldRenderArgs
 	float selection_glow;
 	float fail_fade;
 	float fade_before_targets;
+	// Note sprites go here instead of being drawn one at a time, if it's set.
+	SpriteBatch* sprite_batch;
 };
 
 // NCSplineHandler exists to allow NoteColumnRenderer to have separate
@@ -155,13 +158,29 @@ struct NCSplineHandler
 	void PushSelf(lua_State* L);
 };
 
+// The ArrowEffects results for one note, for notes that had theirs worked out
+// along with the rest of the column.  See NoteDisplay::DrawTapsInRange.
+struct NoteEffects
+{
+	float y_offset;
+	RageVector3 pos;
+	RageVector3 rot;
+	float zoom;
+	float alpha;
+	float glow;
+};
+
 struct NoteColumnRenderArgs
 {
+	// If effects is set, the ArrowEffects part comes from there instead of
+	// being worked out again.
 	void spae_pos_for_beat(const PlayerState* player_state,
 		float beat, float y_offset, float y_reverse_offset,
-		RageVector3& sp_pos, RageVector3& ae_pos) const;
+		RageVector3& sp_pos, RageVector3& ae_pos,
+		const NoteEffects* effects= nullptr) const;
 	void spae_zoom_for_beat(const PlayerState* state, float beat,
-		RageVector3& sp_zoom, RageVector3& ae_zoom, int col_num, float y_offset) const;
+		RageVector3& sp_zoom, RageVector3& ae_zoom, int col_num, float y_offset,
+		const NoteEffects* effects= nullptr) const;
 	void SetPRZForActor(Actor* actor,
 		const RageVector3& sp_pos, const RageVector3& ae_pos,
 		const RageVector3& sp_rot, const RageVector3& ae_rot,
@@ -206,11 +225,13 @@ public:
 	 * @param fReverseOffsetPixels How are the notes adjusted on Reverse?
 	 * @param fDrawDistanceAfterTargetsPixels how much to draw after the receptors.
 	 * @param fDrawDistanceBeforeTargetsPixels how much ot draw before the receptors.
-	 * @param fFadeInPercentOfDrawFar when to start fading in. */
+	 * @param fFadeInPercentOfDrawFar when to start fading in.
+	 * @param pEffects the note's ArrowEffects, if they're already known. */
 	void DrawTap(const TapNote& tn, const NoteFieldRenderArgs& field_args,
 		const NoteColumnRenderArgs& column_args, float fBeat,
 		bool bOnSameRowAsHoldStart,
-		bool bOnSameRowAsRollBeat, bool bIsAddition, float fPercentFadeToFail);
+		bool bOnSameRowAsRollBeat, bool bIsAddition, float fPercentFadeToFail,
+		const NoteEffects* pEffects= nullptr);
 	void DrawHold(const TapNote& tn, const NoteFieldRenderArgs& field_args,
 		const NoteColumnRenderArgs& column_args, int iRow, bool bIsBeingHeld,
 		const HoldNoteResult &Result,
@@ -246,7 +267,10 @@ private:
 		const NoteFieldRenderArgs& field_args,
 		const NoteColumnRenderArgs& column_args, float fYOffset, float fBeat,
 		bool bIsAddition, float fPercentFadeToFail, float fColorScale,
-		bool is_being_held);
+		bool is_being_held, const NoteEffects* pEffects= nullptr);
+	void CalculateTapEffects(const NoteFieldRenderArgs& field_args,
+		const NoteColumnRenderArgs& column_args,
+		const std::vector<NoteData::TrackMap::const_iterator>& tap_set);
 	void DrawHoldPart(std::vector<Sprite*> &vpSpr,
 		const NoteFieldRenderArgs& field_args,
 		const NoteColumnRenderArgs& column_args,
@@ -277,6 +301,24 @@ private:
 	NoteColorSprite		m_HoldBottomCap[NUM_HoldType][NUM_ActiveType];
 	NoteColorActor		m_HoldTail[NUM_HoldType][NUM_ActiveType];
 	float			m_fYReverseOffsetPixels;
+
+	// The ArrowEffects for the taps DrawTapsInRange is drawing, filled in by
+	// CalculateTapEffects.  Kept between frames to save reallocating it.
+	struct TapEffects
+	{
+		// For each note in the tap set, its entry in the arrays below, or -1
+		// if it's off screen.
+		std::vector<int> index;
+		std::vector<float> beat;
+		std::vector<float> y_offset;
+		std::vector<float> fade_to_fail;
+		std::vector<float> x, y, z;
+		std::vector<float> rot_x, rot_y, rot_z;
+		std::vector<float> zoom;
+		std::vector<float> alpha;
+		std::vector<float> glow;
+	};
+	TapEffects		m_TapEffects;
 };
 
 // So, this is a bit screwy, and it's partly because routine forces rendering
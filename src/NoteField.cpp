@@ -19,6 +19,8 @@
 #include "Course.h"
 #include "NoteData.h"
 #include "RageDisplay.h"
+#include "Preference.h"
+#include "PrefsManager.h"
 
 #include <cfloat>
 #include <cmath>
@@ -38,6 +40,10 @@ static ThemeMetric<float> BAR_8TH_ALPHA( "NoteField", "Bar8thAlpha" );
 static ThemeMetric<float> BAR_16TH_ALPHA( "NoteField", "Bar16thAlpha" );
 static ThemeMetric<float> FADE_FAIL_TIME( "NoteField", "FadeFailTime" );
 
+/* Draw runs of note sprites that share a texture in one call instead of one
+ * at a time.  The notes are still drawn in the same order. */
+static Preference<bool> g_bBatchNoteRendering( "BatchNoteRendering", false );
+
 static RString RoutineNoteSkinName( std::size_t i ) { return ssprintf("RoutineNoteSkinP%i",int(i+1)); }
 static ThemeMetric1D<RString> ROUTINE_NOTESKIN( "NoteField", RoutineNoteSkinName, NUM_PLAYERS );
 
@@ -74,6 +80,7 @@ NoteField::NoteField()
 	m_iBeginMarker = m_iEndMarker = -1;
 
 	m_FieldRenderArgs.fail_fade = -1;
+	m_FieldRenderArgs.sprite_batch = nullptr;
 
 	m_StepCallback.SetFromNil();
 	m_SetPressedCallback.SetFromNil();
@@ -1036,10 +1043,29 @@ void NoteField::DrawPrimitives()
 	}
 	m_FieldRenderArgs.fade_before_targets= FADE_BEFORE_TARGETS_PERCENT;
 
+	// Without FastNoteRendering, each note clears the Z buffer after it's
+	// drawn, so they can't be batched.
+	m_FieldRenderArgs.sprite_batch = nullptr;
+	if( g_bBatchNoteRendering && PREFSMAN->m_FastNoteRendering )
+	{
+		m_SpriteBatch.Open();
+		m_FieldRenderArgs.sprite_batch = &m_SpriteBatch;
+	}
+
 	for( int j=0; j<m_pNoteData->GetNumTracks(); j++ )	// for each arrow column
 	{
 		const int c = pStyle->m_iColumnDrawOrder[j];
 		m_ColumnRenderers[c].Draw();
+
+		// Keep each column under the ones drawn after it.
+		if( m_FieldRenderArgs.sprite_batch != nullptr )
+			m_SpriteBatch.Flush();
+	}
+
+	if( m_FieldRenderArgs.sprite_batch != nullptr )
+	{
+		m_SpriteBatch.Draw();
+		m_FieldRenderArgs.sprite_batch = nullptr;
 	}
 
 	cur->m_GhostArrowRow.Draw();
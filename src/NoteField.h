@@ -10,6 +10,7 @@
 #include "NoteDisplay.h"
 #include "ReceptorArrowRow.h"
 #include "GhostArrowRow.h"
+#include "SpriteBatch.h"
 
 #include <vector>
 
@@ -110,6 +111,7 @@ protected:
 	};
 
 	NoteFieldRenderArgs m_FieldRenderArgs;
+	SpriteBatch m_SpriteBatch;
 
 	/* All loaded note displays, mapped by their name. */
 	std::map<RString, NoteDisplayCols *> m_NoteDisplays;
@@ -19,8 +19,6 @@
 
 Difficulty DwiCompatibleStringToDifficulty( const RString& sDC );
 
-static std::map<int,int> g_mapDanceNoteToNoteDataColumn;
-
 /** @brief The different types of core DWI arrows and pads. */
 enum DanceNotes
 {
@@ -101,19 +99,21 @@ static void DWIcharToNote( char c, GameController i, int &note1Out, int &note2Ou
  * @param col1Out The first result based on the character.
  * @param col2Out The second result based on the character.
  * @param sPath the path to the file.
+ * @param mapDanceNoteToColumn the column of each DanceNotes for this chart.
  */
-static void DWIcharToNoteCol( char c, GameController i, int &col1Out, int &col2Out, const RString &sPath )
+static void DWIcharToNoteCol( char c, GameController i, int &col1Out, int &col2Out, const RString &sPath,
+			      std::map<int,int> &mapDanceNoteToColumn )
 {
 	int note1, note2;
 	DWIcharToNote( c, i, note1, note2, sPath );
 
 	if( note1 != DANCE_NOTE_NONE )
-		col1Out = g_mapDanceNoteToNoteDataColumn[note1];
+		col1Out = mapDanceNoteToColumn[note1];
 	else
 		col1Out = -1;
 
 	if( note2 != DANCE_NOTE_NONE )
-		col2Out = g_mapDanceNoteToNoteDataColumn[note2];
+		col2Out = mapDanceNoteToColumn[note2];
 	else
 		col2Out = -1;
 }
@@ -190,39 +190,39 @@ static StepsType GetTypeFromMode(const RString &mode)
 static NoteData ParseNoteData(RString &step1, RString &step2,
 			      Steps &out, const RString &path)
 {
-	g_mapDanceNoteToNoteDataColumn.clear();
+	std::map<int,int> mapDanceNoteToColumn;
 	switch( out.m_StepsType )
 	{
 		case StepsType_dance_single:
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_LEFT] = 0;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_DOWN] = 1;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_UP] = 2;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_RIGHT] = 3;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_LEFT] = 0;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_DOWN] = 1;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_UP] = 2;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_RIGHT] = 3;
 			break;
 		case StepsType_dance_double:
 		case StepsType_dance_couple:
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_LEFT] = 0;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_DOWN] = 1;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_UP] = 2;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_RIGHT] = 3;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD2_LEFT] = 4;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD2_DOWN] = 5;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD2_UP] = 6;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD2_RIGHT] = 7;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_LEFT] = 0;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_DOWN] = 1;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_UP] = 2;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_RIGHT] = 3;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD2_LEFT] = 4;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD2_DOWN] = 5;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD2_UP] = 6;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD2_RIGHT] = 7;
 			break;
 		case StepsType_dance_solo:
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_LEFT] = 0;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_UPLEFT] = 1;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_DOWN] = 2;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_UP] = 3;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_UPRIGHT] = 4;
-			g_mapDanceNoteToNoteDataColumn[DANCE_NOTE_PAD1_RIGHT] = 5;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_LEFT] = 0;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_UPLEFT] = 1;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_DOWN] = 2;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_UP] = 3;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_UPRIGHT] = 4;
+			mapDanceNoteToColumn[DANCE_NOTE_PAD1_RIGHT] = 5;
 			break;
 			DEFAULT_FAIL( out.m_StepsType );
 	}
 
 	NoteData newNoteData;
-	newNoteData.SetNumTracks( g_mapDanceNoteToNoteDataColumn.size() );
+	newNoteData.SetNumTracks( mapDanceNoteToColumn.size() );
 
 	for( int pad=0; pad<2; pad++ )		// foreach pad
 	{
@@ -317,7 +317,8 @@ static NoteData ParseNoteData(RString &step1, RString &step2,
 								 (GameController)pad,
 								 iCol1,
 								 iCol2,
-								 path );
+								 path,
+								 mapDanceNoteToColumn );
 
 						if( iCol1 != -1 )
 							newNoteData.SetTapNote(iCol1,
@@ -344,7 +345,8 @@ static NoteData ParseNoteData(RString &step1, RString &step2,
 									 (GameController)pad,
 									 iCol1,
 									 iCol2,
-									 path );
+									 path,
+									 mapDanceNoteToColumn );
 
 							if( iCol1 != -1 )
 								newNoteData.SetTapNote(iCol1,
@@ -98,12 +98,12 @@ void SMSetOffset(SMSongTagInfo& info)
 void SMSetBPMs(SMSongTagInfo& info)
 {
 	info.BPMChanges.clear();
-	info.loader->ParseBPMs(info.BPMChanges, (*info.params)[1]);
+	info.loader->ParseBPMs(info.BPMChanges, info.params->GetView(1));
 }
 void SMSetStops(SMSongTagInfo& info)
 {
 	info.Stops.clear();
-	info.loader->ParseStops(info.Stops, (*info.params)[1]);
+	info.loader->ParseStops(info.Stops, info.params->GetView(1));
 }
 void SMSetDelays(SMSongTagInfo& info)
 {
@@ -291,7 +291,7 @@ void SMLoader::LoadFromTokens(
 			     RString sDifficulty,
 			     RString sMeter,
 			     RString sRadarValues,
-			     RString sNoteData,
+			     std::string_view sNoteData,
 			     Steps &out
 			     )
 {
@@ -441,26 +441,29 @@ void SMLoader::ProcessInstrumentTracks( Song &out, const RString &sParam )
 	}
 }
 
-void SMLoader::ParseBPMs( std::vector<std::pair<float, float>> &out, const RString line, const int rowsPerBeat )
+void SMLoader::ParseBPMs( std::vector<std::pair<float, float>> &out, std::string_view line, const int rowsPerBeat )
 {
-	std::vector<RString> arrayBPMChangeExpressions;
-	split( line, ",", arrayBPMChangeExpressions );
+	std::vector<std::string_view> arrayBPMChangeExpressions;
+	split( line, ',', arrayBPMChangeExpressions );
 
+	std::vector<std::string_view> arrayBPMChangeValues;
 	for( unsigned b=0; b<arrayBPMChangeExpressions.size(); b++ )
 	{
-		std::vector<RString> arrayBPMChangeValues;
-		split( arrayBPMChangeExpressions[b], "=", arrayBPMChangeValues );
+		arrayBPMChangeValues.clear();
+		split( arrayBPMChangeExpressions[b], '=', arrayBPMChangeValues );
 		if( arrayBPMChangeValues.size() != 2 )
 		{
 			LOG->UserLog("Song file",
 				     this->GetSongTitle(),
-				     "has an invalid #BPMs value \"%s\" (must have exactly one '='), ignored.",
-				     arrayBPMChangeExpressions[b].c_str() );
+				     "has an invalid #BPMs value \"%.*s\" (must have exactly one '='), ignored.",
+				     int(arrayBPMChangeExpressions[b].size()), arrayBPMChangeExpressions[b].data() );
 			continue;
 		}
 
-		const float fBeat = RowToBeat( arrayBPMChangeValues[0], rowsPerBeat );
-		const float fNewBPM = StringToFloat( arrayBPMChangeValues[1] );
+		const RString sBeat( arrayBPMChangeValues[0].data(), arrayBPMChangeValues[0].size() );
+		const RString sNewBPM( arrayBPMChangeValues[1].data(), arrayBPMChangeValues[1].size() );
+		const float fBeat = RowToBeat( sBeat, rowsPerBeat );
+		const float fNewBPM = StringToFloat( sNewBPM );
 		if( fNewBPM == 0 ) {
 			LOG->UserLog("Song file", this->GetSongTitle(),
 				     "has a zero BPM; ignored.");
@@ -471,26 +474,29 @@ void SMLoader::ParseBPMs( std::vector<std::pair<float, float>> &out, const RStri
 	}
 }
 
-void SMLoader::ParseStops( std::vector<std::pair<float, float>> &out, const RString line, const int rowsPerBeat )
+void SMLoader::ParseStops( std::vector<std::pair<float, float>> &out, std::string_view line, const int rowsPerBeat )
 {
-	std::vector<RString> arrayFreezeExpressions;
-	split( line, ",", arrayFreezeExpressions );
+	std::vector<std::string_view> arrayFreezeExpressions;
+	split( line, ',', arrayFreezeExpressions );
 
+	std::vector<std::string_view> arrayFreezeValues;
 	for( unsigned f=0; f<arrayFreezeExpressions.size(); f++ )
 	{
-		std::vector<RString> arrayFreezeValues;
-		split( arrayFreezeExpressions[f], "=", arrayFreezeValues );
+		arrayFreezeValues.clear();
+		split( arrayFreezeExpressions[f], '=', arrayFreezeValues );
 		if( arrayFreezeValues.size() != 2 )
 		{
 			LOG->UserLog("Song file",
 				     this->GetSongTitle(),
-				     "has an invalid #STOPS value \"%s\" (must have exactly one '='), ignored.",
-				     arrayFreezeExpressions[f].c_str() );
+				     "has an invalid #STOPS value \"%.*s\" (must have exactly one '='), ignored.",
+				     int(arrayFreezeExpressions[f].size()), arrayFreezeExpressions[f].data() );
 			continue;
 		}
 
-		const float fFreezeBeat = RowToBeat( arrayFreezeValues[0], rowsPerBeat );
-		const float fFreezeSeconds = StringToFloat( arrayFreezeValues[1] );
+		const RString sFreezeBeat( arrayFreezeValues[0].data(), arrayFreezeValues[0].size() );
+		const RString sFreezeSeconds( arrayFreezeValues[1].data(), arrayFreezeValues[1].size() );
+		const float fFreezeBeat = RowToBeat( sFreezeBeat, rowsPerBeat );
+		const float fFreezeSeconds = StringToFloat( sFreezeSeconds );
 		if( fFreezeSeconds == 0 ) {
 			LOG->UserLog("Song file", this->GetSongTitle(),
 				     "has a zero-length stop; ignored.");
@@ -1090,7 +1096,7 @@ bool SMLoader::LoadNoteDataFromSimfile( const RString &path, Steps &out )
 				continue;
 			}
 
-			RString noteData = sParams[6];
+			std::string_view noteData = sParams.GetView(6);
 			Trim( noteData );
 			out.SetSMNoteData( noteData );
 			out.TidyUpData();
@@ -1151,7 +1157,7 @@ bool SMLoader::LoadFromSimfile( const RString &sPath, Song &out, bool bFromCache
 				sParams[3],
 				sParams[4],
 				sParams[5],
-				sParams[6],
+				sParams.GetView(6),
 				*pNewNotes);
 
 			pNewNotes->SetFilename(sPath);
@@ -1257,7 +1263,7 @@ bool SMLoader::LoadEditFromMsd( const MsdFile &msd, const RString &sEditFilePath
 
 			Steps* pNewNotes = pSong->CreateSteps();
 			LoadFromTokens(
-				sParams[1], sParams[2], sParams[3], sParams[4], sParams[5], sParams[6],
+				sParams[1], sParams[2], sParams[3], sParams[4], sParams[5], sParams.GetView(6),
 				*pNewNotes);
 
 			pNewNotes->SetLoadedFromProfile( slot );
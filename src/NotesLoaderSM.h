@@ -76,7 +76,7 @@ struct SMLoader
 	 * @param line the string in question.
 	 * @param rowsPerBeat the number of rows per beat for this purpose. */
 	void ParseBPMs(std::vector<std::pair<float, float>> &out,
-	               const RString line,
+	               std::string_view line,
 	               const int rowsPerBeat = -1);
 	/**
 	 * @brief Process the BPM Segments from the string.
@@ -90,7 +90,7 @@ struct SMLoader
 	 * @param line the string in question.
 	 * @param rowsPerBeat the number of rows per beat for this purpose. */
 	void ParseStops(std::vector<std::pair<float, float>> &out,
-	                const RString line,
+	                std::string_view line,
 	                const int rowsPerBeat = -1);
 	/**
 	 * @brief Process the Stop Segments from the data.
@@ -188,14 +188,14 @@ protected:
 	 * @param difficulty The difficulty (in words) of the chart.
 	 * @param meter the difficulty (in numbers) of the chart.
 	 * @param radarValues the calculated radar values.
-	 * @param noteData the note data itself.
+	 * @param noteData the note data itself, which is copied into out once.
 	 * @param out the Steps getting the data. */
 	virtual void LoadFromTokens(RString sStepsType,
 				    RString sDescription,
 				    RString sDifficulty,
 				    RString sMeter,
 				    RString sRadarValues,
-				    RString sNoteData,
+				    std::string_view sNoteData,
 				    Steps &out);
 
 	/**
@@ -367,13 +367,13 @@ bool SMALoader::LoadFromSimfile( const RString &sPath, Song &out, bool bFromCach
 		else if( sValueName=="BPMS" )
 		{
 			vBPMChanges.clear();
-			ParseBPMs( vBPMChanges, sParams[1], iRowsPerBeat );
+			ParseBPMs( vBPMChanges, sParams.GetView(1), iRowsPerBeat );
 		}
 
 		else if( sValueName=="STOPS" || sValueName=="FREEZES" )
 		{
 			vStops.clear();
-			ParseStops( vStops, sParams[1], iRowsPerBeat );
+			ParseStops( vStops, sParams.GetView(1), iRowsPerBeat );
 		}
 
 		else if( sValueName=="DELAYS" )
@@ -444,7 +444,7 @@ bool SMALoader::LoadFromSimfile( const RString &sPath, Song &out, bool bFromCach
 					 sParams[3],
 					 sParams[4],
 					 sParams[5],
-					 sParams[6],
+					 sParams.GetView(6),
 					 *pNewNotes );
 			pNewNotes->SetFilename(sPath);
 			out.AddSteps( pNewNotes );
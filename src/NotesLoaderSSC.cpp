@@ -242,7 +242,7 @@ void SetOffset(SongTagInfo& info)
 }
 void SetSongStops(SongTagInfo& info)
 {
-	info.loader->ProcessStops(info.song->m_SongTiming, (*info.params)[1]);
+	info.loader->ProcessStops(info.song->m_SongTiming, info.params->GetView(1));
 }
 void SetSongDelays(SongTagInfo& info)
 {
@@ -250,7 +250,7 @@ void SetSongDelays(SongTagInfo& info)
 }
 void SetSongBPMs(SongTagInfo& info)
 {
-	info.loader->ProcessBPMs(info.song->m_SongTiming, (*info.params)[1]);
+	info.loader->ProcessBPMs(info.song->m_SongTiming, info.params->GetView(1));
 }
 void SetSongWarps(SongTagInfo& info)
 {
@@ -396,7 +396,7 @@ void SetStepsBPMs(StepsTagInfo& info)
 {
 	if(info.song->m_fVersion >= VERSION_SPLIT_TIMING || info.for_load_edit)
 	{
-		info.loader->ProcessBPMs(*info.timing, (*info.params)[1]);
+		info.loader->ProcessBPMs(*info.timing, info.params->GetView(1));
 		info.has_own_timing = true;
 	}
 	info.ssc_format= true;
@@ -405,7 +405,7 @@ void SetStepsStops(StepsTagInfo& info)
 {
 	if(info.song->m_fVersion >= VERSION_SPLIT_TIMING || info.for_load_edit)
 	{
-		info.loader->ProcessStops(*info.timing, (*info.params)[1]);
+		info.loader->ProcessStops(*info.timing, info.params->GetView(1));
 		info.has_own_timing = true;
 	}
 	info.ssc_format= true;
@@ -645,26 +645,29 @@ ssc_parser_helper_t parser_helper;
 // End parser_helper related functions. -Kyz
 /****************************************************************/
 
-void SSCLoader::ProcessBPMs( TimingData &out, const RString sParam )
+void SSCLoader::ProcessBPMs( TimingData &out, std::string_view sParam )
 {
-	std::vector<RString> arrayBPMExpressions;
-	split( sParam, ",", arrayBPMExpressions );
+	std::vector<std::string_view> arrayBPMExpressions;
+	split( sParam, ',', arrayBPMExpressions );
 
+	std::vector<std::string_view> arrayBPMValues;
 	for( unsigned b=0; b<arrayBPMExpressions.size(); b++ )
 	{
-		std::vector<RString> arrayBPMValues;
-		split( arrayBPMExpressions[b], "=", arrayBPMValues );
+		arrayBPMValues.clear();
+		split( arrayBPMExpressions[b], '=', arrayBPMValues );
 		if( arrayBPMValues.size() != 2 )
 		{
 			LOG->UserLog("Song file",
 				     this->GetSongTitle(),
-				     "has an invalid #BPMS value \"%s\" (must have exactly one '='), ignored.",
-				     arrayBPMExpressions[b].c_str() );
+				     "has an invalid #BPMS value \"%.*s\" (must have exactly one '='), ignored.",
+				     int(arrayBPMExpressions[b].size()), arrayBPMExpressions[b].data() );
 			continue;
 		}
 
-		const float fBeat = StringToFloat( arrayBPMValues[0] );
-		const float fNewBPM = StringToFloat( arrayBPMValues[1] );
+		const RString sBeat( arrayBPMValues[0].data(), arrayBPMValues[0].size() );
+		const RString sNewBPM( arrayBPMValues[1].data(), arrayBPMValues[1].size() );
+		const float fBeat = StringToFloat( sBeat );
+		const float fNewBPM = StringToFloat( sNewBPM );
 		if( fBeat >= 0 && fNewBPM > 0 )
 		{
 			out.AddSegment( BPMSegment(BeatToNoteRow(fBeat), fNewBPM) );
@@ -679,26 +682,29 @@ void SSCLoader::ProcessBPMs( TimingData &out, const RString sParam )
 	}
 }
 
-void SSCLoader::ProcessStops( TimingData &out, const RString sParam )
+void SSCLoader::ProcessStops( TimingData &out, std::string_view sParam )
 {
-	std::vector<RString> arrayStopExpressions;
-	split( sParam, ",", arrayStopExpressions );
+	std::vector<std::string_view> arrayStopExpressions;
+	split( sParam, ',', arrayStopExpressions );
 
+	std::vector<std::string_view> arrayStopValues;
 	for( unsigned b=0; b<arrayStopExpressions.size(); b++ )
 	{
-		std::vector<RString> arrayStopValues;
-		split( arrayStopExpressions[b], "=", arrayStopValues );
+		arrayStopValues.clear();
+		split( arrayStopExpressions[b], '=', arrayStopValues );
 		if( arrayStopValues.size() != 2 )
 		{
 			LOG->UserLog("Song file",
 				     this->GetSongTitle(),
-				     "has an invalid #STOPS value \"%s\" (must have exactly one '='), ignored.",
-				     arrayStopExpressions[b].c_str() );
+				     "has an invalid #STOPS value \"%.*s\" (must have exactly one '='), ignored.",
+				     int(arrayStopExpressions[b].size()), arrayStopExpressions[b].data() );
 			continue;
 		}
 
-		const float fBeat = StringToFloat( arrayStopValues[0] );
-		const float fNewStop = StringToFloat( arrayStopValues[1] );
+		const RString sBeat( arrayStopValues[0].data(), arrayStopValues[0].size() );
+		const RString sNewStop( arrayStopValues[1].data(), arrayStopValues[1].size() );
+		const float fBeat = StringToFloat( sBeat );
+		const float fNewStop = StringToFloat( sNewStop );
 		if( fBeat >= 0 && fNewStop > 0 )
 			out.AddSegment( StopSegment(BeatToNoteRow(fBeat), fNewStop) );
 		else
@@ -865,13 +871,18 @@ bool SSCLoader::LoadNoteDataFromSimfile( const RString & cachePath, Steps &out )
 		const MsdFile::value_t &params = msd.GetValue(i);
 		RString valueName = params[0];
 		valueName.MakeUpper();
-		RString matcher = params[1]; // mainly for debugging.
-		Trim(matcher);
 
 		load_note_data_handler_map_t::iterator handler=
 			parser_helper.load_note_data_handlers.find(valueName);
 		if(handler != parser_helper.load_note_data_handlers.end())
 		{
+			std::string_view matcherView = params.GetView(1);
+			Trim(matcherView);
+			// The notes go straight into the Steps; only copy the small tags.
+			RString matcher;
+			if(handler->second != LNDID_notes && handler->second != LNDID_notes2)
+			{ matcher.assign(matcherView.data(), matcherView.size()); }
+
 			if(tryingSteps)
 			{
 				switch(handler->second)
@@ -918,7 +929,7 @@ bool SSCLoader::LoadNoteDataFromSimfile( const RString & cachePath, Steps &out )
 						break;
 					case LNDID_notes:
 					case LNDID_notes2:
-						out.SetSMNoteData(matcher);
+						out.SetSMNoteData(matcherView);
 						out.TidyUpData();
 						return true;
 					default:
@@ -1024,7 +1035,7 @@ bool SSCLoader::LoadFromSimfile( const RString &sPath, Song &out, bool bFromCach
 					if(reused_steps_info.has_own_timing)
 					{ pNewNotes->m_Timing = stepsTiming; }
 					reused_steps_info.has_own_timing = false;
-					pNewNotes->SetSMNoteData(sParams[1]);
+					pNewNotes->SetSMNoteData(sParams.GetView(1));
 					pNewNotes->TidyUpData();
 					pNewNotes->SetFilename(sPath);
 					out.AddSteps(pNewNotes);
@@ -1157,7 +1168,7 @@ bool SSCLoader::LoadEditFromMsd(const MsdFile &msd,
 				{
 					if(reused_steps_info.has_own_timing)
 					{ pNewNotes->m_Timing = stepsTiming; }
-					pNewNotes->SetSMNoteData(sParams[1]);
+					pNewNotes->SetSMNoteData(sParams.GetView(1));
 					pNewNotes->TidyUpData();
 				}
 				else
@@ -1168,7 +1179,7 @@ bool SSCLoader::LoadEditFromMsd(const MsdFile &msd,
 						sParams[3],
 						sParams[4],
 						sParams[5],
-						sParams[6],
+						sParams.GetView(6),
 						*pNewNotes);
 				}
 
@@ -3,6 +3,7 @@
 #include "GameConstantsAndTypes.h"
 #include "RageUtil.h"
 #include "RageTimer.h"
+#include "RageLatency.h"
 #include "PrefsManager.h"
 #include "GameManager.h"
 #include "InputMapper.h"
@@ -165,6 +166,9 @@ static Preference<float> m_fTimingWindowAdd	( "TimingWindowAdd",		0 );
 static Preference1D<float> m_fTimingWindowSeconds( TimingWindowSecondsInit, NUM_TimingWindow );
 static Preference<float> m_fTimingWindowJump	( "TimingWindowJump",		0.25 );
 static Preference<float> m_fMaxInputLatencySeconds	( "MaxInputLatencySeconds",	0.0 );
+/* Place each step on the song at the moment the input driver stamped it, not
+ * when the frame got around to handling it. */
+static Preference<bool> g_bJudgeAtInputTime	( "JudgeAtInputTime", false );
 static Preference<bool> g_bEnableAttackSoundPlayback	( "EnableAttackSounds", true );
 static Preference<bool> g_bEnableMineSoundPlayback	( "EnableMineHitSound", true );
 static Preference<TapNoteScore> g_MinTNSToScoreNotes	( "MinTNSToScoreNotes", TNS_None, ValidateMinTNSToScoreNotes );  // Default to great and above.
@@ -618,23 +622,6 @@ static bool NeedsHoldJudging( const TapNote &tn )
 
 static void GenerateCacheDataStructure(PlayerState *pPlayerState, const NoteData &notes) {
 
-	pPlayerState->m_CacheDisplayedBeat.clear();
-
-	const std::vector<TimingSegment*> vScrolls = pPlayerState->GetDisplayedTiming().GetTimingSegments( SEGMENT_SCROLL );
-
-	float displayedBeat = 0.0f;
-	float lastRealBeat = 0.0f;
-	float lastRatio = 1.0f;
-	for ( unsigned i = 0; i < vScrolls.size(); i++ )
-	{
-		ScrollSegment *seg = ToScroll( vScrolls[i] );
-		displayedBeat += ( seg->GetBeat() - lastRealBeat ) * lastRatio;
-		lastRealBeat = seg->GetBeat();
-		lastRatio = seg->GetRatio();
-		CacheDisplayedBeat c = { seg->GetBeat(), displayedBeat, seg->GetRatio() };
-		pPlayerState->m_CacheDisplayedBeat.push_back( c );
-	}
-
 	pPlayerState->m_CacheNoteStat.clear();
 
 	NoteData::all_tracks_const_iterator it = notes.GetTapNoteRangeAllTracks( 0, MAX_NOTE_ROW, true );
@@ -737,6 +724,11 @@ void Player::Load()
 		default: break;
 	}
 
+	/* The transforms are done; from here on the notes are mostly looked up, so
+	 * keep them in flat storage too.  Attacks that transform them again rebuild
+	 * it when they revalidate our iterators. */
+	m_NoteData.SetFlatStorage( true );
+
 	int iDrawDistanceAfterTargetsPixels = GAMESTATE->IsEditing() ? -100 : DRAW_DISTANCE_AFTER_TARGET_PIXELS;
 	int iDrawDistanceBeforeTargetsPixels = GAMESTATE->IsEditing() ? 400 : DRAW_DISTANCE_BEFORE_TARGET_PIXELS;
 
@@ -802,6 +794,9 @@ void Player::Load()
 
 	SAFE_DELETE( m_pIterUnjudgedMineRows );
 	m_pIterUnjudgedMineRows = new NoteData::all_tracks_iterator( m_NoteData.GetTapNoteRangeAllTracks(iNoteRow, MAX_NOTE_ROW ) );
+
+	// Like the iterators above, anything before where we start is out of play.
+	m_viFirstUnjudgedRow.assign( m_NoteData.GetNumTracks(), iNoteRow );
 }
 
 void Player::SendComboMessages( unsigned int iOldCombo, unsigned int iOldMissCombo )
@@ -1190,8 +1185,15 @@ void Player::Update( float fDeltaTime )
 	// Check for TapNote misses
 	if (!GAMESTATE->m_bInStepEditor)
 	{
-		UpdateTapNotesMissedOlderThan( GetMaxStepDistanceSeconds() );
+		float fMissIfOlderThanSeconds = GetMaxStepDistanceSeconds();
+		/* Input is handled after screens update, so this frame's steps haven't
+		 * been seen yet.  Hold misses back a frame so a step that arrived in
+		 * time is judged before its note is missed. */
+		if( g_bJudgeAtInputTime )
+			fMissIfOlderThanSeconds += fDeltaTime * GAMESTATE->m_SongOptions.GetCurrent().m_fMusicRate;
+		UpdateTapNotesMissedOlderThan( fMissIfOlderThanSeconds );
 	}
+	UpdateFirstUnjudgedRows();
 	// process transforms that are waiting to be applied
 	ApplyWaitingTransforms();
 }
@@ -1612,6 +1614,10 @@ void Player::ApplyWaitingTransforms()
 		// if re-adding noteskin changes, this is one place to edit -aj
 
 		NoteDataUtil::TransformNoteData(m_NoteData, *m_Timing, po, GAMESTATE->GetCurrentStyle(GetPlayerState()->m_PlayerNumber)->m_StepsType, BeatToNoteRow(fStartBeat), BeatToNoteRow(fEndBeat));
+
+		// The transform may have moved unjudged notes into columns we'd passed.
+		for( int &iRow : m_viFirstUnjudgedRow )
+			iRow = std::min( iRow, BeatToNoteRow(fStartBeat) );
 	}
 	m_pPlayerState->m_ModsToApply.clear();
 }
@@ -1894,9 +1900,22 @@ int Player::GetClosestNoteDirectional( int col, int iStartRow, int iEndRow, bool
 // Find the closest note to fBeat.
 int Player::GetClosestNote( int col, int iNoteRow, int iMaxRowsAhead, int iMaxRowsBehind, bool bAllowGraded ) const
 {
+	int iNextStart = iNoteRow;
+	int iPrevStart = iNoteRow-iMaxRowsBehind;
+	if( !bAllowGraded && col < (int) m_viFirstUnjudgedRow.size() )
+	{
+		// Don't walk back over notes that have already been judged.
+		const int iFirstUnjudged = m_viFirstUnjudgedRow[col];
+		iNextStart = std::max( iNextStart, iFirstUnjudged );
+		iPrevStart = std::max( iPrevStart, iFirstUnjudged );
+	}
+
 	// Start at iIndexStartLookingAt and search outward.
-	int iNextIndex = GetClosestNoteDirectional( col, iNoteRow, iNoteRow+iMaxRowsAhead, bAllowGraded, true );
-	int iPrevIndex = GetClosestNoteDirectional( col, iNoteRow-iMaxRowsBehind, iNoteRow, bAllowGraded, false );
+	int iNextIndex = -1, iPrevIndex = -1;
+	if( iNextStart < iNoteRow+iMaxRowsAhead )
+		iNextIndex = GetClosestNoteDirectional( col, iNextStart, iNoteRow+iMaxRowsAhead, bAllowGraded, true );
+	if( iPrevStart < iNoteRow )
+		iPrevIndex = GetClosestNoteDirectional( col, iPrevStart, iNoteRow, bAllowGraded, false );
 
 	if( iNextIndex == -1 && iPrevIndex == -1 )
 		return -1;
@@ -2084,8 +2103,14 @@ void Player::Step( int col, int row, const RageTimer &tm, bool bHeld, bool bRele
 	// Do everything that depends on a RageTimer here;
 	// set your breakpoints somewhere after this block.
 	const float fLastBeatUpdate = m_pPlayerState->m_Position.m_LastBeatUpdate.Ago();
-	const float fPositionSeconds = m_pPlayerState->m_Position.m_fMusicSeconds - tm.Ago();
 	const float fTimeSinceStep = tm.Ago();
+	float fPositionSeconds = m_pPlayerState->m_Position.m_fMusicSeconds - fTimeSinceStep;
+	if( g_bJudgeAtInputTime )
+	{
+		// The same song position the judgment offset below is measured from.
+		fPositionSeconds = m_pPlayerState->m_Position.m_fMusicSeconds +
+			(fLastBeatUpdate - fTimeSinceStep) * GAMESTATE->m_SongOptions.GetCurrent().m_fMusicRate;
+	}
 
 	float fSongBeat = m_pPlayerState->m_Position.m_fSongBeat;
 
@@ -2099,6 +2124,13 @@ void Player::Step( int col, int row, const RageTimer &tm, bool bHeld, bool bRele
 
 	const int iSongRow = row == -1 ? BeatToNoteRow( fSongBeat ) : row;
 
+	if( row == -1 )
+	{
+		// A real step, not autoplay.
+		RageLatency::RecordSince( LatencyStage_Step, tm );
+		RageLatency::AddPendingFrameInput( tm );
+	}
+
 	if( col != -1 && !bRelease )
 	{
 		// Update roll life
@@ -2680,6 +2712,26 @@ void Player::UpdateTapNotesMissedOlderThan( float fMissIfOlderThanSeconds )
 	}
 }
 
+void Player::UpdateFirstUnjudgedRows()
+{
+	// The rows only move forward, so each note is only stepped over once.
+	for( int col = 0; col < (int) m_viFirstUnjudgedRow.size(); ++col )
+	{
+		NoteData::const_iterator begin, end;
+		m_NoteData.GetTapNoteRange( col, m_viFirstUnjudgedRow[col], MAX_NOTE_ROW, begin, end );
+		for( ; begin != end; ++begin )
+		{
+			// The same notes GetClosestNoteDirectional passes over when it
+			// isn't allowed graded notes.
+			const TapNote &tn = begin->second;
+			if( tn.type != TapNoteType_Empty && tn.type != TapNoteType_AutoKeysound &&
+				tn.result.tns == TNS_None && m_Timing->IsJudgableAtRow(begin->first) )
+				break;
+		}
+		m_viFirstUnjudgedRow[col] = begin == end ? MAX_NOTE_ROW : begin->first;
+	}
+}
+
 void Player::UpdateJudgedRows()
 {
 	// Look ahead far enough to catch any rows judged early.
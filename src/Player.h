@@ -143,6 +143,7 @@ public:
 
 protected:
 	void UpdateTapNotesMissedOlderThan( float fMissIfOlderThanThisBeat );
+	void UpdateFirstUnjudgedRows();
 	void UpdateJudgedRows();
 	void FlashGhostRow( int iRow );
 	void HandleTapRowScore( unsigned row );
@@ -219,6 +220,10 @@ protected:
 	NoteData::all_tracks_iterator *m_pIterUncrossedRows;
 	NoteData::all_tracks_iterator *m_pIterUnjudgedRows;
 	NoteData::all_tracks_iterator *m_pIterUnjudgedMineRows;
+	/* Per column, the earliest row that might hold a note a step could still
+	 * judge.  Everything before it has a result or can't be judged, so
+	 * GetClosestNote doesn't have to look at it again. */
+	std::vector<int>	m_viFirstUnjudgedRow;
 	unsigned int	m_iLastSeenCombo;
 	bool	m_bSeenComboYet;
 	JudgedRows		*m_pJudgedRows;
@@ -312,6 +312,8 @@ public:
 	Preference<RString>	m_iSoundDevice;
 	Preference<int> m_iRageSoundSampleCountClamp;
 	Preference<int>	m_iSoundPreferredSampleRate;
+	Preference<bool>	m_bSoundLowLatency;
+	Preference<int>	m_iSoundDecodeBufferFrames;
 	Preference<RString>	m_sLightsStepsDifficulty;
 	Preference<bool>	m_bLightsSimplifyBass;
 	Preference<bool>	m_bAllowUnacceleratedRenderer;
@@ -1,6 +1,7 @@
 #include "global.h"
 #include "RageDisplay.h"
 #include "RageTimer.h"
+#include "RageLatency.h"
 #include "RageLog.h"
 #include "RageMath.h"
 #include "RageUtil.h"
@@ -188,6 +189,7 @@ bool RageDisplay::BeginFrame()
 void RageDisplay::EndFrame()
 {
 	ProcessStatsOnFlip();
+	RageLatency::EndFrame();
 }
 
 void RageDisplay::BeginConcurrentRendering()
@@ -564,6 +566,11 @@ void RageDisplay::TexturePopMatrix()
 	g_TextureStack.Pop();
 }
 
+void RageDisplay::TextureLoadIdentity()
+{
+	g_TextureStack.LoadIdentity();
+}
+
 void RageDisplay::TextureTranslate( float x, float y )
 {
 	g_TextureStack.TranslateLocal(x, y, 0);
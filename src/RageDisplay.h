@@ -412,12 +412,15 @@ public:
 	void PostMultMatrix( const RageMatrix &f );
 	void PreMultMatrix( const RageMatrix &f );
 	void LoadIdentity();
+	const RageMatrix* GetWorldTop() const;
 
 	// Texture matrix functions
 	void TexturePushMatrix();
 	void TexturePopMatrix();
+	void TextureLoadIdentity();
 	void TextureTranslate( float x, float y );
 	void TextureTranslate( const RageVector2 &v ) { this->TextureTranslate( v.x, v.y ); }
+	const RageMatrix* GetTextureTop() const;
 
 	// Projection and View matrix stack functions.
 	void CameraPushMatrix();
@@ -451,8 +454,6 @@ protected:
 	const RageMatrix* GetCentering() const;
 	const RageMatrix* GetProjectionTop() const;
 	const RageMatrix* GetViewTop() const;
-	const RageMatrix* GetWorldTop() const;
-	const RageMatrix* GetTextureTop() const;
 
 	// To limit the framerate, call FrameLimitBeforeVsync before waiting
 	// for vsync and FrameLimitAfterVsync after.
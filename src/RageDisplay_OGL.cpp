@@ -9,6 +9,7 @@ using namespace RageDisplay_Legacy_Helpers;
 #include "RageSurfaceUtils.h"
 #include "RageUtil.h"
 #include "RageLog.h"
+#include "RageProfiler.h"
 #include "RageTextureManager.h"
 #include "RageMath.h"
 #include "RageTypes.h"
@@ -2205,6 +2206,7 @@ std::uintptr_t RageDisplay_Legacy::CreateTexture(
 	RageSurface* pImg,
 	bool bGenerateMipMaps )
 {
+	ProfileScope scope( ProfilePhase_TextureUpload, "CreateTexture" );
 	ASSERT( pixfmt < NUM_RagePixelFormat );
 
 
@@ -2423,6 +2425,7 @@ void RageDisplay_Legacy::UpdateTexture(
 	RageSurface* pImg,
 	int iXOffset, int iYOffset, int iWidth, int iHeight )
 {
+	ProfileScope scope( ProfilePhase_TextureUpload, "UpdateTexture" );
 	glBindTexture( GL_TEXTURE_2D, static_cast<GLuint>(iTexHandle) );
 
 	bool bFreeImg;
@@ -75,7 +75,10 @@ void RageInput::Update()
 {
 	// Update optional devices.
 	for( unsigned i = 0; i < m_InputHandlers.size(); ++i )
+	{
 		m_InputHandlers[i].m_pDevice->Update();
+		m_InputHandlers[i].m_pDevice->FlushEvents();
+	}
 }
 
 bool RageInput::DevicesChanged()
@@ -0,0 +1,224 @@
+#include "global.h"
+#include "RageLatency.h"
+#include "RageTimer.h"
+#include "RageLog.h"
+#include "RageUtil.h"
+#include "EnumHelper.h"
+#include "LuaManager.h"
+#include "Preference.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+static Preference<bool> g_bLatencyStats( "LatencyStats", false );
+/* How often to write the histograms to the log; 0 to never. */
+static Preference<float> g_fLatencyLogSeconds( "LatencyLogSeconds", 0 );
+
+static const char *LatencyStageNames[] = {
+	"InputHandler",
+	"InputFilter",
+	"Step",
+	"Frame",
+	"AudioBuffer",
+};
+XToString( LatencyStage );
+
+namespace
+{
+	/* Quarter-millisecond buckets up to 100ms, and one for everything longer. */
+	const int BUCKET_MICROSECONDS = 250;
+	const int NUM_BUCKETS = 400;
+
+	struct StageStats
+	{
+		std::atomic<unsigned> m_iBuckets[NUM_BUCKETS+1];
+		std::atomic<unsigned> m_iCount;
+		std::atomic<std::uint64_t> m_iTotalMicroseconds;
+		std::atomic<unsigned> m_iMaxMicroseconds;
+	};
+	StageStats g_Stats[NUM_LatencyStage];
+
+	/* Only touched by the main thread, which both judges and draws. */
+	RageTimer g_PendingFrameInput;
+	bool g_bPendingFrameInput = false;
+
+	RageTimer g_LastLog;
+}
+
+bool RageLatency::IsEnabled()
+{
+	return g_bLatencyStats.Get();
+}
+
+void RageLatency::Record( LatencyStage s, float fSeconds )
+{
+	if( !IsEnabled() )
+		return;
+
+	const unsigned iMicroseconds = fSeconds > 0? unsigned(std::lround(fSeconds * 1000000)):0;
+	StageStats &stats = g_Stats[s];
+	const int iBucket = std::min( int(iMicroseconds / BUCKET_MICROSECONDS), NUM_BUCKETS );
+	stats.m_iBuckets[iBucket].fetch_add( 1, std::memory_order_relaxed );
+	stats.m_iCount.fetch_add( 1, std::memory_order_relaxed );
+	stats.m_iTotalMicroseconds.fetch_add( iMicroseconds, std::memory_order_relaxed );
+
+	unsigned iMax = stats.m_iMaxMicroseconds.load( std::memory_order_relaxed );
+	while( iMicroseconds > iMax && !stats.m_iMaxMicroseconds.compare_exchange_weak(iMax, iMicroseconds, std::memory_order_relaxed) )
+		;
+}
+
+void RageLatency::RecordSince( LatencyStage s, const RageTimer &tm )
+{
+	if( !IsEnabled() || tm.IsZero() )
+		return;
+	Record( s, tm.Ago() );
+}
+
+void RageLatency::AddPendingFrameInput( const RageTimer &tm )
+{
+	if( !IsEnabled() || tm.IsZero() )
+		return;
+
+	// If several steps land in one frame, measure from the oldest.
+	if( !g_bPendingFrameInput || tm < g_PendingFrameInput )
+		g_PendingFrameInput = tm;
+	g_bPendingFrameInput = true;
+}
+
+void RageLatency::EndFrame()
+{
+	if( !g_bPendingFrameInput )
+		return;
+	g_bPendingFrameInput = false;
+	RecordSince( LatencyStage_Frame, g_PendingFrameInput );
+}
+
+int RageLatency::GetCount( LatencyStage s )
+{
+	return int( g_Stats[s].m_iCount.load(std::memory_order_relaxed) );
+}
+
+float RageLatency::GetAverage( LatencyStage s )
+{
+	const unsigned iCount = g_Stats[s].m_iCount.load( std::memory_order_relaxed );
+	if( iCount == 0 )
+		return 0;
+	return g_Stats[s].m_iTotalMicroseconds.load( std::memory_order_relaxed ) / 1000000.0f / iCount;
+}
+
+float RageLatency::GetMax( LatencyStage s )
+{
+	return g_Stats[s].m_iMaxMicroseconds.load( std::memory_order_relaxed ) / 1000000.0f;
+}
+
+float RageLatency::GetPercentile( LatencyStage s, float fPercent )
+{
+	const StageStats &stats = g_Stats[s];
+
+	/* Other threads may be adding samples while we walk the buckets, so
+	 * count what's actually there rather than trusting m_iCount. */
+	unsigned iTotal = 0;
+	for( int i = 0; i <= NUM_BUCKETS; ++i )
+		iTotal += stats.m_iBuckets[i].load( std::memory_order_relaxed );
+	if( iTotal == 0 )
+		return 0;
+
+	const unsigned iWanted = std::max( 1u, unsigned(std::ceil(iTotal * fPercent / 100.0f)) );
+	unsigned iSeen = 0;
+	for( int i = 0; i < NUM_BUCKETS; ++i )
+	{
+		iSeen += stats.m_iBuckets[i].load( std::memory_order_relaxed );
+		if( iSeen >= iWanted )
+			return (i+1) * BUCKET_MICROSECONDS / 1000000.0f;
+	}
+	return GetMax( s );
+}
+
+void RageLatency::Reset()
+{
+	for( StageStats &stats : g_Stats )
+	{
+		for( std::atomic<unsigned> &iBucket : stats.m_iBuckets )
+			iBucket.store( 0, std::memory_order_relaxed );
+		stats.m_iCount.store( 0, std::memory_order_relaxed );
+		stats.m_iTotalMicroseconds.store( 0, std::memory_order_relaxed );
+		stats.m_iMaxMicroseconds.store( 0, std::memory_order_relaxed );
+	}
+	g_bPendingFrameInput = false;
+}
+
+static RString GetStageLine( LatencyStage s )
+{
+	return ssprintf( "%s: avg %.1f p50 %.1f p95 %.1f p99 %.1f max %.1fms (%i)",
+		LatencyStageToString(s).c_str(), RageLatency::GetAverage(s)*1000,
+		RageLatency::GetPercentile(s, 50)*1000, RageLatency::GetPercentile(s, 95)*1000,
+		RageLatency::GetPercentile(s, 99)*1000, RageLatency::GetMax(s)*1000, RageLatency::GetCount(s) );
+}
+
+RString RageLatency::GetStatsString()
+{
+	if( !IsEnabled() )
+		return RString();
+
+	RString sRet;
+	FOREACH_ENUM( LatencyStage, s )
+	{
+		if( GetCount(s) == 0 )
+			continue;
+		if( !sRet.empty() )
+			sRet += "\n";
+		sRet += GetStageLine( s );
+	}
+	return sRet;
+}
+
+void RageLatency::Update()
+{
+	if( !IsEnabled() || g_fLatencyLogSeconds <= 0 )
+		return;
+	if( g_LastLog.Ago() < g_fLatencyLogSeconds )
+		return;
+	g_LastLog.Touch();
+
+	FOREACH_ENUM( LatencyStage, s )
+	{
+		if( GetCount(s) != 0 )
+			LOG->Info( "Latency %s", GetStageLine(s).c_str() );
+	}
+}
+
+/* Returns a table of stage name to { Count, Average, Max, P50, P95, P99 },
+ * in seconds, since startup or the last ResetLatencyStats. */
+int LuaFunc_GetLatencyStats( lua_State *L );
+int LuaFunc_GetLatencyStats( lua_State *L )
+{
+	lua_createtable( L, 0, NUM_LatencyStage );
+	FOREACH_ENUM( LatencyStage, s )
+	{
+		lua_createtable( L, 0, 6 );
+		lua_pushinteger( L, RageLatency::GetCount(s) );
+		lua_setfield( L, -2, "Count" );
+		lua_pushnumber( L, RageLatency::GetAverage(s) );
+		lua_setfield( L, -2, "Average" );
+		lua_pushnumber( L, RageLatency::GetMax(s) );
+		lua_setfield( L, -2, "Max" );
+		lua_pushnumber( L, RageLatency::GetPercentile(s, 50) );
+		lua_setfield( L, -2, "P50" );
+		lua_pushnumber( L, RageLatency::GetPercentile(s, 95) );
+		lua_setfield( L, -2, "P95" );
+		lua_pushnumber( L, RageLatency::GetPercentile(s, 99) );
+		lua_setfield( L, -2, "P99" );
+		lua_setfield( L, -2, LatencyStageToString(s).c_str() );
+	}
+	return 1;
+}
+LUAFUNC_REGISTER_COMMON( GetLatencyStats );
+
+int LuaFunc_ResetLatencyStats( lua_State * );
+int LuaFunc_ResetLatencyStats( lua_State * )
+{
+	RageLatency::Reset();
+	return 0;
+}
+LUAFUNC_REGISTER_COMMON( ResetLatencyStats );
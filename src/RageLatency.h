@@ -0,0 +1,50 @@
+/* RageLatency - Histograms of how long input, frames and audio take to get through. */
+
+#ifndef RAGE_LATENCY_H
+#define RAGE_LATENCY_H
+
+class RageTimer;
+
+enum LatencyStage
+{
+	LatencyStage_InputHandler,	// device timestamp to the InputHandler handing it off
+	LatencyStage_InputFilter,	// device timestamp to InputFilter passing it to screens
+	LatencyStage_Step,		// device timestamp to Player::Step
+	LatencyStage_Frame,		// device timestamp of a step to the end of the frame that shows it
+	LatencyStage_AudioBuffer,	// audio mixed to that audio reaching the hardware position
+	NUM_LatencyStage,
+	LatencyStage_Invalid
+};
+const RString& LatencyStageToString( LatencyStage s );
+
+/* Samples are counted into fixed buckets with atomics, so any thread can
+ * record, including the sound mixer.  Nothing is recorded unless the
+ * LatencyStats preference is on. */
+namespace RageLatency
+{
+	bool IsEnabled();
+
+	void Record( LatencyStage s, float fSeconds );
+	/* Record the time from tm until now. */
+	void RecordSince( LatencyStage s, const RageTimer &tm );
+
+	/* A step with device timestamp tm was judged; the next EndFrame shows it. */
+	void AddPendingFrameInput( const RageTimer &tm );
+	/* Called by RageDisplay once the frame has been handed to the driver. */
+	void EndFrame();
+
+	int GetCount( LatencyStage s );
+	float GetAverage( LatencyStage s );
+	float GetMax( LatencyStage s );
+	/* From the histogram, so it's only as accurate as a bucket. */
+	float GetPercentile( LatencyStage s, float fPercent );
+	void Reset();
+
+	/* One line per stage that has samples, for the stats overlay. */
+	RString GetStatsString();
+
+	/* Dump to the log every LatencyLogSeconds.  Called once a frame. */
+	void Update();
+}
+
+#endif
@@ -0,0 +1,191 @@
+#include "global.h"
+#include "RageProfiler.h"
+#include "RageFile.h"
+#include "RageLog.h"
+#include "RageThreads.h"
+#include "RageUtil.h"
+#include "EnumHelper.h"
+#include "arch/ArchHooks/ArchHooks.h"
+
+#include <cstring>
+
+static const char *ProfilePhaseNames[] = {
+	"Input",
+	"Update",
+	"Lua",
+	"Draw",
+	"TextureUpload",
+	"EndFrame",
+};
+XToString( ProfilePhase );
+
+namespace
+{
+	/* A busy frame on a heavy theme runs a few thousand Lua commands, so this
+	 * holds at least several frames of those, and many more of a quiet one. */
+	const int RING_SIZE = 1 << 16;
+	const int MAX_DEPTH = 32;
+
+	bool g_bEnabled = false;
+	std::uint64_t g_iThreadID = 0;
+
+	std::vector<ProfileEvent> g_Ring;
+	std::uint64_t g_iNextEvent = 0;	// counts up forever; index into the ring with % RING_SIZE
+
+	std::uint64_t g_aiOpen[MAX_DEPTH];
+	int g_iDepth = 0;
+
+	std::uint64_t g_iFrameStartEvent = 0, g_iLastFrameStartEvent = 0, g_iLastFrameEndEvent = 0;
+	std::int64_t g_iFrameStartTime = 0, g_iLastFrameStartTime = 0, g_iLastFrameEndTime = 0;
+
+	std::int64_t Now()
+	{
+		return ArchHooks::GetMicrosecondsSinceStart( true );
+	}
+
+	bool IsInRing( std::uint64_t iEvent )
+	{
+		return iEvent < g_iNextEvent && g_iNextEvent - iEvent <= RING_SIZE;
+	}
+}
+
+bool RageProfiler::IsEnabled()
+{
+	return g_bEnabled;
+}
+
+void RageProfiler::SetEnabled( bool b )
+{
+	if( b == g_bEnabled )
+		return;
+	g_bEnabled = b;
+	if( !b )
+		return; // keep what we have, so it can still be exported
+
+	if( g_Ring.empty() )
+		g_Ring.resize( RING_SIZE );
+	g_iNextEvent = 0;
+	g_iDepth = 0;
+	g_iFrameStartEvent = g_iLastFrameStartEvent = g_iLastFrameEndEvent = 0;
+	g_iFrameStartTime = g_iLastFrameStartTime = g_iLastFrameEndTime = 0;
+}
+
+void RageProfiler::BeginFrame()
+{
+	if( !g_bEnabled )
+		return;
+
+	const std::int64_t iNow = Now();
+	g_iThreadID = RageThread::GetCurrentThreadID();
+	if( g_iFrameStartTime != 0 )
+	{
+		g_iLastFrameStartEvent = g_iFrameStartEvent;
+		g_iLastFrameEndEvent = g_iNextEvent;
+		g_iLastFrameStartTime = g_iFrameStartTime;
+		g_iLastFrameEndTime = iNow;
+	}
+	g_iFrameStartEvent = g_iNextEvent;
+	g_iFrameStartTime = iNow;
+}
+
+bool RageProfiler::Begin( ProfilePhase p, const char *szName )
+{
+	if( !g_bEnabled || g_iDepth == MAX_DEPTH || RageThread::GetCurrentThreadID() != g_iThreadID )
+		return false;
+
+	const std::uint64_t iEvent = g_iNextEvent++;
+	ProfileEvent &e = g_Ring[iEvent % RING_SIZE];
+	e.m_Phase = p;
+	e.m_iDepth = g_iDepth;
+	e.m_iStartMicroseconds = Now();
+	e.m_iEndMicroseconds = 0;
+	e.m_szName[0] = 0;
+	if( szName != nullptr )
+		strncat( e.m_szName, szName, sizeof(e.m_szName)-1 );
+
+	g_aiOpen[g_iDepth++] = iEvent;
+	return true;
+}
+
+void RageProfiler::End()
+{
+	// This happens if we were enabled while the scope was open.
+	if( g_iDepth == 0 )
+		return;
+
+	const std::uint64_t iEvent = g_aiOpen[--g_iDepth];
+	if( IsInRing(iEvent) )
+		g_Ring[iEvent % RING_SIZE].m_iEndMicroseconds = Now();
+}
+
+void RageProfiler::GetLastFrame( std::vector<ProfileEvent> &vOut, std::int64_t &iStartOut, std::int64_t &iEndOut )
+{
+	vOut.clear();
+	iStartOut = g_iLastFrameStartTime;
+	iEndOut = g_iLastFrameEndTime;
+	if( g_iLastFrameStartTime == 0 )
+		return;
+
+	for( std::uint64_t i = g_iLastFrameStartEvent; i < g_iLastFrameEndEvent; ++i )
+	{
+		if( !IsInRing(i) )
+			continue;
+		const ProfileEvent &e = g_Ring[i % RING_SIZE];
+		if( e.m_iEndMicroseconds != 0 )
+			vOut.push_back( e );
+	}
+}
+
+static RString JsonEscape( const char *s )
+{
+	RString sRet;
+	for( ; *s; ++s )
+	{
+		const unsigned char c = *s;
+		if( c == '"' || c == '\\' )
+			sRet += '\\';
+		if( c < 0x20 )
+			sRet += ssprintf( "\\u%04x", c );
+		else
+			sRet += c;
+	}
+	return sRet;
+}
+
+bool RageProfiler::ExportChromeTrace( const RString &sPath )
+{
+	RageFile f;
+	if( !f.Open(sPath, RageFile::WRITE) )
+	{
+		LOG->Warn( "Couldn't write profile trace %s: %s", sPath.c_str(), f.GetError().c_str() );
+		return false;
+	}
+
+	f.PutLine( "{\"traceEvents\":[" );
+	const std::uint64_t iFirst = g_iNextEvent > RING_SIZE? g_iNextEvent - RING_SIZE:0;
+	bool bFirst = true;
+	int iWritten = 0;
+	for( std::uint64_t i = iFirst; i < g_iNextEvent; ++i )
+	{
+		const ProfileEvent &e = g_Ring[i % RING_SIZE];
+		if( e.m_iEndMicroseconds == 0 )
+			continue;
+
+		const RString &sPhase = ProfilePhaseToString( e.m_Phase );
+		const RString sName = e.m_szName[0]? JsonEscape(e.m_szName):sPhase;
+		f.PutLine( ssprintf("%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":1}",
+			bFirst? "":",", sName.c_str(), sPhase.c_str(),
+			(long long) e.m_iStartMicroseconds, (long long) (e.m_iEndMicroseconds - e.m_iStartMicroseconds)) );
+		bFirst = false;
+		++iWritten;
+	}
+	f.PutLine( "]}" );
+
+	if( f.Flush() == -1 )
+	{
+		LOG->Warn( "Couldn't write profile trace %s: %s", sPath.c_str(), f.GetError().c_str() );
+		return false;
+	}
+	LOG->Info( "Wrote %i profile events to %s", iWritten, sPath.c_str() );
+	return true;
+}
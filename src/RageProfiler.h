@@ -0,0 +1,73 @@
+/* RageProfiler - Records what each frame spent its time on. */
+
+#ifndef RAGE_PROFILER_H
+#define RAGE_PROFILER_H
+
+#include <cstdint>
+#include <vector>
+
+enum ProfilePhase
+{
+	ProfilePhase_Input,
+	ProfilePhase_Update,
+	ProfilePhase_Lua,
+	ProfilePhase_Draw,
+	ProfilePhase_TextureUpload,
+	ProfilePhase_EndFrame,
+	NUM_ProfilePhase,
+	ProfilePhase_Invalid
+};
+const RString& ProfilePhaseToString( ProfilePhase p );
+
+struct ProfileEvent
+{
+	ProfilePhase m_Phase;
+	int m_iDepth;
+	std::int64_t m_iStartMicroseconds;
+	std::int64_t m_iEndMicroseconds;	// 0 until the scope ends
+	char m_szName[32];			// what in the phase, eg. the actor running a command
+};
+
+/* Scopes are recorded into a ring buffer of the last few thousand events.
+ * Only the game loop's thread is recorded, so nothing here locks; scopes
+ * opened from other threads are ignored.  Recording is off until SetEnabled. */
+namespace RageProfiler
+{
+	bool IsEnabled();
+	void SetEnabled( bool b );
+
+	/* Called by the game loop at the start of each frame. */
+	void BeginFrame();
+
+	/* Returns false if the scope wasn't recorded, in which case don't End it. */
+	bool Begin( ProfilePhase p, const char *szName );
+	void End();
+
+	/* The events of the last complete frame, and when it started and ended. */
+	void GetLastFrame( std::vector<ProfileEvent> &vOut, std::int64_t &iStartOut, std::int64_t &iEndOut );
+
+	/* Write everything in the ring as Chrome trace-event JSON, for
+	 * chrome://tracing or Perfetto. */
+	bool ExportChromeTrace( const RString &sPath );
+}
+
+class ProfileScope
+{
+public:
+	ProfileScope( ProfilePhase p, const char *szName = nullptr ):
+		m_bActive( false )
+	{
+		if( RageProfiler::IsEnabled() )
+			m_bActive = RageProfiler::Begin( p, szName );
+	}
+	~ProfileScope()
+	{
+		if( m_bActive )
+			RageProfiler::End();
+	}
+
+private:
+	bool m_bActive;
+};
+
+#endif
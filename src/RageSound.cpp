@@ -22,6 +22,7 @@
 #include "global.h"
 #include "RageSound.h"
 #include "RageSoundManager.h"
+#include "RageSoundPCMCache.h"
 #include "RageUtil.h"
 #include "RageLog.h"
 #include "PrefsManager.h"
@@ -182,8 +183,14 @@ bool RageSound::Load( RString sSoundFilePath, bool bPrecache, const RageSoundLoa
 	if( pSound == nullptr )
 	{
 		RString error;
-		bool bPrebuffer;
-		pSound = RageSoundReader_FileReader::OpenFile( sSoundFilePath, error, &bPrebuffer );
+		bool bPrebuffer = false;
+
+		/* If the sound is kept decoded, read that instead of decoding it.  Still
+		 * buffer reads, in case the file isn't in memory yet. */
+		if( PCMCACHE != nullptr )
+			pSound = PCMCACHE->Open( sSoundFilePath );
+		if( pSound == nullptr )
+			pSound = RageSoundReader_FileReader::OpenFile( sSoundFilePath, error, &bPrebuffer );
 		if( pSound == nullptr )
 		{
 			LOG->Warn( "RageSound::Load: error opening sound \"%s\": %s",
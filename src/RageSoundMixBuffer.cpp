@@ -1,17 +1,10 @@
 #include "global.h"
 #include "RageSoundMixBuffer.h"
+#include "RageSoundMixKernels.h"
 #include "RageUtil.h"
 
-#include <cmath>
 #include <cstdint>
 
-#if defined(MACOSX)
-#include "archutils/Darwin/VectorHelper.h"
-#ifdef USE_VEC
-static bool g_bVector = Vector::CheckForVector();
-#endif
-#endif
-
 RageSoundMixBuffer::RageSoundMixBuffer()
 {
 	m_iBufSize = m_iBufUsed = 0;
@@ -31,14 +24,19 @@ void RageSoundMixBuffer::SetWriteOffset( int iOffset )
 	m_iOffset = iOffset;
 }
 
-void RageSoundMixBuffer::Extend( unsigned iSamples )
+void RageSoundMixBuffer::Reserve( unsigned iSamples )
 {
-	const unsigned realsize = iSamples+m_iOffset;
-	if( m_iBufSize < realsize )
+	if( m_iBufSize < iSamples )
 	{
-		m_pMixbuf = (float *) realloc( m_pMixbuf, sizeof(float) * realsize );
-		m_iBufSize = realsize;
+		m_pMixbuf = (float *) realloc( m_pMixbuf, sizeof(float) * iSamples );
+		m_iBufSize = iSamples;
 	}
+}
+
+void RageSoundMixBuffer::Extend( unsigned iSamples )
+{
+	const unsigned realsize = iSamples+m_iOffset;
+	Reserve( realsize );
 
 	if( m_iBufUsed < realsize )
 	{
@@ -59,13 +57,11 @@ void RageSoundMixBuffer::write( const float *pBuf, unsigned iSize, int iSourceSt
 	/* Scale volume and add. */
 	float *pDestBuf = m_pMixbuf+m_iOffset;
 
-#ifdef USE_VEC
-	if( g_bVector && iSourceStride == 1 && iDestStride == 1 )
+	if( iSourceStride == 1 && iDestStride == 1 )
 	{
-		Vector::FastSoundWrite( pDestBuf, pBuf, iSize );
+		RageSoundMixKernels::MixAdd( pDestBuf, pBuf, iSize );
 		return;
 	}
-#endif
 
 	while( iSize )
 	{
@@ -78,12 +74,7 @@ void RageSoundMixBuffer::write( const float *pBuf, unsigned iSize, int iSourceSt
 
 void RageSoundMixBuffer::read( std::int16_t *pBuf )
 {
-	for( unsigned iPos = 0; iPos < m_iBufUsed; ++iPos )
-	{
-		float iOut = m_pMixbuf[iPos];
-		iOut = clamp( iOut, -1.0f, +1.0f );
-		pBuf[iPos] = std::lrint(iOut * 32767);
-	}
+	RageSoundMixKernels::ConvertToInt16( pBuf, m_pMixbuf, m_iBufUsed );
 	m_iBufUsed = 0;
 }
 
@@ -95,9 +86,7 @@ void RageSoundMixBuffer::read( float *pBuf )
 
 void RageSoundMixBuffer::read_deinterlace( float **pBufs, int channels )
 {
-	for( unsigned i = 0; i < m_iBufUsed / channels; ++i )
-		for( int ch = 0; ch < channels; ++ch )
-			pBufs[ch][i] = m_pMixbuf[channels * i + ch];
+	RageSoundMixKernels::Deinterleave( pBufs, m_pMixbuf, m_iBufUsed / channels, channels );
 	m_iBufUsed = 0;
 }
 
@@ -17,6 +17,9 @@ public:
 	/* Extend the buffer as if write() was called with a buffer of silence. */
 	void Extend( unsigned iSamples );
 
+	/* Allocate room for iSamples now, so mixing up to that many never allocates. */
+	void Reserve( unsigned iSamples );
+
 	void read( std::int16_t *pBuf );
 	void read( float *pBuf );
 	void read_deinterlace( float **pBufs, int channels );
@@ -0,0 +1,566 @@
+#include "global.h"
+#include "RageSoundMixKernels.h"
+#include "RageUtil.h"
+#include "EnumHelper.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define MIX_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define MIX_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+static const char *MixKernelsNames[] = {
+	"Scalar",
+	"SSE2",
+	"AVX2",
+	"NEON",
+};
+XToString( MixKernels );
+
+namespace
+{
+	struct Kernels
+	{
+		void (*MixAdd)( float *pDest, const float *pSrc, unsigned iSamples );
+		void (*ConvertToInt16)( std::int16_t *pDest, const float *pSrc, unsigned iSamples );
+		void (*DeinterleaveStereo)( float *pLeft, float *pRight, const float *pSrc, unsigned iFrames );
+		void (*PolyphaseMono)( float *pOut, const float *pIn, const float *pBank, const int *piInFrame, const int *piPhase, unsigned iFrames );
+		void (*PolyphaseStereo)( float *pOut, const float *pIn, const float *pBank, const int *piInFrame, const int *piPhase, unsigned iFrames );
+		void (*Correlate)( float *pOut, const float *pSignal, const float *pTarget, unsigned iLength, unsigned iOffsets, unsigned iStride );
+	};
+
+	const int TAPS = RageSoundMixKernels::POLYPHASE_TAPS;
+	static_assert( TAPS == 8, "the Polyphase kernels are unrolled for 8 taps" );
+
+	// Scalar: the reference for the rest, and what finishes their tails.
+	void MixAdd_Scalar( float *pDest, const float *pSrc, unsigned iSamples )
+	{
+		for( unsigned i = 0; i < iSamples; ++i )
+			pDest[i] += pSrc[i];
+	}
+
+	void ConvertToInt16_Scalar( std::int16_t *pDest, const float *pSrc, unsigned iSamples )
+	{
+		for( unsigned i = 0; i < iSamples; ++i )
+		{
+			const float f = clamp( pSrc[i], -1.0f, +1.0f );
+			pDest[i] = std::int16_t( std::lrint(f * 32767) );
+		}
+	}
+
+	void DeinterleaveStereo_Scalar( float *pLeft, float *pRight, const float *pSrc, unsigned iFrames )
+	{
+		for( unsigned i = 0; i < iFrames; ++i )
+		{
+			pLeft[i] = pSrc[i*2];
+			pRight[i] = pSrc[i*2+1];
+		}
+	}
+
+	/* Sum the taps in the order the vector kernels add their lanes: each tap
+	 * with the one four later, then pairs of those, then the two halves. */
+	inline float Polyphase_Scalar( const float *pIn, int iStride, const float *pTaps )
+	{
+		float p[8];
+		for( int t = 0; t < 8; ++t )
+			p[t] = pIn[t*iStride] * pTaps[t];
+		return ((p[0]+p[4]) + (p[2]+p[6])) + ((p[1]+p[5]) + (p[3]+p[7]));
+	}
+
+	void PolyphaseMono_Scalar( float *pOut, const float *pIn, const float *pBank, const int *piInFrame, const int *piPhase, unsigned iFrames )
+	{
+		for( unsigned i = 0; i < iFrames; ++i )
+			pOut[i] = Polyphase_Scalar( pIn + piInFrame[i], 1, pBank + piPhase[i]*TAPS );
+	}
+
+	void PolyphaseStereo_Scalar( float *pOut, const float *pIn, const float *pBank, const int *piInFrame, const int *piPhase, unsigned iFrames )
+	{
+		for( unsigned i = 0; i < iFrames; ++i )
+		{
+			const float *pTaps = pBank + piPhase[i]*TAPS;
+			pOut[i*2] = Polyphase_Scalar( pIn + piInFrame[i]*2, 2, pTaps );
+			pOut[i*2+1] = Polyphase_Scalar( pIn + piInFrame[i]*2 + 1, 2, pTaps );
+		}
+	}
+
+	/* Eight running sums, one for each lane of the vector kernels, added
+	 * together the same way as Polyphase_Scalar; then the tail. */
+	inline float Dot_Scalar( const float *pA, const float *pB, unsigned iLength )
+	{
+		float l[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+		unsigned i = 0;
+		for( ; i + 8 <= iLength; i += 8 )
+			for( int t = 0; t < 8; ++t )
+				l[t] += pA[i+t] * pB[i+t];
+		float f = ((l[0]+l[4]) + (l[2]+l[6])) + ((l[1]+l[5]) + (l[3]+l[7]));
+		for( ; i < iLength; ++i )
+			f += pA[i] * pB[i];
+		return f;
+	}
+
+	void Correlate_Scalar( float *pOut, const float *pSignal, const float *pTarget, unsigned iLength, unsigned iOffsets, unsigned iStride )
+	{
+		for( unsigned j = 0; j < iOffsets; ++j )
+			pOut[j] = Dot_Scalar( pSignal + j*iStride, pTarget, iLength );
+	}
+
+	const Kernels g_Scalar = { MixAdd_Scalar, ConvertToInt16_Scalar, DeinterleaveStereo_Scalar,
+		PolyphaseMono_Scalar, PolyphaseStereo_Scalar, Correlate_Scalar };
+
+#if defined(MIX_KERNELS_X86)
+	void MixAdd_SSE2( float *pDest, const float *pSrc, unsigned iSamples )
+	{
+		unsigned i = 0;
+		for( ; i + 8 <= iSamples; i += 8 )
+		{
+			__m128 a = _mm_add_ps( _mm_loadu_ps(pDest+i), _mm_loadu_ps(pSrc+i) );
+			__m128 b = _mm_add_ps( _mm_loadu_ps(pDest+i+4), _mm_loadu_ps(pSrc+i+4) );
+			_mm_storeu_ps( pDest+i, a );
+			_mm_storeu_ps( pDest+i+4, b );
+		}
+		MixAdd_Scalar( pDest+i, pSrc+i, iSamples-i );
+	}
+
+	/* _mm_cvtps_epi32 rounds with the MXCSR mode, which is round-to-nearest
+	 * unless someone changed it, the same as lrint. */
+	void ConvertToInt16_SSE2( std::int16_t *pDest, const float *pSrc, unsigned iSamples )
+	{
+		const __m128 fMin = _mm_set1_ps( -1.0f );
+		const __m128 fMax = _mm_set1_ps( +1.0f );
+		const __m128 fScale = _mm_set1_ps( 32767.0f );
+		unsigned i = 0;
+		for( ; i + 8 <= iSamples; i += 8 )
+		{
+			__m128 a = _mm_min_ps( _mm_max_ps(_mm_loadu_ps(pSrc+i), fMin), fMax );
+			__m128 b = _mm_min_ps( _mm_max_ps(_mm_loadu_ps(pSrc+i+4), fMin), fMax );
+			__m128i ia = _mm_cvtps_epi32( _mm_mul_ps(a, fScale) );
+			__m128i ib = _mm_cvtps_epi32( _mm_mul_ps(b, fScale) );
+			_mm_storeu_si128( (__m128i *) (pDest+i), _mm_packs_epi32(ia, ib) );
+		}
+		ConvertToInt16_Scalar( pDest+i, pSrc+i, iSamples-i );
+	}
+
+	void DeinterleaveStereo_SSE2( float *pLeft, float *pRight, const float *pSrc, unsigned iFrames )
+	{
+		unsigned i = 0;
+		for( ; i + 4 <= iFrames; i += 4 )
+		{
+			__m128 a = _mm_loadu_ps( pSrc + i*2 );		// L0 R0 L1 R1
+			__m128 b = _mm_loadu_ps( pSrc + i*2 + 4 );	// L2 R2 L3 R3
+			_mm_storeu_ps( pLeft+i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)) );
+			_mm_storeu_ps( pRight+i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1)) );
+		}
+		DeinterleaveStereo_Scalar( pLeft+i, pRight+i, pSrc+i*2, iFrames-i );
+	}
+
+	void PolyphaseMono_SSE2( float *pOut, const float *pIn, const float *pBank, const int *piInFrame, const int *piPhase, unsigned iFrames )
+	{
+		for( unsigned i = 0; i < iFrames; ++i )
+		{
+			const float *pWin = pIn + piInFrame[i];
+			const float *pTaps = pBank + piPhase[i]*TAPS;
+			__m128 s = _mm_add_ps( _mm_mul_ps(_mm_loadu_ps(pWin), _mm_load_ps(pTaps)),
+				_mm_mul_ps(_mm_loadu_ps(pWin+4), _mm_load_ps(pTaps+4)) );
+			s = _mm_add_ps( s, _mm_movehl_ps(s, s) );
+			s = _mm_add_ss( s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1,1,1,1)) );
+			_mm_store_ss( pOut+i, s );
+		}
+	}
+
+	void PolyphaseStereo_SSE2( float *pOut, const float *pIn, const float *pBank, const int *piInFrame, const int *piPhase, unsigned iFrames )
+	{
+		for( unsigned i = 0; i < iFrames; ++i )
+		{
+			const float *pWin = pIn + piInFrame[i]*2;
+			const float *pTaps = pBank + piPhase[i]*TAPS;
+			const __m128 c0 = _mm_load_ps( pTaps );
+			const __m128 c1 = _mm_load_ps( pTaps+4 );
+			// Each tap twice, once for each channel: c0 c0 c1 c1, and so on.
+			__m128 a = _mm_add_ps( _mm_mul_ps(_mm_loadu_ps(pWin), _mm_unpacklo_ps(c0, c0)),
+				_mm_mul_ps(_mm_loadu_ps(pWin+8), _mm_unpacklo_ps(c1, c1)) );
+			__m128 b = _mm_add_ps( _mm_mul_ps(_mm_loadu_ps(pWin+4), _mm_unpackhi_ps(c0, c0)),
+				_mm_mul_ps(_mm_loadu_ps(pWin+12), _mm_unpackhi_ps(c1, c1)) );
+			__m128 s = _mm_add_ps( a, b );
+			s = _mm_add_ps( s, _mm_movehl_ps(s, s) );
+			_mm_storel_pi( (__m64 *) (pOut + i*2), s );
+		}
+	}
+
+	void Correlate_SSE2( float *pOut, const float *pSignal, const float *pTarget, unsigned iLength, unsigned iOffsets, unsigned iStride )
+	{
+		for( unsigned j = 0; j < iOffsets; ++j )
+		{
+			const float *pA = pSignal + j*iStride;
+			__m128 a = _mm_setzero_ps();
+			__m128 b = _mm_setzero_ps();
+			unsigned i = 0;
+			for( ; i + 8 <= iLength; i += 8 )
+			{
+				a = _mm_add_ps( a, _mm_mul_ps(_mm_loadu_ps(pA+i), _mm_loadu_ps(pTarget+i)) );
+				b = _mm_add_ps( b, _mm_mul_ps(_mm_loadu_ps(pA+i+4), _mm_loadu_ps(pTarget+i+4)) );
+			}
+			__m128 s = _mm_add_ps( a, b );
+			s = _mm_add_ps( s, _mm_movehl_ps(s, s) );
+			s = _mm_add_ss( s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1,1,1,1)) );
+			float f = _mm_cvtss_f32( s );
+			for( ; i < iLength; ++i )
+				f += pA[i] * pTarget[i];
+			pOut[j] = f;
+		}
+	}
+
+	const Kernels g_SSE2 = { MixAdd_SSE2, ConvertToInt16_SSE2, DeinterleaveStereo_SSE2,
+		PolyphaseMono_SSE2, PolyphaseStereo_SSE2, Correlate_SSE2 };
+
+	TARGET_AVX2 void MixAdd_AVX2( float *pDest, const float *pSrc, unsigned iSamples )
+	{
+		unsigned i = 0;
+		for( ; i + 16 <= iSamples; i += 16 )
+		{
+			__m256 a = _mm256_add_ps( _mm256_loadu_ps(pDest+i), _mm256_loadu_ps(pSrc+i) );
+			__m256 b = _mm256_add_ps( _mm256_loadu_ps(pDest+i+8), _mm256_loadu_ps(pSrc+i+8) );
+			_mm256_storeu_ps( pDest+i, a );
+			_mm256_storeu_ps( pDest+i+8, b );
+		}
+		MixAdd_SSE2( pDest+i, pSrc+i, iSamples-i );
+	}
+
+	TARGET_AVX2 void ConvertToInt16_AVX2( std::int16_t *pDest, const float *pSrc, unsigned iSamples )
+	{
+		const __m256 fMin = _mm256_set1_ps( -1.0f );
+		const __m256 fMax = _mm256_set1_ps( +1.0f );
+		const __m256 fScale = _mm256_set1_ps( 32767.0f );
+		unsigned i = 0;
+		for( ; i + 16 <= iSamples; i += 16 )
+		{
+			__m256 a = _mm256_min_ps( _mm256_max_ps(_mm256_loadu_ps(pSrc+i), fMin), fMax );
+			__m256 b = _mm256_min_ps( _mm256_max_ps(_mm256_loadu_ps(pSrc+i+8), fMin), fMax );
+			__m256i ia = _mm256_cvtps_epi32( _mm256_mul_ps(a, fScale) );
+			__m256i ib = _mm256_cvtps_epi32( _mm256_mul_ps(b, fScale) );
+			// packs works within each 128-bit lane; put the quarters back in order.
+			__m256i packed = _mm256_packs_epi32( ia, ib );
+			packed = _mm256_permute4x64_epi64( packed, _MM_SHUFFLE(3,1,2,0) );
+			_mm256_storeu_si256( (__m256i *) (pDest+i), packed );
+		}
+		ConvertToInt16_SSE2( pDest+i, pSrc+i, iSamples-i );
+	}
+
+	TARGET_AVX2 void DeinterleaveStereo_AVX2( float *pLeft, float *pRight, const float *pSrc, unsigned iFrames )
+	{
+		unsigned i = 0;
+		for( ; i + 8 <= iFrames; i += 8 )
+		{
+			__m256 a = _mm256_loadu_ps( pSrc + i*2 );	// L0 R0 L1 R1 | L2 R2 L3 R3
+			__m256 b = _mm256_loadu_ps( pSrc + i*2 + 8 );	// L4 R4 L5 R5 | L6 R6 L7 R7
+			__m256 l = _mm256_shuffle_ps( a, b, _MM_SHUFFLE(2,0,2,0) );	// L0 L1 L4 L5 | L2 L3 L6 L7
+			__m256 r = _mm256_shuffle_ps( a, b, _MM_SHUFFLE(3,1,3,1) );
+			l = _mm256_castpd_ps( _mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3,1,2,0)) );
+			r = _mm256_castpd_ps( _mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3,1,2,0)) );
+			_mm256_storeu_ps( pLeft+i, l );
+			_mm256_storeu_ps( pRight+i, r );
+		}
+		DeinterleaveStereo_SSE2( pLeft+i, pRight+i, pSrc+i*2, iFrames-i );
+	}
+
+	TARGET_AVX2 void PolyphaseMono_AVX2( float *pOut, const float *pIn, const float *pBank, const int *piInFrame, const int *piPhase, unsigned iFrames )
+	{
+		for( unsigned i = 0; i < iFrames; ++i )
+		{
+			__m256 p = _mm256_mul_ps( _mm256_loadu_ps(pIn + piInFrame[i]), _mm256_load_ps(pBank + piPhase[i]*TAPS) );
+			__m128 s = _mm_add_ps( _mm256_castps256_ps128(p), _mm256_extractf128_ps(p, 1) );
+			s = _mm_add_ps( s, _mm_movehl_ps(s, s) );
+			s = _mm_add_ss( s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1,1,1,1)) );
+			_mm_store_ss( pOut+i, s );
+		}
+	}
+
+	TARGET_AVX2 void PolyphaseStereo_AVX2( float *pOut, const float *pIn, const float *pBank, const int *piInFrame, const int *piPhase, unsigned iFrames )
+	{
+		const __m256i iLow = _mm256_setr_epi32( 0, 0, 1, 1, 2, 2, 3, 3 );
+		const __m256i iHigh = _mm256_setr_epi32( 4, 4, 5, 5, 6, 6, 7, 7 );
+		for( unsigned i = 0; i < iFrames; ++i )
+		{
+			const float *pWin = pIn + piInFrame[i]*2;
+			const __m256 c = _mm256_load_ps( pBank + piPhase[i]*TAPS );
+			__m256 p = _mm256_add_ps( _mm256_mul_ps(_mm256_loadu_ps(pWin), _mm256_permutevar8x32_ps(c, iLow)),
+				_mm256_mul_ps(_mm256_loadu_ps(pWin+8), _mm256_permutevar8x32_ps(c, iHigh)) );
+			__m128 s = _mm_add_ps( _mm256_castps256_ps128(p), _mm256_extractf128_ps(p, 1) );
+			s = _mm_add_ps( s, _mm_movehl_ps(s, s) );
+			_mm_storel_pi( (__m64 *) (pOut + i*2), s );
+		}
+	}
+
+	/* No FMA: it rounds once instead of twice, which would change the result. */
+	TARGET_AVX2 void Correlate_AVX2( float *pOut, const float *pSignal, const float *pTarget, unsigned iLength, unsigned iOffsets, unsigned iStride )
+	{
+		for( unsigned j = 0; j < iOffsets; ++j )
+		{
+			const float *pA = pSignal + j*iStride;
+			__m256 p = _mm256_setzero_ps();
+			unsigned i = 0;
+			for( ; i + 8 <= iLength; i += 8 )
+				p = _mm256_add_ps( p, _mm256_mul_ps(_mm256_loadu_ps(pA+i), _mm256_loadu_ps(pTarget+i)) );
+			__m128 s = _mm_add_ps( _mm256_castps256_ps128(p), _mm256_extractf128_ps(p, 1) );
+			s = _mm_add_ps( s, _mm_movehl_ps(s, s) );
+			s = _mm_add_ss( s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1,1,1,1)) );
+			float f = _mm_cvtss_f32( s );
+			for( ; i < iLength; ++i )
+				f += pA[i] * pTarget[i];
+			pOut[j] = f;
+		}
+	}
+
+	const Kernels g_AVX2 = { MixAdd_AVX2, ConvertToInt16_AVX2, DeinterleaveStereo_AVX2,
+		PolyphaseMono_AVX2, PolyphaseStereo_AVX2, Correlate_AVX2 };
+
+	bool CPUHasSSE2()
+	{
+#if defined(__x86_64__) || defined(_M_X64)
+		return true;
+#elif defined(_MSC_VER)
+		int regs[4];
+		__cpuid( regs, 1 );
+		return (regs[3] & (1 << 26)) != 0;
+#else
+		__builtin_cpu_init(); // we may be running from a static constructor
+		return __builtin_cpu_supports( "sse2" );
+#endif
+	}
+
+	bool CPUHasAVX2()
+	{
+#if defined(_MSC_VER)
+		int regs[4];
+		__cpuid( regs, 0 );
+		if( regs[0] < 7 )
+			return false;
+		// The OS has to save the YMM registers, too.
+		__cpuid( regs, 1 );
+		const bool bOSXSAVE = (regs[2] & (1 << 27)) != 0;
+		if( !bOSXSAVE || (_xgetbv(0) & 6) != 6 )
+			return false;
+		__cpuidex( regs, 7, 0 );
+		return (regs[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports( "avx2" );
+#endif
+	}
+#endif
+
+#if defined(MIX_KERNELS_NEON)
+	void MixAdd_NEON( float *pDest, const float *pSrc, unsigned iSamples )
+	{
+		unsigned i = 0;
+		for( ; i + 8 <= iSamples; i += 8 )
+		{
+			float32x4_t a = vaddq_f32( vld1q_f32(pDest+i), vld1q_f32(pSrc+i) );
+			float32x4_t b = vaddq_f32( vld1q_f32(pDest+i+4), vld1q_f32(pSrc+i+4) );
+			vst1q_f32( pDest+i, a );
+			vst1q_f32( pDest+i+4, b );
+		}
+		MixAdd_Scalar( pDest+i, pSrc+i, iSamples-i );
+	}
+
+	/* vcvtnq rounds to nearest-even regardless of FPCR, as lrint does in
+	 * the default mode. */
+	void ConvertToInt16_NEON( std::int16_t *pDest, const float *pSrc, unsigned iSamples )
+	{
+		const float32x4_t fMin = vdupq_n_f32( -1.0f );
+		const float32x4_t fMax = vdupq_n_f32( +1.0f );
+		unsigned i = 0;
+		for( ; i + 8 <= iSamples; i += 8 )
+		{
+			float32x4_t a = vminq_f32( vmaxq_f32(vld1q_f32(pSrc+i), fMin), fMax );
+			float32x4_t b = vminq_f32( vmaxq_f32(vld1q_f32(pSrc+i+4), fMin), fMax );
+			int32x4_t ia = vcvtnq_s32_f32( vmulq_n_f32(a, 32767.0f) );
+			int32x4_t ib = vcvtnq_s32_f32( vmulq_n_f32(b, 32767.0f) );
+			vst1q_s16( pDest+i, vcombine_s16(vqmovn_s32(ia), vqmovn_s32(ib)) );
+		}
+		ConvertToInt16_Scalar( pDest+i, pSrc+i, iSamples-i );
+	}
+
+	void DeinterleaveStereo_NEON( float *pLeft, float *pRight, const float *pSrc, unsigned iFrames )
+	{
+		unsigned i = 0;
+		for( ; i + 4 <= iFrames; i += 4 )
+		{
+			float32x4x2_t lr = vld2q_f32( pSrc + i*2 );
+			vst1q_f32( pLeft+i, lr.val[0] );
+			vst1q_f32( pRight+i, lr.val[1] );
+		}
+		DeinterleaveStereo_Scalar( pLeft+i, pRight+i, pSrc+i*2, iFrames-i );
+	}
+
+	void PolyphaseMono_NEON( float *pOut, const float *pIn, const float *pBank, const int *piInFrame, const int *piPhase, unsigned iFrames )
+	{
+		for( unsigned i = 0; i < iFrames; ++i )
+		{
+			const float *pWin = pIn + piInFrame[i];
+			const float *pTaps = pBank + piPhase[i]*TAPS;
+			float32x4_t s = vaddq_f32( vmulq_f32(vld1q_f32(pWin), vld1q_f32(pTaps)),
+				vmulq_f32(vld1q_f32(pWin+4), vld1q_f32(pTaps+4)) );
+			float32x2_t h = vadd_f32( vget_low_f32(s), vget_high_f32(s) );
+			pOut[i] = vget_lane_f32( vpadd_f32(h, h), 0 );
+		}
+	}
+
+	void PolyphaseStereo_NEON( float *pOut, const float *pIn, const float *pBank, const int *piInFrame, const int *piPhase, unsigned iFrames )
+	{
+		for( unsigned i = 0; i < iFrames; ++i )
+		{
+			const float *pWin = pIn + piInFrame[i]*2;
+			const float *pTaps = pBank + piPhase[i]*TAPS;
+			const float32x4_t c0 = vld1q_f32( pTaps );
+			const float32x4_t c1 = vld1q_f32( pTaps+4 );
+			float32x4_t a = vaddq_f32( vmulq_f32(vld1q_f32(pWin), vzip1q_f32(c0, c0)),
+				vmulq_f32(vld1q_f32(pWin+8), vzip1q_f32(c1, c1)) );
+			float32x4_t b = vaddq_f32( vmulq_f32(vld1q_f32(pWin+4), vzip2q_f32(c0, c0)),
+				vmulq_f32(vld1q_f32(pWin+12), vzip2q_f32(c1, c1)) );
+			float32x4_t s = vaddq_f32( a, b );
+			vst1_f32( pOut + i*2, vadd_f32(vget_low_f32(s), vget_high_f32(s)) );
+		}
+	}
+
+	void Correlate_NEON( float *pOut, const float *pSignal, const float *pTarget, unsigned iLength, unsigned iOffsets, unsigned iStride )
+	{
+		for( unsigned j = 0; j < iOffsets; ++j )
+		{
+			const float *pA = pSignal + j*iStride;
+			float32x4_t a = vdupq_n_f32( 0 );
+			float32x4_t b = vdupq_n_f32( 0 );
+			unsigned i = 0;
+			for( ; i + 8 <= iLength; i += 8 )
+			{
+				a = vaddq_f32( a, vmulq_f32(vld1q_f32(pA+i), vld1q_f32(pTarget+i)) );
+				b = vaddq_f32( b, vmulq_f32(vld1q_f32(pA+i+4), vld1q_f32(pTarget+i+4)) );
+			}
+			float32x4_t s = vaddq_f32( a, b );
+			float32x2_t h = vadd_f32( vget_low_f32(s), vget_high_f32(s) );
+			float f = vget_lane_f32( vpadd_f32(h, h), 0 );
+			for( ; i < iLength; ++i )
+				f += pA[i] * pTarget[i];
+			pOut[j] = f;
+		}
+	}
+
+	const Kernels g_NEON = { MixAdd_NEON, ConvertToInt16_NEON, DeinterleaveStereo_NEON,
+		PolyphaseMono_NEON, PolyphaseStereo_NEON, Correlate_NEON };
+#endif
+
+	const Kernels *GetKernels( MixKernels k )
+	{
+		switch( k )
+		{
+		case MixKernels_Scalar: return &g_Scalar;
+#if defined(MIX_KERNELS_X86)
+		case MixKernels_SSE2: return CPUHasSSE2()? &g_SSE2:nullptr;
+		case MixKernels_AVX2: return CPUHasSSE2() && CPUHasAVX2()? &g_AVX2:nullptr;
+#endif
+#if defined(MIX_KERNELS_NEON)
+		case MixKernels_NEON: return &g_NEON;
+#endif
+		default: return nullptr;
+		}
+	}
+
+	MixKernels GetBest()
+	{
+		for( int k = NUM_MixKernels-1; k > MixKernels_Scalar; --k )
+		{
+			if( GetKernels(MixKernels(k)) != nullptr )
+				return MixKernels(k);
+		}
+		return MixKernels_Scalar;
+	}
+
+	MixKernels g_Active = GetBest();
+	const Kernels *g_pKernels = GetKernels( g_Active );
+}
+
+bool RageSoundMixKernels::IsSupported( MixKernels k )
+{
+	return GetKernels( k ) != nullptr;
+}
+
+MixKernels RageSoundMixKernels::GetActive()
+{
+	return g_Active;
+}
+
+void RageSoundMixKernels::SetActive( MixKernels k )
+{
+	ASSERT( IsSupported(k) );
+	g_Active = k;
+	g_pKernels = GetKernels( k );
+}
+
+void RageSoundMixKernels::MixAdd( float *pDest, const float *pSrc, unsigned iSamples )
+{
+	g_pKernels->MixAdd( pDest, pSrc, iSamples );
+}
+
+void RageSoundMixKernels::ConvertToInt16( std::int16_t *pDest, const float *pSrc, unsigned iSamples )
+{
+	g_pKernels->ConvertToInt16( pDest, pSrc, iSamples );
+}
+
+void RageSoundMixKernels::Deinterleave( float **pDest, const float *pSrc, unsigned iFrames, int iChannels )
+{
+	if( iChannels == 2 )
+	{
+		g_pKernels->DeinterleaveStereo( pDest[0], pDest[1], pSrc, iFrames );
+		return;
+	}
+
+	if( iChannels == 1 )
+	{
+		memcpy( pDest[0], pSrc, iFrames * sizeof(float) );
+		return;
+	}
+
+	for( unsigned i = 0; i < iFrames; ++i )
+		for( int ch = 0; ch < iChannels; ++ch )
+			pDest[ch][i] = pSrc[iChannels * i + ch];
+}
+
+void RageSoundMixKernels::Polyphase( float *pOut, const float *pIn, int iChannels, const float *pBank,
+	const int *piInFrame, const int *piPhase, unsigned iFrames )
+{
+	if( iChannels == 2 )
+	{
+		g_pKernels->PolyphaseStereo( pOut, pIn, pBank, piInFrame, piPhase, iFrames );
+		return;
+	}
+
+	if( iChannels == 1 )
+	{
+		g_pKernels->PolyphaseMono( pOut, pIn, pBank, piInFrame, piPhase, iFrames );
+		return;
+	}
+
+	for( unsigned i = 0; i < iFrames; ++i )
+	{
+		const float *pTaps = pBank + piPhase[i]*TAPS;
+		for( int ch = 0; ch < iChannels; ++ch )
+			pOut[iChannels * i + ch] = Polyphase_Scalar( pIn + iChannels * piInFrame[i] + ch, iChannels, pTaps );
+	}
+}
+
+void RageSoundMixKernels::Correlate( float *pOut, const float *pSignal, const float *pTarget,
+	unsigned iLength, unsigned iOffsets, unsigned iStride )
+{
+	g_pKernels->Correlate( pOut, pSignal, pTarget, iLength, iOffsets, iStride );
+}
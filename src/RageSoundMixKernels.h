@@ -0,0 +1,51 @@
+/* RageSoundMixKernels - Vectorized inner loops for mixing sound. */
+
+#ifndef RAGE_SOUND_MIX_KERNELS_H
+#define RAGE_SOUND_MIX_KERNELS_H
+
+#include <cstdint>
+
+enum MixKernels
+{
+	MixKernels_Scalar,
+	MixKernels_SSE2,
+	MixKernels_AVX2,
+	MixKernels_NEON,
+	NUM_MixKernels,
+	MixKernels_Invalid
+};
+const RString& MixKernelsToString( MixKernels k );
+
+/** @brief Mixer loops, picked at startup for the best instruction set the CPU has.
+ *
+ * Every set gives the same results as the scalar one, bit for bit. */
+namespace RageSoundMixKernels
+{
+	bool IsSupported( MixKernels k );
+	MixKernels GetActive();
+	/* For tests and benchmarks; don't call while sound is playing. */
+	void SetActive( MixKernels k );
+
+	/* pDest[i] += pSrc[i] */
+	void MixAdd( float *pDest, const float *pSrc, unsigned iSamples );
+	/* Clamp to -1..+1, scale and round to nearest. */
+	void ConvertToInt16( std::int16_t *pDest, const float *pSrc, unsigned iSamples );
+	/* Split iFrames interleaved frames into one buffer per channel. */
+	void Deinterleave( float **pDest, const float *pSrc, unsigned iFrames, int iChannels );
+
+	/* The resampler's filter: output frame i is the POLYPHASE_TAPS interleaved
+	 * frames of pIn from frame piInFrame[i] on, each channel weighted by row
+	 * piPhase[i] of pBank.  Rows are POLYPHASE_TAPS floats, and pBank must be
+	 * 32-byte aligned.  Mono and stereo are vectorized. */
+	const int POLYPHASE_TAPS = 8;
+	void Polyphase( float *pOut, const float *pIn, int iChannels, const float *pBank,
+		const int *piInFrame, const int *piPhase, unsigned iFrames );
+
+	/* Time stretching's search: pOut[j] is the dot product of the iLength
+	 * floats of pTarget with those of pSignal from j*iStride on, for iOffsets
+	 * values of j. */
+	void Correlate( float *pOut, const float *pSignal, const float *pTarget,
+		unsigned iLength, unsigned iOffsets, unsigned iStride );
+}
+
+#endif
@@ -0,0 +1,373 @@
+#include "global.h"
+#include "RageSoundPCMCache.h"
+#include "RageSoundReader_FileReader.h"
+#include "RageSoundReader_MappedPCM.h"
+#include "RageSoundUtil.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageLog.h"
+#include "RageUtil.h"
+#include "Preference.h"
+#include "SpecialFiles.h"
+
+#include <climits>
+#include <memory>
+
+#if defined(WIN32)
+#include <windows.h>
+#include "archutils/Win32/ErrorStrings.h"
+#elif defined(LINUX) || defined(MACOSX)
+#include <sys/resource.h>
+#endif
+
+RageSoundPCMCache *PCMCACHE = nullptr;
+
+/* Megabytes of disk to keep decoded music in; 0 to decode as songs play.
+ * A few minutes of stereo music at 44.1kHz is about 30MB.  This writes a lot
+ * to the disk, so it's off unless a cabinet asks for it. */
+static Preference<int> g_iPCMCacheMB( "PCMCacheMB", 0 );
+
+#define PCM_CACHE_DIR (SpecialFiles::CACHE_DIR + "PCM/")
+
+static std::int64_t GetBudget()
+{
+	return std::int64_t( std::max(g_iPCMCacheMB.Get(), 0) ) * 1024 * 1024;
+}
+
+RageSoundPCMCache::RageSoundPCMCache():
+	m_Event( "PCMCache" )
+{
+	m_bShutdown = false;
+	m_iPauseCount = 0;
+	m_bWantedChanged = false;
+	m_iTotalBytes = 0;
+
+	if( g_iPCMCacheMB.Get() <= 0 )
+		return;
+
+	m_DecodeThread.SetName( "PCM cache" );
+	m_DecodeThread.Create( DecodeThread_Start, this );
+}
+
+RageSoundPCMCache::~RageSoundPCMCache()
+{
+	if( !m_DecodeThread.IsCreated() )
+		return;
+
+	m_Event.Lock();
+	m_bShutdown = true;
+	m_Event.Broadcast();
+	m_Event.Unlock();
+
+	m_DecodeThread.Wait();
+}
+
+/* The path picks the file, and its size and date pick the version of it. */
+RString RageSoundPCMCache::GetKey( const RString &sPath )
+{
+	return ssprintf( "%08x%08x", GetHashForString(sPath), GetHashForFile(sPath) );
+}
+
+RString RageSoundPCMCache::GetCachePath( const RString &sKey )
+{
+	return PCM_CACHE_DIR + sKey + ".pcm";
+}
+
+RageSoundReader *RageSoundPCMCache::Open( const RString &sPath )
+{
+	if( !m_DecodeThread.IsCreated() )
+		return nullptr;
+
+	const RString sKey = GetKey( sPath );
+	{
+		LockMut( m_Event );
+		if( m_Entries.find(sKey) == m_Entries.end() )
+			return nullptr;
+	}
+
+	RageSoundReader_MappedPCM *pSound = new RageSoundReader_MappedPCM;
+	if( !pSound->Open(GetCachePath(sKey)) )
+	{
+		LOG->Warn( "RageSoundPCMCache: couldn't open the decoded copy of \"%s\": %s",
+			sPath.c_str(), pSound->GetError().c_str() );
+		delete pSound;
+		return nullptr;
+	}
+
+	LOG->Trace( "RageSoundPCMCache: playing \"%s\" decoded", sPath.c_str() );
+	return pSound;
+}
+
+void RageSoundPCMCache::SetWanted( const std::vector<RString> &asPaths )
+{
+	if( !m_DecodeThread.IsCreated() )
+		return;
+
+	LockMut( m_Event );
+	m_asWanted = asPaths;
+	m_bWantedChanged = true;
+	m_Event.Broadcast();
+}
+
+void RageSoundPCMCache::PauseDecoding()
+{
+	LockMut( m_Event );
+	++m_iPauseCount;
+}
+
+void RageSoundPCMCache::UnPauseDecoding()
+{
+	LockMut( m_Event );
+	ASSERT( m_iPauseCount > 0 );
+	--m_iPauseCount;
+	m_Event.Broadcast();
+}
+
+/* Wait until decoding isn't paused.  Return false if we're shutting down. */
+bool RageSoundPCMCache::WaitWhilePaused()
+{
+	LockMut( m_Event );
+	while( m_iPauseCount > 0 && !m_bShutdown )
+		m_Event.Wait();
+	return !m_bShutdown;
+}
+
+/* Find the files decoded by earlier runs, and clean up after any that were
+ * interrupted. */
+void RageSoundPCMCache::ReadIndex()
+{
+	std::vector<RString> asFiles;
+	GetDirListing( PCM_CACHE_DIR + "*", asFiles, false, true );
+
+	LockMut( m_Event );
+	for( RString const &sFile : asFiles )
+	{
+		const RString sExt = GetExtension( sFile );
+		if( sExt.EqualsNoCase("pcm") )
+		{
+			const std::int64_t iBytes = FILEMAN->GetFileSizeInBytes( sFile );
+			m_Entries[GetFileNameWithoutExtension(sFile)] = iBytes;
+			m_iTotalBytes += iBytes;
+		}
+		else if( sExt.EqualsNoCase("tmp") )
+		{
+			FILEMAN->Remove( sFile );
+		}
+	}
+
+	LOG->Trace( "RageSoundPCMCache: %i files, %i MB", int(m_Entries.size()), int(m_iTotalBytes / (1024*1024)) );
+}
+
+/* Decoding is only worth doing with time nothing else wants. */
+static void LowerThreadPriority()
+{
+#if defined(WIN32)
+	if( !SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE) )
+		LOG->Warn( werr_ssprintf(GetLastError(), "RageSoundPCMCache: SetThreadPriority failed") );
+#elif defined(LINUX)
+	/* On Linux, this only changes the calling thread. */
+	setpriority( PRIO_PROCESS, 0, 19 );
+#elif defined(MACOSX)
+	/* Lowers the thread's disk priority, too. */
+	setpriority( PRIO_DARWIN_THREAD, 0, PRIO_DARWIN_BG );
+#endif
+}
+
+void RageSoundPCMCache::DecodeThread()
+{
+	LowerThreadPriority();
+	ReadIndex();
+
+	m_Event.Lock();
+	while( !m_bShutdown )
+	{
+		/* It's normal for this to wait for a long time. */
+		if( m_iPauseCount > 0 || !m_bWantedChanged )
+		{
+			m_Event.Wait();
+			continue;
+		}
+
+		const std::vector<RString> asWanted = m_asWanted;
+		m_bWantedChanged = false;
+		m_Event.Unlock();
+
+		Update( asWanted );
+
+		m_Event.Lock();
+	}
+	m_Event.Unlock();
+}
+
+/* Decode the wanted files that aren't decoded yet, most wanted first, until
+ * the cache is full of wanted files.  Return early if the list changes. */
+void RageSoundPCMCache::Update( const std::vector<RString> &asPaths )
+{
+	/* Getting a key looks at the file, so don't do it while locked. */
+	std::vector<RString> asKeys;
+	std::map<RString, int> mapKeyToRank;
+	for( unsigned i = 0; i < asPaths.size(); ++i )
+	{
+		asKeys.push_back( GetKey(asPaths[i]) );
+		mapKeyToRank.insert( std::make_pair(asKeys[i], int(i)) );
+	}
+
+	/* If the cache was made smaller, let go of the least wanted files. */
+	{
+		LockMut( m_Event );
+		MakeRoom( 0, mapKeyToRank, -1 );
+	}
+
+	const std::int64_t iBudget = GetBudget();
+	std::int64_t iWantedBytes = 0;
+	for( unsigned i = 0; i < asPaths.size() && iWantedBytes < iBudget; ++i )
+	{
+		if( !WaitWhilePaused() )
+			return;
+
+		{
+			LockMut( m_Event );
+			if( m_bWantedChanged )
+				return;
+
+			std::map<RString, std::int64_t>::const_iterator it = m_Entries.find( asKeys[i] );
+			if( it != m_Entries.end() )
+			{
+				iWantedBytes += it->second;
+				continue;
+			}
+			if( m_Unusable.find(asKeys[i]) != m_Unusable.end() )
+				continue;
+		}
+
+		const std::int64_t iBytes = Decode( asPaths[i], asKeys[i], iBudget - iWantedBytes, mapKeyToRank, i );
+		if( iBytes > 0 )
+			iWantedBytes += iBytes;
+	}
+}
+
+/* Remove files until there's room for iBytes more, starting with the least
+ * wanted, but keeping anything wanted as much as iRank.  Return false if
+ * there isn't enough room anyway.  m_Event must be locked. */
+bool RageSoundPCMCache::MakeRoom( std::int64_t iBytes, const std::map<RString, int> &mapKeyToRank, int iRank )
+{
+	while( m_iTotalBytes + iBytes > GetBudget() )
+	{
+		std::map<RString, std::int64_t>::iterator victim = m_Entries.end();
+		int iVictimRank = iRank;
+		for( std::map<RString, std::int64_t>::iterator it = m_Entries.begin(); it != m_Entries.end(); ++it )
+		{
+			std::map<RString, int>::const_iterator r = mapKeyToRank.find( it->first );
+			const int iEntryRank = r == mapKeyToRank.end()? INT_MAX:r->second;
+			if( iEntryRank > iVictimRank )
+			{
+				victim = it;
+				iVictimRank = iEntryRank;
+			}
+		}
+
+		if( victim == m_Entries.end() )
+			return false;
+
+		/* A sound still playing it keeps its own reference, so this is safe.
+		 * Where the file was read into memory, it isn't open anyway. */
+		FILEMAN->Remove( GetCachePath(victim->first) );
+		m_iTotalBytes -= victim->second;
+		m_Entries.erase( victim );
+	}
+	return true;
+}
+
+/* Decode sPath into the cache, unless it would take more than iMaxBytes.
+ * Return the size of the file, or -1 if it wasn't added. */
+std::int64_t RageSoundPCMCache::Decode( const RString &sPath, const RString &sKey, std::int64_t iMaxBytes,
+	const std::map<RString, int> &mapKeyToRank, int iRank )
+{
+	RString sError;
+	bool bPrebuffer;
+	std::unique_ptr<RageSoundReader> pSound( RageSoundReader_FileReader::OpenFile(sPath, sError, &bPrebuffer) );
+
+	/* Short sounds are preloaded into memory by RageSound anyway, and a sound
+	 * whose rate changes as it plays can't be stored as one stream. */
+	const unsigned iChannels = pSound? pSound->GetNumChannels():0;
+	if( pSound == nullptr || bPrebuffer || pSound->GetStreamToSourceRatio() != 1.0f ||
+		iChannels == 0 || iChannels > 8 )
+	{
+		if( pSound == nullptr )
+			LOG->Warn( "RageSoundPCMCache: couldn't open \"%s\": %s", sPath.c_str(), sError.c_str() );
+		LockMut( m_Event );
+		m_Unusable.insert( sKey );
+		return -1;
+	}
+
+	const RString sCachePath = GetCachePath( sKey );
+	const RString sTempPath = sCachePath + ".tmp";
+	RageFile f;
+	if( !f.Open(sTempPath, RageFile::WRITE) )
+	{
+		LOG->Warn( "RageSoundPCMCache: couldn't write %s: %s", sTempPath.c_str(), f.GetError().c_str() );
+		return -1;
+	}
+
+	const RString sHeader = RageSoundReader_MappedPCM::MakeHeader( pSound->GetSampleRate(), iChannels );
+	std::int64_t iBytes = sHeader.size();
+	bool bDone = f.Write( sHeader ) != -1;
+	bool bUsable = true;
+
+	float fBuf[4096];
+	std::int16_t iBuf[ARRAYLEN(fBuf)];
+	while( bDone )
+	{
+		if( !WaitWhilePaused() )
+		{
+			bDone = false;
+			break;
+		}
+
+		const int iGot = pSound->Read( fBuf, ARRAYLEN(fBuf) / iChannels );
+		if( iGot == RageSoundReader::END_OF_FILE )
+			break;
+		if( iGot < 0 || pSound->GetStreamToSourceRatio() != 1.0f )
+		{
+			LOG->Warn( "RageSoundPCMCache: couldn't decode \"%s\": %s", sPath.c_str(), pSound->GetError().c_str() );
+			bDone = bUsable = false;
+			break;
+		}
+
+		const int iSamples = iGot * iChannels;
+		RageSoundUtil::ConvertFloatToNativeInt16( fBuf, iBuf, iSamples );
+		if( f.Write(iBuf, iSamples * sizeof(std::int16_t)) == -1 )
+		{
+			LOG->Warn( "RageSoundPCMCache: couldn't write %s: %s", sTempPath.c_str(), f.GetError().c_str() );
+			bDone = false;
+			break;
+		}
+
+		/* It won't fit.  Something else might, so don't give up on it. */
+		iBytes += iSamples * sizeof(std::int16_t);
+		if( iBytes > iMaxBytes )
+		{
+			bDone = false;
+			break;
+		}
+	}
+
+	if( bDone && f.Flush() == -1 )
+		bDone = false;
+	f.Close();
+
+	LockMut( m_Event );
+	if( !bUsable )
+		m_Unusable.insert( sKey );
+	if( !bDone || !MakeRoom(iBytes, mapKeyToRank, iRank) || !FILEMAN->Move(sTempPath, sCachePath) )
+	{
+		FILEMAN->Remove( sTempPath );
+		return -1;
+	}
+
+	m_Entries[sKey] = iBytes;
+	m_iTotalBytes += iBytes;
+	LOG->Trace( "RageSoundPCMCache: decoded \"%s\" (%i MB, %i MB in all)", sPath.c_str(),
+		int(iBytes / (1024*1024)), int(m_iTotalBytes / (1024*1024)) );
+	return iBytes;
+}
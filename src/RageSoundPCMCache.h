@@ -0,0 +1,81 @@
+/* RageSoundPCMCache - Keep the music of often played songs decoded on disk. */
+
+#ifndef RAGE_SOUND_PCM_CACHE_H
+#define RAGE_SOUND_PCM_CACHE_H
+
+#include "RageThreads.h"
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+class RageSoundReader;
+
+/*
+ * Files are decoded by a low-priority background thread, most wanted first,
+ * into as much space as the "PCMCacheMB" preference allows; by default there
+ * is no space, and no thread.  Each is named after a hash of its path, size
+ * and date, so a changed file is decoded again.
+ */
+class RageSoundPCMCache
+{
+public:
+	RageSoundPCMCache();
+
+	/* Note that destruction of this object will wait for the file being
+	 * decoded to be abandoned. */
+	~RageSoundPCMCache();
+
+	/* If sPath has been decoded, return a reader of the decoded sound.
+	 * Otherwise, return nullptr. */
+	RageSoundReader *Open( const RString &sPath );
+
+	/* Set the files worth keeping decoded, most wanted first.  Files that
+	 * aren't wanted, or are wanted less, are removed to make room. */
+	void SetWanted( const std::vector<RString> &asPaths );
+
+	/* Stop decoding while something that can't afford to share the CPU or
+	 * disk is running, like gameplay, song loading or music previews.  Calls
+	 * nest. */
+	void PauseDecoding();
+	void UnPauseDecoding();
+
+private:
+	RageThread m_DecodeThread;
+	void DecodeThread();
+	static int DecodeThread_Start( void *p ) { ((RageSoundPCMCache *) p)->DecodeThread(); return 0; }
+
+	void ReadIndex();
+	void Update( const std::vector<RString> &asPaths );
+	std::int64_t Decode( const RString &sPath, const RString &sKey, std::int64_t iMaxBytes,
+		const std::map<RString, int> &mapKeyToRank, int iRank );
+	bool MakeRoom( std::int64_t iBytes, const std::map<RString, int> &mapKeyToRank, int iRank );
+	bool WaitWhilePaused();
+
+	static RString GetKey( const RString &sPath );
+	static RString GetCachePath( const RString &sKey );
+
+	/* Lock before accessing any of the rest of the object, and signal it when
+	 * the thread has something new to do.  Don't keep this locked while
+	 * decoding. */
+	RageEvent m_Event;
+
+	bool m_bShutdown;
+	int m_iPauseCount;
+
+	std::vector<RString> m_asWanted;
+	bool m_bWantedChanged;
+
+	/* Decoded files, by key, and their sizes in bytes. */
+	std::map<RString, std::int64_t> m_Entries;
+	std::int64_t m_iTotalBytes;
+
+	/* Files that can't be decoded, or aren't worth it, so they aren't tried
+	 * again. */
+	std::set<RString> m_Unusable;
+};
+
+extern RageSoundPCMCache *PCMCACHE;
+
+#endif
@@ -0,0 +1,162 @@
+#include "global.h"
+#include "RageSoundReader_MappedPCM.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageSoundUtil.h"
+#include "RageUtil.h"
+
+#include <climits>
+#include <cstring>
+
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* "SMPC", PCM_VERSION, sample rate, channels.  The header is a whole number
+ * of samples long, so the samples after it stay aligned. */
+static const char PCM_MAGIC[4] = { 'S', 'M', 'P', 'C' };
+static const std::uint32_t PCM_VERSION = 1;
+static const unsigned HEADER_SIZE = sizeof(PCM_MAGIC) + 3*sizeof(std::uint32_t);
+
+class RageSoundReader_MappedPCM::Mapping
+{
+public:
+	Mapping(): m_pData(nullptr), m_iSize(0), m_bMapped(false) { }
+	~Mapping()
+	{
+#if !defined(WIN32)
+		if( m_bMapped )
+			munmap( const_cast<char *>(m_pData), m_iSize );
+#endif
+	}
+
+	bool Open( const RString &sPath, RString &sError );
+
+	const char *m_pData;
+	std::size_t m_iSize;
+
+private:
+	bool m_bMapped;
+	RString m_sBuffer;
+};
+
+bool RageSoundReader_MappedPCM::Mapping::Open( const RString &sPath, RString &sError )
+{
+#if !defined(WIN32)
+	/* Map the file if it lives on a real disk, so nothing is read until it's
+	 * played. */
+	const int fd = open( FILEMAN->ResolvePath(sPath).c_str(), O_RDONLY );
+	if( fd != -1 )
+	{
+		struct stat st;
+		if( fstat(fd, &st) == 0 && st.st_size > 0 )
+		{
+			void *p = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+			if( p != MAP_FAILED )
+			{
+				/* It'll be played from the start, so start reading it now. */
+				madvise( p, st.st_size, MADV_SEQUENTIAL );
+				madvise( p, st.st_size, MADV_WILLNEED );
+				m_pData = (const char *) p;
+				m_iSize = st.st_size;
+				m_bMapped = true;
+			}
+		}
+		close( fd );
+		if( m_bMapped )
+			return true;
+	}
+#endif
+
+	RageFile f;
+	if( !f.Open(sPath) || f.Read(m_sBuffer) == -1 )
+	{
+		sError = f.GetError();
+		return false;
+	}
+	m_pData = m_sBuffer.data();
+	m_iSize = m_sBuffer.size();
+	return true;
+}
+
+RageSoundReader_MappedPCM::RageSoundReader_MappedPCM():
+	m_pSamples(nullptr), m_iFrames(0), m_iPosition(0),
+	m_iSampleRate(0), m_iChannels(0)
+{
+}
+
+RString RageSoundReader_MappedPCM::MakeHeader( int iSampleRate, unsigned iChannels )
+{
+	const std::uint32_t aFields[3] = { PCM_VERSION, std::uint32_t(iSampleRate), iChannels };
+	RString sHeader( PCM_MAGIC, sizeof(PCM_MAGIC) );
+	sHeader.append( (const char *) aFields, sizeof(aFields) );
+	return sHeader;
+}
+
+bool RageSoundReader_MappedPCM::Open( const RString &sPath )
+{
+	std::shared_ptr<Mapping> pMapping = std::make_shared<Mapping>();
+	if( !pMapping->Open(sPath, m_sError) )
+		return false;
+
+	std::uint32_t aFields[3];
+	if( pMapping->m_iSize < HEADER_SIZE || memcmp(pMapping->m_pData, PCM_MAGIC, sizeof(PCM_MAGIC)) )
+	{
+		m_sError = "not a PCM cache file";
+		return false;
+	}
+	memcpy( aFields, pMapping->m_pData + sizeof(PCM_MAGIC), sizeof(aFields) );
+	if( aFields[0] != PCM_VERSION )
+	{
+		m_sError = ssprintf( "version %u, expected %u", aFields[0], PCM_VERSION );
+		return false;
+	}
+
+	const std::size_t iFrameSize = aFields[2] * sizeof(std::int16_t);
+	const std::size_t iDataSize = pMapping->m_iSize - HEADER_SIZE;
+	if( aFields[1] == 0 || aFields[1] > INT_MAX || aFields[2] == 0 ||
+		iDataSize % iFrameSize != 0 || iDataSize / iFrameSize > INT_MAX )
+	{
+		m_sError = "damaged";
+		return false;
+	}
+
+	m_iSampleRate = aFields[1];
+	m_iChannels = aFields[2];
+	m_iFrames = iDataSize / iFrameSize;
+	m_pSamples = (const std::int16_t *) (pMapping->m_pData + HEADER_SIZE);
+	m_iPosition = 0;
+	m_pMapping = pMapping;
+	return true;
+}
+
+int RageSoundReader_MappedPCM::GetLength() const
+{
+	return int( std::int64_t(m_iFrames) * 1000 / m_iSampleRate );
+}
+
+int RageSoundReader_MappedPCM::SetPosition( int iFrame )
+{
+	if( iFrame >= m_iFrames )
+	{
+		m_iPosition = m_iFrames;
+		return 0;
+	}
+
+	m_iPosition = std::max( iFrame, 0 );
+	return 1;
+}
+
+int RageSoundReader_MappedPCM::Read( float *pBuffer, int iFrames )
+{
+	iFrames = std::min( iFrames, m_iFrames - m_iPosition );
+	if( iFrames <= 0 )
+		return END_OF_FILE;
+
+	RageSoundUtil::ConvertNativeInt16ToFloat( m_pSamples + m_iPosition * m_iChannels, pBuffer, iFrames * m_iChannels );
+	m_iPosition += iFrames;
+	return iFrames;
+}
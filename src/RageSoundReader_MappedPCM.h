@@ -0,0 +1,51 @@
+/* RageSoundReader_MappedPCM - Read decoded sound from a cache file, mapped into memory. */
+
+#ifndef RAGE_SOUND_READER_MAPPED_PCM_H
+#define RAGE_SOUND_READER_MAPPED_PCM_H
+
+#include "RageSoundReader.h"
+
+#include <cstdint>
+#include <memory>
+
+/*
+ * The file is a header, then interleaved 16-bit samples, in native byte
+ * order, to the end of the file.  Where mmap is available the samples are
+ * read straight out of the page cache; elsewhere the file is read into
+ * memory when it's opened.  Either way, copies share the data.
+ */
+class RageSoundReader_MappedPCM: public RageSoundReader
+{
+public:
+	RageSoundReader_MappedPCM();
+
+	/* Return false and set GetError() if the file can't be used. */
+	bool Open( const RString &sPath );
+
+	int GetLength() const;
+	int SetPosition( int iFrame );
+	int Read( float *pBuffer, int iFrames );
+	RageSoundReader_MappedPCM *Copy() const { return new RageSoundReader_MappedPCM(*this); }
+	int GetSampleRate() const { return m_iSampleRate; }
+	unsigned GetNumChannels() const { return m_iChannels; }
+	int GetNextSourceFrame() const { return m_iPosition; }
+	float GetStreamToSourceRatio() const { return 1.0f; }
+	RString GetError() const { return m_sError; }
+
+	/* Return the header for a file of this format. */
+	static RString MakeHeader( int iSampleRate, unsigned iChannels );
+
+private:
+	class Mapping;
+	std::shared_ptr<const Mapping> m_pMapping;
+
+	const std::int16_t *m_pSamples;
+	int m_iFrames;
+	int m_iPosition;
+
+	int m_iSampleRate;
+	unsigned m_iChannels;
+	RString m_sError;
+};
+
+#endif
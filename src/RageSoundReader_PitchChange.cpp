@@ -12,17 +12,22 @@
 #include "Preference.h"
 #include "RageSoundReader_PitchChange.h"
 #include "RageSoundReader_SpeedChange.h"
+#include "RageSoundReader_WSOLA.h"
 #include "RageSoundReader_Resample_Good.h"
 #include "RageLog.h"
 
 static Preference<bool> g_bRateModPreservesPitch( "RateModPreservesPitch", true );
+static Preference<bool> g_bRateModUseWSOLA( "RateModUseWSOLA", true );
 
 RageSoundReader_PitchChange::RageSoundReader_PitchChange( RageSoundReader *pSource ):
 	RageSoundReader_Filter(nullptr)
 {
 	bool bPreservePitch = g_bRateModPreservesPitch.Get();
 
-	m_pSpeedChange = new RageSoundReader_SpeedChange( pSource );
+	if( g_bRateModUseWSOLA.Get() )
+		m_pSpeedChange = new RageSoundReader_WSOLA( pSource );
+	else
+		m_pSpeedChange = new RageSoundReader_SpeedChange( pSource );
 	if (bPreservePitch)
 	{
 		m_pResample = new RageSoundReader_Resample_Good( m_pSpeedChange, m_pSpeedChange->GetSampleRate() );
@@ -45,7 +50,7 @@ RageSoundReader_PitchChange::RageSoundReader_PitchChange( const RageSoundReader_
 	 * is m_pSpeedChange (and its source is a copy of the pSource we were initialized
 	 * with). */
 	m_pResample = dynamic_cast<RageSoundReader_Resample_Good *>( &*m_pSource );
-	m_pSpeedChange = dynamic_cast<RageSoundReader_SpeedChange *>( m_pResample->GetSource() );
+	m_pSpeedChange = dynamic_cast<RageSoundReader_TimeStretch *>( m_pResample->GetSource() );
 	m_fSpeedRatio = cpy.m_fSpeedRatio;
 	m_fPitchRatio = cpy.m_fPitchRatio;
 	m_fLastSetSpeedRatio = cpy.m_fLastSetSpeedRatio;
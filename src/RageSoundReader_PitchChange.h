@@ -4,7 +4,7 @@
 #define RAGE_SOUND_READER_PITCH_CHANGE_H
 
 #include "RageSoundReader_Filter.h"
-class RageSoundReader_SpeedChange;
+class RageSoundReader_TimeStretch;
 class RageSoundReader_Resample_Good;
 
 class RageSoundReader_PitchChange: public RageSoundReader_Filter
@@ -22,7 +22,7 @@ public:
 	virtual RageSoundReader_PitchChange *Copy() const { return new RageSoundReader_PitchChange(*this); }
 
 private:
-	RageSoundReader_SpeedChange *m_pSpeedChange; // freed by RageSoundReader_Filter
+	RageSoundReader_TimeStretch *m_pSpeedChange; // freed by RageSoundReader_Filter
 	RageSoundReader_Resample_Good *m_pResample; // freed by RageSoundReader_Filter
 
 	float m_fSpeedRatio;
@@ -3,7 +3,9 @@
  *  http://www.dspguru.com/info/faqs/mrfaq.htm
  *
  * Each conversion ratio uses some memory, but the resulting table is
- * shared, so the memory overhead per stream is negligible.
+ * shared, so the memory overhead per stream is negligible.  All channels
+ * are filtered in one pass over the interleaved data, by the vector
+ * kernels in RageSoundMixKernels.
  */
 #include "global.h"
 #include "RageSoundReader_Resample_Good.h"
@@ -11,14 +13,16 @@
 #include "RageUtil.h"
 #include "RageMath.h"
 #include "RageThreads.h"
+#include "RageSoundMixKernels.h"
 
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <numeric>
 
-/* Filter length.  This must be a power of 2. */
+/* Filter length.  This must match the kernels. */
 #define L 8
+static_assert( L == RageSoundMixKernels::POLYPHASE_TAPS, "L must match the Polyphase kernels" );
 
 namespace
 {
@@ -136,32 +140,40 @@ void RunFIRFilter( float *pIn, float *pOut, int iInputValues, float *pFIR, int i
 }
 #endif
 
+/* A buffer aligned for the vector kernels.  T must be a plain type. */
 template<typename T>
 class AlignedBuffer
 {
 public:
 	AlignedBuffer( int iSize )
 	{
-		m_iSize = iSize;
-		m_pBuf = new T[m_iSize];
+		Allocate( iSize );
 	}
 
 	AlignedBuffer( const AlignedBuffer &cpy )
 	{
-		m_iSize = cpy.m_iSize;
-		m_pBuf = new T[m_iSize];
+		Allocate( cpy.m_iSize );
 		memcpy( m_pBuf, cpy.m_pBuf, sizeof(T)*m_iSize );
 	}
 	~AlignedBuffer()
 	{
-		delete [] m_pBuf;
+		delete [] m_pAlloc;
 	}
 	operator T*() { return m_pBuf; }
 	operator const T*() const { return m_pBuf; }
 
 private:
+	enum { ALIGNMENT = 32 };
+	void Allocate( int iSize )
+	{
+		m_iSize = iSize;
+		m_pAlloc = new char[sizeof(T)*m_iSize + ALIGNMENT-1];
+		m_pBuf = (T *) ((std::uintptr_t(m_pAlloc) + ALIGNMENT-1) & ~std::uintptr_t(ALIGNMENT-1));
+	}
+
 	T& operator=( T &rhs );
 	int m_iSize;
+	char *m_pAlloc;
 	T *m_pBuf;
 };
 
@@ -169,22 +181,23 @@ struct PolyphaseFilter
 {
 	struct State
 	{
-		State( int iUpFactor ):
-			m_fBuf( L * 2 )
+		State( int iUpFactor, int iChannels ):
+			m_fBuf( L * iChannels )
 		{
 			m_iPolyIndex = iUpFactor-1;
 			m_iFilled = 0;
-			m_iBufNext = 0;
+			m_iChannels = iChannels;
 		}
 
 		int m_iPolyIndex;
+
+		/* The number of frames in m_fBuf.  If the window has moved past the last input,
+		 * as it can when downsampling, this is minus the number of frames to skip. */
 		int m_iFilled;
+		int m_iChannels;
 
-		/* This buffer is duplicated.  If the circular buffer is size L, the actual buffer
-		 * is size L*2, and data at buf[N] is also at buf[N+L].  That way, we can access
-		 * up to buf[N*2-1] without having to wrap. */
+		/* The start of the next window, interleaved. */
 		AlignedBuffer<float> m_fBuf;
-		int m_iBufNext;
 	};
 	friend struct State;
 
@@ -195,8 +208,8 @@ struct PolyphaseFilter
 	}
 
 	void Generate( const float *pFIR );
-	int RunPolyphaseFilter( State &State, const float *pIn, int iSamplesIn, int iDownFactor,
-			float *pOut, int iSamplesOut, int iSampleStride ) const;
+	int RunPolyphaseFilter( State &State, const float *pIn, int iFramesIn, int iDownFactor,
+			float *pOut, int iFramesOut ) const;
 	int GetLatency() const { return L/2; }
 
 	int NumInputsForOutputSamples( const State &State, int iOut, int iDownFactor ) const;
@@ -284,60 +297,69 @@ void PolyphaseFilter::Generate( const float *pFIR )
  */
 int PolyphaseFilter::RunPolyphaseFilter(
 		State &State,
-		const float *pIn, int iSamplesIn, int iDownFactor,
-		float *pOut, int iSamplesOut,
-		int iSampleStride ) const
+		const float *pIn, int iFramesIn, int iDownFactor,
+		float *pOut, int iFramesOut ) const
 {
-	ASSERT( iSamplesIn >= 0 );
-
-	float *pOutOrig = pOut;
-	const float *pInEnd = pIn + iSamplesIn*iSampleStride;
-	const float *pOutEnd = pOut + iSamplesOut*iSampleStride;
-
-	int iFilled = State.m_iFilled;
+	ASSERT( iFramesIn >= 0 );
+
+	const int iChannels = State.m_iChannels;
+	const int iBuffered = std::max( State.m_iFilled, 0 );
+	const int iTotal = iBuffered + iFramesIn;
+
+	/* Windows that start in the buffered frames are filtered from a copy of them
+	 * followed by the start of the input; the rest are filtered in place. */
+	const int iJoined = iBuffered + std::min( iFramesIn, L );
+	float *pJoined = (float *) alloca( iJoined * iChannels * sizeof(float) );
+	memcpy( pJoined, State.m_fBuf, iBuffered * iChannels * sizeof(float) );
+	memcpy( pJoined + iBuffered*iChannels, pIn, (iJoined - iBuffered) * iChannels * sizeof(float) );
+
+	/* Find the window and the filter row of each output, then filter them all. */
+	int *piInFrame = (int *) alloca( iFramesOut * sizeof(int) );
+	int *piPhase = (int *) alloca( iFramesOut * sizeof(int) );
+	const int iStepFrames = iDownFactor / m_iUpFactor;
+	const int iStepPhase = iDownFactor % m_iUpFactor;
+	int iPos = std::max( -State.m_iFilled, 0 );
 	int iPolyIndex = State.m_iPolyIndex;
-	while( pOut != pOutEnd )
+	int iOut = 0;
+	int iFirstInPlace = 0;
+	while( iOut < iFramesOut && iPos + L <= iTotal )
 	{
-		if( iFilled < L )
+		if( iPos < iBuffered )
 		{
-			if( pIn == pInEnd )
-				break;
-
-			State.m_fBuf[State.m_iBufNext] = *pIn;
-			State.m_fBuf[State.m_iBufNext + L] = *pIn;
-			++State.m_iBufNext;
-			State.m_iBufNext &= L-1;
-
-			pIn += iSampleStride;
-			++iFilled;
-			continue;
+			piInFrame[iOut] = iPos;
+			++iFirstInPlace;
 		}
-
-		while( pOut != pOutEnd )
+		else
 		{
-			const float *pCurPoly = &m_pPolyphase[iPolyIndex*L];
-			const float *pInData = &State.m_fBuf[State.m_iBufNext];
-
-			float fTot = 0;
-			for( int j = 0; j < L; ++j )
-				fTot += pInData[j]*pCurPoly[j];
-			*pOut = fTot;
-			pOut += iSampleStride;
+			piInFrame[iOut] = iPos - iBuffered;
+		}
+		piPhase[iOut] = iPolyIndex;
+		++iOut;
 
-			iPolyIndex += iDownFactor;
-			if( iPolyIndex >= m_iUpFactor )
-				break;
+		iPos += iStepFrames;
+		iPolyIndex += iStepPhase;
+		if( iPolyIndex >= m_iUpFactor )
+		{
+			iPolyIndex -= m_iUpFactor;
+			++iPos;
 		}
-		iFilled -= iPolyIndex/m_iUpFactor;
-		iPolyIndex %= m_iUpFactor;
 	}
 
-	State.m_iFilled = iFilled;
+	RageSoundMixKernels::Polyphase( pOut, pJoined, iChannels, m_pPolyphase,
+		piInFrame, piPhase, iFirstInPlace );
+	RageSoundMixKernels::Polyphase( pOut + iFirstInPlace*iChannels, pIn, iChannels, m_pPolyphase,
+		piInFrame + iFirstInPlace, piPhase + iFirstInPlace, iOut - iFirstInPlace );
+
+	/* Keep the start of the next window. */
+	State.m_iFilled = std::min( iTotal - iPos, L );
 	State.m_iPolyIndex = iPolyIndex;
+	if( State.m_iFilled > 0 )
+	{
+		const float *pKeep = iPos < iBuffered? pJoined + iPos*iChannels: pIn + (iPos - iBuffered)*iChannels;
+		memcpy( State.m_fBuf, pKeep, State.m_iFilled * iChannels * sizeof(float) );
+	}
 
-	int iRetSamples = pOut - pOutOrig;
-	int iRetFrames = iRetSamples / iSampleStride;
-	return iRetFrames;
+	return iOut;
 }
 
 /*
@@ -445,7 +467,7 @@ namespace PolyphaseFilterCache
 
 /*
  * Interface to PolyphaseFilter, providing a simple resampling interface.  This handles
- * reuse of PolyphaseFilters.  This does not handle delay, flushing, or multiple channels.
+ * reuse of PolyphaseFilters.  This does not handle delay or flushing.
  */
 class RageSoundResampler_Polyphase
 {
@@ -453,13 +475,14 @@ public:
 	/* Note that going outside of [iMinDownFactor,iMaxDownFactor] while resampling isn't
 	 * fatal.  It'll only cause aliasing, by not having a LPF that's low enough, or cause
 	 * too much filtering, by not having a LPF that's high enough. */
-	RageSoundResampler_Polyphase( int iUpFactor, int iMinDownFactor, int iMaxDownFactor )
+	RageSoundResampler_Polyphase( int iUpFactor, int iMinDownFactor, int iMaxDownFactor, int iChannels )
 	{
 		/* Cache filters between iMinDownFactor and iMaxDownFactor.  Do them in
 		 * iFilterIncrement increments; we'll round down to the closest match
 		 * when filtering.  This will only cause the low-pass filter to be rounded;
 		 * the conversion ratio will always be exact. */
 		m_iUpFactor = iUpFactor;
+		m_iChannels = iChannels;
 		m_pPolyphase = nullptr;
 
 		int iFilterIncrement = std::max( (iMaxDownFactor - iMinDownFactor)/10, 1 );
@@ -471,7 +494,7 @@ public:
 
 		SetDownFactor( iUpFactor );
 
-		m_pState = new PolyphaseFilter::State( iUpFactor );
+		m_pState = new PolyphaseFilter::State( iUpFactor, iChannels );
 	}
 
 	~RageSoundResampler_Polyphase()
@@ -485,15 +508,15 @@ public:
 		m_pPolyphase = GetFilter( m_iDownFactor );
 	}
 
-	int Run( const float *pIn, int iSamplesIn, float *pOut, int iSamplesOut, int iSampleStride ) const
+	int Run( const float *pIn, int iFramesIn, float *pOut, int iFramesOut ) const
 	{
-		return m_pPolyphase->RunPolyphaseFilter( *m_pState, pIn, iSamplesIn, m_iDownFactor, pOut, iSamplesOut, iSampleStride );
+		return m_pPolyphase->RunPolyphaseFilter( *m_pState, pIn, iFramesIn, m_iDownFactor, pOut, iFramesOut );
 	}
 
 	void Reset()
 	{
 		delete m_pState;
-		m_pState = new PolyphaseFilter::State( m_iUpFactor );
+		m_pState = new PolyphaseFilter::State( m_iUpFactor, m_iChannels );
 	}
 
 	int NumInputsForOutputSamples( int iOut ) const { return m_pPolyphase->NumInputsForOutputSamples(*m_pState, iOut, m_iDownFactor); }
@@ -506,6 +529,7 @@ public:
 		m_pState = new PolyphaseFilter::State(*cpy.m_pState);
 		m_iUpFactor = cpy.m_iUpFactor;
 		m_iDownFactor = cpy.m_iDownFactor;
+		m_iChannels = cpy.m_iChannels;
 	}
 
 private:
@@ -535,12 +559,15 @@ private:
 	PolyphaseFilter::State *m_pState;
 	int m_iUpFactor;
 	int m_iDownFactor;
+	int m_iChannels;
 };
 
 int RageSoundReader_Resample_Good::GetNextSourceFrame() const
 {
+	/* The buffered frames came from the source at its ratio, which isn't 1:1
+	 * under a time stretch. */
 	std::int64_t iPosition = m_pSource->GetNextSourceFrame();
-	iPosition -= m_apResamplers[0]->GetFilled();
+	iPosition -= std::lrint( m_pResampler->GetFilled() * m_pSource->GetStreamToSourceRatio() );
 
 	iPosition *= m_iSampleRate;
 	iPosition /= m_pSource->GetSampleRate();
@@ -569,6 +596,7 @@ float RageSoundReader_Resample_Good::GetStreamToSourceRatio() const
 RageSoundReader_Resample_Good::RageSoundReader_Resample_Good( RageSoundReader *pSource, int iSampleRate ):
 	RageSoundReader_Filter( pSource )
 {
+	m_pResampler = nullptr;
 	m_iSampleRate = iSampleRate;
 	m_fRate = -1;
 	ReopenResampler();
@@ -577,8 +605,7 @@ RageSoundReader_Resample_Good::RageSoundReader_Resample_Good( RageSoundReader *p
 /* Call this if the input position is changed or reset. */
 void RageSoundReader_Resample_Good::Reset()
 {
-	for( std::size_t iChannel = 0; iChannel < m_pSource->GetNumChannels(); ++iChannel )
-		m_apResamplers[iChannel]->Reset();
+	m_pResampler->Reset();
 }
 
 
@@ -604,35 +631,27 @@ void RageSoundReader_Resample_Good::GetFactors( int &iDownFactor, int &iUpFactor
 /* Call this if the sample factor changes. */
 void RageSoundReader_Resample_Good::ReopenResampler()
 {
-	for( std::size_t iChannel = 0; iChannel < m_apResamplers.size(); ++iChannel )
-		delete m_apResamplers[iChannel];
-	m_apResamplers.clear();
+	delete m_pResampler;
 
 	int iDownFactor, iUpFactor;
 	GetFactors( iDownFactor, iUpFactor );
 
-	for( std::size_t iChannel = 0; iChannel < m_pSource->GetNumChannels(); ++iChannel )
-	{
-		int iMinDownFactor = iDownFactor;
-		int iMaxDownFactor = iDownFactor;
-		if( m_fRate != -1 )
-			iMaxDownFactor *= 5;
+	int iMinDownFactor = iDownFactor;
+	int iMaxDownFactor = iDownFactor;
+	if( m_fRate != -1 )
+		iMaxDownFactor *= 5;
 
-		RageSoundResampler_Polyphase *p = new RageSoundResampler_Polyphase( iUpFactor, iMinDownFactor, iMaxDownFactor );
-		m_apResamplers.push_back( p );
-	}
+	m_pResampler = new RageSoundResampler_Polyphase( iUpFactor, iMinDownFactor, iMaxDownFactor, m_pSource->GetNumChannels() );
 
 	if( m_fRate != -1 )
 		iDownFactor = std::lrint( m_fRate * iDownFactor );
 
-	for( std::size_t iChannel = 0; iChannel < m_apResamplers.size(); ++iChannel )
-		m_apResamplers[iChannel]->SetDownFactor( iDownFactor );
+	m_pResampler->SetDownFactor( iDownFactor );
 }
 
 RageSoundReader_Resample_Good::~RageSoundReader_Resample_Good()
 {
-	for( std::size_t iChannel = 0; iChannel < m_apResamplers.size(); ++iChannel )
-		delete m_apResamplers[iChannel];
+	delete m_pResampler;
 }
 
 /* iFrame is in the destination rate.  Seek the source in its own sample rate. */
@@ -645,35 +664,24 @@ int RageSoundReader_Resample_Good::SetPosition( int iFrame )
 
 int RageSoundReader_Resample_Good::Read( float *pBuf, int iFrames )
 {
-	int iChannels = m_apResamplers.size();
-
-	int iFramesRead = 0;
+	int iChannels = m_pSource->GetNumChannels();
 
 	/* If the ratio is 1:1, then we're effectively disabled, and we can read
 	 * directly into the buffer. */
 	int iDownFactor, iUpFactor;
 	GetFactors( iDownFactor, iUpFactor );
 
-	if( m_apResamplers[0]->GetFilled() == 0 && iDownFactor == iUpFactor && GetRate() == 1.0f )
+	if( m_pResampler->GetFilled() == 0 && iDownFactor == iUpFactor && GetRate() == 1.0f )
 		return m_pSource->Read( pBuf, iFrames );
 
-	{
-		int iFramesNeeded = m_apResamplers[0]->NumInputsForOutputSamples(iFrames);
-		float *pTmpBuf = (float *) alloca( iFramesNeeded * sizeof(float) * iChannels );
-		int iFramesIn = m_pSource->Read( pTmpBuf, iFramesNeeded );
-		if( iFramesIn < 0 )
-			return iFramesIn;
-
-		for( int iChannel = 0; iChannel < iChannels; ++iChannel )
-		{
-			int iGotFrames = m_apResamplers[iChannel]->Run( pTmpBuf + iChannel, iFramesIn, pBuf + iChannel, iFrames, iChannels );
-			ASSERT( iGotFrames <= iFrames );
-
-			if( iChannel == 0 )
-				iFramesRead += iGotFrames;
-		}
-	}
+	int iFramesNeeded = m_pResampler->NumInputsForOutputSamples(iFrames);
+	float *pTmpBuf = (float *) alloca( iFramesNeeded * sizeof(float) * iChannels );
+	int iFramesIn = m_pSource->Read( pTmpBuf, iFramesNeeded );
+	if( iFramesIn < 0 )
+		return iFramesIn;
 
+	int iFramesRead = m_pResampler->Run( pTmpBuf, iFramesIn, pBuf, iFrames );
+	ASSERT( iFramesRead <= iFrames );
 	return iFramesRead;
 }
 
@@ -704,8 +712,7 @@ void RageSoundReader_Resample_Good::SetRate( float fRatio )
 	/* Set m_fRate to the actual rate, after quantization by iUpFactor. */
 	m_fRate = float(iDownFactor) / iUpFactor;
 
-	for( std::size_t iChannel = 0; iChannel < m_apResamplers.size(); ++iChannel )
-		m_apResamplers[iChannel]->SetDownFactor( iDownFactor );
+	m_pResampler->SetDownFactor( iDownFactor );
 }
 
 float RageSoundReader_Resample_Good::GetRate() const
@@ -719,8 +726,7 @@ float RageSoundReader_Resample_Good::GetRate() const
 RageSoundReader_Resample_Good::RageSoundReader_Resample_Good( const RageSoundReader_Resample_Good &cpy ):
 	RageSoundReader_Filter(cpy)
 {
-	for( std::size_t i = 0; i < cpy.m_apResamplers.size(); ++i )
-		this->m_apResamplers.push_back( new RageSoundResampler_Polyphase(*cpy.m_apResamplers[i]) );
+	this->m_pResampler = new RageSoundResampler_Polyphase( *cpy.m_pResampler );
 	this->m_iSampleRate = cpy.m_iSampleRate;
 	this->m_fRate = cpy.m_fRate;
 }
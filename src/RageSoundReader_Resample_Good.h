@@ -5,9 +5,6 @@
 
 #include "RageSoundReader_Filter.h"
 
-#include <vector>
-
-
 class RageSoundResampler_Polyphase;
 
 /** @brief This class changes the sampling rate of a sound. */
@@ -42,7 +39,7 @@ private:
 	void ReopenResampler();
 	void GetFactors( int &iDownFactor, int &iUpFactor ) const;
 
-	std::vector<RageSoundResampler_Polyphase*> m_apResamplers; /* one per channel */
+	RageSoundResampler_Polyphase *m_pResampler; /* all channels */
 
 	int m_iSampleRate;
 	float m_fRate;
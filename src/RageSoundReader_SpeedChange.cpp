@@ -9,7 +9,7 @@
 static const int WINDOW_SIZE_MS = 30;
 
 RageSoundReader_SpeedChange::RageSoundReader_SpeedChange( RageSoundReader *pSource ):
-	RageSoundReader_Filter( pSource )
+	RageSoundReader_TimeStretch( pSource )
 {
 	m_Channels.resize( pSource->GetNumChannels() );
 	m_fSpeedRatio = m_fTrailingSpeedRatio = 1.0f;
@@ -3,12 +3,14 @@
 #ifndef RAGE_SOUND_READER_SPEED_CHANGE_H
 #define RAGE_SOUND_READER_SPEED_CHANGE_H
 
-#include "RageSoundReader_Filter.h"
+#include "RageSoundReader_TimeStretch.h"
 
 #include <vector>
 
 
-class RageSoundReader_SpeedChange: public RageSoundReader_Filter
+/* Overlap-add, with each channel searched separately.  RageSoundReader_WSOLA
+ * replaces this by default. */
+class RageSoundReader_SpeedChange: public RageSoundReader_TimeStretch
 {
 public:
 	RageSoundReader_SpeedChange( RageSoundReader *pSource );
@@ -20,14 +22,9 @@ public:
 	virtual int GetNextSourceFrame() const;
 	virtual float GetStreamToSourceRatio() const;
 
-	void SetSpeedRatio( float fRatio );
-
-	/* Return true if the next Read() will start a new block, allowing GetRatio() to
-	 * be updated to a new value.  Used by RageSoundReader_PitchChange. */
-	bool NextReadWillStep() const { return GetCursorAvail() == 0; }
-
-	/* Get the ratio last set by SetSpeedRatio. */
-	float GetRatio() const { return m_fSpeedRatio; }
+	virtual void SetSpeedRatio( float fRatio );
+	virtual bool NextReadWillStep() const { return GetCursorAvail() == 0; }
+	virtual float GetRatio() const { return m_fSpeedRatio; }
 
 protected:
 	int FillData( int iMax );
@@ -0,0 +1,28 @@
+/* RageSoundReader_TimeStretch - interface for readers that change speed without changing pitch. */
+
+#ifndef RAGE_SOUND_READER_TIME_STRETCH_H
+#define RAGE_SOUND_READER_TIME_STRETCH_H
+
+#include "RageSoundReader_Filter.h"
+
+/* RageSoundReader_PitchChange drives one of these under its resampler;
+ * the "RateModUseWSOLA" preference picks which. */
+class RageSoundReader_TimeStretch: public RageSoundReader_Filter
+{
+public:
+	RageSoundReader_TimeStretch( RageSoundReader *pSource ):
+		RageSoundReader_Filter( pSource ) { }
+
+	virtual RageSoundReader_TimeStretch *Copy() const = 0;
+
+	virtual void SetSpeedRatio( float fRatio ) = 0;
+
+	/* Return true if the next Read() will start a new block, allowing GetRatio() to
+	 * be updated to a new value.  Used by RageSoundReader_PitchChange. */
+	virtual bool NextReadWillStep() const = 0;
+
+	/* Get the ratio last set by SetSpeedRatio. */
+	virtual float GetRatio() const = 0;
+};
+
+#endif
@@ -0,0 +1,291 @@
+#include "global.h"
+#include "RageSoundReader_WSOLA.h"
+#include "RageSoundMixKernels.h"
+#include "RageUtil.h"
+
+#include <cmath>
+#include <cstring>
+
+/* Long enough to hold a couple of periods of a bass note, short enough that
+ * repeated or skipped transients aren't heard as echoes. */
+static const int SEGMENT_MS = 20;
+static const int SEARCH_MS = 8;
+
+/* Search every COARSE_STRIDE frames first, then every frame around the best. */
+static const int COARSE_STRIDE = 4;
+
+RageSoundReader_WSOLA::RageSoundReader_WSOLA( RageSoundReader *pSource ):
+	RageSoundReader_TimeStretch( pSource )
+{
+	const int iSegmentFrames = std::max( SEGMENT_MS * pSource->GetSampleRate() / 1000, 1 );
+	/* Crossfade linearly.  Segments are picked to be in phase, so this keeps
+	 * the level, and it makes the position played exactly linear in each
+	 * block, which is what GetNextSourceFrame() reports. */
+	m_Window.resize( iSegmentFrames );
+	for( int i = 0; i < iSegmentFrames; ++i )
+		m_Window[i] = float(i) / iSegmentFrames;
+	m_iSearchFrames = SEARCH_MS * pSource->GetSampleRate() / 1000;
+
+	m_fSpeedRatio = 1.0f;
+	Reset();
+}
+
+void RageSoundReader_WSOLA::Reset()
+{
+	m_iBufferFrames = 0;
+
+	/* Start as if a segment ending at frame 0 had just been played. */
+	m_iSegment = -GetSegmentFrames();
+	m_iPrevSegment = m_iSegment - GetSegmentFrames();
+	m_fNominal = m_iSegment;
+	m_iBlockFrames = m_iCursor = GetSegmentFrames();
+}
+
+int RageSoundReader_WSOLA::FillData( int iFrames )
+{
+	const int iChannels = GetNumChannels();
+	if( (int) m_Mono.size() < iFrames )
+	{
+		m_Buffer.resize( iFrames * iChannels );
+		m_Mono.resize( iFrames );
+	}
+
+	while( m_iBufferFrames < iFrames )
+	{
+		float *pBuf = &m_Buffer[m_iBufferFrames * iChannels];
+		int iGotFrames = m_pSource->Read( pBuf, iFrames - m_iBufferFrames );
+		if( iGotFrames == END_OF_FILE )
+			break;
+		if( iGotFrames < 0 )
+			return iGotFrames;
+
+		float *pMono = &m_Mono[m_iBufferFrames];
+		if( iChannels == 1 )
+		{
+			memcpy( pMono, pBuf, iGotFrames * sizeof(float) );
+		}
+		else
+		{
+			const float fScale = 1.0f / iChannels;
+			for( int i = 0; i < iGotFrames; ++i )
+			{
+				float fSum = 0;
+				for( int c = 0; c < iChannels; ++c )
+					fSum += *pBuf++;
+				pMono[i] = fSum * fScale;
+			}
+		}
+
+		m_iBufferFrames += iGotFrames;
+	}
+	return m_iBufferFrames;
+}
+
+void RageSoundReader_WSOLA::EraseData( int iFrames )
+{
+	ASSERT( iFrames <= m_iBufferFrames );
+
+	const int iChannels = GetNumChannels();
+	const int iFramesToMove = m_iBufferFrames - iFrames;
+	if( iFramesToMove )
+	{
+		memmove( &m_Buffer[0], &m_Buffer[iFrames * iChannels], iFramesToMove * iChannels * sizeof(float) );
+		memmove( &m_Mono[0], &m_Mono[iFrames], iFramesToMove * sizeof(float) );
+	}
+
+	m_iBufferFrames -= iFrames;
+	m_iPrevSegment -= iFrames;
+	m_iSegment -= iFrames;
+	m_fNominal -= iFrames;
+}
+
+/* Return the start of the segment in [iFirst,iLast] that looks most like the
+ * one at iTarget, by normalized cross-correlation.  Ties go to iNominal. */
+int RageSoundReader_WSOLA::FindBestMatch( int iTarget, int iFirst, int iLast, int iNominal )
+{
+	const int iLength = GetSegmentFrames();
+	const float *pTarget = &m_Mono[iTarget];
+
+	/* m_Energy[i] is the sum of squares of the first i frames from iFirst, so
+	 * the energy of any candidate is a subtraction. */
+	m_Energy.resize( iLast - iFirst + iLength + 1 );
+	m_Energy[0] = 0;
+	for( int i = 0; i < iLast - iFirst + iLength; ++i )
+		m_Energy[i+1] = m_Energy[i] + double(m_Mono[iFirst+i]) * m_Mono[iFirst+i];
+
+	const int iCoarse = (iLast - iFirst) / COARSE_STRIDE + 1;
+	m_Scores.resize( std::max(iCoarse, 2*COARSE_STRIDE - 1) );
+
+	int iBest = iNominal;
+	double fBestScore = 0;
+	auto Consider = [&]( int iPos, float fCorrelation, bool bFirst )
+	{
+		const double fEnergy = m_Energy[iPos - iFirst + iLength] - m_Energy[iPos - iFirst];
+		const double fScore = fCorrelation / std::sqrt( std::max(fEnergy, 1e-12) );
+		if( bFirst || fScore > fBestScore )
+		{
+			iBest = iPos;
+			fBestScore = fScore;
+		}
+	};
+
+	RageSoundMixKernels::Correlate( &m_Scores[0], &m_Mono[iNominal], pTarget, iLength, 1, 1 );
+	Consider( iNominal, m_Scores[0], true );
+
+	RageSoundMixKernels::Correlate( &m_Scores[0], &m_Mono[iFirst], pTarget, iLength, iCoarse, COARSE_STRIDE );
+	for( int i = 0; i < iCoarse; ++i )
+		Consider( iFirst + i*COARSE_STRIDE, m_Scores[i], false );
+
+	const int iFineFirst = std::max( iFirst, iBest - COARSE_STRIDE + 1 );
+	const int iFineLast = std::min( iLast, iBest + COARSE_STRIDE - 1 );
+	RageSoundMixKernels::Correlate( &m_Scores[0], &m_Mono[iFineFirst], pTarget, iLength, iFineLast - iFineFirst + 1, 1 );
+	for( int i = 0; i < iFineLast - iFineFirst + 1; ++i )
+		Consider( iFineFirst + i, m_Scores[i], false );
+
+	return iBest;
+}
+
+/* Pick the next segment, and start a block crossfading to it.  Return the
+ * size of the block, or an error. */
+int RageSoundReader_WSOLA::Step()
+{
+	const int iSegmentFrames = GetSegmentFrames();
+	const bool bFirst = m_iBufferFrames == 0;
+
+	/* Where the current segment would continue, and the range to look for
+	 * something like that around where the speed would put the next one.
+	 * Always move forward, so the source position never goes backwards. */
+	int iNatural = m_iSegment + iSegmentFrames;
+	double fNominal = bFirst? double(iNatural):m_fNominal + iSegmentFrames * m_fSpeedRatio;
+	int iNominal = std::lrint( fNominal );
+	int iFirst = std::max( iNominal - GetSearchFrames(), m_iSegment + 1 );
+	int iLast = std::max( iNominal + GetSearchFrames(), iFirst );
+	iNominal = clamp( iNominal, iFirst, iLast );
+
+	/* Nothing before either is needed again. */
+	const int iErase = clamp( std::min(iNatural, iFirst), 0, m_iBufferFrames );
+	if( iErase )
+	{
+		EraseData( iErase );
+		iNatural -= iErase;
+		fNominal -= iErase;
+		iNominal -= iErase;
+		iFirst -= iErase;
+		iLast -= iErase;
+	}
+
+	const int iFramesNeeded = std::max( iNatural, iLast ) + iSegmentFrames;
+	int iGot = FillData( iFramesNeeded );
+	if( iGot < 0 )
+		return iGot;
+
+	int iNext = iNatural;
+	int iBlockFrames = iSegmentFrames;
+	if( m_iBufferFrames < iFramesNeeded )
+	{
+		/* We're at EOF.  Play out what's left of the current segment. */
+		iBlockFrames = std::min( iBlockFrames, m_iBufferFrames - iNatural );
+		if( iBlockFrames <= 0 )
+			return END_OF_FILE;
+	}
+	else if( bFirst || (m_fSpeedRatio == 1.0f && iFirst <= iNatural && iNatural <= iLast) )
+	{
+		/* Continuing is exact, so don't search.  At 1x, this passes the
+		 * source through unchanged. */
+	}
+	else
+	{
+		iNext = FindBestMatch( iNatural, iFirst, iLast, iNominal );
+	}
+
+	m_iPrevSegment = m_iSegment;
+	m_iSegment = iNext;
+	m_fNominal = fNominal;
+	m_iBlockFrames = iBlockFrames;
+	m_iCursor = 0;
+	return iBlockFrames;
+}
+
+int RageSoundReader_WSOLA::Read( float *pBuf, int iFrames )
+{
+	if( m_iBufferFrames == 0 && m_fSpeedRatio == 1.0f )
+	{
+		/* Fast path: the buffer is empty, and we're not scaling the audio.  Read directly
+		 * into the output buffer, to eliminate memory and copying overhead. */
+		return m_pSource->Read( pBuf, iFrames );
+	}
+
+	if( GetCursorAvail() == 0 )
+	{
+		/* Return no data, so the caller sees where the new block starts
+		 * before reading it. */
+		int iRet = Step();
+		return iRet < 0? iRet:0;
+	}
+
+	const int iChannels = GetNumChannels();
+	const int iSegmentFrames = GetSegmentFrames();
+	iFrames = std::min( iFrames, GetCursorAvail() );
+
+	const float *pOut = &m_Buffer[(m_iPrevSegment + iSegmentFrames + m_iCursor) * iChannels];
+	const float *pIn = &m_Buffer[(m_iSegment + m_iCursor) * iChannels];
+	const float *pWindow = &m_Window[m_iCursor];
+	for( int i = 0; i < iFrames; ++i )
+	{
+		const float fWeight = pWindow[i];
+		for( int c = 0; c < iChannels; ++c )
+		{
+			*pBuf++ = *pOut + fWeight * (*pIn - *pOut);
+			++pOut;
+			++pIn;
+		}
+	}
+
+	m_iCursor += iFrames;
+	return iFrames;
+}
+
+/* As with RageSoundReader_SpeedChange, the segments picked after seeking
+ * depend on where we seeked from, so this isn't exact. */
+int RageSoundReader_WSOLA::SetPosition( int iFrame )
+{
+	Reset();
+	return RageSoundReader_Filter::SetPosition( iFrame );
+}
+
+bool RageSoundReader_WSOLA::SetProperty( const RString &sProperty, float fValue )
+{
+	if( sProperty == "Speed" )
+	{
+		SetSpeedRatio( fValue );
+		return true;
+	}
+
+	return RageSoundReader_Filter::SetProperty( sProperty, fValue );
+}
+
+/* Each block moves from where the old segment would continue to where the
+ * new one continues.  Interpolate between those, rather than reporting the
+ * nominal position; the difference is up to the search range, plus a segment
+ * times how far the speed is from 1x. */
+int RageSoundReader_WSOLA::GetNextSourceFrame() const
+{
+	const int iSegmentFrames = GetSegmentFrames();
+	const int iStart = m_iPrevSegment + iSegmentFrames;
+	const int iEnd = m_iSegment + iSegmentFrames;
+
+	int iSourceFrame = RageSoundReader_Filter::GetNextSourceFrame();
+	iSourceFrame -= m_iBufferFrames;
+	iSourceFrame += iStart + (int) std::lrint( double(iEnd - iStart) * m_iCursor / iSegmentFrames );
+	return iSourceFrame;
+}
+
+float RageSoundReader_WSOLA::GetStreamToSourceRatio() const
+{
+	/* If we're between blocks, the next Read() starts a new one at the
+	 * current speed. */
+	float fRatio = m_fSpeedRatio;
+	if( GetCursorAvail() != 0 )
+		fRatio = float(m_iSegment - m_iPrevSegment) / GetSegmentFrames();
+	return fRatio * RageSoundReader_Filter::GetStreamToSourceRatio();
+}
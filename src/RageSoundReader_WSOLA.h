@@ -0,0 +1,74 @@
+/* RageSoundReader_WSOLA - change the speed of an audio stream without changing its pitch. */
+
+#ifndef RAGE_SOUND_READER_WSOLA_H
+#define RAGE_SOUND_READER_WSOLA_H
+
+#include "RageSoundReader_TimeStretch.h"
+
+#include <vector>
+
+/*
+ * Waveform-similarity overlap-add.  Output is made of blocks of
+ * GetSegmentFrames() frames; each one fades out the segment before it and
+ * fades in a new segment of the source.  The new segment is placed where
+ * the speed says it should be, then moved by up to GetSearchFrames() to
+ * wherever it best matches what the old segment would have continued with.
+ * All channels use the same position, found on a mono mix.
+ *
+ * GetNextSourceFrame() follows the position actually being played, so the
+ * search's offset, the buffered lookahead and the crossfade's delay are all
+ * reported, not just the nominal speed.
+ */
+class RageSoundReader_WSOLA: public RageSoundReader_TimeStretch
+{
+public:
+	RageSoundReader_WSOLA( RageSoundReader *pSource );
+
+	virtual int SetPosition( int iFrame );
+	virtual int Read( float *pBuf, int iFrames );
+	virtual RageSoundReader_WSOLA *Copy() const { return new RageSoundReader_WSOLA(*this); }
+	virtual bool SetProperty( const RString &sProperty, float fValue );
+	virtual int GetNextSourceFrame() const;
+	virtual float GetStreamToSourceRatio() const;
+
+	virtual void SetSpeedRatio( float fRatio ) { m_fSpeedRatio = fRatio; }
+	virtual bool NextReadWillStep() const { return GetCursorAvail() == 0; }
+	virtual float GetRatio() const { return m_fSpeedRatio; }
+
+private:
+	int FillData( int iFrames );
+	void EraseData( int iFrames );
+	int Step();
+	int FindBestMatch( int iTarget, int iFirst, int iLast, int iNominal );
+	void Reset();
+
+	int GetCursorAvail() const { return m_iBlockFrames - m_iCursor; }
+	int GetSegmentFrames() const { return (int) m_Window.size(); }
+	int GetSearchFrames() const { return m_iSearchFrames; }
+
+	/* Source frames not yet played, interleaved, and mixed down to mono. */
+	std::vector<float> m_Buffer;
+	std::vector<float> m_Mono;
+	int m_iBufferFrames;
+
+	/* The fade-in, a linear ramp; the fade-out is one minus this. */
+	std::vector<float> m_Window;
+	int m_iSearchFrames;
+
+	/* Where the faded-out and faded-in segments start in m_Buffer, and where
+	 * the speed alone would have put the faded-in one. */
+	int m_iPrevSegment;
+	int m_iSegment;
+	double m_fNominal;
+
+	/* Frames of the current block, and how many have been read. */
+	int m_iBlockFrames;
+	int m_iCursor;
+
+	float m_fSpeedRatio;
+
+	std::vector<float> m_Scores;
+	std::vector<double> m_Energy;
+};
+
+#endif
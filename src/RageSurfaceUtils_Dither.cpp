@@ -17,8 +17,6 @@ static const int DitherMat[DitherMatDim][DitherMatDim] =
 	{ 15,  7, 13,  5 }
 };
 
-static int DitherMatCalc[DitherMatDim][DitherMatDim];
-
 // conv is the ratio from the input to the output.
 static std::uint8_t DitherPixel(int x, int y, int intensity,  int conv)
 {
@@ -39,8 +37,9 @@ static std::uint8_t DitherPixel(int x, int y, int intensity,  int conv)
 	// Convert the number to the destination range.
 	int out_intensity = intensity * conv;
 
-	// Add bias.
-	out_intensity += DitherMatCalc[y][x];
+	/* Add bias.  Each matrix value is 0..15, representing 0/16 through 15/16;
+	 * scale it by 65536 so we can do it with integer calcs. */
+	out_intensity += DitherMat[y][x] * 65536 / 16;
 
 	// Truncate, and add e to make sure a value of 14.999998 -> 15.
 	return std::uint8_t((out_intensity + 1) >> 16);
@@ -48,23 +47,6 @@ static std::uint8_t DitherPixel(int x, int y, int intensity,  int conv)
 
 void RageSurfaceUtils::OrderedDither( const RageSurface *src, RageSurface *dst )
 {
-	static bool DitherMatCalc_initted = false;
-	if( !DitherMatCalc_initted )
-	{
-		for( int i = 0; i < DitherMatDim; ++i )
-		{
-			for( int j = 0; j < DitherMatDim; ++j )
-			{
-				/* Each value is 0..15.  They represent 0/16 through 15/16.
-				 * Set DitherMatCalc to that value * 65536, so we can do it
-				 * with integer calcs. */
-				DitherMatCalc[i][j] = DitherMat[i][j] * 65536 / 16;
-			}
-		}
-
-		DitherMatCalc_initted = true;
-	}
-
 	// We can't dither to paletted surfaces.
 	ASSERT( dst->format->BytesPerPixel > 1 );
 
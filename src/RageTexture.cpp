@@ -13,6 +13,7 @@ RageTexture::RageTexture( RageTextureID name ):
 	m_iSourceWidth(0), m_iSourceHeight(0),
 	m_iTextureWidth(0), m_iTextureHeight(0),
 	m_iImageWidth(0), m_iImageHeight(0),
+	m_iImageOffsetX(0), m_iImageOffsetY(0),
 	m_iFramesWide(1), m_iFramesHigh(1) {}
 
 
@@ -33,10 +34,10 @@ void RageTexture::CreateFrameRects()
 	{
 		for( int i=0; i<m_iFramesWide; i++ )	// traverse along X (important that this is the inner loop)
 		{
-			RectF frect( (i+0)/(float)m_iFramesWide*m_iImageWidth /(float)m_iTextureWidth,	// these will all be between 0.0 and 1.0
-						 (j+0)/(float)m_iFramesHigh*m_iImageHeight/(float)m_iTextureHeight,
-						 (i+1)/(float)m_iFramesWide*m_iImageWidth /(float)m_iTextureWidth,
-						 (j+1)/(float)m_iFramesHigh*m_iImageHeight/(float)m_iTextureHeight );
+			RectF frect( (m_iImageOffsetX + (i+0)/(float)m_iFramesWide*m_iImageWidth) /(float)m_iTextureWidth,	// these will all be between 0.0 and 1.0
+						 (m_iImageOffsetY + (j+0)/(float)m_iFramesHigh*m_iImageHeight)/(float)m_iTextureHeight,
+						 (m_iImageOffsetX + (i+1)/(float)m_iFramesWide*m_iImageWidth) /(float)m_iTextureWidth,
+						 (m_iImageOffsetY + (j+1)/(float)m_iFramesHigh*m_iImageHeight)/(float)m_iTextureHeight );
 			m_TextureCoordRects.push_back( frect );	// the index of this array element will be (i + j*m_iFramesWide)
 
 			//LOG->Trace( "Adding frect%d %f %f %f %f", (i + j*m_iFramesWide), frect.left, frect.top, frect.right, frect.bottom );
@@ -34,6 +34,8 @@ public:
 	int GetTextureHeight() const{return m_iTextureHeight;}
 	int GetImageWidth() const	{return m_iImageWidth;}
 	int GetImageHeight() const	{return m_iImageHeight;}
+	int GetImageOffsetX() const	{return m_iImageOffsetX;}
+	int GetImageOffsetY() const	{return m_iImageOffsetY;}
 
 	int GetFramesWide() const	{return m_iFramesWide;}
 	int GetFramesHigh() const	{return m_iFramesHigh;}
@@ -80,6 +82,7 @@ protected:
 	int		m_iSourceWidth,		m_iSourceHeight;	// dimensions of the original image loaded from disk
 	int		m_iTextureWidth,	m_iTextureHeight;	// dimensions of the texture in memory
 	int		m_iImageWidth,		m_iImageHeight;		// dimensions of the image in the texture
+	int		m_iImageOffsetX,	m_iImageOffsetY;	// top-left of the image in the texture; nonzero when textures share one
 	int		m_iFramesWide,		m_iFramesHigh;		// The number of frames of animation in each row and column of this texture
 	std::vector<RectF>	m_TextureCoordRects;	// size = m_iFramesWide * m_iFramesHigh
 
@@ -821,6 +821,11 @@ void split( const std::wstring &sSource, const std::wstring &sDelimitor, std::ve
 		do_split( sSource, sDelimitor, asAddIt, bIgnoreEmpty );
 }
 
+void split( std::string_view sSource, char cDelimitor, std::vector<std::string_view> &asAddIt, const bool bIgnoreEmpty )
+{
+	do_split( sSource, cDelimitor, asAddIt, bIgnoreEmpty );
+}
+
 /* Use:
 
 RString str="a,b,c";
@@ -1262,6 +1267,16 @@ void Trim( RString &sStr, const char *s )
 	sStr.assign( sStr.substr(b, e-b) );
 }
 
+void Trim( std::string_view &sStr, const char *s )
+{
+	std::string_view::size_type b = 0, e = sStr.size();
+	while( b < e && strchr(s, sStr[b]) )
+		++b;
+	while( b < e && strchr(s, sStr[e-1]) )
+		--e;
+	sStr = sStr.substr( b, e-b );
+}
+
 void StripCrnl( RString &s )
 {
 	while( s.size() && (s[s.size()-1] == '\r' || s[s.size()-1] == '\n') )
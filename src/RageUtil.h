@@ -12,6 +12,7 @@
 #include <map>
 #include <random>
 #include <sstream>
+#include <string_view>
 #include <vector>
 
 class RageFileDriver;
@@ -408,6 +409,8 @@ RString GetLanguageNameFromISO639Code( RString sName );
 // Splits a RString into an std::vector<RString> according the Delimitor.
 void split( const RString &sSource, const RString &sDelimitor, std::vector<RString>& asAddIt, const bool bIgnoreEmpty = true );
 void split( const std::wstring &sSource, const std::wstring &sDelimitor, std::vector<std::wstring> &asAddIt, const bool bIgnoreEmpty = true );
+/* Split without copying; the pieces point into sSource. */
+void split( std::string_view sSource, char cDelimitor, std::vector<std::string_view> &asAddIt, const bool bIgnoreEmpty = true );
 
 /* In-place split. */
 void split( const RString &sSource, const RString &sDelimitor, int &iBegin, int &iSize, const bool bIgnoreEmpty = true );
@@ -490,6 +493,7 @@ inline T Decrement( T a ) { --a; return a; }
 void TrimLeft( RString &sStr, const char *szTrim = "\r\n\t " );
 void TrimRight( RString &sStr, const char *szTrim = "\r\n\t " );
 void Trim( RString &sStr, const char *szTrim = "\r\n\t " );
+void Trim( std::string_view &sStr, const char *szTrim = "\r\n\t " );
 void StripCrnl( RString &sStr );
 bool BeginsWith( const RString &sTestThis, const RString &sBeginning );
 bool EndsWith( const RString &sTestThis, const RString &sEnding );
@@ -3,8 +3,13 @@
 #ifndef RAGE_UTIL_CIRCULAR_BUFFER
 #define RAGE_UTIL_CIRCULAR_BUFFER
 
+#include <atomic>
+#include <type_traits>
+
 /* Lock-free circular buffer.  This should be threadsafe if one thread is reading
- * and another is writing. */
+ * and another is writing.  Neither side ever waits on the other: the writer
+ * publishes data by storing write_pos, and the reader releases it by storing
+ * read_pos, so each sees the other's data before it sees the position move. */
 template<class T>
 class CircBuf
 {
@@ -19,8 +24,7 @@ class CircBuf
 	unsigned size;
 	unsigned m_iBlockSize;
 
-	/* These are volatile to prevent reads and writes to them from being optimized. */
-	volatile unsigned read_pos, write_pos;
+	std::atomic<unsigned> read_pos, write_pos;
 
 public:
 	CircBuf()
@@ -34,12 +38,13 @@ public:
 		delete[] buf;
 	}
 		
+	/* Neither buffer may be in use by another thread. */
 	void swap( CircBuf &rhs )
 	{
 		std::swap( size, rhs.size );
 		std::swap( m_iBlockSize, rhs.m_iBlockSize );
-		std::swap( read_pos, rhs.read_pos );
-		std::swap( write_pos, rhs.write_pos );
+		read_pos = rhs.read_pos.exchange( read_pos );
+		write_pos = rhs.write_pos.exchange( write_pos );
 		std::swap( buf, rhs.buf );
 	}
 
@@ -53,8 +58,8 @@ public:
 	CircBuf( const CircBuf &cpy )
 	{
 		size = cpy.size;
-		read_pos = cpy.read_pos;
-		write_pos = cpy.write_pos;
+		read_pos = cpy.read_pos.load();
+		write_pos = cpy.write_pos.load();
 		m_iBlockSize = cpy.m_iBlockSize;
 		if( size )
 		{
@@ -70,8 +75,8 @@ public:
 	/* Return the number of elements available to read. */
 	unsigned num_readable() const
 	{
-		const int rpos = read_pos;
-		const int wpos = write_pos;
+		const int rpos = read_pos.load( std::memory_order_acquire );
+		const int wpos = write_pos.load( std::memory_order_acquire );
 		if( rpos < wpos )
 			/* The buffer looks like "eeeeDDDDeeee" (e = empty, D = data). */
 			return wpos - rpos;
@@ -86,8 +91,8 @@ public:
 	/* Return the number of writable elements. */
 	unsigned num_writable() const
 	{
-		const int rpos = read_pos;
-		const int wpos = write_pos;
+		const int rpos = read_pos.load( std::memory_order_acquire );
+		const int wpos = write_pos.load( std::memory_order_acquire );
 
 		int ret;
 		if( rpos < wpos )
@@ -138,19 +143,21 @@ public:
 	/* Indicate that n elements have been written. */
 	void advance_write_pointer( int n )
 	{
-		write_pos = (write_pos + n) % size;
+		const unsigned wpos = write_pos.load( std::memory_order_relaxed );
+		write_pos.store( (wpos + n) % size, std::memory_order_release );
 	}
 	
 	/* Indicate that n elements have been read. */
 	void advance_read_pointer( int n )
 	{
-		read_pos = (read_pos + n) % size;
+		const unsigned rpos = read_pos.load( std::memory_order_relaxed );
+		read_pos.store( (rpos + n) % size, std::memory_order_release );
 	}
 	
 	void get_write_pointers( T *pPointers[2], unsigned pSizes[2] )
 	{
-		const int rpos = read_pos;
-		const int wpos = write_pos;
+		const int rpos = read_pos.load( std::memory_order_acquire );
+		const int wpos = write_pos.load( std::memory_order_relaxed );
 
 		if( rpos <= wpos )
 		{
@@ -191,8 +198,8 @@ public:
 
 	void get_read_pointers( T *pPointers[2], unsigned pSizes[2] )
 	{
-		const int rpos = read_pos;
-		const int wpos = write_pos;
+		const int rpos = read_pos.load( std::memory_order_relaxed );
+		const int wpos = write_pos.load( std::memory_order_acquire );
 
 		if( rpos < wpos )
 		{
@@ -263,10 +270,14 @@ public:
 			memcpy( buffer+from_first, p[1], (buffer_size-sizes[0])*sizeof(T) );
 
 		/* Set the data that we just read to 0xFF.  This way, if we're passing pointesr
-		 * through, we can tell if we accidentally get a stale pointer. */
-		memset( p[0], 0xFF, from_first*sizeof(T) );
-		if( buffer_size > sizes[0] )
-			memset( p[1], 0xFF, (buffer_size-sizes[0])*sizeof(T) );
+		 * through, we can tell if we accidentally get a stale pointer.  Only plain
+		 * data can be scribbled over like that. */
+		if constexpr( std::is_trivial<T>::value )
+		{
+			memset( p[0], 0xFF, from_first*sizeof(T) );
+			if( buffer_size > sizes[0] )
+				memset( p[1], 0xFF, (buffer_size-sizes[0])*sizeof(T) );
+		}
 
 		advance_read_pointer( buffer_size );
 		return true;
@@ -0,0 +1,117 @@
+#include "global.h"
+#include "RageUtil_WorkerPool.h"
+#include "RageUtil.h"
+#include "RageLog.h"
+#include "RageTimer.h"
+
+#include <thread>
+
+static const int MAX_POOL_THREADS = 32;
+
+RageWorkerPool::RageWorkerPool( const RString &sName, int iNumThreads ):
+	m_sName( sName ),
+	m_Event( "\"" + sName + "\" worker pool event" ),
+	m_iRunningJobs( 0 ),
+	m_iFinishedJobs( 0 ),
+	m_bShutdown( false )
+{
+	if( iNumThreads < 1 )
+		iNumThreads = GetDefaultNumThreads();
+	/* Every RageThread takes a checkpoint slot, and there are only so many. */
+	iNumThreads = std::min( iNumThreads, MAX_POOL_THREADS );
+
+	for( int i = 0; i < iNumThreads; ++i )
+	{
+		RageThread *pThread = new RageThread;
+		pThread->SetName( ssprintf("Worker pool (%s) %i", sName.c_str(), i) );
+		pThread->Create( StartWorkerMain, this );
+		m_apThreads.push_back( pThread );
+	}
+}
+
+RageWorkerPool::~RageWorkerPool()
+{
+	WaitForJobs();
+
+	m_Event.Lock();
+	m_bShutdown = true;
+	m_Event.Broadcast();
+	m_Event.Unlock();
+
+	for( RageThread *pThread : m_apThreads )
+	{
+		pThread->Wait();
+		delete pThread;
+	}
+	m_apThreads.clear();
+}
+
+int RageWorkerPool::GetDefaultNumThreads()
+{
+	const int iCores = int(std::thread::hardware_concurrency());
+	return clamp( iCores, 1, MAX_POOL_THREADS );
+}
+
+void RageWorkerPool::AddJob( const std::function<void()> &job )
+{
+	m_Event.Lock();
+	m_Jobs.push_back( job );
+	m_Event.Broadcast();
+	m_Event.Unlock();
+}
+
+bool RageWorkerPool::WaitForJobs( float fTimeout )
+{
+	RageTimer timeout;
+	const bool bUseTimeout = fTimeout >= 0 && m_Event.WaitTimeoutSupported();
+	if( bUseTimeout )
+		timeout += fTimeout;
+
+	m_Event.Lock();
+	while( !m_Jobs.empty() || m_iRunningJobs != 0 )
+	{
+		if( !m_Event.Wait(bUseTimeout? &timeout:nullptr) )
+		{
+			m_Event.Unlock();
+			return false;
+		}
+	}
+	m_Event.Unlock();
+	return true;
+}
+
+int RageWorkerPool::GetNumFinishedJobs() const
+{
+	m_Event.Lock();
+	const int iFinished = m_iFinishedJobs;
+	m_Event.Unlock();
+	return iFinished;
+}
+
+void RageWorkerPool::WorkerMain()
+{
+	m_Event.Lock();
+	for(;;)
+	{
+		while( m_Jobs.empty() && !m_bShutdown )
+			m_Event.Wait();
+
+		if( m_Jobs.empty() )
+			break; /* shutting down, and nothing is left to do */
+
+		std::function<void()> job = m_Jobs.front();
+		m_Jobs.pop_front();
+		++m_iRunningJobs;
+		m_Event.Unlock();
+
+		job();
+
+		m_Event.Lock();
+		--m_iRunningJobs;
+		++m_iFinishedJobs;
+
+		/* Wake up anyone in WaitForJobs. */
+		m_Event.Broadcast();
+	}
+	m_Event.Unlock();
+}
@@ -0,0 +1,54 @@
+/* RageWorkerPool - a fixed set of threads that run queued jobs. */
+
+#ifndef RAGE_UTIL_WORKER_POOL_H
+#define RAGE_UTIL_WORKER_POOL_H
+
+#include "RageThreads.h"
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+
+class RageWorkerPool
+{
+public:
+	/* Start iNumThreads threads.  If iNumThreads is less than 1, one thread
+	 * per available CPU core is started. */
+	RageWorkerPool( const RString &sName, int iNumThreads );
+
+	/* Destruction waits for all queued jobs to finish. */
+	~RageWorkerPool();
+
+	/* Queue a job.  Jobs are started in the order they're added, but may
+	 * finish in any order.  Jobs must not touch anything that isn't
+	 * threadsafe; hand results back to the owner and merge them there. */
+	void AddJob( const std::function<void()> &job );
+
+	/* Wait for every queued job to finish.  If fTimeout is non-negative,
+	 * give up after that many seconds and return false, so the caller can
+	 * update a loading window and wait again. */
+	bool WaitForJobs( float fTimeout = -1 );
+
+	int GetNumThreads() const { return int(m_apThreads.size()); }
+	int GetNumFinishedJobs() const;
+
+	/* The number of threads to use when the caller doesn't care. */
+	static int GetDefaultNumThreads();
+
+private:
+	static int StartWorkerMain( void *pThis ) { ((RageWorkerPool *) (pThis))->WorkerMain(); return 0; }
+	void WorkerMain();
+
+	RString m_sName;
+	std::vector<RageThread *> m_apThreads;
+
+	/* Lock before touching anything below. */
+	mutable RageEvent m_Event;
+	std::deque<std::function<void()>> m_Jobs;
+	int m_iRunningJobs;
+	int m_iFinishedJobs;
+	bool m_bShutdown;
+};
+
+#endif
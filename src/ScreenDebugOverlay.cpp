@@ -21,6 +21,7 @@
 #include "CodeDetector.h"
 #include "RageInput.h"
 #include "RageDisplay.h"
+#include "RageProfiler.h"
 #include "InputEventPlus.h"
 #include "LocalizedString.h"
 #include "Profile.h"
@@ -561,6 +562,8 @@ static LocalizedString HALT			( "ScreenDebugOverlay", "Halt" );
 static LocalizedString LIGHTS_DEBUG	( "ScreenDebugOverlay", "Lights Debug" );
 static LocalizedString MONKEY_INPUT	( "ScreenDebugOverlay", "Monkey Input" );
 static LocalizedString RENDERING_STATS	( "ScreenDebugOverlay", "Rendering Stats" );
+static LocalizedString FRAME_PROFILER	( "ScreenDebugOverlay", "Frame Profiler" );
+static LocalizedString EXPORT_PROFILE_TRACE	( "ScreenDebugOverlay", "Export Profile Trace" );
 static LocalizedString VSYNC			( "ScreenDebugOverlay", "Vsync" );
 static LocalizedString MULTITEXTURE	( "ScreenDebugOverlay", "Multitexture" );
 static LocalizedString SCREEN_TEST_MODE	( "ScreenDebugOverlay", "Screen Test Mode" );
@@ -777,6 +780,29 @@ class DebugLineStats : public IDebugLine
 	}
 };
 
+class DebugLineFrameProfiler : public IDebugLine
+{
+	virtual RString GetDisplayTitle() { return FRAME_PROFILER.GetValue(); }
+	virtual bool IsEnabled() { return RageProfiler::IsEnabled(); }
+	virtual void DoAndLog( RString &sMessageOut )
+	{
+		RageProfiler::SetEnabled( !RageProfiler::IsEnabled() );
+		IDebugLine::DoAndLog( sMessageOut );
+	}
+};
+
+class DebugLineExportProfileTrace : public IDebugLine
+{
+	virtual RString GetDisplayTitle() { return EXPORT_PROFILE_TRACE.GetValue(); }
+	virtual RString GetDisplayValue() { return RString(); }
+	virtual bool IsEnabled() { return RageProfiler::IsEnabled(); }
+	virtual void DoAndLog( RString &sMessageOut )
+	{
+		RageProfiler::ExportChromeTrace( "/Logs/ProfileTrace.json" );
+		IDebugLine::DoAndLog( sMessageOut );
+	}
+};
+
 class DebugLineVsync : public IDebugLine
 {
 	virtual RString GetDisplayTitle() { return VSYNC.GetValue(); }
@@ -1339,6 +1365,8 @@ DECLARE_ONE( DebugLineHalt );
 DECLARE_ONE( DebugLineLightsDebug );
 DECLARE_ONE( DebugLineMonkeyInput );
 DECLARE_ONE( DebugLineStats );
+DECLARE_ONE( DebugLineFrameProfiler );
+DECLARE_ONE( DebugLineExportProfileTrace );
 DECLARE_ONE( DebugLineVsync );
 DECLARE_ONE( DebugLineAllowMultitexture );
 DECLARE_ONE( DebugLineShowMasks );
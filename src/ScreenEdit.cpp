@@ -2580,6 +2580,7 @@ bool ScreenEdit::InputEdit( const InputEventPlus &input, EditButton EditB )
 				seg->SetPause(seg->GetPause() + fDelta);
 				if( seg->GetPause() <= 0 )
 					stops.erase( stops.begin()+i, stops.begin()+i+1);
+				timing.InvalidateLookup();
 			}
 
 			(fDelta>0 ? m_soundValueIncrease : m_soundValueDecrease).Play(true);
@@ -2626,6 +2627,7 @@ bool ScreenEdit::InputEdit( const InputEventPlus &input, EditButton EditB )
 				seg->SetPause(seg->GetPause() + fDelta);
 				if( seg->GetPause() <= 0 )
 					stops.erase( stops.begin()+i, stops.begin()+i+1);
+				timing.InvalidateLookup();
 			}
 
 			(fDelta>0 ? m_soundValueIncrease : m_soundValueDecrease).Play(true);
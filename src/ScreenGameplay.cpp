@@ -25,6 +25,7 @@
 #include "ActorUtil.h"
 #include "ArrowEffects.h"
 #include "RageSoundManager.h"
+#include "RageSoundPCMCache.h"
 #include "RageSoundReader.h"
 #include "RageTextureManager.h"
 #include "GameSoundManager.h"
@@ -328,6 +329,10 @@ ScreenGameplay::ScreenGameplay()
 	m_pSongForeground = nullptr;
 	m_delaying_ready_announce= false;
 	GAMESTATE->m_AdjustTokensBySongCostForFinalStageCheck= false;
+
+	/* Don't decode music in the background while the player is playing. */
+	if( PCMCACHE != nullptr )
+		PCMCACHE->PauseDecoding();
 }
 
 void ScreenGameplay::Init()
@@ -1008,6 +1013,9 @@ ScreenGameplay::~ScreenGameplay()
 	if( !GAMESTATE->m_bDemonstrationOrJukebox )
 		MEMCARDMAN->UnPauseMountingThread();
 
+	if( PCMCACHE != nullptr )
+		PCMCACHE->UnPauseDecoding();
+
 	SAFE_DELETE( m_pCombinedLifeMeter );
 	if( m_pSoundMusic )
 		m_pSoundMusic->StopPlaying();
@@ -2583,13 +2591,6 @@ void ScreenGameplay::SaveStats()
 
 void ScreenGameplay::SongFinished()
 {
-	FOREACH_EnabledPlayer(pn)
-	{
-		if(GAMESTATE->m_pCurSteps[pn])
-		{
-			GAMESTATE->m_pCurSteps[pn]->GetTimingData()->ReleaseLookup();
-		}
-	}
 	AdjustSync::HandleSongEnd();
 	SaveStats(); // Let subclasses save the stats.
 	/* Extremely important: if we don't remove attacks before moving on to the next
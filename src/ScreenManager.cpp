@@ -64,6 +64,7 @@
 #include "RageUtil.h"
 #include "GameSoundManager.h"
 #include "RageDisplay.h"
+#include "RageProfiler.h"
 #include "SongManager.h"
 #include "RageTextureManager.h"
 #include "ThemeManager.h"
@@ -500,18 +501,22 @@ void ScreenManager::Draw()
 	if( !DISPLAY->BeginFrame() )
 		return;
 
-	DISPLAY->CameraPushMatrix();
-	DISPLAY->LoadMenuPerspective( 0, SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_CENTER_X, SCREEN_CENTER_Y );
-	g_pSharedBGA->Draw();
-	DISPLAY->CameraPopMatrix();
-
-	for( unsigned i=0; i<g_ScreenStack.size(); i++ )	// Draw all screens bottom to top
-		g_ScreenStack[i].m_pScreen->Draw();
+	{
+		ProfileScope scope( ProfilePhase_Draw );
+		DISPLAY->CameraPushMatrix();
+		DISPLAY->LoadMenuPerspective( 0, SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_CENTER_X, SCREEN_CENTER_Y );
+		g_pSharedBGA->Draw();
+		DISPLAY->CameraPopMatrix();
 
-	for( unsigned i=0; i<g_OverlayScreens.size(); i++ )
-		g_OverlayScreens[i]->Draw();
+		for( unsigned i=0; i<g_ScreenStack.size(); i++ )	// Draw all screens bottom to top
+			g_ScreenStack[i].m_pScreen->Draw();
 
+		for( unsigned i=0; i<g_OverlayScreens.size(); i++ )
+			g_OverlayScreens[i]->Draw();
+	}
 
+	// Includes waiting for vsync.
+	ProfileScope scope( ProfilePhase_EndFrame );
 	DISPLAY->EndFrame();
 }
 
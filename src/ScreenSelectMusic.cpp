@@ -31,6 +31,7 @@
 #include "RageInput.h"
 #include "OptionsList.h"
 #include "RageFileManager.h"
+#include "RageSoundPCMCache.h"
 
 #include <cmath>
 #include <vector>
@@ -168,6 +169,11 @@ void ScreenSelectMusic::Init()
 	// Load low-res banners and backgrounds if needed.
 	IMAGECACHE->Demand("Banner");
 
+	// Don't decode music in the background while previews are loading and
+	// playing.
+	if( PCMCACHE != nullptr )
+		PCMCACHE->PauseDecoding();
+
 	m_MusicWheel.SetName( "MusicWheel" );
 	m_MusicWheel.Load( MUSIC_WHEEL_TYPE );
 	LOAD_ALL_COMMANDS_AND_SET_XY( m_MusicWheel );
@@ -295,6 +301,8 @@ ScreenSelectMusic::~ScreenSelectMusic()
 {
 	LOG->Trace( "ScreenSelectMusic::~ScreenSelectMusic()" );
 	IMAGECACHE->Undemand("Banner");
+	if( PCMCACHE != nullptr )
+		PCMCACHE->UnPauseDecoding();
 }
 
 // If bForce is true, the next request will be started even if it might cause a skip.
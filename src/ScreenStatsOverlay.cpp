@@ -3,6 +3,8 @@
 #include "ActorUtil.h"
 #include "PrefsManager.h"
 #include "RageDisplay.h"
+#include "RageLatency.h"
+#include "RageProfiler.h"
 #include "RageLog.h"
 #include "ScreenDimensions.h"
 
@@ -17,6 +19,10 @@ void ScreenStatsOverlay::Init()
 	LOAD_ALL_COMMANDS_AND_SET_XY_AND_ON_COMMAND( m_textStats ); 
 	this->AddChild( &m_textStats );
 
+	m_ProfilerGraph.SetName( "ProfilerGraph" );
+	m_ProfilerGraph.SetXY( SCREEN_LEFT + 16, SCREEN_BOTTOM - 96 );
+	this->AddChild( &m_ProfilerGraph );
+
 	/* "Was that a skip?"  This displays a message when an update takes
 	 * abnormally long, to quantify skips more precisely, verify them
 	 * when they're subtle, and show the time it happened, so you can pinpoint
@@ -74,15 +80,73 @@ void ScreenStatsOverlay::Update( float fDeltaTime )
 	}
 	bShowStatsWasOn = PREFSMAN->m_bShowStats.Get();
 
-	this->SetVisible( PREFSMAN->m_bShowStats );
+	this->SetVisible( PREFSMAN->m_bShowStats || RageProfiler::IsEnabled() );
+	m_textStats.SetVisible( PREFSMAN->m_bShowStats );
+	m_ProfilerGraph.SetVisible( RageProfiler::IsEnabled() );
 	if( PREFSMAN->m_bShowStats )
 	{
-		m_textStats.SetText( DISPLAY->GetStats() );
+		RString sStats = DISPLAY->GetStats();
+		RString sLatency = RageLatency::GetStatsString();
+		if( !sLatency.empty() )
+			sStats += "\n" + sLatency;
+		m_textStats.SetText( sStats );
 		if ( SHOW_SKIPS )
 			UpdateSkips();
 	}
 }
 
+static const float PROFILER_BAR_HEIGHT = 10;
+static const RageColor g_ProfilePhaseColors[NUM_ProfilePhase] =
+{
+	RageColor( 0.9f, 0.9f, 0.2f, 0.9f ),	// Input
+	RageColor( 0.3f, 0.6f, 1.0f, 0.9f ),	// Update
+	RageColor( 1.0f, 0.5f, 0.1f, 0.9f ),	// Lua
+	RageColor( 0.3f, 0.9f, 0.4f, 0.9f ),	// Draw
+	RageColor( 0.9f, 0.3f, 0.9f, 0.9f ),	// TextureUpload
+	RageColor( 0.6f, 0.6f, 0.6f, 0.9f ),	// EndFrame
+};
+
+static void DrawProfilerBar( float fLeft, float fRight, float fTop, const RageColor &color )
+{
+	RageSpriteVertex v[4];
+	v[0].p = RageVector3( fLeft,	fTop,				0 );	// top left
+	v[1].p = RageVector3( fLeft,	fTop+PROFILER_BAR_HEIGHT-1,	0 );	// bottom left
+	v[2].p = RageVector3( fRight,	fTop+PROFILER_BAR_HEIGHT-1,	0 );	// bottom right
+	v[3].p = RageVector3( fRight,	fTop,				0 );	// top right
+	v[0].c = v[1].c = v[2].c = v[3].c = color;
+	DISPLAY->DrawQuad( v );
+}
+
+void ProfilerGraph::DrawPrimitives()
+{
+	std::int64_t iFrameStart, iFrameEnd;
+	RageProfiler::GetLastFrame( m_vEvents, iFrameStart, iFrameEnd );
+	if( iFrameEnd <= iFrameStart )
+		return;
+
+	/* One frame at the refresh rate fills half the width, so a frame that
+	 * blew its budget runs past the middle. */
+	const float fWidth = SCREEN_WIDTH - 32;
+	const int iRate = std::max( DISPLAY->GetActualVideoModeParams().rate, 1 );
+	const float fScale = (fWidth / 2) / (1000000.0f / iRate);
+	auto GetX = [&]( std::int64_t iTime ) { return std::min( (iTime - iFrameStart) * fScale, fWidth ); };
+
+	DISPLAY->ClearAllTextures();
+
+	// The whole frame across the top, then each scope below by depth.
+	const bool bOverBudget = GetX(iFrameEnd) > fWidth / 2;
+	DrawProfilerBar( 0, fWidth, -PROFILER_BAR_HEIGHT, RageColor(0,0,0,0.5f) );
+	DrawProfilerBar( 0, GetX(iFrameEnd), -PROFILER_BAR_HEIGHT, bOverBudget? RageColor(1,0.3f,0.3f,0.9f):RageColor(1,1,1,0.6f) );
+	DrawProfilerBar( fWidth/2, fWidth/2 + 1, -PROFILER_BAR_HEIGHT, RageColor(1,1,1,1) );
+
+	for( const ProfileEvent &e : m_vEvents )
+	{
+		const float fLeft = GetX( e.m_iStartMicroseconds );
+		const float fRight = std::max( GetX(e.m_iEndMicroseconds), fLeft + 1 );
+		DrawProfilerBar( fLeft, fRight, e.m_iDepth * PROFILER_BAR_HEIGHT, g_ProfilePhaseColors[e.m_Phase] );
+	}
+}
+
 void ScreenStatsOverlay::AddTimestampLine( const RString &txt, const RageColor &color )
 {
 	m_textSkips[m_LastSkip].SetText( txt );
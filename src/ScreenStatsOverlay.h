@@ -6,10 +6,22 @@
 #include "Screen.h"
 #include "BitmapText.h"
 #include "Quad.h"
+#include "RageProfiler.h"
 #include <array>
+#include <vector>
 
 const int NUM_SKIPS_TO_SHOW = 5;
 
+/** @brief Bars for each phase of the last frame, from RageProfiler. */
+class ProfilerGraph : public Actor
+{
+public:
+	void DrawPrimitives();
+
+private:
+	std::vector<ProfileEvent> m_vEvents;
+};
+
 class ScreenStatsOverlay : public Screen
 {
 public:
@@ -22,6 +34,7 @@ private:
 	void UpdateSkips();
 
 	BitmapText m_textStats;
+	ProfilerGraph m_ProfilerGraph;
 	Quad m_quadSkipBackground;
 	std::array<BitmapText, NUM_SKIPS_TO_SHOW> m_textSkips;
 	RageTimer m_timerSkip;
@@ -169,19 +169,6 @@ bool ScreenSyncOverlay::Input( const InputEventPlus &input )
 		return true;
 	}
 
-	// Release the lookup tables being used for the timing data because
-	// changing the timing data invalidates them. -Kyz
-	if(a != Action_Invalid)
-	{
-		FOREACH_EnabledPlayer(pn)
-		{
-			if(GAMESTATE->m_pCurSteps[pn])
-			{
-				GAMESTATE->m_pCurSteps[pn]->GetTimingData()->ReleaseLookup();
-			}
-		}
-	}
-
 	switch( a )
 	{
 	case RevertSyncChanges:
@@ -216,6 +203,7 @@ bool ScreenSyncOverlay::Input( const InputEventPlus &input )
 				TimingData &sTiming = GAMESTATE->m_pCurSong->m_SongTiming;
 				BPMSegment * seg = sTiming.GetBPMSegmentAtBeat( GAMESTATE->m_Position.m_fSongBeat );
 				seg->SetBPS( seg->GetBPS() + fDelta );
+				sTiming.InvalidateLookup();
 				const std::vector<Steps*>& vpSteps = GAMESTATE->m_pCurSong->GetAllSteps();
 				for (Steps *s : vpSteps)
 				{
@@ -227,6 +215,7 @@ bool ScreenSyncOverlay::Input( const InputEventPlus &input )
 					float second = sTiming.GetElapsedTimeFromBeat(GAMESTATE->m_Position.m_fSongBeat);
 					seg = pTiming.GetBPMSegmentAtBeat(pTiming.GetBeatFromElapsedTime(second));
 					seg->SetBPS( seg->GetBPS() + fDelta );
+					pTiming.InvalidateLookup();
 				}
 			}
 		}
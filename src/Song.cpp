@@ -7,6 +7,7 @@
 #include "RageSoundReader_FileReader.h"
 #include "RageSurface_Load.h"
 #include "SongCacheIndex.h"
+#include "SongCacheBinary.h"
 #include "GameManager.h"
 #include "PrefsManager.h"
 #include "Style.h"
@@ -51,7 +52,7 @@
  * @brief The internal version of the cache for StepMania.
  *
  * Increment this value to invalidate the current cache. */
-const int FILE_CACHE_VERSION = 227;
+const int FILE_CACHE_VERSION = 231;
 
 /** @brief How long does a song sample last by default? */
 const float DEFAULT_MUSIC_SAMPLE_LENGTH = 12.f;
@@ -258,11 +259,6 @@ const BackgroundChange &Song::GetBackgroundAtBeat( BackgroundLayer iLayer, float
 }
 
 
-RString Song::GetCacheFilePath() const
-{
-	return SongCacheIndex::GetCacheFilePath( "Songs", m_sSongDir );
-}
-
 // Get a path to the SM containing data for this song. It might be a cache file.
 const RString &Song::GetSongFilePath() const
 {
@@ -272,16 +268,13 @@ const RString &Song::GetSongFilePath() const
 	return m_sSongFileName;
 }
 
-/* Hack: This should be a parameter to TidyUpData, but I don't want to pull in
- * <set> into Song.h, which is heavily used. */
-static std::set<RString> BlacklistedImages;
-
 /* If PREFSMAN->m_bFastLoad is true, always load from cache if possible.
  * Don't read the contents of sDir if we can avoid it. That means we can't call
  * HasMusic(), HasBanner() or GetHashForDirectory().
  * If true, check the directory hash and reload the song from scratch if it's changed.
+ * check_cache_hash forces the check, for directories SongManager saw change.
  */
-bool Song::LoadFromSongDir(RString sDir, bool load_autosave, ProfileSlot from_profile)
+bool Song::LoadFromSongDir(RString sDir, bool load_autosave, ProfileSlot from_profile, bool check_cache_hash)
 {
 //	LOG->Trace( "Song::LoadFromSongDir(%s)", sDir.c_str() );
 	ASSERT_M( sDir != "", "Songs can't be loaded from an empty directory!" );
@@ -311,37 +304,32 @@ bool Song::LoadFromSongDir(RString sDir, bool load_autosave, ProfileSlot from_pr
 		use_cache= false;
 	}
 
-	RString cache_file_path;
+	RString cached_song;
 	if(m_LoadedFromProfile == ProfileSlot_Invalid)
 	{
 		// First, look in the cache for this song (without loading NoteData)
 		unsigned uCacheHash = SONGINDEX->GetCacheHash(m_sSongDir);
-		cache_file_path = GetCacheFilePath();
 
-		if( !DoesFileExist(cache_file_path) )
+		if(load_autosave)
+		{ use_cache= false; }
+		else if( !SONGINDEX->GetSongCache(m_sSongDir, cached_song) )
 		{ use_cache = false; }
-		else if(!PREFSMAN->m_bFastLoad && GetHashForDirectory(m_sSongDir) != uCacheHash)
+		else if((!PREFSMAN->m_bFastLoad || check_cache_hash) && GetHashForDirectory(m_sSongDir) != uCacheHash)
 		{ use_cache = false; } // this cache is out of date
-		else if(load_autosave)
-		{ use_cache= false; }
+	}
+
+	if(use_cache && !SongCacheBinary::ReadSong(cached_song.data(), cached_song.size(), *this))
+	{
+		LOG->Warn("The cache entry for \"%s\" is damaged; loading the song from its directory.", m_sSongDir.c_str());
+		RString group_name= m_sGroupName;
+		Reset();
+		m_sSongDir= sDir;
+		m_sGroupName= group_name;
+		use_cache= false;
 	}
 
 	if(use_cache)
 	{
-		/*
-		LOG->Trace("Loading '%s' from cache file '%s'.",
-				   m_sSongDir.c_str(),
-				   GetCacheFilePath().c_str());
-		*/
-		SSCLoader loaderSSC;
-		bool bLoadedFromSSC = loaderSSC.LoadFromSimfile( cache_file_path, *this, true );
-		if( !bLoadedFromSSC )
-		{
-			// load from .sm
-			SMLoader loaderSM;
-			loaderSM.LoadFromSimfile( cache_file_path, *this, true );
-			loaderSM.TidyUpData( *this, true );
-		}
 		if(m_sMainTitle == "" || (m_sMusicFile == "" && m_vsKeysoundFile.empty()))
 		{
 			LOG->Warn("Main title or music file for '%s' came up blank, forced to fall back on TidyUpData to fix title and paths.  Do not use # or ; in a song title.", m_sSongDir.c_str());
@@ -355,7 +343,7 @@ bool Song::LoadFromSongDir(RString sDir, bool load_autosave, ProfileSlot from_pr
 		// There was no entry in the cache for this song, or it was out of date.
 		// Let's load it from a file, then write a cache entry.
 
-		if(!NotesLoader::LoadFromDir(sDir, *this, BlacklistedImages, load_autosave))
+		if(!NotesLoader::LoadFromDir(sDir, *this, m_BlacklistedImages, load_autosave))
 		{
 			LOG->UserLog( "Song", sDir, "has no SSC, SM, SMA, DWI, BMS, or KSF files." );
 
@@ -389,9 +377,8 @@ bool Song::LoadFromSongDir(RString sDir, bool load_autosave, ProfileSlot from_pr
 		// entries. -Kyz
 		if(!load_autosave && m_LoadedFromProfile == ProfileSlot_Invalid)
 		{
-			// save a cache file so we don't have to parse it all over again next time
-			if(!SaveToCacheFile())
-			{ cache_file_path = RString(); }
+			// save a cache entry so we don't have to parse it all over again next time
+			SaveToCacheFile();
 		}
 	}
 
@@ -460,9 +447,9 @@ bool Song::LoadFromSongDir(RString sDir, bool load_autosave, ProfileSlot from_pr
  * Song/Steps objects to reload themselves. -- djpohly */
 bool Song::ReloadFromSongDir( RString sDir )
 {
-	// Remove the cache file to force the song to reload from its dir instead
+	// Remove the cache entry to force the song to reload from its dir instead
 	// of loading from the cache. -Kyz
-	FILEMAN->Remove(GetCacheFilePath());
+	SONGINDEX->RemoveSongCache(m_sSongDir);
 
 	RemoveAutoGenNotes();
 	std::vector<Steps*> vOldSteps = m_vpSteps;
@@ -965,7 +952,7 @@ void Song::TidyUpData( bool from_cache, bool /* duringCache */ )
 				// ignore DWI "-char" graphics
 				RString lower = image_list[i];
 				lower.MakeLower();
-				if(BlacklistedImages.find(lower) != BlacklistedImages.end())
+				if(m_BlacklistedImages.find(lower) != m_BlacklistedImages.end())
 				continue;	// skip
 
 				// Skip any image that we've already classified
@@ -1108,7 +1095,7 @@ void Song::TidyUpData( bool from_cache, bool /* duringCache */ )
 
 	/* Generate these before we autogen notes, so the new notes can inherit
 	 * their source's values. */
-	ReCalculateRadarValuesAndLastSecond(from_cache, true);
+	ReCalculateRadarValuesAndLastSecond(from_cache);
 	// If the music length is suspiciously shorter than the last second, adjust
 	// the length.  This prevents the ogg patch from setting a false length. -Kyz
 	if(m_fMusicLengthSeconds < lastSecond - 10.0f)
@@ -1129,7 +1116,7 @@ void Song::TranslateTitles()
 						m_sMainTitleTranslit, m_sSubTitleTranslit, m_sArtistTranslit );
 }
 
-void Song::ReCalculateRadarValuesAndLastSecond(bool fromCache, bool duringCache)
+void Song::ReCalculateRadarValuesAndLastSecond(bool fromCache)
 {
 	if( fromCache && this->GetFirstSecond() >= 0 && this->GetLastSecond() > 0 )
 	{
@@ -1165,7 +1152,7 @@ void Song::ReCalculateRadarValuesAndLastSecond(bool fromCache, bool duringCache)
 			// Don't set first/last beat based on lights.  They often start very
 			// early and end very late.
 			if( pSteps->m_StepsType == StepsType_lights_cabinet )
-				continue; // no need to wipe this.
+				continue;
 
 			/* Many songs have stray, empty song patterns. Ignore them, so they
 			 * don't force the first beat of the whole song to 0. */
@@ -1178,13 +1165,8 @@ void Song::ReCalculateRadarValuesAndLastSecond(bool fromCache, bool duringCache)
 			}
 		}
 
-		// Wipe NoteData
-		if (duringCache)
-		{
-			NoteData dummy;
-			dummy.SetNumTracks(tempNoteData.GetNumTracks());
-			pSteps->SetNoteData(dummy);
-		}
+		/* Don't wipe the NoteData while caching: SaveToCacheFile packs it into
+		 * the song cache, and LoadFromSongDir compresses it away afterwards. */
 	}
 
 	// Yes, for some reason we can have freaky stuff take place here.
@@ -1371,8 +1353,29 @@ bool Song::SaveToCacheFile()
 		return true;
 	}
 	SONGINDEX->AddCacheIndex(m_sSongDir, GetHashForDirectory(m_sSongDir));
-	const RString sPath = GetCacheFilePath();
-	return SaveToSSCFile(sPath, true);
+
+	// The same Steps SaveToSSCFile would write.
+	std::vector<Steps*> vpStepsToSave;
+	for (Steps *pSteps : m_vpSteps)
+	{
+		if( pSteps->IsAutogen() || pSteps->WasLoadedFromProfile() )
+			continue;
+		vpStepsToSave.push_back( pSteps );
+	}
+	for (Steps *s : m_UnknownStyleSteps)
+	{
+		vpStepsToSave.push_back(s);
+	}
+
+	RString sSong;
+	std::vector<RString> vsNotes;
+	SongCacheBinary::WriteSong( *this, vpStepsToSave, sSong, vsNotes );
+	SONGINDEX->AddSongCache( m_sSongDir, sSong, vsNotes );
+
+	// The Steps' notes now live at their new place in the cache entry.
+	for( unsigned i = 0; i < vpStepsToSave.size(); ++i )
+		vpStepsToSave[i]->SetCacheNoteDataIndex( vsNotes[i].empty()? -1:int(i) );
+	return true;
 }
 
 bool Song::SaveToDWIFile()
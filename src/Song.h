@@ -90,9 +90,11 @@ public:
 	 * @brief Load a song from the chosen directory.
 	 *
 	 * This assumes that there is no song present right now.
-	 * @param sDir the song directory from which to load. */
+	 * @param sDir the song directory from which to load.
+	 * @param check_cache_hash check the directory hash against the cache even
+	 * with FastLoad on, because the directory is known to have changed. */
 	bool LoadFromSongDir(RString sDir, bool load_autosave= false,
-		ProfileSlot from_profile= ProfileSlot_Invalid);
+		ProfileSlot from_profile= ProfileSlot_Invalid, bool check_cache_hash= false);
 	// This one takes the effort to reuse Steps pointers as best as it can
 	bool ReloadFromSongDir( RString sDir );
 	bool ReloadFromSongDir() { return ReloadFromSongDir(GetSongDir()); }
@@ -110,9 +112,8 @@ public:
 	/**
 	 * @brief Get the new radar values, and determine the last second at the same time.
 	 * This is called by TidyUpData, after saving the Song.
-	 * @param fromCache was this data loaded from the cache file?
-	 * @param duringCache was this data loaded during the cache process? */
-	void ReCalculateRadarValuesAndLastSecond(bool fromCache = false, bool duringCache = false);
+	 * @param fromCache was this data loaded from the cache file? */
+	void ReCalculateRadarValuesAndLastSecond(bool fromCache = false);
 	/**
 	 * @brief Translate any titles that aren't in english.
 	 * This is called by TidyUpData. */
@@ -148,7 +149,6 @@ public:
 	{ return m_loaded_from_autosave; }
 
 	const RString &GetSongFilePath() const;
-	RString GetCacheFilePath() const;
 
 	void AddAutoGenNotes();
 	/**
@@ -469,6 +469,10 @@ public:
 
 private:
 	bool m_loaded_from_autosave;
+	/** @brief DWI "-char" graphics found by the loader, which TidyUpData must
+	 * not mistake for a banner or background.  This is per song so that
+	 * songs can be loaded from several threads at once. */
+	std::set<RString> m_BlacklistedImages;
 	/** @brief the Steps that belong to this Song. */
 	std::vector<Steps*> m_vpSteps;
 	/** @brief the Steps of a particular StepsType that belong to this Song. */
@@ -0,0 +1,597 @@
+#include "global.h"
+#include "SongCacheBinary.h"
+#include "Song.h"
+#include "Steps.h"
+#include "NoteData.h"
+#include "TimingData.h"
+#include "BackgroundUtil.h"
+#include "GameManager.h"
+
+#include <cstring>
+
+void SongCacheBinary::Writer::WriteVarInt( std::uint32_t i )
+{
+	while( i >= 0x80 )
+	{
+		WriteU8( std::uint8_t(i | 0x80) );
+		i >>= 7;
+	}
+	WriteU8( std::uint8_t(i) );
+}
+
+const char *SongCacheBinary::Reader::ReadBytes( unsigned iSize )
+{
+	if( m_bError || unsigned(m_pEnd - m_p) < iSize )
+	{
+		m_bError = true;
+		return nullptr;
+	}
+	const char *p = m_p;
+	m_p += iSize;
+	return p;
+}
+
+std::uint8_t SongCacheBinary::Reader::ReadU8()
+{
+	const char *p = ReadBytes( 1 );
+	return p? std::uint8_t(*p):0;
+}
+
+std::uint32_t SongCacheBinary::Reader::ReadU32()
+{
+	std::uint32_t i = 0;
+	const char *p = ReadBytes( sizeof(i) );
+	if( p != nullptr )
+		memcpy( &i, p, sizeof(i) );
+	return i;
+}
+
+float SongCacheBinary::Reader::ReadFloat()
+{
+	float f = 0;
+	const char *p = ReadBytes( sizeof(f) );
+	if( p != nullptr )
+		memcpy( &f, p, sizeof(f) );
+	return f;
+}
+
+std::uint32_t SongCacheBinary::Reader::ReadVarInt()
+{
+	std::uint32_t i = 0;
+	for( int iShift = 0; iShift < 32; iShift += 7 )
+	{
+		const std::uint8_t c = ReadU8();
+		i |= std::uint32_t(c & 0x7F) << iShift;
+		if( !(c & 0x80) )
+			return i;
+	}
+	m_bError = true;
+	return 0;
+}
+
+int SongCacheBinary::Reader::ReadEnum( int iNumValues )
+{
+	const int i = ReadU8();
+	if( i >= iNumValues )
+	{
+		m_bError = true;
+		return 0;
+	}
+	return i;
+}
+
+RString SongCacheBinary::Reader::ReadString()
+{
+	const std::uint32_t iSize = ReadVarInt();
+	const char *p = ReadBytes( iSize );
+	return p? RString( p, iSize ):RString();
+}
+
+using SongCacheBinary::Writer;
+using SongCacheBinary::Reader;
+
+static void WriteTimingData( Writer &w, const TimingData &timing )
+{
+	w.WriteFloat( timing.m_fBeat0OffsetInSeconds );
+	FOREACH_TimingSegmentType( tst )
+	{
+		const std::vector<TimingSegment *> &vSegs = timing.GetTimingSegments( tst );
+		w.WriteVarInt( vSegs.size() );
+		for( const TimingSegment *seg : vSegs )
+		{
+			w.WriteInt( seg->GetRow() );
+			switch( tst )
+			{
+			case SEGMENT_BPM:	w.WriteFloat( ToBPM(seg)->GetBPM() ); break;
+			case SEGMENT_STOP:	w.WriteFloat( ToStop(seg)->GetPause() ); break;
+			case SEGMENT_DELAY:	w.WriteFloat( ToDelay(seg)->GetPause() ); break;
+			case SEGMENT_TIME_SIG:
+				w.WriteInt( ToTimeSignature(seg)->GetNum() );
+				w.WriteInt( ToTimeSignature(seg)->GetDen() );
+				break;
+			case SEGMENT_WARP:	w.WriteInt( ToWarp(seg)->GetLengthRows() ); break;
+			case SEGMENT_LABEL:	w.WriteString( ToLabel(seg)->GetLabel() ); break;
+			case SEGMENT_TICKCOUNT:	w.WriteInt( ToTickcount(seg)->GetTicks() ); break;
+			case SEGMENT_COMBO:
+				w.WriteInt( ToCombo(seg)->GetCombo() );
+				w.WriteInt( ToCombo(seg)->GetMissCombo() );
+				break;
+			case SEGMENT_SPEED:
+				w.WriteFloat( ToSpeed(seg)->GetRatio() );
+				w.WriteFloat( ToSpeed(seg)->GetDelay() );
+				w.WriteU8( ToSpeed(seg)->GetUnit() );
+				break;
+			case SEGMENT_SCROLL:	w.WriteFloat( ToScroll(seg)->GetRatio() ); break;
+			case SEGMENT_FAKE:	w.WriteInt( ToFake(seg)->GetLengthRows() ); break;
+			default: FAIL_M( ssprintf("Unknown timing segment type %i", tst) );
+			}
+		}
+	}
+}
+
+/* The segments were sorted and merged when the cache was written, so they
+ * go straight back in without AddSegment's bookkeeping. */
+static void ReadTimingData( Reader &r, TimingData &timing )
+{
+	timing.m_fBeat0OffsetInSeconds = r.ReadFloat();
+	FOREACH_TimingSegmentType( tst )
+	{
+		std::vector<TimingSegment *> &vSegs = timing.GetTimingSegments( tst );
+		const std::uint32_t iNumSegs = r.ReadVarInt();
+		for( std::uint32_t i = 0; i < iNumSegs && !r.Error(); ++i )
+		{
+			const int iRow = r.ReadInt();
+			TimingSegment *seg = nullptr;
+			switch( tst )
+			{
+			case SEGMENT_BPM:	seg = new BPMSegment( iRow, r.ReadFloat() ); break;
+			case SEGMENT_STOP:	seg = new StopSegment( iRow, r.ReadFloat() ); break;
+			case SEGMENT_DELAY:	seg = new DelaySegment( iRow, r.ReadFloat() ); break;
+			case SEGMENT_TIME_SIG:
+			{
+				const int iNum = r.ReadInt();
+				seg = new TimeSignatureSegment( iRow, iNum, r.ReadInt() );
+				break;
+			}
+			case SEGMENT_WARP:	seg = new WarpSegment( iRow, r.ReadInt() ); break;
+			case SEGMENT_LABEL:	seg = new LabelSegment( iRow, r.ReadString() ); break;
+			case SEGMENT_TICKCOUNT:	seg = new TickcountSegment( iRow, r.ReadInt() ); break;
+			case SEGMENT_COMBO:
+			{
+				const int iCombo = r.ReadInt();
+				seg = new ComboSegment( iRow, iCombo, r.ReadInt() );
+				break;
+			}
+			case SEGMENT_SPEED:
+			{
+				const float fRatio = r.ReadFloat();
+				const float fDelay = r.ReadFloat();
+				seg = new SpeedSegment( iRow, fRatio, fDelay, SpeedSegment::BaseUnit(r.ReadEnum(SpeedSegment::UNIT_SECONDS+1)) );
+				break;
+			}
+			case SEGMENT_SCROLL:	seg = new ScrollSegment( iRow, r.ReadFloat() ); break;
+			case SEGMENT_FAKE:	seg = new FakeSegment( iRow, r.ReadInt() ); break;
+			default: FAIL_M( ssprintf("Unknown timing segment type %i", tst) );
+			}
+			vSegs.push_back( seg );
+		}
+	}
+	timing.InvalidateLookup();
+}
+
+static void WriteBackgroundChanges( Writer &w, const std::vector<BackgroundChange> &vChanges )
+{
+	w.WriteVarInt( vChanges.size() );
+	for( const BackgroundChange &bgc : vChanges )
+	{
+		w.WriteFloat( bgc.m_fStartBeat );
+		w.WriteFloat( bgc.m_fRate );
+		w.WriteString( bgc.m_sTransition );
+		w.WriteString( bgc.m_def.m_sEffect );
+		w.WriteString( bgc.m_def.m_sFile1 );
+		w.WriteString( bgc.m_def.m_sFile2 );
+		w.WriteString( bgc.m_def.m_sColor1 );
+		w.WriteString( bgc.m_def.m_sColor2 );
+	}
+}
+
+static void ReadBackgroundChanges( Reader &r, std::vector<BackgroundChange> &vChanges )
+{
+	const std::uint32_t iNumChanges = r.ReadVarInt();
+	for( std::uint32_t i = 0; i < iNumChanges && !r.Error(); ++i )
+	{
+		BackgroundChange bgc;
+		bgc.m_fStartBeat = r.ReadFloat();
+		bgc.m_fRate = r.ReadFloat();
+		bgc.m_sTransition = r.ReadString();
+		bgc.m_def.m_sEffect = r.ReadString();
+		bgc.m_def.m_sFile1 = r.ReadString();
+		bgc.m_def.m_sFile2 = r.ReadString();
+		bgc.m_def.m_sColor1 = r.ReadString();
+		bgc.m_def.m_sColor2 = r.ReadString();
+		vChanges.push_back( bgc );
+	}
+}
+
+static void WriteAttacks( Writer &w, const AttackArray &attacks, const std::vector<RString> &vsAttackString )
+{
+	w.WriteVarInt( attacks.size() );
+	for( const Attack &a : attacks )
+	{
+		w.WriteU8( a.level );
+		w.WriteFloat( a.fStartSecond );
+		w.WriteFloat( a.fSecsRemaining );
+		w.WriteString( a.sModifiers );
+		w.WriteBool( a.bGlobal );
+		w.WriteBool( a.bShowInAttackList );
+	}
+	w.WriteVarInt( vsAttackString.size() );
+	for( const RString &s : vsAttackString )
+		w.WriteString( s );
+}
+
+static void ReadAttacks( Reader &r, AttackArray &attacks, std::vector<RString> &vsAttackString )
+{
+	const std::uint32_t iNumAttacks = r.ReadVarInt();
+	for( std::uint32_t i = 0; i < iNumAttacks && !r.Error(); ++i )
+	{
+		Attack a;
+		a.level = AttackLevel( r.ReadEnum(NUM_ATTACK_LEVELS) );
+		a.fStartSecond = r.ReadFloat();
+		a.fSecsRemaining = r.ReadFloat();
+		a.sModifiers = r.ReadString();
+		a.bGlobal = r.ReadBool();
+		a.bShowInAttackList = r.ReadBool();
+		attacks.push_back( a );
+	}
+	const std::uint32_t iNumStrings = r.ReadVarInt();
+	for( std::uint32_t i = 0; i < iNumStrings && !r.Error(); ++i )
+		vsAttackString.push_back( r.ReadString() );
+}
+
+static void WriteDensity( Writer &w, const ChartDensity &density )
+{
+	w.WriteVarInt( density.m_viNotesPerMeasure.size() );
+	for( unsigned i = 0; i < density.m_viNotesPerMeasure.size(); ++i )
+	{
+		w.WriteVarInt( density.m_viNotesPerMeasure[i] );
+		w.WriteFloat( density.m_vfNPSPerMeasure[i] );
+	}
+	w.WriteFloat( density.m_fPeakNPS );
+
+	w.WriteVarInt( density.m_vRuns.size() );
+	for( const ChartDensity::Run &run : density.m_vRuns )
+	{
+		w.WriteBool( run.m_bStream );
+		w.WriteVarInt( run.m_iFirstMeasure );
+		w.WriteVarInt( run.m_iNumMeasures );
+	}
+}
+
+static void ReadDensity( Reader &r, ChartDensity &density )
+{
+	const std::uint32_t iNumMeasures = r.ReadVarInt();
+	for( std::uint32_t i = 0; i < iNumMeasures && !r.Error(); ++i )
+	{
+		density.m_viNotesPerMeasure.push_back( r.ReadVarInt() );
+		density.m_vfNPSPerMeasure.push_back( r.ReadFloat() );
+	}
+	density.m_fPeakNPS = r.ReadFloat();
+
+	const std::uint32_t iNumRuns = r.ReadVarInt();
+	for( std::uint32_t i = 0; i < iNumRuns && !r.Error(); ++i )
+	{
+		ChartDensity::Run run;
+		run.m_bStream = r.ReadBool();
+		run.m_iFirstMeasure = r.ReadVarInt();
+		run.m_iNumMeasures = r.ReadVarInt();
+		density.m_vRuns.push_back( run );
+	}
+}
+
+static void WriteSteps( Writer &w, const Steps &steps )
+{
+	w.WriteString( steps.m_StepsTypeStr );
+	w.WriteString( steps.GetChartName() );
+	w.WriteString( steps.GetDescription() );
+	w.WriteString( steps.GetChartStyle() );
+	w.WriteU8( steps.GetDifficulty() );
+	w.WriteInt( steps.GetMeter() );
+	w.WriteString( steps.GetMusicFile() );
+	w.WriteString( steps.GetCredit() );
+	w.WriteString( steps.GetFilename() );
+
+	FOREACH_PlayerNumber( pn )
+	{
+		const RadarValues &rv = steps.GetRadarValues( pn );
+		FOREACH_ENUM( RadarCategory, rc )
+			w.WriteFloat( rv[rc] );
+	}
+
+	// Steps without timing of their own use the song's.
+	w.WriteBool( !steps.m_Timing.empty() );
+	if( !steps.m_Timing.empty() )
+		WriteTimingData( w, steps.m_Timing );
+
+	WriteAttacks( w, steps.m_Attacks, steps.m_sAttackString );
+
+	w.WriteU8( steps.GetDisplayBPM() );
+	w.WriteFloat( steps.GetMinBPM() );
+	w.WriteFloat( steps.GetMaxBPM() );
+
+	// Saves loading the notes to match edits against each other.
+	w.WriteU32( steps.GetHash() );
+	w.WriteString( steps.ChartKey );
+
+	WriteDensity( w, steps.GetDensity() );
+}
+
+static void ReadSteps( Reader &r, Steps &steps )
+{
+	steps.m_StepsTypeStr = r.ReadString();
+	steps.m_StepsType = GAMEMAN->StringToStepsType( steps.m_StepsTypeStr );
+	steps.SetChartName( r.ReadString() );
+	const RString sDescription = r.ReadString();
+	steps.SetChartStyle( r.ReadString() );
+	// Steps that never got a difficulty are cached as Difficulty_Invalid.
+	steps.SetDifficultyAndDescription( Difficulty(r.ReadEnum(Difficulty_Invalid+1)), sDescription );
+	steps.SetMeter( r.ReadInt() );
+	steps.SetMusicFile( r.ReadString() );
+	steps.SetCredit( r.ReadString() );
+	steps.SetFilename( r.ReadString() );
+
+	RadarValues rv[NUM_PLAYERS];
+	FOREACH_PlayerNumber( pn )
+	{
+		FOREACH_ENUM( RadarCategory, rc )
+			rv[pn][rc] = r.ReadFloat();
+	}
+	steps.SetCachedRadarValues( rv );
+
+	if( r.ReadBool() )
+		ReadTimingData( r, steps.m_Timing );
+
+	ReadAttacks( r, steps.m_Attacks, steps.m_sAttackString );
+
+	steps.SetDisplayBPM( DisplayBPM(r.ReadEnum(NUM_DisplayBPM)) );
+	steps.SetMinBPM( r.ReadFloat() );
+	steps.SetMaxBPM( r.ReadFloat() );
+
+	steps.SetCachedHash( r.ReadU32() );
+	steps.SetChartKey( r.ReadString() );
+
+	ChartDensity density;
+	ReadDensity( r, density );
+	steps.SetCachedDensity( density );
+}
+
+void SongCacheBinary::WriteSong( const Song &song, const std::vector<Steps*> &vpSteps, RString &sSongOut, std::vector<RString> &vsNotesOut )
+{
+	Writer w( sSongOut );
+
+	w.WriteString( song.m_sSongFileName );
+	w.WriteString( song.m_sMainTitle );
+	w.WriteString( song.m_sSubTitle );
+	w.WriteString( song.m_sArtist );
+	w.WriteString( song.m_sMainTitleTranslit );
+	w.WriteString( song.m_sSubTitleTranslit );
+	w.WriteString( song.m_sArtistTranslit );
+	w.WriteString( song.m_sGenre );
+	w.WriteString( song.m_sOrigin );
+	w.WriteString( song.m_sCredit );
+	w.WriteString( song.m_sBannerFile );
+	w.WriteString( song.m_sBackgroundFile );
+	w.WriteString( song.m_sPreviewVidFile );
+	w.WriteString( song.m_sJacketFile );
+	w.WriteString( song.m_sCDFile );
+	w.WriteString( song.m_sDiscFile );
+	w.WriteString( song.m_sLyricsFile );
+	w.WriteString( song.m_sCDTitleFile );
+	w.WriteString( song.m_sMusicFile );
+	w.WriteString( song.m_PreviewFile );
+	FOREACH_ENUM( InstrumentTrack, it )
+		w.WriteString( song.m_sInstrumentTrackFile[it] );
+
+	w.WriteFloat( song.m_fMusicSampleStartSeconds );
+	w.WriteFloat( song.m_fMusicSampleLengthSeconds );
+	w.WriteFloat( song.m_fMusicLengthSeconds );
+	w.WriteU8( song.m_SelectionDisplay );
+	w.WriteU8( song.m_DisplayBPMType );
+	w.WriteFloat( song.m_fSpecifiedBPMMin );
+	w.WriteFloat( song.m_fSpecifiedBPMMax );
+	w.WriteFloat( song.GetFirstSecond() );
+	w.WriteFloat( song.GetLastSecond() );
+	w.WriteFloat( song.GetSpecifiedLastSecond() );
+	w.WriteBool( song.m_bHasMusic );
+	w.WriteBool( song.m_bHasBanner );
+	w.WriteBool( song.m_bHasBackground );
+
+	WriteTimingData( w, song.m_SongTiming );
+
+	FOREACH_BackgroundLayer( b )
+		WriteBackgroundChanges( w, song.GetBackgroundChanges(b) );
+	WriteBackgroundChanges( w, song.GetForegroundChanges() );
+
+	w.WriteVarInt( song.m_vsKeysoundFile.size() );
+	for( const RString &s : song.m_vsKeysoundFile )
+		w.WriteString( s );
+
+	WriteAttacks( w, song.m_Attacks, song.m_sAttackString );
+
+	w.WriteVarInt( vpSteps.size() );
+	vsNotesOut.clear();
+	for( Steps *pSteps : vpSteps )
+	{
+		WriteSteps( w, *pSteps );
+
+		/* Steps in styles we don't know about have no track count to unpack
+		 * into; they keep loading from their simfile. */
+		vsNotesOut.push_back( RString() );
+		if( pSteps->m_StepsType != StepsType_Invalid )
+		{
+			NoteData nd;
+			pSteps->GetNoteData( nd );
+			WriteNoteData( nd, vsNotesOut.back() );
+		}
+	}
+}
+
+bool SongCacheBinary::ReadSong( const char *pData, unsigned iSize, Song &out )
+{
+	Reader r( pData, iSize );
+
+	out.m_sSongFileName = r.ReadString();
+	out.m_sMainTitle = r.ReadString();
+	out.m_sSubTitle = r.ReadString();
+	out.m_sArtist = r.ReadString();
+	out.m_sMainTitleTranslit = r.ReadString();
+	out.m_sSubTitleTranslit = r.ReadString();
+	out.m_sArtistTranslit = r.ReadString();
+	out.m_sGenre = r.ReadString();
+	out.m_sOrigin = r.ReadString();
+	out.m_sCredit = r.ReadString();
+	out.m_sBannerFile = r.ReadString();
+	out.m_sBackgroundFile = r.ReadString();
+	out.m_sPreviewVidFile = r.ReadString();
+	out.m_sJacketFile = r.ReadString();
+	out.m_sCDFile = r.ReadString();
+	out.m_sDiscFile = r.ReadString();
+	out.m_sLyricsFile = r.ReadString();
+	out.m_sCDTitleFile = r.ReadString();
+	out.m_sMusicFile = r.ReadString();
+	out.m_PreviewFile = r.ReadString();
+	FOREACH_ENUM( InstrumentTrack, it )
+		out.m_sInstrumentTrackFile[it] = r.ReadString();
+
+	out.m_fMusicSampleStartSeconds = r.ReadFloat();
+	out.m_fMusicSampleLengthSeconds = r.ReadFloat();
+	out.m_fMusicLengthSeconds = r.ReadFloat();
+	out.m_SelectionDisplay = Song::SelectionDisplay( r.ReadEnum(Song::SHOW_NEVER+1) );
+	out.m_DisplayBPMType = DisplayBPM( r.ReadEnum(NUM_DisplayBPM) );
+	out.m_fSpecifiedBPMMin = r.ReadFloat();
+	out.m_fSpecifiedBPMMax = r.ReadFloat();
+	out.SetFirstSecond( r.ReadFloat() );
+	out.SetLastSecond( r.ReadFloat() );
+	out.SetSpecifiedLastSecond( r.ReadFloat() );
+	out.m_bHasMusic = r.ReadBool();
+	out.m_bHasBanner = r.ReadBool();
+	out.m_bHasBackground = r.ReadBool();
+
+	ReadTimingData( r, out.m_SongTiming );
+	out.m_SongTiming.m_sFile = out.m_sSongFileName;
+
+	FOREACH_BackgroundLayer( b )
+		ReadBackgroundChanges( r, out.GetBackgroundChanges(b) );
+	ReadBackgroundChanges( r, out.GetForegroundChanges() );
+
+	const std::uint32_t iNumKeysounds = r.ReadVarInt();
+	for( std::uint32_t i = 0; i < iNumKeysounds && !r.Error(); ++i )
+		out.m_vsKeysoundFile.push_back( r.ReadString() );
+
+	ReadAttacks( r, out.m_Attacks, out.m_sAttackString );
+
+	const std::uint32_t iNumSteps = r.ReadVarInt();
+	for( std::uint32_t i = 0; i < iNumSteps && !r.Error(); ++i )
+	{
+		Steps *pSteps = out.CreateSteps();
+		ReadSteps( r, *pSteps );
+		if( r.Error() )
+		{
+			delete pSteps;
+			break;
+		}
+		pSteps->SetCacheNoteDataIndex( i );
+		out.AddSteps( pSteps );
+	}
+
+	out.m_fVersion = STEPFILE_VERSION_NUMBER;
+	return !r.Error() && r.AtEnd();
+}
+
+/* Notes are stored track by track, as row deltas.  Most notes are plain taps
+ * and mines, so everything beyond the type is only written when it isn't the
+ * default. */
+enum
+{
+	PACKED_SUBTYPE = 1<<0,
+	PACKED_SOURCE = 1<<1,
+	PACKED_PLAYER = 1<<2,
+	PACKED_DURATION = 1<<3,
+	PACKED_KEYSOUND = 1<<4,
+	PACKED_ATTACK = 1<<5
+};
+
+void SongCacheBinary::WriteNoteData( const NoteData &nd, RString &sOut )
+{
+	Writer w( sOut );
+	w.WriteVarInt( nd.GetNumTracks() );
+	for( int t = 0; t < nd.GetNumTracks(); ++t )
+	{
+		int iNumNotes = 0;
+		for( NoteData::const_iterator it = nd.begin(t); it != nd.end(t); ++it )
+			++iNumNotes;
+		w.WriteVarInt( iNumNotes );
+
+		int iLastRow = 0;
+		for( NoteData::const_iterator it = nd.begin(t); it != nd.end(t); ++it )
+		{
+			const TapNote &tn = it->second;
+			std::uint8_t iFlags = 0;
+			if( tn.subType != TapNoteSubType_Invalid )	iFlags |= PACKED_SUBTYPE;
+			if( tn.source != TapNoteSource_Original )	iFlags |= PACKED_SOURCE;
+			if( tn.pn != PLAYER_INVALID )			iFlags |= PACKED_PLAYER;
+			if( tn.iDuration != 0 )				iFlags |= PACKED_DURATION;
+			if( tn.iKeysoundIndex != -1 )			iFlags |= PACKED_KEYSOUND;
+			if( tn.type == TapNoteType_Attack )		iFlags |= PACKED_ATTACK;
+
+			// Rows are never negative, and the map is sorted.
+			w.WriteVarInt( it->first - iLastRow );
+			iLastRow = it->first;
+			w.WriteU8( tn.type );
+			w.WriteU8( iFlags );
+			if( iFlags & PACKED_SUBTYPE )	w.WriteU8( tn.subType );
+			if( iFlags & PACKED_SOURCE )	w.WriteU8( tn.source );
+			if( iFlags & PACKED_PLAYER )	w.WriteU8( tn.pn );
+			if( iFlags & PACKED_DURATION )	w.WriteVarInt( tn.iDuration );
+			if( iFlags & PACKED_KEYSOUND )	w.WriteVarInt( tn.iKeysoundIndex );
+			if( iFlags & PACKED_ATTACK )
+			{
+				w.WriteString( tn.sAttackModifiers );
+				w.WriteFloat( tn.fAttackDurationSeconds );
+			}
+		}
+	}
+}
+
+bool SongCacheBinary::ReadNoteData( const char *pData, unsigned iSize, NoteData &nd )
+{
+	Reader r( pData, iSize );
+	if( int(r.ReadVarInt()) != nd.GetNumTracks() )
+		return false;
+
+	for( int t = 0; t < nd.GetNumTracks() && !r.Error(); ++t )
+	{
+		const std::uint32_t iNumNotes = r.ReadVarInt();
+		int iRow = 0;
+		for( std::uint32_t i = 0; i < iNumNotes && !r.Error(); ++i )
+		{
+			iRow += r.ReadVarInt();
+
+			TapNote tn;
+			tn.type = TapNoteType( r.ReadEnum(NUM_TapNoteType) );
+			const std::uint8_t iFlags = r.ReadU8();
+			if( iFlags & PACKED_SUBTYPE )	tn.subType = TapNoteSubType( r.ReadEnum(TapNoteSubType_Invalid+1) );
+			if( iFlags & PACKED_SOURCE )	tn.source = TapNoteSource( r.ReadEnum(TapNoteSource_Invalid+1) );
+			if( iFlags & PACKED_PLAYER )	tn.pn = PlayerNumber( r.ReadEnum(PlayerNumber_Invalid+1) );
+			if( iFlags & PACKED_DURATION )	tn.iDuration = r.ReadVarInt();
+			if( iFlags & PACKED_KEYSOUND )	tn.iKeysoundIndex = r.ReadVarInt();
+			if( iFlags & PACKED_ATTACK )
+			{
+				tn.sAttackModifiers = r.ReadString();
+				tn.fAttackDurationSeconds = r.ReadFloat();
+			}
+			nd.SetTapNote( t, iRow, tn );
+		}
+	}
+	return !r.Error() && r.AtEnd();
+}
@@ -0,0 +1,81 @@
+/* SongCacheBinary - Read and write songs in the binary song cache. */
+
+#ifndef SONG_CACHE_BINARY_H
+#define SONG_CACHE_BINARY_H
+
+#include <cstdint>
+#include <vector>
+
+class Song;
+class Steps;
+class NoteData;
+
+/* The song cache holds everything Song::LoadFromSongDir would otherwise parse
+ * out of the simfile, so warm loads never touch MsdFile.  Each chart's notes
+ * are packed separately, so they can stay on disk until something asks for
+ * them; see Steps::Decompress. */
+namespace SongCacheBinary
+{
+	/* Serialize the song and the given Steps.  vsNotesOut receives one packed
+	 * NoteData per Steps, in the same order; Steps whose notes couldn't be
+	 * packed get an empty string and load from their simfile instead. */
+	void WriteSong( const Song &song, const std::vector<Steps*> &vpSteps, RString &sSongOut, std::vector<RString> &vsNotesOut );
+
+	/* Fill in a freshly constructed Song from data written by WriteSong.  Each
+	 * Steps learns its index into vsNotesOut, for SongCacheIndex::GetCachedNoteData.
+	 * Returns false if the data is damaged, in which case the song is left
+	 * partially loaded and must be Reset. */
+	bool ReadSong( const char *pData, unsigned iSize, Song &out );
+
+	void WriteNoteData( const NoteData &nd, RString &sOut );
+	/* nd must already have the right number of tracks. */
+	bool ReadNoteData( const char *pData, unsigned iSize, NoteData &nd );
+
+	/* Little helpers for building the cache, shared with SongCacheIndex. */
+	class Writer
+	{
+	public:
+		Writer( RString &sOut ): m_sOut(sOut) { }
+		void WriteU8( std::uint8_t i ) { m_sOut.append( 1, char(i) ); }
+		void WriteU32( std::uint32_t i ) { m_sOut.append( (const char *) &i, sizeof(i) ); }
+		void WriteInt( int i ) { WriteU32( std::uint32_t(i) ); }
+		void WriteFloat( float f ) { m_sOut.append( (const char *) &f, sizeof(f) ); }
+		void WriteBool( bool b ) { WriteU8( b? 1:0 ); }
+		void WriteVarInt( std::uint32_t i );
+		void WriteString( const RString &s ) { WriteVarInt( s.size() ); m_sOut.append( s ); }
+		void WriteBytes( const char *p, unsigned iSize ) { m_sOut.append( p, iSize ); }
+
+	private:
+		RString &m_sOut;
+	};
+
+	/* Reads never run off the end of the buffer; once anything goes wrong,
+	 * every read returns zero and Error() is true. */
+	class Reader
+	{
+	public:
+		Reader( const char *pData, unsigned iSize ): m_p(pData), m_pEnd(pData+iSize), m_bError(false) { }
+		std::uint8_t ReadU8();
+		std::uint32_t ReadU32();
+		int ReadInt() { return int(ReadU32()); }
+		float ReadFloat();
+		bool ReadBool() { return ReadU8() != 0; }
+		std::uint32_t ReadVarInt();
+		RString ReadString();
+		/* Read an enum written with WriteU8.  Anything from iNumValues up
+		 * means the cache is damaged. */
+		int ReadEnum( int iNumValues );
+		/* Return a pointer to the next iSize bytes, and skip them. */
+		const char *ReadBytes( unsigned iSize );
+
+		bool Error() const { return m_bError; }
+		bool AtEnd() const { return m_p == m_pEnd; }
+
+	private:
+		const char *m_p;
+		const char *m_pEnd;
+		bool m_bError;
+	};
+}
+
+#endif
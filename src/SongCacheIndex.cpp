@@ -1,16 +1,26 @@
 #include "global.h"
 
 #include "SongCacheIndex.h"
+#include "SongCacheBinary.h"
 #include "RageLog.h"
 #include "RageUtil.h"
+#include "RageFile.h"
 #include "RageFileManager.h"
 #include "Song.h"
 #include "SpecialFiles.h"
 #include "CommonMetrics.h"
 
 #include <cstddef>
+#include <cstring>
 #include <vector>
 
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 /*
  * A quick explanation of song cache hashes: Each song has two hashes; a hash of the
  * song path, and a hash of the song directory.  The former is Song::GetCacheFilePath;
@@ -30,6 +40,30 @@
  */
 #define CACHE_INDEX SpecialFiles::CACHE_DIR + "index.cache"
 
+/*
+ * The songs themselves are cached in a single binary file, so a warm start
+ * is one read (or mmap) instead of a cache file per song:
+ *
+ * "SMSC", FILE_CACHE_VERSION, number of entries
+ * for each entry: song dir, size, SongCacheBinary song data followed by each
+ * chart's packed notes
+ *
+ * Numbers are in native byte order; the cache never leaves this machine.
+ */
+#define SONG_CACHE (SpecialFiles::CACHE_DIR + "songs.cache")
+static const char SONG_CACHE_MAGIC[4] = { 'S', 'M', 'S', 'C' };
+
+/*
+ * The library manifest lets SongManager skip listing groups that haven't
+ * changed since the last load:
+ *
+ * "SMLM", FILE_CACHE_VERSION, number of groups
+ * for each group: group dir, hash, banner, symlinks, then each song dir and
+ * its hash
+ */
+#define LIBRARY_MANIFEST (SpecialFiles::CACHE_DIR + "library.cache")
+static const char LIBRARY_MANIFEST_MAGIC[4] = { 'S', 'M', 'L', 'M' };
+
 
 SongCacheIndex *SONGINDEX; // global and accessible from anywhere in our program
 
@@ -57,14 +91,23 @@ RString SongCacheIndex::GetCacheFilePath( const RString &sGroup, const RString &
 	return ssprintf( "%s%s/%s", SpecialFiles::CACHE_DIR.c_str(), sGroup.c_str(), s.c_str() );
 }
 
-SongCacheIndex::SongCacheIndex()
+SongCacheIndex::SongCacheIndex():
+	CacheIndexLock( "SongCacheIndex" ),
+	pSongCacheFile( nullptr ),
+	iSongCacheFileSize( 0 ),
+	bSongCacheFileMapped( false ),
+	bSongCacheDirty( false ),
+	bLibraryManifestDirty( false ),
+	delay_save_cache( false )
 {
 	ReadCacheIndex();
 }
 
 SongCacheIndex::~SongCacheIndex()
 {
-
+	WriteSongCache();
+	SongCache.clear();
+	CloseSongCache();
 }
 
 void SongCacheIndex::ReadFromDisk()
@@ -87,14 +130,24 @@ static void EmptyDir( RString dir )
 
 void SongCacheIndex::ReadCacheIndex()
 {
+	LockMut( CacheIndexLock );
 	CacheIndex.ReadFile( CACHE_INDEX );	// don't care if this fails
 
 	int iCacheVersion = -1;
 	CacheIndex.GetValue( "Cache", "CacheVersion", iCacheVersion );
 	if( iCacheVersion == FILE_CACHE_VERSION )
+	{
+		ReadSongCache();
+		ReadLibraryManifest();
 		return; // OK
+	}
 
 	LOG->Trace( "Cache format is out of date.  Deleting all cache files." );
+	SongCache.clear();
+	bSongCacheDirty = false;
+	CloseSongCache();
+	LibraryManifest.clear();
+	bLibraryManifestDirty = false;
 	EmptyDir( SpecialFiles::CACHE_DIR );
 	EmptyDir( SpecialFiles::CACHE_DIR+"Songs/" );
 	EmptyDir( SpecialFiles::CACHE_DIR+"Courses/" );
@@ -115,13 +168,17 @@ void SongCacheIndex::ReadCacheIndex()
 
 void SongCacheIndex::SaveCacheIndex()
 {
+	LockMut( CacheIndexLock );
 	CacheIndex.WriteFile(CACHE_INDEX);
+	WriteSongCache();
+	WriteLibraryManifest();
 }
 
 void SongCacheIndex::AddCacheIndex(const RString &path, unsigned hash)
 {
 	if( hash == 0 )
 		++hash; /* no 0 hash values */
+	LockMut( CacheIndexLock );
 	CacheIndex.SetValue( "Cache", "CacheVersion", FILE_CACHE_VERSION );
 	CacheIndex.SetValue( "Cache", MangleName(path), hash );
 	if(!delay_save_cache)
@@ -133,6 +190,7 @@ void SongCacheIndex::AddCacheIndex(const RString &path, unsigned hash)
 unsigned SongCacheIndex::GetCacheHash( const RString &path ) const
 {
 	unsigned iDirHash = 0;
+	LockMut( CacheIndexLock );
 	if( !CacheIndex.GetValue( "Cache", MangleName(path), iDirHash ) )
 		return 0;
 	if( iDirHash == 0 )
@@ -140,6 +198,306 @@ unsigned SongCacheIndex::GetCacheHash( const RString &path ) const
 	return iDirHash;
 }
 
+void SongCacheIndex::ReadSongCache()
+{
+	LockMut( CacheIndexLock );
+	SongCache.clear();
+	bSongCacheDirty = false;
+	CloseSongCache();
+
+#if !defined(WIN32)
+	/* Map the file if it lives on a real disk, so nothing is copied until a
+	 * song asks for its entry. */
+	const int fd = open( FILEMAN->ResolvePath(SONG_CACHE).c_str(), O_RDONLY );
+	if( fd != -1 )
+	{
+		struct stat st;
+		if( fstat(fd, &st) == 0 && st.st_size > 0 )
+		{
+			void *p = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+			if( p != MAP_FAILED )
+			{
+				pSongCacheFile = (const char *) p;
+				iSongCacheFileSize = st.st_size;
+				bSongCacheFileMapped = true;
+			}
+		}
+		close( fd );
+	}
+#endif
+
+	if( pSongCacheFile == nullptr )
+	{
+		RageFile f;
+		if( !f.Open(SONG_CACHE) )
+			return; // no cache yet
+		if( f.Read(SongCacheFileBuffer) == -1 )
+		{
+			LOG->Warn( "Couldn't read %s: %s", SONG_CACHE.c_str(), f.GetError().c_str() );
+			SongCacheFileBuffer = RString();
+			return;
+		}
+		pSongCacheFile = SongCacheFileBuffer.data();
+		iSongCacheFileSize = SongCacheFileBuffer.size();
+	}
+
+	SongCacheBinary::Reader r( pSongCacheFile, iSongCacheFileSize );
+	const char *pMagic = r.ReadBytes( sizeof(SONG_CACHE_MAGIC) );
+	if( pMagic == nullptr || memcmp(pMagic, SONG_CACHE_MAGIC, sizeof(SONG_CACHE_MAGIC)) ||
+		r.ReadInt() != FILE_CACHE_VERSION )
+	{
+		LOG->Trace( "%s is out of date; ignoring it.", SONG_CACHE.c_str() );
+		CloseSongCache();
+		return;
+	}
+
+	const std::uint32_t iNumEntries = r.ReadU32();
+	for( std::uint32_t i = 0; i < iNumEntries && !r.Error(); ++i )
+	{
+		const RString sPath = r.ReadString();
+		const std::uint32_t iSize = r.ReadVarInt();
+		const char *pData = r.ReadBytes( iSize );
+		if( pData == nullptr )
+			break;
+
+		SongCacheEntry &entry = SongCache[sPath];
+		entry.pData = pData;
+		entry.iSize = iSize;
+	}
+
+	if( r.Error() )
+	{
+		LOG->Warn( "%s is damaged; ignoring it.", SONG_CACHE.c_str() );
+		SongCache.clear();
+		CloseSongCache();
+		return;
+	}
+
+	LOG->Trace( "Read %i songs from %s (%s).", int(SongCache.size()), SONG_CACHE.c_str(),
+		bSongCacheFileMapped? "mapped":"copied" );
+}
+
+void SongCacheIndex::WriteSongCache()
+{
+	LockMut( CacheIndexLock );
+	if( !bSongCacheDirty )
+		return;
+
+	RString sBuf;
+	SongCacheBinary::Writer w( sBuf );
+	w.WriteBytes( SONG_CACHE_MAGIC, sizeof(SONG_CACHE_MAGIC) );
+	w.WriteInt( FILE_CACHE_VERSION );
+	w.WriteU32( SongCache.size() );
+	for( std::pair<const RString, SongCacheEntry> const &entry : SongCache )
+	{
+		w.WriteString( entry.first );
+		w.WriteVarInt( entry.second.iSize );
+		w.WriteBytes( entry.second.pData, entry.second.iSize );
+	}
+
+	/* RageFile writes to a temporary file and renames it over the old one
+	 * when it's closed, so if this fails, the old file is still there.  Keep
+	 * the entries we have, and try again next time. */
+	RageFile f;
+	if( !f.Open(SONG_CACHE, RageFile::WRITE) || f.Write(sBuf) == -1 || f.Flush() == -1 )
+	{
+		LOG->Warn( "Couldn't write %s: %s", SONG_CACHE.c_str(), f.GetError().c_str() );
+		return;
+	}
+	f.Close();
+
+	/* Read it back, so entries point into the mapped file instead of
+	 * holding on to their own copies.  The old file may still be mapped
+	 * until now; it was renamed over, not changed. */
+	ReadSongCache();
+}
+
+void SongCacheIndex::CloseSongCache()
+{
+#if !defined(WIN32)
+	if( bSongCacheFileMapped )
+		munmap( const_cast<char *>(pSongCacheFile), iSongCacheFileSize );
+#endif
+	pSongCacheFile = nullptr;
+	iSongCacheFileSize = 0;
+	bSongCacheFileMapped = false;
+	SongCacheFileBuffer = RString();
+}
+
+void SongCacheIndex::AddSongCache( const RString &path, const RString &sSong, const std::vector<RString> &vsNotes )
+{
+	RString sBlob;
+	SongCacheBinary::Writer w( sBlob );
+	w.WriteVarInt( sSong.size() );
+	w.WriteBytes( sSong.data(), sSong.size() );
+	w.WriteVarInt( vsNotes.size() );
+	for( RString const &sNotes : vsNotes )
+	{
+		w.WriteVarInt( sNotes.size() );
+		w.WriteBytes( sNotes.data(), sNotes.size() );
+	}
+
+	LockMut( CacheIndexLock );
+	SongCacheEntry &entry = SongCache[path];
+	entry.Owned = sBlob;
+	entry.pData = entry.Owned.data();
+	entry.iSize = entry.Owned.size();
+	bSongCacheDirty = true;
+}
+
+void SongCacheIndex::RemoveSongCache( const RString &path )
+{
+	LockMut( CacheIndexLock );
+	if( SongCache.erase(path) == 0 )
+		return;
+	bSongCacheDirty = true;
+}
+
+bool SongCacheIndex::GetSongCache( const RString &path, RString &sSongOut ) const
+{
+	LockMut( CacheIndexLock );
+	std::map<RString, SongCacheEntry>::const_iterator it = SongCache.find( path );
+	if( it == SongCache.end() )
+		return false;
+
+	SongCacheBinary::Reader r( it->second.pData, it->second.iSize );
+	const std::uint32_t iSize = r.ReadVarInt();
+	const char *pData = r.ReadBytes( iSize );
+	if( pData == nullptr )
+		return false;
+	sSongOut.assign( pData, iSize );
+	return true;
+}
+
+bool SongCacheIndex::GetCachedNoteData( const RString &path, int iIndex, RString &sNotesOut ) const
+{
+	LockMut( CacheIndexLock );
+	std::map<RString, SongCacheEntry>::const_iterator it = SongCache.find( path );
+	if( it == SongCache.end() )
+		return false;
+
+	SongCacheBinary::Reader r( it->second.pData, it->second.iSize );
+	r.ReadBytes( r.ReadVarInt() ); // skip the song
+	const int iNumNotes = r.ReadVarInt();
+	if( iIndex < 0 || iIndex >= iNumNotes )
+		return false;
+	for( int i = 0; i < iIndex; ++i )
+		r.ReadBytes( r.ReadVarInt() );
+
+	const std::uint32_t iSize = r.ReadVarInt();
+	const char *pData = r.ReadBytes( iSize );
+	if( pData == nullptr || iSize == 0 )
+		return false; // not packed; load from the simfile
+	sNotesOut.assign( pData, iSize );
+	return true;
+}
+
+void SongCacheIndex::ReadLibraryManifest()
+{
+	LockMut( CacheIndexLock );
+	LibraryManifest.clear();
+	bLibraryManifestDirty = false;
+
+	RString sBuf;
+	RageFile f;
+	if( !f.Open(LIBRARY_MANIFEST) )
+		return; // no manifest yet
+	if( f.Read(sBuf) == -1 )
+	{
+		LOG->Warn( "Couldn't read %s: %s", LIBRARY_MANIFEST.c_str(), f.GetError().c_str() );
+		return;
+	}
+
+	SongCacheBinary::Reader r( sBuf.data(), sBuf.size() );
+	const char *pMagic = r.ReadBytes( sizeof(LIBRARY_MANIFEST_MAGIC) );
+	if( pMagic == nullptr || memcmp(pMagic, LIBRARY_MANIFEST_MAGIC, sizeof(LIBRARY_MANIFEST_MAGIC)) ||
+		r.ReadInt() != FILE_CACHE_VERSION )
+	{
+		LOG->Trace( "%s is out of date; ignoring it.", LIBRARY_MANIFEST.c_str() );
+		return;
+	}
+
+	const std::uint32_t iNumGroups = r.ReadU32();
+	for( std::uint32_t i = 0; i < iNumGroups && !r.Error(); ++i )
+	{
+		LibraryGroup &group = LibraryManifest[r.ReadString()];
+		group.iHash = r.ReadInt();
+		group.sBannerPath = r.ReadString();
+		const std::uint32_t iNumSymLinks = r.ReadVarInt();
+		for( std::uint32_t j = 0; j < iNumSymLinks && !r.Error(); ++j )
+			group.vsSymLinks.push_back( r.ReadString() );
+		const std::uint32_t iNumSongs = r.ReadVarInt();
+		for( std::uint32_t j = 0; j < iNumSongs && !r.Error(); ++j )
+		{
+			group.vsSongDirs.push_back( r.ReadString() );
+			group.viSongHashes.push_back( r.ReadInt() );
+		}
+	}
+
+	if( r.Error() || !r.AtEnd() )
+	{
+		LOG->Warn( "%s is damaged; ignoring it.", LIBRARY_MANIFEST.c_str() );
+		LibraryManifest.clear();
+	}
+}
+
+void SongCacheIndex::WriteLibraryManifest()
+{
+	LockMut( CacheIndexLock );
+	if( !bLibraryManifestDirty )
+		return;
+	bLibraryManifestDirty = false;
+
+	RString sBuf;
+	SongCacheBinary::Writer w( sBuf );
+	w.WriteBytes( LIBRARY_MANIFEST_MAGIC, sizeof(LIBRARY_MANIFEST_MAGIC) );
+	w.WriteInt( FILE_CACHE_VERSION );
+	w.WriteU32( LibraryManifest.size() );
+	for( std::pair<const RString, LibraryGroup> const &entry : LibraryManifest )
+	{
+		const LibraryGroup &group = entry.second;
+		w.WriteString( entry.first );
+		w.WriteInt( group.iHash );
+		w.WriteString( group.sBannerPath );
+		w.WriteVarInt( group.vsSymLinks.size() );
+		for( RString const &sSymLink : group.vsSymLinks )
+			w.WriteString( sSymLink );
+		w.WriteVarInt( group.vsSongDirs.size() );
+		for( unsigned i = 0; i < group.vsSongDirs.size(); ++i )
+		{
+			w.WriteString( group.vsSongDirs[i] );
+			w.WriteInt( group.viSongHashes[i] );
+		}
+	}
+
+	RageFile f;
+	if( !f.Open(LIBRARY_MANIFEST, RageFile::WRITE) || f.Write(sBuf) == -1 || f.Flush() == -1 )
+	{
+		LOG->Warn( "Couldn't write %s: %s", LIBRARY_MANIFEST.c_str(), f.GetError().c_str() );
+		f.Close();
+		FILEMAN->Remove( LIBRARY_MANIFEST );
+	}
+}
+
+bool SongCacheIndex::GetLibraryGroup( const RString &sGroupDir, LibraryGroup &out ) const
+{
+	LockMut( CacheIndexLock );
+	std::map<RString, LibraryGroup>::const_iterator it = LibraryManifest.find( sGroupDir );
+	if( it == LibraryManifest.end() )
+		return false;
+	out = it->second;
+	return true;
+}
+
+void SongCacheIndex::SetLibraryManifest( const std::map<RString, LibraryGroup> &manifest )
+{
+	LockMut( CacheIndexLock );
+	LibraryManifest = manifest;
+	bLibraryManifestDirty = true;
+	if( !delay_save_cache )
+		WriteLibraryManifest();
+}
+
 RString SongCacheIndex::MangleName( const RString &Name )
 {
 	/* We store paths in an INI.  We can't store '='. */
@@ -2,12 +2,63 @@
 #define SONG_CACHE_INDEX_H
 
 #include "IniFile.h"
+#include "RageThreads.h"
+
+#include <map>
+#include <vector>
 
 class SongCacheIndex
 {
 	IniFile CacheIndex;
+	/* Songs may be loaded from several threads at once; lock before
+	 * touching CacheIndex or SongCache. */
+	mutable RageMutex CacheIndexLock;
 	static RString MangleName( const RString &Name );
 
+	/* Every cached song lives in one file, which is mapped into memory when
+	 * we can.  An entry points either into the mapped file, or into Owned
+	 * if the song was cached since the file was last read. */
+	struct SongCacheEntry
+	{
+		const char *pData;
+		unsigned iSize;
+		RString Owned;
+	};
+	std::map<RString, SongCacheEntry> SongCache;
+	const char *pSongCacheFile;
+	unsigned iSongCacheFileSize;
+	bool bSongCacheFileMapped;
+	RString SongCacheFileBuffer;
+	bool bSongCacheDirty;
+
+	void ReadSongCache();
+	void WriteSongCache();
+	void CloseSongCache();
+
+public:
+	/* What a group directory looked like the last time the library was
+	 * loaded.  Hashes are FILEMAN->GetFileHash of the directory: its mtime
+	 * plus its size.  Adding, removing or renaming anything directly inside
+	 * a directory changes its mtime. */
+	struct LibraryGroup
+	{
+		LibraryGroup(): iHash(-1) { }
+		int iHash;
+		/* Full paths of the song directories, and the hash of each. */
+		std::vector<RString> vsSongDirs;
+		std::vector<int> viSongHashes;
+		/* The banner found inside the group directory, if any. */
+		RString sBannerPath;
+		std::vector<RString> vsSymLinks;
+	};
+
+private:
+	std::map<RString, LibraryGroup> LibraryManifest;
+	bool bLibraryManifestDirty;
+
+	void ReadLibraryManifest();
+	void WriteLibraryManifest();
+
 public:
 	SongCacheIndex();
 	~SongCacheIndex();
@@ -18,6 +69,21 @@ public:
 	void SaveCacheIndex();
 	void AddCacheIndex( const RString &path, unsigned hash );
 	unsigned GetCacheHash( const RString &path ) const;
+
+	/* The binary song cache, keyed by song directory like the hashes above.
+	 * See SongCacheBinary for what's in an entry.  Changes are kept in memory
+	 * and written by SaveCacheIndex, or when this is destroyed: rewriting the
+	 * file costs as much as the whole library. */
+	void AddSongCache( const RString &path, const RString &sSong, const std::vector<RString> &vsNotes );
+	void RemoveSongCache( const RString &path );
+	bool GetSongCache( const RString &path, RString &sSongOut ) const;
+	bool GetCachedNoteData( const RString &path, int iIndex, RString &sNotesOut ) const;
+
+	/* The library manifest, keyed by group directory.  SongManager replaces
+	 * the whole thing after each scan of the songs directory. */
+	bool GetLibraryGroup( const RString &sGroupDir, LibraryGroup &out ) const;
+	void SetLibraryManifest( const std::map<RString, LibraryGroup> &manifest );
+
 	bool delay_save_cache;
 };
 
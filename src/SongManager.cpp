@@ -24,6 +24,8 @@
 #include "RageFile.h"
 #include "RageFileManager.h"
 #include "RageLog.h"
+#include "RageSoundPCMCache.h"
+#include "RageUtil_WorkerPool.h"
 #include "Song.h"
 #include "SongCacheIndex.h"
 #include "SongUtil.h"
@@ -59,6 +61,9 @@ static const ThemeMetric<int>		EXTRA_STAGE2_DIFFICULTY_MAX	( "SongManager", "Ext
 
 static Preference<RString> g_sDisabledSongs( "DisabledSongs", "" );
 static Preference<bool> g_bHideIncompleteCourses( "HideIncompleteCourses", false );
+/* Number of threads used to parse songs at startup.  1 loads songs one at a
+ * time on the loading thread; 0 uses one thread per CPU core. */
+static Preference<int> g_iSongLoadThreads( "SongLoadThreads", 1 );
 
 RString SONG_GROUP_COLOR_NAME( std::size_t i )   { return ssprintf( "SongGroupColor%i", (int) i+1 ); }
 RString COURSE_GROUP_COLOR_NAME( std::size_t i ) { return ssprintf( "CourseGroupColor%i", (int) i+1 ); }
@@ -105,6 +110,9 @@ void SongManager::InitAll( LoadingWindow *ld, bool onlyAdditions )
 	{
 		m_GroupsToNeverCache.insert(*group);
 	}
+	// Loading needs the disk and the CPU to itself.
+	if( PCMCACHE != nullptr )
+		PCMCACHE->PauseDecoding();
 	InitSongsFromDisk( ld, onlyAdditions );
 	InitCoursesFromDisk( ld, onlyAdditions );
 	if (onlyAdditions)
@@ -113,6 +121,8 @@ void SongManager::InitAll( LoadingWindow *ld, bool onlyAdditions )
 	}
 	InitAutogenCourses();
 	InitRandomAttacks();
+	if( PCMCACHE != nullptr )
+		PCMCACHE->UnPauseDecoding();
 }
 
 static LocalizedString RELOADING ( "SongManager", "Reloading..." );
@@ -235,13 +245,13 @@ void SongManager::InitSongsFromDisk( LoadingWindow *ld, bool onlyAdditions )
 	// Tell SONGINDEX to not write the cache index file every time a song adds
 	// an entry. -Kyz
 	SONGINDEX->delay_save_cache = true;
-	IMAGECACHE->delay_save_cache = true;
+	// Banners that need caching are made on the image cache's own threads.
+	IMAGECACHE->StartBatch();
 	LoadSongDir( SpecialFiles::SONGS_DIR, ld, onlyAdditions );
 	LoadEnabledSongsFromPref();
 	SONGINDEX->SaveCacheIndex();
 	SONGINDEX->delay_save_cache = false;
-	IMAGECACHE->WriteToDisk();
-	IMAGECACHE->delay_save_cache = false;
+	IMAGECACHE->FinishBatch( ld );
 
 	LOG->Trace( "Found %d songs in %f seconds.", (int)m_pSongs.size(), tm.GetDeltaTime() );
 }
@@ -267,7 +277,24 @@ void SongManager::SanityCheckGroupDir( RString sDir ) const
 	}
 }
 
-void SongManager::AddGroup( RString sDir, RString sGroupDirName )
+// Look for a group banner in this group folder.
+static RString FindGroupBannerInGroupDir( RString sDir, RString sGroupDirName )
+{
+	std::vector<RString> arrayGroupBanners;
+	GetDirListing( sDir+sGroupDirName+"/*.png", arrayGroupBanners );
+	GetDirListing( sDir+sGroupDirName+"/*.jpg", arrayGroupBanners );
+	GetDirListing( sDir+sGroupDirName+"/*.jpeg", arrayGroupBanners );
+	GetDirListing( sDir+sGroupDirName+"/*.gif", arrayGroupBanners );
+	GetDirListing( sDir+sGroupDirName+"/*.bmp", arrayGroupBanners );
+
+	if( arrayGroupBanners.empty() )
+		return RString();
+	return sDir+sGroupDirName+"/"+arrayGroupBanners[0];
+}
+
+/* sBannerPath is the banner found by FindGroupBannerInGroupDir, or empty to
+ * look in the parent folder. */
+void SongManager::AddGroup( RString sDir, RString sGroupDirName, RString sBannerPath )
 {
 	unsigned j;
 	for(j = 0; j < m_sSongGroupNames.size(); ++j)
@@ -277,20 +304,10 @@ void SongManager::AddGroup( RString sDir, RString sGroupDirName )
 	if( j != m_sSongGroupNames.size() )
 		return; // the group is already added
 
-	// Look for a group banner in this group folder
-	std::vector<RString> arrayGroupBanners;
-	GetDirListing( sDir+sGroupDirName+"/*.png", arrayGroupBanners );
-	GetDirListing( sDir+sGroupDirName+"/*.jpg", arrayGroupBanners );
-	GetDirListing( sDir+sGroupDirName+"/*.jpeg", arrayGroupBanners );
-	GetDirListing( sDir+sGroupDirName+"/*.gif", arrayGroupBanners );
-	GetDirListing( sDir+sGroupDirName+"/*.bmp", arrayGroupBanners );
-
-	RString sBannerPath;
-	if( !arrayGroupBanners.empty() )
-		sBannerPath = sDir+sGroupDirName+"/"+arrayGroupBanners[0] ;
-	else
+	if( sBannerPath.empty() )
 	{
 		// Look for a group banner in the parent folder
+		std::vector<RString> arrayGroupBanners;
 		GetDirListing( sDir+sGroupDirName+".png", arrayGroupBanners );
 		GetDirListing( sDir+sGroupDirName+".jpg", arrayGroupBanners );
 		GetDirListing( sDir+sGroupDirName+".jpeg", arrayGroupBanners );
@@ -339,6 +356,21 @@ void SongManager::AddGroup( RString sDir, RString sGroupDirName )
 }
 
 static LocalizedString LOADING_SONGS ( "SongManager", "Loading songs..." );
+
+/* Load one song.  This may be run on a worker thread, so it must not touch
+ * SongManager; the caller adds the song to the lists. */
+static Song *LoadSongFromDir( const RString &sSongDirName, bool bChanged )
+{
+	Song* pNewSong = new Song;
+	if( !pNewSong->LoadFromSongDir( sSongDirName, false, ProfileSlot_Invalid, bChanged ) )
+	{
+		// The song failed to load.
+		delete pNewSong;
+		return nullptr;
+	}
+	return pNewSong;
+}
+
 void SongManager::LoadSongDir( RString sDir, LoadingWindow *ld, bool onlyAdditions )
 {
 	if( ld )
@@ -362,8 +394,17 @@ void SongManager::LoadSongDir( RString sDir, LoadingWindow *ld, bool onlyAdditio
 	StripMacResourceForks( arrayGroupDirs );
 
 	std::vector<std::vector<RString>> arrayGroupSongDirs;
+	// Whether each song's directory changed since the last load.
+	std::vector<std::vector<bool>> arrayGroupSongChanged;
 	int groupIndex, songCount, songIndex;
 
+	/* With FastLoad, a group whose directory hasn't changed since the last
+	 * load is taken from the library manifest, without listing it; songs
+	 * inside it are trusted to the cache, as FastLoad always has.  Without
+	 * FastLoad every group is listed and every song is checked. */
+	std::map<RString, SongCacheIndex::LibraryGroup> manifest;
+	int iUnchangedGroups = 0, iChangedSongDirs = 0;
+
 	groupIndex = 0;
 	songCount = 0;
 	if(ld)
@@ -374,26 +415,87 @@ void SongManager::LoadSongDir( RString sDir, LoadingWindow *ld, bool onlyAdditio
 	int sanity_index= 0;
 	for (RString const &sGroupDirName : arrayGroupDirs)	// foreach dir in /Songs/
 	{
-		if(ld && loading_window_last_update_time.Ago() > next_loading_window_update)
+		SongCacheIndex::LibraryGroup &group = manifest[sDir+sGroupDirName];
+		SongCacheIndex::LibraryGroup old;
+		const bool bHaveOld = SONGINDEX->GetLibraryGroup( sDir+sGroupDirName, old );
+		const int iGroupHash = FILEMAN->GetFileHash( sDir+sGroupDirName );
+
+		if( PREFSMAN->m_bFastLoad && bHaveOld && iGroupHash != -1 && old.iHash == iGroupHash )
+		{
+			group = old;
+			++iUnchangedGroups;
+		}
+		else
 		{
-			loading_window_last_update_time.Touch();
-			ld->SetProgress(sanity_index);
-			ld->SetText(SANITY_CHECKING_GROUPS.GetValue() + ssprintf("\n%s",
-					Basename(sGroupDirName).c_str()));
+			if(ld && loading_window_last_update_time.Ago() > next_loading_window_update)
+			{
+				loading_window_last_update_time.Touch();
+				ld->SetProgress(sanity_index);
+				ld->SetText(SANITY_CHECKING_GROUPS.GetValue() + ssprintf("\n%s",
+						Basename(sGroupDirName).c_str()));
+			}
+			// TODO: If this check fails, log a warning instead of crashing.
+			SanityCheckGroupDir(sDir+sGroupDirName);
+
+			// Find all Song folders in this group directory
+			GetDirListing( sDir+sGroupDirName + "/*", group.vsSongDirs, true, true );
+			StripCvsAndSvn( group.vsSongDirs );
+			StripMacResourceForks( group.vsSongDirs );
+			SortRStringArray( group.vsSongDirs );
+
+			group.iHash = iGroupHash;
+			for (RString const &sSongDirName : group.vsSongDirs)
+				group.viSongHashes.push_back( FILEMAN->GetFileHash(sSongDirName) );
+			group.sBannerPath = FindGroupBannerInGroupDir( sDir, sGroupDirName );
+			GetDirListing( sDir+sGroupDirName+"/*.include", group.vsSymLinks, false );
+			SortRStringArray( group.vsSymLinks );
 		}
-		// TODO: If this check fails, log a warning instead of crashing.
-		SanityCheckGroupDir(sDir+sGroupDirName);
 
-		// Find all Song folders in this group directory
-		std::vector<RString> arraySongDirs;
-		GetDirListing( sDir+sGroupDirName + "/*", arraySongDirs, true, true );
-		StripCvsAndSvn( arraySongDirs );
-		StripMacResourceForks( arraySongDirs );
-		SortRStringArray( arraySongDirs );
+		std::map<RString, int> oldSongHashes;
+		for( unsigned i=0; i < old.vsSongDirs.size(); ++i )
+			oldSongHashes[old.vsSongDirs[i]] = old.viSongHashes[i];
 
-		arrayGroupSongDirs.push_back(arraySongDirs);
-		songCount += arraySongDirs.size();
+		std::vector<bool> songChanged;
+		for( unsigned i=0; i < group.vsSongDirs.size(); ++i )
+		{
+			std::map<RString, int>::const_iterator it = oldSongHashes.find( group.vsSongDirs[i] );
+			const bool bChanged = it == oldSongHashes.end() || it->second != group.viSongHashes[i];
+			songChanged.push_back( bChanged );
+			if( bChanged )
+				++iChangedSongDirs;
+		}
 
+		arrayGroupSongDirs.push_back(group.vsSongDirs);
+		arrayGroupSongChanged.push_back(songChanged);
+		songCount += group.vsSongDirs.size();
+	}
+
+	SONGINDEX->SetLibraryManifest( manifest );
+	LOG->Trace( "Song library: %i of %i groups unchanged, %i of %i song folders new or changed.",
+		iUnchangedGroups, int(arrayGroupDirs.size()), iChangedSongDirs, songCount );
+
+	// Skip already loaded songs if onlyAdditions is set.
+	if (onlyAdditions)
+	{
+		songCount = 0;
+		for( unsigned i=0; i < arrayGroupSongDirs.size(); ++i )
+		{
+			std::vector<RString> newSongDirs;
+			std::vector<bool> newSongChanged;
+			for( unsigned j=0; j < arrayGroupSongDirs[i].size(); ++j )
+			{
+				SongID songID;
+				songID.FromString(arrayGroupSongDirs[i][j]);
+				if (songID.ToSong() == nullptr)
+				{
+					newSongDirs.push_back(arrayGroupSongDirs[i][j]);
+					newSongChanged.push_back(arrayGroupSongChanged[i][j]);
+				}
+			}
+			arrayGroupSongDirs[i].swap(newSongDirs);
+			arrayGroupSongChanged[i].swap(newSongChanged);
+			songCount += arrayGroupSongDirs[i].size();
+		}
 	}
 
 	if( songCount==0 ) return;
@@ -403,71 +505,105 @@ void SongManager::LoadSongDir( RString sDir, LoadingWindow *ld, bool onlyAdditio
 		ld->SetTotalWork( songCount );
 	}
 
-	groupIndex = 0;
-	songIndex = 0;
-	for (RString const &sGroupDirName : arrayGroupDirs)	// foreach dir in /Songs/
-	{
-		std::vector<RString> &arraySongDirs = arrayGroupSongDirs[groupIndex++];
+	// Songs are parsed into one slot per song directory, then added in
+	// directory order below, so the result doesn't depend on which song
+	// finished loading first.
+	std::vector<std::vector<Song*>> arrayGroupSongs;
+	for (std::vector<RString> const &arraySongDirs : arrayGroupSongDirs)
+		arrayGroupSongs.push_back(std::vector<Song*>(arraySongDirs.size(), nullptr));
 
-		LOG->Trace("Attempting to load %i songs from \"%s\"", int(arraySongDirs.size()),
-				   (sDir+sGroupDirName).c_str() );
-		int loaded = 0;
+	int iNumThreads = g_iSongLoadThreads;
+	if( iNumThreads < 1 )
+		iNumThreads = RageWorkerPool::GetDefaultNumThreads();
 
-		SongPointerVector& index_entry = m_mapSongGroupIndex[sGroupDirName];
-		RString group_base_name= Basename(sGroupDirName);
-		for( unsigned j=0; j< arraySongDirs.size(); ++j )	// for each song dir
+	if( iNumThreads > 1 )
+	{
+		RageWorkerPool pool( "SongLoad", iNumThreads );
+		for( unsigned i=0; i < arrayGroupSongDirs.size(); ++i )
 		{
-			RString sSongDirName = arraySongDirs[j];
-
-			// Skip already loaded songs if onlyAdditions is set.
-			if (onlyAdditions)
+			for( unsigned j=0; j < arrayGroupSongDirs[i].size(); ++j )
 			{
-				SongID songID;
-				songID.FromString(sSongDirName);
-				if (songID.ToSong() != nullptr)
-					continue;
+				Song **ppSong = &arrayGroupSongs[i][j];
+				const RString sSongDirName = arrayGroupSongDirs[i][j];
+				const bool bChanged = arrayGroupSongChanged[i][j];
+				pool.AddJob( [ppSong, sSongDirName, bChanged]() { *ppSong = LoadSongFromDir( sSongDirName, bChanged ); } );
 			}
+		}
 
-			// this is a song directory. Load a new song.
-			if(ld && loading_window_last_update_time.Ago() > next_loading_window_update)
+		LOG->Trace( "Loading %i songs with %i threads", songCount, pool.GetNumThreads() );
+		while( !pool.WaitForJobs(next_loading_window_update) )
+		{
+			if( ld )
 			{
-				loading_window_last_update_time.Touch();
-				ld->SetProgress(songIndex);
-				ld->SetText( LOADING_SONGS.GetValue() +
-					ssprintf("\n%s\n%s",
-						group_base_name.c_str(),
-						Basename(sSongDirName).c_str()
-					)
-				);
+				const int iFinished = pool.GetNumFinishedJobs();
+				ld->SetProgress( iFinished );
+				ld->SetText( LOADING_SONGS.GetValue() + ssprintf("\n%i / %i", iFinished, songCount) );
 			}
-
-			Song* pNewSong = new Song;
-			if( !pNewSong->LoadFromSongDir( sSongDirName ) )
+		}
+	}
+	else
+	{
+		songIndex = 0;
+		for( unsigned i=0; i < arrayGroupSongDirs.size(); ++i )
+		{
+			RString group_base_name= Basename(arrayGroupDirs[i]);
+			for( unsigned j=0; j < arrayGroupSongDirs[i].size(); ++j )	// for each song dir
 			{
-				// The song failed to load.
-				delete pNewSong;
-				continue;
+				RString sSongDirName = arrayGroupSongDirs[i][j];
+
+				// this is a song directory. Load a new song.
+				if(ld && loading_window_last_update_time.Ago() > next_loading_window_update)
+				{
+					loading_window_last_update_time.Touch();
+					ld->SetProgress(songIndex);
+					ld->SetText( LOADING_SONGS.GetValue() +
+						ssprintf("\n%s\n%s",
+							group_base_name.c_str(),
+							Basename(sSongDirName).c_str()
+						)
+					);
+				}
+
+				arrayGroupSongs[i][j] = LoadSongFromDir( sSongDirName, arrayGroupSongChanged[i][j] );
+				songIndex++;
 			}
+		}
+	}
+
+	groupIndex = 0;
+	for (RString const &sGroupDirName : arrayGroupDirs)	// foreach dir in /Songs/
+	{
+		std::vector<Song*> &arraySongs = arrayGroupSongs[groupIndex++];
+		const SongCacheIndex::LibraryGroup &group = manifest[sDir+sGroupDirName];
+
+		int loaded = 0;
+
+		SongPointerVector& index_entry = m_mapSongGroupIndex[sGroupDirName];
+		for (Song *pNewSong : arraySongs)
+		{
+			// The song failed to load.
+			if( pNewSong == nullptr )
+				continue;
 			AddSongToList(pNewSong);
 
 			index_entry.push_back( pNewSong );
 			loaded++;
-			songIndex++;
 		}
 
-		LOG->Trace("Loaded %i songs from \"%s\"", loaded, (sDir+sGroupDirName).c_str() );
+		LOG->Trace("Loaded %i of %i songs from \"%s\"", loaded, int(arraySongs.size()),
+				   (sDir+sGroupDirName).c_str() );
 
 		// Don't add the group name if we didn't load any songs in this group.
 		if(!loaded) continue;
 
 		// Add this group to the group array.
-		AddGroup(sDir, sGroupDirName);
+		AddGroup(sDir, sGroupDirName, group.sBannerPath);
 
 		// Cache and load the group banner. (and background if it has one -aj)
 		IMAGECACHE->CacheImage( "Banner", GetSongGroupBannerPath(sGroupDirName) );
 
 		// Load the group sym links (if any)
-		LoadGroupSymLinks(sDir, sGroupDirName);
+		LoadGroupSymLinks(sDir, sGroupDirName, group.vsSymLinks);
 	}
 
 	if( ld ) {
@@ -476,12 +612,9 @@ void SongManager::LoadSongDir( RString sDir, LoadingWindow *ld, bool onlyAdditio
 }
 
 // Instead of "symlinks", songs should have membership in multiple groups. -Chris
-void SongManager::LoadGroupSymLinks(RString sDir, RString sGroupFolder)
+// arraySymLinks holds the names of the group's .include files.
+void SongManager::LoadGroupSymLinks(RString sDir, RString sGroupFolder, const std::vector<RString> &arraySymLinks)
 {
-	// Find all symlink files in this folder
-	std::vector<RString> arraySymLinks;
-	GetDirListing( sDir+sGroupFolder+"/*.include", arraySymLinks, false );
-	SortRStringArray( arraySymLinks );
 	SongPointerVector& index_entry = m_mapSongGroupIndex[sGroupFolder];
 	for( unsigned s=0; s< arraySymLinks.size(); s++ )	// for each symlink in this dir, add it in as a song.
 	{
@@ -1589,6 +1722,22 @@ void SongManager::UpdatePopular()
 		vpCourses = apBestCourses[ct];
 		CourseUtil::SortCoursePointerArrayByNumPlays( vpCourses, ProfileSlot_Machine, true );
 	}
+
+	/* Keep the music of the songs played most on this machine decoded, so they
+	 * start without decoding anything. */
+	if( PCMCACHE != nullptr && PROFILEMAN->IsPersistentProfile(ProfileSlot_Machine) )
+	{
+		const Profile *pProfile = PROFILEMAN->GetMachineProfile();
+		std::vector<RString> vsMusic;
+		for( Song const *pSong : m_pPopularSongs )
+		{
+			if( pProfile->GetSongNumTimesPlayed(pSong) == 0 )
+				break;
+			if( pSong->HasMusic() )
+				vsMusic.push_back( pSong->GetMusicPath() );
+		}
+		PCMCACHE->SetWanted( vsMusic );
+	}
 }
 
 void SongManager::UpdateShuffled()
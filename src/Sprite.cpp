@@ -11,6 +11,7 @@
 #include "LuaBinding.h"
 #include "LuaManager.h"
 #include "ImageCache.h"
+#include "SpriteBatch.h"
 #include "ThemeMetric.h"
 #include <numeric>
 
@@ -527,9 +528,33 @@ void TexCoordArrayFromRect( float fImageCoords[8], const RectF &rect )
 	fImageCoords[6] = rect.right;	fImageCoords[7] = rect.top;	// top right
 }
 
+bool Sprite::CanBatch() const
+{
+	return m_pTexture != nullptr &&
+		m_BlendMode == BLEND_NORMAL &&
+		!m_bZWrite &&
+		m_ZTestMode == ZTEST_OFF &&
+		m_fZBias == 0 &&
+		!m_bClearZBuffer &&
+		m_CullMode == CULL_NONE &&
+		!m_bTextureWrapping &&
+		m_bTextureFiltering &&
+		m_EffectMode == EffectMode_Normal &&
+		m_fShadowLengthX == 0 && m_fShadowLengthY == 0;
+}
+
 void Sprite::DrawTexture( const TweenState *state )
 {
-	Actor::SetGlobalRenderStates(); // set Actor-specified render states
+	SpriteBatch *pBatch = SpriteBatch::GetCollecting();
+	if( pBatch != nullptr && !CanBatch() )
+	{
+		/* Draw what's collected first, so this goes on top of it. */
+		pBatch->Flush();
+		pBatch = nullptr;
+	}
+
+	if( pBatch == nullptr )
+		Actor::SetGlobalRenderStates(); // set Actor-specified render states
 
 	RectF crop = state->crop;
 	// bail if cropped all the way
@@ -577,14 +602,6 @@ void Sprite::DrawTexture( const TweenState *state )
 		}
 	}
 
-	DISPLAY->ClearAllTextures();
-	DISPLAY->SetTexture( TextureUnit_1, m_pTexture? m_pTexture->GetTexHandle():0 );
-
-	// Must call this after setting the texture or else texture
-	// parameters have no effect.
-	Actor::SetTextureRenderStates(); // set Actor-specified render states
-	DISPLAY->SetEffectMode( m_EffectMode );
-
 	if( m_pTexture )
 	{
 		float f[8];
@@ -627,6 +644,35 @@ void Sprite::DrawTexture( const TweenState *state )
 			v[i].t.x = v[i].t.y = 0;
 	}
 
+	if( pBatch != nullptr )
+	{
+		if( state->diffuse[0].a > 0 ||
+			state->diffuse[1].a > 0 ||
+			state->diffuse[2].a > 0 ||
+			state->diffuse[3].a > 0 )
+		{
+			v[0].c = state->diffuse[0]; // top left
+			v[1].c = state->diffuse[2]; // bottom left
+			v[2].c = state->diffuse[3]; // bottom right
+			v[3].c = state->diffuse[1]; // top right
+			pBatch->AddDiffuse( m_pTexture->GetTexHandle(), v );
+		}
+		if( state->glow.a > 0.0001f )
+		{
+			v[0].c = v[1].c = v[2].c = v[3].c = state->glow;
+			pBatch->AddGlow( m_pTexture->GetTexHandle(), v );
+		}
+		return;
+	}
+
+	DISPLAY->ClearAllTextures();
+	DISPLAY->SetTexture( TextureUnit_1, m_pTexture? m_pTexture->GetTexHandle():0 );
+
+	// Must call this after setting the texture or else texture
+	// parameters have no effect.
+	Actor::SetTextureRenderStates(); // set Actor-specified render states
+	DISPLAY->SetEffectMode( m_EffectMode );
+
 	// Draw if we're not fully transparent
 	if( state->diffuse[0].a > 0 ||
 		state->diffuse[1].a > 0 ||
@@ -886,10 +932,12 @@ void Sprite::SetCustomTextureCoords( float fTexCoords[8] ) // order: top left, b
 void Sprite::SetCustomImageRect( RectF rectImageCoords )
 {
 	// Convert to a rectangle in texture coordinate space.
-	rectImageCoords.left	*= m_pTexture->GetImageWidth()	/ (float)m_pTexture->GetTextureWidth();
-	rectImageCoords.right	*= m_pTexture->GetImageWidth()	/ (float)m_pTexture->GetTextureWidth();
-	rectImageCoords.top	*= m_pTexture->GetImageHeight()	/ (float)m_pTexture->GetTextureHeight();
-	rectImageCoords.bottom	*= m_pTexture->GetImageHeight()	/ (float)m_pTexture->GetTextureHeight();
+	const float fOffsetX = m_pTexture->GetImageOffsetX() / (float)m_pTexture->GetTextureWidth();
+	const float fOffsetY = m_pTexture->GetImageOffsetY() / (float)m_pTexture->GetTextureHeight();
+	rectImageCoords.left	= rectImageCoords.left * m_pTexture->GetImageWidth() / (float)m_pTexture->GetTextureWidth() + fOffsetX;
+	rectImageCoords.right	= rectImageCoords.right * m_pTexture->GetImageWidth() / (float)m_pTexture->GetTextureWidth() + fOffsetX;
+	rectImageCoords.top	= rectImageCoords.top * m_pTexture->GetImageHeight() / (float)m_pTexture->GetTextureHeight() + fOffsetY;
+	rectImageCoords.bottom	= rectImageCoords.bottom * m_pTexture->GetImageHeight() / (float)m_pTexture->GetTextureHeight() + fOffsetY;
 
 	SetCustomTextureRect( rectImageCoords );
 }
@@ -897,10 +945,12 @@ void Sprite::SetCustomImageRect( RectF rectImageCoords )
 void Sprite::SetCustomImageCoords( float fImageCoords[8] )	// order: top left, bottom left, bottom right, top right
 {
 	// convert image coords to texture coords in place
+	const float fOffsetX = m_pTexture->GetImageOffsetX() / (float)m_pTexture->GetTextureWidth();
+	const float fOffsetY = m_pTexture->GetImageOffsetY() / (float)m_pTexture->GetTextureHeight();
 	for( int i=0; i<8; i+=2 )
 	{
-		fImageCoords[i+0] *= m_pTexture->GetImageWidth()	/ (float)m_pTexture->GetTextureWidth();
-		fImageCoords[i+1] *= m_pTexture->GetImageHeight()	/ (float)m_pTexture->GetTextureHeight();
+		fImageCoords[i+0] = fImageCoords[i+0] * m_pTexture->GetImageWidth() / (float)m_pTexture->GetTextureWidth() + fOffsetX;
+		fImageCoords[i+1] = fImageCoords[i+1] * m_pTexture->GetImageHeight() / (float)m_pTexture->GetTextureHeight() + fOffsetY;
 	}
 
 	SetCustomTextureCoords( fImageCoords );
@@ -109,6 +109,9 @@ private:
 	void LoadStatesFromTexture();
 
 	void DrawTexture( const TweenState *state );
+	/* Whether this sprite can go into a SpriteBatch: it must use only the
+	 * render states the batch draws with. */
+	bool CanBatch() const;
 
 	RageTexture* m_pTexture;
 
@@ -0,0 +1,126 @@
+#include "global.h"
+#include "SpriteBatch.h"
+#include "RageDisplay.h"
+#include "RageMath.h"
+
+SpriteBatch *SpriteBatch::s_pCollecting = nullptr;
+
+void SpriteBatch::Open()
+{
+	ASSERT( !m_bOpen );
+	m_bOpen = true;
+}
+
+void SpriteBatch::StartCollecting()
+{
+	ASSERT( m_bOpen );
+	ASSERT( s_pCollecting == nullptr );
+	s_pCollecting = this;
+}
+
+void SpriteBatch::StopCollecting()
+{
+	ASSERT( s_pCollecting == this );
+	s_pCollecting = nullptr;
+}
+
+SpriteBatch::Layer &SpriteBatch::GetLayer( std::uintptr_t iTexture, bool bGlow )
+{
+	/* Only join the last layer, so nothing is drawn over something that was
+	 * collected after it.  A layer's glow is drawn after all of its diffuse,
+	 * so a diffuse quad can't join a layer that already has glow. */
+	if( m_iUsedLayers != 0 )
+	{
+		Layer &last = m_Layers[m_iUsedLayers-1];
+		if( last.m_iTexture == iTexture && (bGlow || last.m_vGlow.empty()) )
+			return last;
+	}
+
+	if( m_iUsedLayers == m_Layers.size() )
+		m_Layers.push_back( Layer() );
+	Layer &layer = m_Layers[m_iUsedLayers++];
+	layer.m_iTexture = iTexture;
+	return layer;
+}
+
+void SpriteBatch::AddQuad( std::vector<RageSpriteVertex> &vOut, const RageSpriteVertex v[4] )
+{
+	const RageMatrix *pWorld = DISPLAY->GetWorldTop();
+	const RageMatrix *pTexture = DISPLAY->GetTextureTop();
+	for( int i = 0; i < 4; ++i )
+	{
+		RageSpriteVertex vert = v[i];
+		RageVec3TransformCoord( &vert.p, &v[i].p, pWorld );
+
+		RageVector3 t( v[i].t.x, v[i].t.y, 0 );
+		RageVec3TransformCoord( &t, &t, pTexture );
+		vert.t = RageVector2( t.x, t.y );
+
+		vOut.push_back( vert );
+	}
+}
+
+void SpriteBatch::AddDiffuse( std::uintptr_t iTexture, const RageSpriteVertex v[4] )
+{
+	AddQuad( GetLayer(iTexture, false).m_vDiffuse, v );
+}
+
+void SpriteBatch::AddGlow( std::uintptr_t iTexture, const RageSpriteVertex v[4] )
+{
+	AddQuad( GetLayer(iTexture, true).m_vGlow, v );
+}
+
+void SpriteBatch::Draw()
+{
+	ASSERT( s_pCollecting == nullptr );
+	Flush();
+	m_bOpen = false;
+}
+
+void SpriteBatch::Flush()
+{
+	ASSERT( m_bOpen );
+
+	if( m_iUsedLayers == 0 )
+		return;
+
+	/* The quads are already in world space, and their texture coordinates
+	 * already have the texture matrix applied.  We may be flushed from under
+	 * a texture translate, like a noteskin part's color offset, so don't
+	 * apply it again. */
+	DISPLAY->PushMatrix();
+	DISPLAY->LoadIdentity();
+	DISPLAY->TexturePushMatrix();
+	DISPLAY->TextureLoadIdentity();
+
+	/* The states every batched sprite had; see Sprite::CanBatch. */
+	DISPLAY->SetBlendMode( BLEND_NORMAL );
+	DISPLAY->SetZWrite( false );
+	DISPLAY->SetZTestMode( ZTEST_OFF );
+	DISPLAY->SetZBias( 0 );
+	DISPLAY->SetCullMode( CULL_NONE );
+
+	for( unsigned i = 0; i < m_iUsedLayers; ++i )
+	{
+		Layer &layer = m_Layers[i];
+
+		DISPLAY->ClearAllTextures();
+		DISPLAY->SetTexture( TextureUnit_1, layer.m_iTexture );
+		DISPLAY->SetTextureWrapping( TextureUnit_1, false );
+		DISPLAY->SetTextureFiltering( TextureUnit_1, true );
+		DISPLAY->SetEffectMode( EffectMode_Normal );
+
+		DISPLAY->SetTextureMode( TextureUnit_1, TextureMode_Modulate );
+		DISPLAY->DrawQuads( layer.m_vDiffuse.data(), layer.m_vDiffuse.size() );
+
+		DISPLAY->SetTextureMode( TextureUnit_1, TextureMode_Glow );
+		DISPLAY->DrawQuads( layer.m_vGlow.data(), layer.m_vGlow.size() );
+
+		layer.m_vDiffuse.clear();
+		layer.m_vGlow.clear();
+	}
+	m_iUsedLayers = 0;
+
+	DISPLAY->TexturePopMatrix();
+	DISPLAY->PopMatrix();
+}
@@ -0,0 +1,61 @@
+/* SpriteBatch - Collect sprite quads and draw them a texture at a time. */
+
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include "RageTypes.h"
+
+#include <cstdint>
+#include <vector>
+
+/* While a batch is collecting, Sprite::DrawTexture hands it the quads of any
+ * sprite that only uses the default render states, instead of drawing them.
+ * Quads are kept in world space, so sprites under different transforms can
+ * share a draw call.  Runs of quads with the same texture are drawn in one
+ * call, and the runs in the order they were collected, so the result looks
+ * the same as drawing each sprite in turn.
+ *
+ * Quads are only drawn at Flush or Draw, so Flush before drawing anything
+ * directly while the batch is open, or it'll end up underneath. */
+class SpriteBatch
+{
+public:
+	SpriteBatch(): m_iUsedLayers(0), m_bOpen(false) { }
+
+	/* Start a batch. */
+	void Open();
+	/* Draw everything collected so far, and keep collecting. */
+	void Flush();
+	/* Flush, and close the batch. */
+	void Draw();
+	bool IsOpen() const { return m_bOpen; }
+
+	/* Collect sprite quads between these. */
+	void StartCollecting();
+	void StopCollecting();
+	static SpriteBatch *GetCollecting() { return s_pCollecting; }
+
+	/* v is in the current world space, upper-left, lower-left, lower-right,
+	 * upper-right, as in Sprite::DrawTexture. */
+	void AddDiffuse( std::uintptr_t iTexture, const RageSpriteVertex v[4] );
+	void AddGlow( std::uintptr_t iTexture, const RageSpriteVertex v[4] );
+
+private:
+	struct Layer
+	{
+		std::uintptr_t m_iTexture;
+		std::vector<RageSpriteVertex> m_vDiffuse;
+		std::vector<RageSpriteVertex> m_vGlow;
+	};
+	Layer &GetLayer( std::uintptr_t iTexture, bool bGlow );
+	static void AddQuad( std::vector<RageSpriteVertex> &vOut, const RageSpriteVertex v[4] );
+
+	/* Layers stay allocated between frames; m_iUsedLayers are in use. */
+	std::vector<Layer> m_Layers;
+	unsigned m_iUsedLayers;
+	bool m_bOpen;
+
+	static SpriteBatch *s_pCollecting;
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include "RageLog.h"
 #include "RageTextureManager.h"
 #include "RageSoundManager.h"
+#include "RageSoundPCMCache.h"
 #include "GameSoundManager.h"
 #include "RageInput.h"
 #include "RageTimer.h"
@@ -29,6 +30,7 @@
 #include "RageSurface.h"
 #include "RageSurface_Load.h"
 #include "CommandLineActions.h"
+#include "GameplayBenchmark.h"
 
 #if !defined(SUPPORT_OPENGL) && !defined(SUPPORT_D3D)
 #define SUPPORT_OPENGL
@@ -317,6 +319,7 @@ void ShutdownGame()
 	SAFE_DELETE( IMAGECACHE );
 	SAFE_DELETE( SONGINDEX );
 	SAFE_DELETE( SOUND ); // uses GAMESTATE, PREFSMAN
+	SAFE_DELETE( PCMCACHE );
 	SAFE_DELETE( PREFSMAN );
 	SAFE_DELETE( GAMESTATE );
 	SAFE_DELETE( GAMEMAN );
@@ -920,6 +923,9 @@ int sm_main(int argc, char* argv[])
 	PREFSMAN->ReadPrefsFromDisk();
 	ApplyLogPreferences();
 
+	if( GameplayBenchmark::IsActive() )
+		GameplayBenchmark::ApplyPreferences();
+
 	// This needs PREFSMAN.
 	Dialog::Init();
 
@@ -981,6 +987,7 @@ int sm_main(int argc, char* argv[])
 	SOUNDMAN	= new RageSoundManager;
 	SOUNDMAN->Init();
 	SOUNDMAN->SetMixVolume();
+	PCMCACHE	= new RageSoundPCMCache;
 	SOUND		= new GameSoundManager;
 	BOOKKEEPER	= new Bookkeeper;
 	LIGHTSMAN	= new LightsManager;
@@ -1042,7 +1049,10 @@ int sm_main(int argc, char* argv[])
 	/* Now that GAMESTATE is reset, tell SCREENMAN to update the theme (load
 	 * overlay screens and global sounds), and load the initial screen. */
 	SCREENMAN->ThemeChanged();
-	SCREENMAN->SetNewScreen( StepMania::GetInitialScreen() );
+	if( GameplayBenchmark::IsActive() )
+		GameplayBenchmark::Start();
+	else
+		SCREENMAN->SetNewScreen( StepMania::GetInitialScreen() );
 
 	// Do this after ThemeChanged so that we can show a system message
 	RString sMessage;
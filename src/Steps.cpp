@@ -21,6 +21,8 @@
 #include "NoteData.h"
 #include "GameManager.h"
 #include "SongManager.h"
+#include "SongCacheIndex.h"
+#include "SongCacheBinary.h"
 #include "NoteDataUtil.h"
 #include "NotesLoaderSSC.h"
 #include "NotesLoaderSM.h"
@@ -28,9 +30,12 @@
 #include "NotesLoaderDWI.h"
 #include "NotesLoaderKSF.h"
 #include "NotesLoaderBMS.h"
+#include "Preference.h"
+#include "RageThreads.h"
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 /* register DisplayBPM with StringConversion */
@@ -48,9 +53,37 @@ static const char *DisplayBPMNames[] =
 XToString( DisplayBPM );
 LuaXType( DisplayBPM );
 
+/* Charts that have their notes parsed into NoteData, least recently used first.
+ * Only charts that can load their notes again from the song cache or their
+ * simfile are listed.  Once there are more than MaxResidentNoteData of them, the
+ * oldest are compressed, so memory use stays flat however big the library is.
+ * Values less than 1 disable the limit. */
+static Preference<int> g_iMaxResidentNoteData( "MaxResidentNoteData", 32 );
+static RageMutex g_ResidentNoteDataLock( "ResidentNoteData" );
+static std::vector<const Steps *> g_vpResidentNoteData;
+
+/* Song loading threads parse charts too, but compress them again before the song
+ * is handed over.  Only charts used from the main thread are listed, so we never
+ * compress notes another thread is reading.  (Statics are constructed on the
+ * main thread.) */
+static const std::uint64_t g_iResidentNoteDataThreadID = RageThread::GetCurrentThreadID();
+
+/* The radar calculation reads timing through GAMESTATE->GetProcessedTimingData,
+ * which is shared by every thread, so song loading threads take turns. */
+static RageMutex g_ProcessedTimingLock( "StepsProcessedTiming" );
+
+static void ForgetResidentNoteData( const Steps *pSteps )
+{
+	LockMut( g_ResidentNoteDataLock );
+	auto it = std::find( g_vpResidentNoteData.begin(), g_vpResidentNoteData.end(), pSteps );
+	if( it != g_vpResidentNoteData.end() )
+		g_vpResidentNoteData.erase( it );
+}
+
 Steps::Steps(Song *song): m_StepsType(StepsType_Invalid), m_pSong(song),
 	parent(nullptr), m_pNoteData(new NoteData), m_bNoteDataIsFilled(false),
-	m_sNoteDataCompressed(""), m_sFilename(""), m_bSavedToDisk(false),
+	m_sNoteDataCompressed(""), m_sFilename(""), m_iCacheNoteDataIndex(-1),
+	m_bSavedToDisk(false),
 	m_LoadedFromProfile(ProfileSlot_Invalid), m_iHash(0),
 	m_sDescription(""), m_sChartStyle(""),
 	m_Difficulty(Difficulty_Invalid), m_iMeter(0),
@@ -60,6 +93,7 @@ Steps::Steps(Song *song): m_StepsType(StepsType_Invalid), m_pSong(song),
 
 Steps::~Steps()
 {
+	ForgetResidentNoteData( this );
 }
 
 void Steps::GetDisplayBpms( DisplayBpms &AddTo ) const
@@ -92,13 +126,64 @@ unsigned Steps::GetHash() const
 	if( m_sNoteDataCompressed.empty() )
 	{
 		if( !m_bNoteDataIsFilled )
-			return 0; // No data, no hash.
+		{
+			/* Charts loaded from the song cache have their hash cached, so we
+			 * only get here if that's out of date.  Load the notes just long
+			 * enough to hash them. */
+			if( !CanReloadNoteData() )
+				return 0; // No data, no hash.
+			Decompress();
+			if( !m_bNoteDataIsFilled )
+				return 0;
+			RString sNoteData;
+			NoteDataUtil::GetSMNoteDataString( *m_pNoteData, sNoteData );
+			m_iHash = GetHashForString( sNoteData );
+			Compress();
+			return m_iHash;
+		}
 		NoteDataUtil::GetSMNoteDataString( *m_pNoteData, m_sNoteDataCompressed );
 	}
 	m_iHash = GetHashForString( m_sNoteDataCompressed );
 	return m_iHash;
 }
 
+bool Steps::CanReloadNoteData() const
+{
+	return parent == nullptr && !m_sFilename.empty() &&
+		m_LoadedFromProfile == ProfileSlot_Invalid &&
+		m_StepsType != StepsType_lights_cabinet;
+}
+
+void Steps::TouchResidentNoteData() const
+{
+	if( RageThread::GetCurrentThreadID() != g_iResidentNoteDataThreadID || !CanReloadNoteData() )
+		return;
+
+	std::vector<const Steps *> vpEvict;
+	{
+		LockMut( g_ResidentNoteDataLock );
+		auto it = std::find( g_vpResidentNoteData.begin(), g_vpResidentNoteData.end(), this );
+		if( it != g_vpResidentNoteData.end() )
+			g_vpResidentNoteData.erase( it );
+		g_vpResidentNoteData.push_back( this );
+
+		// The editor holds on to its charts; Compress() wouldn't free them anyway.
+		const int iMax = g_iMaxResidentNoteData;
+		if( iMax < 1 || GAMESTATE->m_bInStepEditor )
+			return;
+
+		const int iExtra = int(g_vpResidentNoteData.size()) - iMax;
+		if( iExtra > 0 )
+		{
+			vpEvict.assign( g_vpResidentNoteData.begin(), g_vpResidentNoteData.begin() + iExtra );
+			g_vpResidentNoteData.erase( g_vpResidentNoteData.begin(), g_vpResidentNoteData.begin() + iExtra );
+		}
+	}
+
+	for( const Steps *pSteps : vpEvict )
+		pSteps->Compress();
+}
+
 bool Steps::IsNoteDataEmpty() const
 {
 	return this->m_sNoteDataCompressed.empty();
@@ -173,6 +258,28 @@ bool Steps::GetNoteDataFromSimfile()
 	return false;
 }
 
+bool Steps::GetNoteDataFromCache() const
+{
+	if( m_iCacheNoteDataIndex == -1 || m_pSong == nullptr )
+		return false;
+
+	RString sPacked;
+	if( !SONGINDEX->GetCachedNoteData(m_pSong->GetSongDir(), m_iCacheNoteDataIndex, sPacked) )
+		return false;
+
+	m_pNoteData->SetNumTracks( GAMEMAN->GetStepsTypeInfo(m_StepsType).iNumTracks );
+	if( !SongCacheBinary::ReadNoteData(sPacked.data(), sPacked.size(), *m_pNoteData) )
+	{
+		LOG->Warn( "The song cache's notes for the %s chart of \"%s\" are damaged.",
+			DifficultyToString(m_Difficulty).c_str(), m_pSong->GetSongDir().c_str() );
+		m_pNoteData->Init();
+		return false;
+	}
+
+	m_bNoteDataIsFilled = true;
+	return true;
+}
+
 void Steps::SetNoteData( const NoteData& noteDataNew )
 {
 	ASSERT( noteDataNew.GetNumTracks() == GAMEMAN->GetStepsTypeInfo(m_StepsType).iNumTracks );
@@ -184,6 +291,7 @@ void Steps::SetNoteData( const NoteData& noteDataNew )
 
 	m_sNoteDataCompressed = RString();
 	m_iHash = 0;
+	ChartKey = RString();
 }
 
 void Steps::GetNoteData( NoteData& noteDataOut ) const
@@ -192,6 +300,7 @@ void Steps::GetNoteData( NoteData& noteDataOut ) const
 
 	if( m_bNoteDataIsFilled )
 	{
+		TouchResidentNoteData();
 		noteDataOut = *m_pNoteData;
 	}
 	else
@@ -208,13 +317,14 @@ NoteData Steps::GetNoteData() const
 	return tmp;
 }
 
-void Steps::SetSMNoteData( const RString &notes_comp_ )
+void Steps::SetSMNoteData( std::string_view notes_comp_ )
 {
 	m_pNoteData->Init();
 	m_bNoteDataIsFilled = false;
 
-	m_sNoteDataCompressed = notes_comp_;
+	m_sNoteDataCompressed.assign( notes_comp_.data(), notes_comp_.size() );
 	m_iHash = 0;
+	ChartKey = RString();
 }
 
 /* XXX: this function should pull data from m_sFilename, like Decompress() */
@@ -318,9 +428,13 @@ void Steps::CalculateRadarValues( float fMusicLengthSeconds )
 	NoteData tempNoteData;
 	this->GetNoteData( tempNoteData );
 
+	NoteDataUtil::CalculateDensity( tempNoteData, *GetTimingData(), m_Density );
+	ChartKey = GenerateChartKey( tempNoteData, *GetTimingData() );
+
 	FOREACH_PlayerNumber( pn )
 		m_CachedRadarValues[pn].Zero();
 
+	LockMut( g_ProcessedTimingLock );
 	GAMESTATE->SetProcessedTimingData(this->GetTimingData());
 	if( tempNoteData.IsComposite() )
 	{
@@ -419,7 +533,11 @@ void Steps::Decompress()
 
 	if( !m_sFilename.empty() && m_sNoteDataCompressed.empty() )
 	{
-		// We have NoteData on disk and not in memory. Load it.
+		// We have NoteData on disk and not in memory. Load it, from the
+		// song cache if we can, since that needs no parsing.
+		if( GetNoteDataFromCache() )
+			return;
+
 		if (!this->GetNoteDataFromSimfile())
 		{
 			LOG->Warn("Couldn't load the %s chart's NoteData from \"%s\"",
@@ -467,6 +585,8 @@ void Steps::Compress() const
 		 * the device), and when we start a game and load edits, we want to be
 		 * sure that it'll be available if the user picks it and pulls the device.
 		 * Also, Decompress() doesn't know how to load .edits. */
+		if( m_bNoteDataIsFilled )
+			ForgetResidentNoteData( this );
 		m_pNoteData->Init();
 		m_bNoteDataIsFilled = false;
 
@@ -503,6 +623,7 @@ void Steps::DeAutogen( bool bCopyNoteData )
 	m_Difficulty		= Real()->m_Difficulty;
 	m_iMeter		= Real()->m_iMeter;
 	std::copy( Real()->m_CachedRadarValues, Real()->m_CachedRadarValues + NUM_PLAYERS, m_CachedRadarValues );
+	m_Density		= Real()->m_Density;
 	m_sCredit		= Real()->m_sCredit;
 	parent = nullptr;
 
@@ -631,74 +752,46 @@ void Steps::SetCachedRadarValues( const RadarValues v[NUM_PLAYERS] )
 	m_bAreCachedRadarValuesJustLoaded = true;
 }
 
+void Steps::SetCachedDensity( const ChartDensity &density )
+{
+	DeAutogen();
+	m_Density = density;
+}
+
 RString Steps::GenerateChartKey()
 {
-	ChartKey = this->GenerateChartKey(*m_pNoteData, this->GetTimingData());
+	ChartKey = GenerateChartKey( GetNoteData(), *GetTimingData() );
 	return ChartKey;
 }
 RString Steps::GetChartKey()
 {
-	if (ChartKey.empty()) {
-		this->Decompress();
-		ChartKey = this->GenerateChartKey(*m_pNoteData, this->GetTimingData());
-		this->Compress();
-	}
+	if( ChartKey.empty() )
+		GenerateChartKey();
 	return ChartKey;
 }
-RString Steps::GenerateChartKey(NoteData &nd, TimingData *td)
+RString Steps::GenerateChartKey( const NoteData &nd, const TimingData &td )
 {
-	RString k = "";
-	RString o = "";
-	float bpm;
-	nd.LogNonEmptyRows();
-	std::vector<int>& nerv = nd.GetNonEmptyRowVector();
-
+	std::vector<int> viRows;
+	FOREACH_NONEMPTY_ROW_ALL_TRACKS( nd, row )
+		viRows.push_back( row );
 
-	RString firstHalf = "";
-	RString secondHalf = "";
-
-#pragma omp parallel sections
+	/* Keys are compared against ones generated by other builds, so the layout
+	 * must stay as it always was: the notes of the first half of the rows with
+	 * each row's BPM after it, then the BPMs of the second half, then its
+	 * notes.  Every TapNoteType is a single digit. */
+	RString sFirstHalf, sSecondHalf;
+	const std::size_t iHalf = viRows.size() / 2;
+	for( std::size_t r = 0; r < viRows.size(); ++r )
 	{
-#pragma omp section
-		{
-			for (std::size_t r = 0; r < nerv.size() / 2; r++) {
-				int row = nerv[r];
-				for (int t = 0; t < nd.GetNumTracks(); ++t) {
-					const TapNote &tn = nd.GetTapNote(t, row);
-					std::ostringstream os;
-					os << tn.type;
-					firstHalf.append(os.str());
-				}
-				bpm = td->GetBPMAtRow(row);
-				std::ostringstream os;
-				os << static_cast<int>(bpm + 0.374643f);
-				firstHalf.append(os.str());
-			}
-		}
-
-#pragma omp section
-		{
-			for (std::size_t r = nerv.size() / 2; r < nerv.size(); r++) {
-				int row = nerv[r];
-				for (int t = 0; t < nd.GetNumTracks(); ++t) {
-					const TapNote &tn = nd.GetTapNote(t, row);
-					std::ostringstream os;
-					os << tn.type;
-					secondHalf.append(os.str());
-				}
-				bpm = td->GetBPMAtRow(row);
-				std::ostringstream os;
-				os << static_cast<int>(bpm + 0.374643f);
-				firstHalf.append(os.str());
-			}
-		}
+		const int row = viRows[r];
+		RString &sNotes = r < iHalf? sFirstHalf:sSecondHalf;
+		for( int t = 0; t < nd.GetNumTracks(); ++t )
+			sNotes += char( '0' + nd.GetTapNote(t, row).type );
+		sFirstHalf += ssprintf( "%d", static_cast<int>(td.GetBPMAtRow(row) + 0.374643f) );
 	}
-	k = firstHalf + secondHalf;
 
-	//ChartKeyRecord = k;
-	o.append("X");	// I was thinking of using "C" to indicate chart.. however.. X is cooler... - Mina
-	o.append(BinaryToHex(CryptManager::GetSHA1ForString(k)));
-	return o;
+	// I was thinking of using "C" to indicate chart.. however.. X is cooler... - Mina
+	return "X" + BinaryToHex( CryptManager::GetSHA1ForString(sFirstHalf + sSecondHalf) );
 }
 
 
@@ -746,6 +839,36 @@ public:
 		return 1;
 	}
 	static int GetHash( T* p, lua_State *L ) { lua_pushnumber( L, p->GetHash() ); return 1; }
+	static int GetChartKey( T* p, lua_State *L ) { lua_pushstring( L, p->GetChartKey() ); return 1; }
+	static int GetNotesPerMeasure( T* p, lua_State *L )
+	{
+		LuaHelpers::CreateTableFromArray( p->GetDensity().m_viNotesPerMeasure, L );
+		return 1;
+	}
+	static int GetNPSPerMeasure( T* p, lua_State *L )
+	{
+		LuaHelpers::CreateTableFromArray( p->GetDensity().m_vfNPSPerMeasure, L );
+		return 1;
+	}
+	DEFINE_METHOD( GetPeakNPS, GetDensity().m_fPeakNPS )
+	static int GetStreamBreakdown( T* p, lua_State *L )
+	{
+		const std::vector<ChartDensity::Run> &vRuns = p->GetDensity().m_vRuns;
+		lua_createtable( L, vRuns.size(), 0 );
+		for( unsigned i = 0; i < vRuns.size(); ++i )
+		{
+			lua_createtable( L, 0, 3 );
+			lua_pushboolean( L, vRuns[i].m_bStream );
+			lua_setfield( L, -2, "IsStream" );
+			// Measures are numbered from 1 on the Lua side, like everything else.
+			lua_pushinteger( L, vRuns[i].m_iFirstMeasure + 1 );
+			lua_setfield( L, -2, "FirstMeasure" );
+			lua_pushinteger( L, vRuns[i].m_iNumMeasures );
+			lua_setfield( L, -2, "NumMeasures" );
+			lua_rawseti( L, -2, i+1 );
+		}
+		return 1;
+	}
 	// untested
 	/*
 	static int GetSMNoteData( T* p, lua_State *L )
@@ -807,6 +930,11 @@ public:
 		ADD_METHOD( GetDifficulty );
 		ADD_METHOD( GetFilename );
 		ADD_METHOD( GetHash );
+		ADD_METHOD( GetChartKey );
+		ADD_METHOD( GetNotesPerMeasure );
+		ADD_METHOD( GetNPSPerMeasure );
+		ADD_METHOD( GetPeakNPS );
+		ADD_METHOD( GetStreamBreakdown );
 		ADD_METHOD( GetMeter );
 		ADD_METHOD( HasSignificantTimingChanges );
 		ADD_METHOD( HasAttacks );
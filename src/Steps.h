@@ -6,10 +6,12 @@
 #include "PlayerNumber.h"
 #include "Grade.h"
 #include "RadarValues.h"
+#include "ChartDensity.h"
 #include "Difficulty.h"
 #include "RageUtil_AutoPtr.h"
 #include "TimingData.h"
 
+#include <string_view>
 #include <vector>
 
 
@@ -102,6 +104,8 @@ public:
 	 */
 	int GetMeter() const				{ return Real()->m_iMeter; }
 	const RadarValues& GetRadarValues( PlayerNumber pn ) const { return Real()->m_CachedRadarValues[pn]; }
+	/** @brief Retrieve the per-measure density, calculated along with the radar values. */
+	const ChartDensity& GetDensity() const		{ return Real()->m_Density; }
 	/**
 	 * @brief Retrieve the author credit used for this edit.
 	 * @return the author credit used for this edit.
@@ -117,6 +121,8 @@ public:
 	void SetChartName(const RString name)		{ this->chartName = name; }
 	void SetFilename( RString fn )			{ m_sFilename = fn; }
 	RString GetFilename() const			{ return m_sFilename; }
+	/** @brief Where the song cache keeps these Steps' packed notes, or -1 if it doesn't. */
+	void SetCacheNoteDataIndex( int i )		{ m_iCacheNoteDataIndex = i; }
 	void SetSavedToDisk( bool b )			{ DeAutogen(); m_bSavedToDisk = b; }
 	bool GetSavedToDisk() const			{ return Real()->m_bSavedToDisk; }
 	void SetDifficulty( Difficulty dc )		{ SetDifficultyAndDescription( dc, GetDescription() ); }
@@ -128,8 +134,12 @@ public:
 
 	/* This is a reimplementation of the lua version of the script to generate chart keys, except this time
 	using the notedata stored in game memory immediately after reading it than parsing it using lua. - Mina */
-	RString GenerateChartKey(NoteData &nd, TimingData *td);
+	static RString GenerateChartKey( const NoteData &nd, const TimingData &td );
 	RString GenerateChartKey();
+	/* Chart keys are worked out with the radar values, which happens on the
+	 * song loading threads, and kept in the song cache.  Only charts that
+	 * never went through CalculateRadarValues, like autogen charts, are
+	 * hashed when they're asked for. */
 	RString ChartKey;
 	RString GetChartKey();
 	void SetChartKey(const RString &k) { ChartKey = k; }
@@ -139,13 +149,16 @@ public:
 	void SetLoadedFromProfile( ProfileSlot slot )	{ m_LoadedFromProfile = slot; }
 	void SetMeter( int meter );
 	void SetCachedRadarValues( const RadarValues v[NUM_PLAYERS] );
+	void SetCachedDensity( const ChartDensity &density );
 	float PredictMeter() const;
 
 	unsigned GetHash() const;
+	/** @brief Restore a hash saved in the song cache, so GetHash needn't load the notes. */
+	void SetCachedHash( unsigned iHash )		{ m_iHash = iHash; }
 	void GetNoteData( NoteData& noteDataOut ) const;
 	NoteData GetNoteData() const;
 	void SetNoteData( const NoteData& noteDataNew );
-	void SetSMNoteData( const RString &notes_comp );
+	void SetSMNoteData( std::string_view notes_comp );
 	void GetSMNoteData( RString &notes_comp_out ) const;
 
 	/**
@@ -153,6 +166,11 @@ public:
 	 * @return true if successful, false for failure. */
 	bool GetNoteDataFromSimfile();
 
+	/**
+	 * @brief Retrieve the NoteData from the packed copy in the song cache.
+	 * @return true if successful, false if it has to come from the simfile. */
+	bool GetNoteDataFromCache() const;
+
 	/**
 	 * @brief Determine if we are missing any note data.
 	 *
@@ -214,6 +232,10 @@ public:
 private:
 	inline const Steps *Real() const		{ return parent ? parent : this; }
 	void DeAutogen( bool bCopyNoteData = true ); /* If this Steps is autogenerated, make it a real Steps. */
+	/* Whether Compress() can drop our NoteData and Decompress() load it again. */
+	bool CanReloadNoteData() const;
+	/* Mark our NoteData as just used, compressing charts that haven't been. */
+	void TouchResidentNoteData() const;
 
 	/**
 	 * @brief Identify this Steps' parent.
@@ -231,6 +253,8 @@ private:
 
 	/** @brief The name of the file where these steps are stored. */
 	RString				m_sFilename;
+	/** @brief The index of these steps' notes in the song cache entry, or -1. */
+	int				m_iCacheNoteDataIndex;
 	/** @brief true if these Steps were loaded from or saved to disk. */
 	bool				m_bSavedToDisk;
 	/** @brief allows the steps to specify their own music file. */
@@ -253,6 +277,8 @@ private:
 	/** @brief The radar values used for each player. */
 	RadarValues			m_CachedRadarValues[NUM_PLAYERS];
 	bool                m_bAreCachedRadarValuesJustLoaded;
+	/** @brief Notes per measure and stream runs, kept in the song cache with the radar values. */
+	ChartDensity			m_Density;
 	/** @brief The name of the person who created the Steps. */
 	RString				m_sCredit;
 	/** @brief The name of the chart. */
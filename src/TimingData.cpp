@@ -4,9 +4,11 @@
 #include "GameState.h"
 #include "RageUtil.h"
 #include "RageLog.h"
+#include "RageThreads.h"
 #include "ThemeManager.h"
 #include "NoteTypes.h"
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
 #include <cstddef>
@@ -18,10 +20,14 @@ static const int INVALID_INDEX = -1;
 
 TimingSegment* GetSegmentAtRow( int iNoteRow, TimingSegmentType tst );
 
-TimingData::TimingData(float fOffset) : m_fBeat0OffsetInSeconds(fOffset)
+TimingData::TimingData(float fOffset) : m_fBeat0OffsetInSeconds(fOffset),
+	m_bLookupValid(false)
 {
 }
 
+/* Only taken while a lookup table is being built. */
+static RageMutex g_LookupLock( "TimingDataLookup" );
+
 void TimingData::Copy( const TimingData& cpy )
 {
 	/* de-allocate any old pointers we had */
@@ -52,24 +58,24 @@ void TimingData::Clear()
 
 		vSegs.clear();
 	}
+	InvalidateLookup();
 }
 
 bool TimingData::IsSafeFullTiming()
 {
-	static std::vector<TimingSegmentType> needed_segments;
-	if(needed_segments.empty())
-	{
-		needed_segments.push_back(SEGMENT_BPM);
-		needed_segments.push_back(SEGMENT_TIME_SIG);
-		needed_segments.push_back(SEGMENT_TICKCOUNT);
-		needed_segments.push_back(SEGMENT_COMBO);
-		needed_segments.push_back(SEGMENT_LABEL);
-		needed_segments.push_back(SEGMENT_SPEED);
-		needed_segments.push_back(SEGMENT_SCROLL);
-	}
-	for(std::size_t s= 0; s < needed_segments.size(); ++s)
+	// Songs are loaded from several threads, so this can't be filled in lazily.
+	static const TimingSegmentType needed_segments[] = {
+		SEGMENT_BPM,
+		SEGMENT_TIME_SIG,
+		SEGMENT_TICKCOUNT,
+		SEGMENT_COMBO,
+		SEGMENT_LABEL,
+		SEGMENT_SPEED,
+		SEGMENT_SCROLL
+	};
+	for(TimingSegmentType tst : needed_segments)
 	{
-		if(m_avpTimingSegments[needed_segments[s]].empty())
+		if(m_avpTimingSegments[tst].empty())
 		{
 			return false;
 		}
@@ -82,12 +88,27 @@ TimingData::~TimingData()
 	Clear();
 }
 
-void TimingData::PrepareLookup()
+void TimingData::PrepareLookup() const
 {
-	// If multiple players have the same timing data, then adding to the
-	// lookups would probably cause FindEntryInLookup to return the wrong
-	// thing.  So release the lookups. -Kyz
-	ReleaseLookup();
+	if(m_bLookupValid.load(std::memory_order_acquire))
+	{
+		return;
+	}
+	LockMut(g_LookupLock);
+	if(m_bLookupValid.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+	BuildLookup();
+	m_bLookupValid.store(true, std::memory_order_release);
+}
+
+void TimingData::BuildLookup() const
+{
+	m_beat_start_lookup.clear();
+	m_time_start_lookup.clear();
+	m_displayed_beat_lookup.clear();
+	m_speed_time_lookup.clear();
 	const unsigned int segments_per_lookup= 16;
 	const std::vector<TimingSegment*>& bpms= m_avpTimingSegments[SEGMENT_BPM];
 	const std::vector<TimingSegment*>& warps= m_avpTimingSegments[SEGMENT_WARP];
@@ -98,18 +119,19 @@ void TimingData::PrepareLookup()
 	unsigned int lookup_entries= total_segments / segments_per_lookup;
 	m_beat_start_lookup.reserve(lookup_entries);
 	m_time_start_lookup.reserve(lookup_entries);
+	// Times in the tables start from 0 at beat 0; the lookups subtract
+	// m_fBeat0OffsetInSeconds from them.
 	for(unsigned int curr_segment= segments_per_lookup;
 			curr_segment < total_segments; curr_segment+= segments_per_lookup)
 	{
 		GetBeatStarts beat_start;
-		beat_start.last_time= -m_fBeat0OffsetInSeconds;
 		GetBeatArgs args;
 		args.elapsed_time= FLT_MAX;
 		GetBeatInternal(beat_start, args, curr_segment);
 		m_beat_start_lookup.push_back(lookup_item_t(args.elapsed_time, beat_start));
 
 		GetBeatStarts time_start;
-		time_start.last_time= -m_fBeat0OffsetInSeconds;
+		GetElapsedTimeInternal(time_start, FLT_MAX, curr_segment);
 		m_time_start_lookup.push_back(lookup_item_t(NoteRowToBeat(time_start.last_row), time_start));
 	}
 	// If there are less than two entries, then FindEntryInLookup in lookup
@@ -117,13 +139,54 @@ void TimingData::PrepareLookup()
 	// -Kyz
 	if(m_beat_start_lookup.size() < 2)
 	{
-		ReleaseLookup();
+		m_beat_start_lookup.clear();
+		m_time_start_lookup.clear();
 	}
 	// DumpLookupTables();
+
+	const std::vector<TimingSegment*>& scrolls= m_avpTimingSegments[SEGMENT_SCROLL];
+	m_displayed_beat_lookup.reserve(scrolls.size());
+	float displayed_beat= 0.0f;
+	float last_beat= 0.0f;
+	float last_ratio= 1.0f;
+	for(const TimingSegment* seg : scrolls)
+	{
+		const ScrollSegment* scroll= ToScroll(seg);
+		displayed_beat+= (scroll->GetBeat() - last_beat) * last_ratio;
+		last_beat= scroll->GetBeat();
+		last_ratio= scroll->GetRatio();
+		m_displayed_beat_lookup.push_back({last_beat, displayed_beat, last_ratio});
+	}
+
+	// The time spent in a delay at the start of a speed segment doesn't count
+	// toward changing the speed.  This uses the time table built above.
+	const std::vector<TimingSegment*>& speeds= m_avpTimingSegments[SEGMENT_SPEED];
+	m_speed_time_lookup.reserve(speeds.size());
+	for(const TimingSegment* seg : speeds)
+	{
+		const SpeedSegment* speed= ToSpeed(seg);
+		const float start_beat= speed->GetBeat();
+		speed_time_item_t item;
+		item.start_time= LookUpElapsedTime(start_beat) + m_fBeat0OffsetInSeconds
+			- GetDelayAtBeat(start_beat);
+		if(speed->GetUnit() == SpeedSegment::UNIT_SECONDS)
+		{
+			item.end_time= item.start_time + speed->GetDelay();
+		}
+		else
+		{
+			const float end_beat= start_beat + speed->GetDelay();
+			item.end_time= LookUpElapsedTime(end_beat) + m_fBeat0OffsetInSeconds
+				- GetDelayAtBeat(end_beat);
+		}
+		m_speed_time_lookup.push_back(item);
+	}
 }
 
 void TimingData::ReleaseLookup()
 {
+	LockMut(g_LookupLock);
+	InvalidateLookup();
 	// According to The C++ Programming Language 3rd Ed., decreasing the size
 	// of a vector doesn't actually free the memory it has allocated.  So this
 	// small trick is required to actually free the memory. -Kyz
@@ -136,6 +199,8 @@ void TimingData::ReleaseLookup()
 	CLEAR_LOOKUP(m_beat_start_lookup);
 	CLEAR_LOOKUP(m_time_start_lookup);
 #undef CLEAR_LOOKUP
+	std::vector<displayed_beat_item_t>().swap(m_displayed_beat_lookup);
+	std::vector<speed_time_item_t>().swap(m_speed_time_lookup);
 }
 
 RString SegInfoStr(const std::vector<TimingSegment*>& segs, unsigned int index, const RString& name)
@@ -262,6 +327,7 @@ void TimingData::CopyRange(int start_row, int end_row,
 void TimingData::ShiftRange(int start_row, int end_row,
 	TimingSegmentType shift_type, int shift_amount)
 {
+	InvalidateLookup();
 	FOREACH_TimingSegmentType(seg_type)
 	{
 		if(seg_type == shift_type || shift_type == TimingSegmentType_Invalid)
@@ -327,6 +393,7 @@ void TimingData::ShiftRange(int start_row, int end_row,
 
 void TimingData::ClearRange(int start_row, int end_row, TimingSegmentType clear_type)
 {
+	InvalidateLookup();
 	FOREACH_TimingSegmentType(seg_type)
 	{
 		if(seg_type == clear_type || clear_type == TimingSegmentType_Invalid)
@@ -367,31 +434,33 @@ void TimingData::GetActualBPM( float &fMinBPMOut, float &fMaxBPMOut, float highe
 
 float TimingData::GetNextSegmentBeatAtRow(TimingSegmentType tst, int row) const
 {
-	const std::vector<TimingSegment *> segs = GetTimingSegments(tst);
-	for (unsigned i = 0; i < segs.size(); i++ )
+	const std::vector<TimingSegment *> &segs = GetTimingSegments(tst);
+	const int index = GetSegmentIndexAtRow(tst, row);
+	if( index == INVALID_INDEX )
 	{
-		if( segs[i]->GetRow() <= row )
-		{
-			continue;
-		}
-		return segs[i]->GetBeat();
+		return NoteRowToBeat(row);
+	}
+	// The first segment after row is the one after the segment in effect,
+	// unless row is before all of them; then the first segment is in effect
+	// anyway.
+	const std::size_t next = segs[index]->GetRow() > row ? index : index + 1;
+	if( next < segs.size() )
+	{
+		return segs[next]->GetBeat();
 	}
 	return NoteRowToBeat(row);
 }
 
 float TimingData::GetPreviousSegmentBeatAtRow(TimingSegmentType tst, int row) const
 {
-	float backup = -1;
-	const std::vector<TimingSegment *> segs = GetTimingSegments(tst);
-	for (unsigned i = 0; i < segs.size(); i++ )
+	const std::vector<TimingSegment *> &segs = GetTimingSegments(tst);
+	const int prev = GetSegmentIndexAtRow(tst, row - 1);
+	// The segment in effect may be after row, if row is before all of them.
+	if( prev != INVALID_INDEX && segs[prev]->GetRow() < row )
 	{
-		if( segs[i]->GetRow() >= row )
-		{
-			break;
-		}
-		backup = segs[i]->GetBeat();
+		return segs[prev]->GetBeat();
 	}
-	return (backup > -1) ? backup : NoteRowToBeat(row);
+	return NoteRowToBeat(row);
 }
 
 int TimingData::GetSegmentIndexAtRow(TimingSegmentType tst, int iRow ) const
@@ -435,6 +504,7 @@ struct ts_less
 // Multiply the BPM in the range [fStartBeat,fEndBeat) by fFactor.
 void TimingData::MultiplyBPMInBeatRange( int iStartIndex, int iEndIndex, float fFactor )
 {
+	InvalidateLookup();
 	// Change all other BPM segments in this range.
 	std::vector<TimingSegment *> &bpms = m_avpTimingSegments[SEGMENT_BPM];
 	for( unsigned i=0; i<bpms.size(); i++ )
@@ -601,6 +671,7 @@ void TimingData::AddSegment( const TimingSegment *seg )
 	seg->DebugPrint();
 #endif
 
+	InvalidateLookup();
 	TimingSegmentType tst = seg->GetType();
 	std::vector<TimingSegment*> &vSegs = m_avpTimingSegments[tst];
 
@@ -916,14 +987,15 @@ void TimingData::GetBeatInternal(GetBeatStarts& start, GetBeatArgs& args,
 
 void TimingData::GetBeatAndBPSFromElapsedTimeNoOffset(GetBeatArgs& args) const
 {
+	PrepareLookup();
 	GetBeatStarts start;
-	start.last_time= -m_fBeat0OffsetInSeconds;
 	beat_start_lookup_t::const_iterator looked_up_start=
-		FindEntryInLookup(m_beat_start_lookup, args.elapsed_time);
+		FindEntryInLookup(m_beat_start_lookup, args.elapsed_time + m_fBeat0OffsetInSeconds);
 	if(looked_up_start != m_beat_start_lookup.end())
 	{
 		start= looked_up_start->second;
 	}
+	start.last_time-= m_fBeat0OffsetInSeconds;
 	GetBeatInternal(start, args, INT_MAX);
 }
 
@@ -1000,32 +1072,62 @@ float TimingData::GetElapsedTimeFromBeat( float fBeat ) const
 }
 
 float TimingData::GetElapsedTimeFromBeatNoOffset( float fBeat ) const
+{
+	PrepareLookup();
+	return LookUpElapsedTime( fBeat );
+}
+
+float TimingData::LookUpElapsedTime( float fBeat ) const
 {
 	GetBeatStarts start;
-	start.last_time= -m_fBeat0OffsetInSeconds;
 	beat_start_lookup_t::const_iterator looked_up_start=
 		FindEntryInLookup(m_time_start_lookup, fBeat);
 	if(looked_up_start != m_time_start_lookup.end())
 	{
 		start= looked_up_start->second;
 	}
+	start.last_time-= m_fBeat0OffsetInSeconds;
 	GetElapsedTimeInternal(start, fBeat, INT_MAX);
 	return start.last_time;
 }
 
 float TimingData::GetDisplayedBeat( float fBeat ) const
 {
-	float fOutBeat = 0;
-	unsigned i;
-	const std::vector<TimingSegment *> &scrolls = m_avpTimingSegments[SEGMENT_SCROLL];
-	for( i=0; i<scrolls.size()-1; i++ )
+	int iEntry = -1;
+	return GetDisplayedBeat( fBeat, iEntry );
+}
+
+float TimingData::GetDisplayedBeat( float fBeat, int &iEntry ) const
+{
+	PrepareLookup();
+	const std::vector<displayed_beat_item_t> &data = m_displayed_beat_lookup;
+	if( data.empty() )
+		return fBeat;
+
+	const int iLast = data.size() - 1;
+	if( iEntry >= 0 && iEntry <= iLast && (iEntry == 0 || data[iEntry].beat <= fBeat) )
 	{
-		if( scrolls[i+1]->GetBeat() > fBeat )
-			break;
-		fOutBeat += (scrolls[i+1]->GetBeat() - scrolls[i]->GetBeat()) * ToScroll(scrolls[i])->GetRatio();
+		// Step forward from where the last beat was.
+		while( iEntry < iLast && data[iEntry + 1].beat <= fBeat )
+			++iEntry;
+	}
+	else
+	{
+		// The first entry also covers anything before it.
+		auto it = std::upper_bound( data.begin() + 1, data.end(), fBeat,
+			[]( float beat, const displayed_beat_item_t &item ) { return beat < item.beat; } );
+		iEntry = (it - data.begin()) - 1;
 	}
-	fOutBeat += (fBeat - scrolls[i]->GetBeat()) * ToScroll(scrolls[i])->GetRatio();
-	return fOutBeat;
+
+	const displayed_beat_item_t &item = data[iEntry];
+	return item.displayed_beat + item.velocity * (fBeat - item.beat);
+}
+
+void TimingData::GetDisplayedBeats( const float *pBeats, int iCount, float *pDisplayedOut ) const
+{
+	int iEntry = -1;
+	for( int i = 0; i < iCount; ++i )
+		pDisplayedOut[i] = GetDisplayedBeat( pBeats[i], iEntry );
 }
 
 void TimingData::ScaleRegion( float fScale, int iStartIndex, int iEndIndex, bool bAdjustBPM )
@@ -1033,6 +1135,7 @@ void TimingData::ScaleRegion( float fScale, int iStartIndex, int iEndIndex, bool
 	ASSERT( fScale > 0 );
 	ASSERT( iStartIndex >= 0 );
 	ASSERT( iStartIndex < iEndIndex );
+	InvalidateLookup();
 
 	int length = iEndIndex - iStartIndex;
 	int newLength = std::lrint( fScale * length );
@@ -1070,6 +1173,7 @@ void TimingData::ScaleRegion( float fScale, int iStartIndex, int iEndIndex, bool
 
 void TimingData::InsertRows( int iStartRow, int iRowsToAdd )
 {
+	InvalidateLookup();
 	FOREACH_TimingSegmentType( tst )
 	{
 		std::vector<TimingSegment *> &segs = m_avpTimingSegments[tst];
@@ -1095,6 +1199,7 @@ void TimingData::InsertRows( int iStartRow, int iRowsToAdd )
 // Delete timing changes in [iStartRow, iStartRow + iRowsToDelete) and shift up.
 void TimingData::DeleteRows( int iStartRow, int iRowsToDelete )
 {
+	InvalidateLookup();
 	FOREACH_TimingSegmentType( tst )
 	{
 		// Don't delete the indefinite segments that are still in effect
@@ -1145,21 +1250,14 @@ float TimingData::GetDisplayedSpeedPercent( float fSongBeat, float fMusicSeconds
 	const int index = GetSegmentIndexAtBeat( SEGMENT_SPEED, fSongBeat );
 
 	const SpeedSegment *seg = ToSpeed(speeds[index]);
-	float fStartBeat = seg->GetBeat();
-	float fStartTime = GetElapsedTimeFromBeat( fStartBeat ) - GetDelayAtBeat( fStartBeat );
-	float fEndTime;
+	PrepareLookup();
+	// The table leaves out both offsets; add them the way GetElapsedTimeFromBeat does.
+	const float fOffset = -m_fBeat0OffsetInSeconds
+		- GAMESTATE->m_SongOptions.GetCurrent().m_fMusicRate * PREFSMAN->m_fGlobalOffsetSeconds;
+	float fStartTime = m_speed_time_lookup[index].start_time + fOffset;
+	float fEndTime = m_speed_time_lookup[index].end_time + fOffset;
 	float fCurTime = fMusicSeconds;
 
-	if( seg->GetUnit() == SpeedSegment::UNIT_SECONDS )
-	{
-		fEndTime = fStartTime + seg->GetDelay();
-	}
-	else
-	{
-		fEndTime = GetElapsedTimeFromBeat( fStartBeat + seg->GetDelay() )
-			- GetDelayAtBeat( fStartBeat + seg->GetDelay() );
-	}
-
 	SpeedSegment *first = ToSpeed(speeds[0]);
 
 	if( ( index == 0 && first->GetDelay() > 0.0 ) && fCurTime < fStartTime )
@@ -1192,6 +1290,7 @@ void TimingData::TidyUpData(bool allowEmpty)
 	// own.  Don't override this.
 	if( allowEmpty && empty() )
 		return;
+	InvalidateLookup();
 
 	// If there are no BPM segments, provide a default.
 	auto &segs = m_avpTimingSegments;
@@ -1237,6 +1336,7 @@ void TimingData::SortSegments( TimingSegmentType tst )
 {
 	std::vector<TimingSegment*> &vSegments = m_avpTimingSegments[tst];
 	sort( vSegments.begin(), vSegments.end() );
+	InvalidateLookup();
 }
 
 bool TimingData::HasSpeedChanges() const
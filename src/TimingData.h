@@ -6,6 +6,7 @@
 #include "PrefsManager.h"
 
 #include <array>
+#include <atomic>
 #include <cfloat>
 #include <vector>
 
@@ -74,7 +75,7 @@ public:
 	void Clear();
 	bool IsSafeFullTiming();
 
-	TimingData( const TimingData &cpy ) { Copy(cpy); }
+	TimingData( const TimingData &cpy ): m_bLookupValid(false) { Copy(cpy); }
 	TimingData& operator=( const TimingData &cpy ) { Copy(cpy); return *this; }
 
 	// GetBeatArgs, GetBeatStarts, m_beat_start_lookup, m_time_start_lookup,
@@ -84,10 +85,14 @@ public:
 	// The lookup tables contain indices for the beat and time finding
 	// functions to start at so they don't have to walk through all the timing
 	// segments.
-	// PrepareLookup should be called before gameplay starts, so that the lookup
-	// tables are populated.  ReleaseLookup should be called after gameplay
-	// finishes so that memory isn't wasted.
 	// -Kyz
+	// The tables are built the first time they're needed and thrown away
+	// whenever a segment is added, removed or moved, so every screen gets them,
+	// not just gameplay.  They're kept relative to beat 0 rather than to
+	// m_fBeat0OffsetInSeconds, so changing the offset doesn't invalidate them.
+	// The scroll and speed tables used for drawing notes are built with them.
+	// Anything that changes a segment in place, through GetTimingSegments or a
+	// Get*SegmentAtRow pointer, must call InvalidateLookup afterwards.
 	struct GetBeatArgs
 	{
 		float elapsed_time;
@@ -127,11 +132,33 @@ public:
 	lookup_item_t(float f, GetBeatStarts& s) :first(f), second(s) {}
 	};
 	typedef std::vector<lookup_item_t> beat_start_lookup_t;
-	beat_start_lookup_t m_beat_start_lookup;
-	beat_start_lookup_t m_time_start_lookup;
+	mutable beat_start_lookup_t m_beat_start_lookup;
+	mutable beat_start_lookup_t m_time_start_lookup;
 
-	void PrepareLookup();
+	/* One entry per scroll segment: the displayed beat where it starts, and
+	 * how fast the displayed beat moves through it. */
+	struct displayed_beat_item_t
+	{
+		float beat;
+		float displayed_beat;
+		float velocity;
+	};
+	/* One entry per speed segment: when it starts and finishes changing the
+	 * speed, in seconds from beat 0, ignoring both offsets. */
+	struct speed_time_item_t
+	{
+		float start_time;
+		float end_time;
+	};
+	mutable std::vector<displayed_beat_item_t> m_displayed_beat_lookup;
+	mutable std::vector<speed_time_item_t> m_speed_time_lookup;
+
+	/* Build the lookup tables now instead of on first use, so the first frame
+	 * of gameplay doesn't pay for it. */
+	void PrepareLookup() const;
+	/* Free the lookup tables; they'll be rebuilt the next time they're needed. */
 	void ReleaseLookup();
+	void InvalidateLookup() { m_bLookupValid = false; }
 	void DumpOneTable(const beat_start_lookup_t& lookup, const RString& name);
 	void DumpLookupTables();
 
@@ -380,6 +407,12 @@ public:
 	}
 	float GetElapsedTimeFromBeatNoOffset( float fBeat ) const;
 	float GetDisplayedBeat( float fBeat ) const;
+	/* iEntry is where to start looking, and is left at the scroll segment
+	 * fBeat is in.  Start it at -1. */
+	float GetDisplayedBeat( float fBeat, int &iEntry ) const;
+	/* Beats that are mostly in order, like the notes in a column, cost one
+	 * search and then a step forward now and then. */
+	void GetDisplayedBeats( const float *pBeats, int iCount, float *pDisplayedOut ) const;
 
 	bool HasBpmChanges() const { return GetTimingSegments(SEGMENT_BPM).size() > 1; }
 	bool HasStops() const { return !GetTimingSegments(SEGMENT_STOP).empty(); }
@@ -472,6 +505,14 @@ protected:
 
 	// All of the following vectors must be sorted before gameplay.
 	std::array<std::vector<TimingSegment *>, NUM_TimingSegmentType> m_avpTimingSegments;
+
+private:
+	void BuildLookup() const;
+	float LookUpElapsedTime( float fBeat ) const;
+
+	/* Set once the lookup tables match m_avpTimingSegments.  Several threads
+	 * may read the same TimingData, so the tables are built under a lock. */
+	mutable std::atomic<bool> m_bLookupValid;
 };
 
 #undef COMPARE
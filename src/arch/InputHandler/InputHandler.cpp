@@ -6,11 +6,57 @@
 #include "LocalizedString.h"
 #include "arch/arch_default.h"
 #include "InputHandler_MonkeyKeyboard.h"
+#include "RageThreads.h"
+#include "RageLatency.h"
 //#include "InputHandler_NSEvent.hpp"
 
 #include <vector>
 
 
+/* Room for a few seconds of button mashing on every pad, so a stalled frame
+ * doesn't lose input. */
+static const int INPUT_QUEUE_SIZE = 4096;
+
+InputHandler::InputHandler():
+	m_LastUpdate(), m_iInputsSinceUpdate(0),
+	m_iConsumerThreadID( RageThread::GetCurrentThreadID() ),
+	m_OverflowLock( "InputHandlerOverflow" ),
+	m_bOverflowed(false), m_iOverflowedEvents(0), m_iOverflowedEventsWarned(0)
+{
+	m_Events.reserve( INPUT_QUEUE_SIZE );
+}
+
+void InputHandler::FlushEvents()
+{
+	DeviceInput di;
+	while( m_Events.read(&di, 1) )
+		INPUTFILTER->ButtonPressed( di );
+
+	if( !m_bOverflowed )
+		return;
+
+	/* The input thread doesn't touch the queue while it's overflowed, so
+	 * everything still in it came before the overflowed events. */
+	std::vector<DeviceInput> vEvents;
+	{
+		LockMut( m_OverflowLock );
+		while( m_Events.read(&di, 1) )
+			INPUTFILTER->ButtonPressed( di );
+		vEvents.swap( m_OverflowEvents );
+		m_bOverflowed = false;
+	}
+
+	for( DeviceInput const &ev : vEvents )
+		INPUTFILTER->ButtonPressed( ev );
+
+	const int iOverflowed = m_iOverflowedEvents;
+	if( iOverflowed != m_iOverflowedEventsWarned )
+	{
+		LOG->Warn( "InputHandler: input queue overflowed; %i events queued under a lock", iOverflowed - m_iOverflowedEventsWarned );
+		m_iOverflowedEventsWarned = iOverflowed;
+	}
+}
+
 void InputHandler::UpdateTimer()
 {
 	m_LastUpdate.Touch();
@@ -24,8 +70,30 @@ void InputHandler::ButtonPressed( DeviceInput di )
 		di.ts = m_LastUpdate.Half();
 		++m_iInputsSinceUpdate;
 	}
+	else
+	{
+		RageLatency::RecordSince( LatencyStage_InputHandler, di.ts );
+	}
 
-	INPUTFILTER->ButtonPressed( di );
+	if( RageThread::GetCurrentThreadID() == m_iConsumerThreadID )
+	{
+		/* Polled input.  Anything the thread queued came first. */
+		FlushEvents();
+		INPUTFILTER->ButtonPressed( di );
+	}
+	else if( m_bOverflowed || !m_Events.write(&di, 1) )
+	{
+		/* The queue is full.  Don't drop the event, or a release could leave
+		 * a button stuck down; keep it, and everything after it, in order until
+		 * FlushEvents catches up. */
+		LockMut( m_OverflowLock );
+		if( m_bOverflowed || !m_Events.write(&di, 1) )
+		{
+			m_bOverflowed = true;
+			m_OverflowEvents.push_back( di );
+			++m_iOverflowedEvents;
+		}
+	}
 
 	if( m_iInputsSinceUpdate >= 1000 )
 	{
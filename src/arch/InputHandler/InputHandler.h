@@ -18,7 +18,11 @@
  * if it becomes needed.) */
 #include "RageInputDevice.h"	// for InputDevice
 #include "arch/RageDriver.h"
+#include "RageUtil_CircularBuffer.h"
+#include "RageThreads.h"
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 
@@ -29,9 +33,13 @@ public:
 	static void Create( const RString &sDrivers, std::vector<InputHandler *> &apAdd );
 	static DriverList m_pDriverList;
 
-	InputHandler(): m_LastUpdate(), m_iInputsSinceUpdate(0) {}
+	InputHandler();
 	virtual ~InputHandler() { }
 	virtual void Update() { }
+
+	/* Send events queued by input threads on to INPUTFILTER, in the order they
+	 * arrived.  RageInput calls this after Update(). */
+	void FlushEvents();
 	virtual bool DevicesChanged() { return false; }
 	virtual void GetDevicesAndDescriptions( std::vector<InputDeviceInfo>& vDevicesOut ) = 0;
 
@@ -61,7 +69,11 @@ protected:
 	 * Note that timestamps are set to the current time by default, so for this
 	 * to happen, you need to explicitly call di.ts.SetZero().
 	 *
-	 * If the timestamp is set, it'll be left alone. */
+	 * If the timestamp is set, it'll be left alone.
+	 *
+	 * Events from other threads go through a lock-free queue, so an input thread
+	 * doesn't wait on the main thread unless the queue fills up; drivers should
+	 * timestamp them as close to the hardware as they can. */
 	void ButtonPressed( DeviceInput di );
 
 	/* Call this at the end of polling input. */
@@ -70,6 +82,19 @@ protected:
 private:
 	RageTimer m_LastUpdate;
 	int m_iInputsSinceUpdate;
+
+	/* Written by the input thread, read by the thread that created us. */
+	CircBuf<DeviceInput> m_Events;
+	std::uint64_t m_iConsumerThreadID;
+
+	/* If m_Events fills up, events go here instead, so nothing is lost, until
+	 * FlushEvents empties both.  Only the input thread sets m_bOverflowed, and
+	 * only FlushEvents clears it, both with m_OverflowLock held. */
+	RageMutex m_OverflowLock;
+	std::vector<DeviceInput> m_OverflowEvents;
+	std::atomic<bool> m_bOverflowed;
+	std::atomic<int> m_iOverflowedEvents;
+	int m_iOverflowedEventsWarned;
 };
 
 #define REGISTER_INPUT_HANDLER_CLASS2( name, x ) \
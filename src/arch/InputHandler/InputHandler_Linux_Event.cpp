@@ -4,6 +4,7 @@
 #include "RageUtil.h"
 #include "LinuxInputManager.h"
 #include "GamePreferences.h" //needed for Axis Fix
+#include "arch/ArchHooks/ArchHooks_Unix.h"
 
 #include <cerrno>
 #include <cstdint>
@@ -128,6 +129,14 @@ bool EventDevice::Open( RString sFile, InputDevice dev )
 			DevInfo.version, m_sName.c_str() );
 	}
 
+#if defined(EVIOCSCLOCKID)
+	/* Have the kernel stamp events with the same clock RageTimer uses, so we
+	 * can use its timestamps instead of when the input thread woke up. */
+	clockid_t iClock = ArchHooks_Unix::GetClock();
+	if( iClock != CLOCK_REALTIME && ioctl(m_iFD, EVIOCSCLOCKID, &iClock) == -1 )
+		LOG->Warn( "ioctl(EVIOCSCLOCKID): %s", strerror(errno) );
+#endif
+
 	std::uint8_t iABSMask[ABS_MAX/8 + 1];
 	memset( iABSMask, 0, sizeof(iABSMask) );
 	if( ioctl(m_iFD, EVIOCGBIT(EV_ABS, sizeof(iABSMask)), iABSMask) < 0 )
@@ -329,6 +338,17 @@ bool InputHandler_Linux_Event::TryDevice(RString devfile)
 	}
 }
 
+/* Use the kernel's timestamp for an event, unless it's clearly not on our
+ * clock (an old kernel, or time was fixed up after going backwards). */
+static RageTimer GetEventTime( const input_event &event, const RageTimer &now )
+{
+	RageTimer ts( int(event.time.tv_sec), int(event.time.tv_usec) );
+	const float fAge = now - ts;
+	if( fAge < 0 || fAge > 1.0f )
+		return now;
+	return ts;
+}
+
 int InputHandler_Linux_Event::InputThread_Start( void *p )
 {
 	((InputHandler_Linux_Event *) p)->InputThread();
@@ -385,6 +405,8 @@ void InputHandler_Linux_Event::InputThread()
 				continue;
 			}
 
+			const RageTimer ts = GetEventTime( event, now );
+
 			switch (event.type) {
 			case EV_KEY: {
 				int iNum;
@@ -400,7 +422,7 @@ void InputHandler_Linux_Event::InputThread()
 					iNum = event.code;
 				}
 				wrap( iNum, 32 );	// max number of joystick buttons.  Make this a constant?
-				ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, enum_add2(JOY_BUTTON_1, iNum), event.value != 0, now) );
+				ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, enum_add2(JOY_BUTTON_1, iNum), event.value != 0, ts) );
 				break;
 			}
 
@@ -412,13 +434,13 @@ void InputHandler_Linux_Event::InputThread()
 				float l = SCALE( int(event.value), (float) g_apEventDevices[i]->aiAbsMin[event.code], (float) g_apEventDevices[i]->aiAbsMax[event.code], -1.0f, 1.0f );
 				if (GamePreferences::m_AxisFix)
 				{
-				  ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, neg, (l < -0.5)||((l > 0.0001)&&(l < 0.5)), now) ); //Up if between 0.0001 and 0.5 or if less than -0.5
-				  ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, pos, (l > 0.5)||((l > 0.0001)&&(l < 0.5)) , now) ); //Down if between 0.0001 and 0.5 or if more than 0.5
+				  ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, neg, (l < -0.5)||((l > 0.0001)&&(l < 0.5)), ts) ); //Up if between 0.0001 and 0.5 or if less than -0.5
+				  ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, pos, (l > 0.5)||((l > 0.0001)&&(l < 0.5)) , ts) ); //Down if between 0.0001 and 0.5 or if more than 0.5
 				}
 				else
 				{
-				  ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, neg, std::max(-l, 0.0f), now) );
-				  ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, pos, std::max(+l, 0.0f), now) );
+				  ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, neg, std::max(-l, 0.0f), ts) );
+				  ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, pos, std::max(+l, 0.0f), ts) );
 				}
 				break;
 			}
@@ -2,10 +2,10 @@
 #define INPUT_HANDLER_LINUX_PIUIO_H 1
 
 #include "InputHandler.h"
-#include "RageThreads.h"
 
 #include <vector>
 
+class PIUIOBoard;
 
 class InputHandler_Linux_PIUIO: public InputHandler
 {
@@ -15,13 +15,9 @@ public:
 	void GetDevicesAndDescriptions( std::vector<InputDeviceInfo>& vDevicesOut );
 
 private:
-	static int InputThread_Start( void *p );
-	void InputThread();
+	static void OnEdge( void *p, int iButton, bool bDown, const RageTimer &ts );
 
-	int fd;
-	unsigned char lastInputs[8];
-	RageThread m_InputThread;
-	bool m_bShutdown;
+	PIUIOBoard *m_pBoard;
 };
 
 #endif
@@ -0,0 +1,265 @@
+#include "global.h"
+#include "PIUIOBoard.h"
+#include "Preference.h"
+#include "RageLog.h"
+#include "RageUtil.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+#if defined(HAVE_FCNTL_H)
+#include <fcntl.h>
+#endif
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* How often to poll the board.  The kernel driver's transfers take time too,
+ * so this is an upper bound. */
+static Preference<int> g_iPIUIOPollRate( "PIUIOPollRate", 1000 );
+
+namespace
+{
+	/* Talks to the board through the piuio kernel driver.  A read does the
+	 * USB transfers for all four sensor sets, and carries whatever lights
+	 * were last written, so writing the lights right before the read puts
+	 * them in the same transaction. */
+	class PIUIOTransport_Kernel: public PIUIOBoard::Transport
+	{
+	public:
+		PIUIOTransport_Kernel( int fd ): m_iFD(fd) { }
+		~PIUIOTransport_Kernel() { close( m_iFD ); }
+
+		bool Transfer( const std::uint8_t *pLights, bool bLightsChanged, std::uint8_t *pInputs )
+		{
+			if( bLightsChanged && write(m_iFD, pLights, PIUIOBoard::NUM_LIGHT_BYTES) != PIUIOBoard::NUM_LIGHT_BYTES )
+			{
+				LOG->Warn( "Error setting PIUIO lights: %s", strerror(errno) );
+				return false;
+			}
+
+			int ret = read( m_iFD, pInputs, PIUIOBoard::NUM_INPUT_BYTES );
+			if( ret != PIUIOBoard::NUM_INPUT_BYTES )
+			{
+				LOG->Warn( "Unexpected packet (size %i != %i) from PIUIO", ret, PIUIOBoard::NUM_INPUT_BYTES );
+				return false;
+			}
+			return true;
+		}
+
+	private:
+		int m_iFD;
+	};
+}
+
+PIUIOBoard::PIUIOBoard( Transport *pTransport, int iPollsPerSecond ):
+	m_pTransport( pTransport ),
+	m_iPollsPerSecond( clamp(iPollsPerSecond, 1, 10000) ),
+	m_iLights( 0 ),
+	m_iLastSentLights( 0 ),
+	m_bSentLights( false ),
+	m_CallbackLock( "PIUIOBoard callback" ),
+	m_pfnEdge( nullptr ),
+	m_pEdgeUser( nullptr ),
+	m_bShutdown( false ),
+	m_iNumPolls( 0 )
+{
+	// Everything starts out released, which reads high.
+	memset( m_LastInputs, 0xFF, sizeof(m_LastInputs) );
+}
+
+PIUIOBoard::~PIUIOBoard()
+{
+	StopThread();
+	delete m_pTransport;
+}
+
+void PIUIOBoard::StartThread()
+{
+	if( m_PollThread.IsCreated() )
+		return;
+
+	m_bShutdown = false;
+	m_PollThread.SetName( "PIUIO thread" );
+	m_PollThread.Create( PollThread_Start, this );
+}
+
+void PIUIOBoard::StopThread()
+{
+	if( !m_PollThread.IsCreated() )
+		return;
+
+	m_bShutdown = true;
+	LOG->Trace( "Shutting down PIUIO thread ..." );
+	m_PollThread.Wait();
+	LOG->Trace( "PIUIO thread shut down." );
+}
+
+void PIUIOBoard::SetEdgeCallback( EdgeCallback pfn, void *pUser )
+{
+	LockMut( m_CallbackLock );
+	m_pfnEdge = pfn;
+	m_pEdgeUser = pUser;
+}
+
+void PIUIOBoard::SetLights( const std::uint8_t *pLights )
+{
+	std::uint64_t iLights;
+	memcpy( &iLights, pLights, sizeof(iLights) );
+	m_iLights.store( iLights );
+}
+
+bool PIUIOBoard::Poll()
+{
+	const std::uint64_t iLights = m_iLights.load();
+	std::uint8_t lights[NUM_LIGHT_BYTES];
+	memcpy( lights, &iLights, sizeof(lights) );
+
+	std::uint8_t inputs[NUM_INPUT_BYTES];
+	RageTimer before;
+	// Always send the first time, to replace whatever the board powered up with.
+	const bool bLightsChanged = !m_bSentLights || iLights != m_iLastSentLights;
+	if( !m_pTransport->Transfer(lights, bLightsChanged, inputs) )
+		return false;
+	RageTimer after;
+
+	m_iLastSentLights = iLights;
+	m_bSentLights = true;
+	++m_iNumPolls;
+
+	// The sensors were sampled somewhere in the middle of the transfer.
+	const RageTimer ts = before + (after - before) * 0.5f;
+
+	// The board reads *low* for a pressed input, so AND the four sets of
+	// sensors together: if any sensor was pressed, the button is pressed.
+	for( int i = 8; i < NUM_INPUT_BYTES; ++i )
+		inputs[i % 8] &= inputs[i];
+
+	std::uint8_t changed[NUM_BUTTONS/8];
+	bool bAnyChanged = false;
+	for( int i = 0; i < NUM_BUTTONS/8; ++i )
+	{
+		changed[i] = m_LastInputs[i] ^ inputs[i];
+		bAnyChanged |= changed[i] != 0;
+	}
+	if( !bAnyChanged )
+		return true;
+	memcpy( m_LastInputs, inputs, sizeof(m_LastInputs) );
+
+	LockMut( m_CallbackLock );
+	if( m_pfnEdge == nullptr )
+		return true;
+
+	for( int i = 0; i < NUM_BUTTONS; ++i )
+	{
+		const std::uint8_t iBit = 128 >> (i % 8);
+		if( changed[i / 8] & iBit )
+			m_pfnEdge( m_pEdgeUser, i, !(inputs[i / 8] & iBit), ts );
+	}
+	return true;
+}
+
+int PIUIOBoard::PollThread_Start( void *p )
+{
+	((PIUIOBoard *) p)->PollThread();
+	return 0;
+}
+
+static void SetRealtimePriority()
+{
+	sched_param param;
+	memset( &param, 0, sizeof(param) );
+	param.sched_priority = sched_get_priority_max( SCHED_FIFO ) / 2;
+	int iRet = pthread_setschedparam( pthread_self(), SCHED_FIFO, &param );
+	if( iRet == 0 )
+	{
+		LOG->Info( "PIUIO thread running with real-time priority" );
+		return;
+	}
+
+	/* We need CAP_SYS_NICE for SCHED_FIFO.  Settle for a better nice value,
+	 * which may also fail. */
+	LOG->Info( "PIUIO thread couldn't get real-time priority: %s", strerror(iRet) );
+	setpriority( PRIO_PROCESS, 0, -15 );
+}
+
+void PIUIOBoard::PollThread()
+{
+	SetRealtimePriority();
+
+	const float fPeriod = 1.0f / m_iPollsPerSecond;
+	RageTimer next;
+	while( !m_bShutdown )
+	{
+		if( !Poll() )
+		{
+			// Don't spin on a board that has stopped answering.
+			usleep( 10000 );
+			next.Touch();
+			continue;
+		}
+
+		next += fPeriod;
+		const float fWait = -next.Ago();
+		if( fWait > 0 )
+			usleep( int(fWait * 1000000) );
+		else if( fWait < -fPeriod )
+			next.Touch(); // fell behind; don't try to catch up with a burst of polls
+	}
+}
+
+static RageMutex g_BoardLock( "PIUIOBoard" );
+static PIUIOBoard *g_pBoard = nullptr;
+static int g_iBoardRefs = 0;
+
+PIUIOBoard *PIUIOBoard::Acquire()
+{
+	LockMut( g_BoardLock );
+	if( g_pBoard != nullptr )
+	{
+		++g_iBoardRefs;
+		return g_pBoard;
+	}
+
+	int fd = open( "/dev/piuio0", O_RDWR );
+	if( fd < 0 )
+	{
+		LOG->Warn( "Couldn't open PIUIO device: %s", strerror(errno) );
+		return nullptr;
+	}
+
+	struct stat st;
+	if( fstat(fd, &st) == -1 )
+	{
+		LOG->Warn( "Couldn't stat PIUIO device: %s", strerror(errno) );
+		close( fd );
+		return nullptr;
+	}
+
+	if( !S_ISCHR(st.st_mode) )
+	{
+		LOG->Warn( "Ignoring /dev/piuio0: not a character device" );
+		close( fd );
+		return nullptr;
+	}
+
+	LOG->Info( "Opened PIUIO device, polling at %i Hz", g_iPIUIOPollRate.Get() );
+	g_pBoard = new PIUIOBoard( new PIUIOTransport_Kernel(fd), g_iPIUIOPollRate );
+	g_pBoard->StartThread();
+	g_iBoardRefs = 1;
+	return g_pBoard;
+}
+
+void PIUIOBoard::Release()
+{
+	LockMut( g_BoardLock );
+	ASSERT( g_iBoardRefs > 0 );
+	if( --g_iBoardRefs == 0 )
+		SAFE_DELETE( g_pBoard );
+}
@@ -0,0 +1,83 @@
+/* PIUIOBoard - Polls a PIUIO cabinet board from its own thread. */
+
+#ifndef PIUIO_BOARD_H
+#define PIUIO_BOARD_H
+
+#include "RageThreads.h"
+#include "RageTimer.h"
+
+#include <atomic>
+#include <cstdint>
+
+/* The input handler and the lights driver share one board.  Every poll
+ * sends the current lights and reads back all four sets of sensors, so lights
+ * never wait on a frame and input is sampled at a steady rate instead of
+ * whenever the driver gets around to it. */
+class PIUIOBoard
+{
+public:
+	static const int NUM_LIGHT_BYTES = 8;
+	static const int NUM_INPUT_BYTES = 32;
+	static const int NUM_BUTTONS = 64;
+
+	/* How one poll reaches the board.  The real one talks to the kernel
+	 * driver; tests supply a fake board. */
+	class Transport
+	{
+	public:
+		virtual ~Transport() { }
+		/* Send the lights, and read back four sets of 64 sensors, which read
+		 * low when pressed.  Return false if the board didn't answer. */
+		virtual bool Transfer( const std::uint8_t *pLights, bool bLightsChanged, std::uint8_t *pInputs ) = 0;
+	};
+
+	/* Called from the poll thread for each button that changed. */
+	typedef void (*EdgeCallback)( void *pUser, int iButton, bool bDown, const RageTimer &ts );
+
+	/* Takes ownership of pTransport.  The thread isn't started until
+	 * StartThread, so tests can call Poll themselves. */
+	PIUIOBoard( Transport *pTransport, int iPollsPerSecond );
+	~PIUIOBoard();
+
+	void StartThread();
+	void StopThread();
+
+	/* Run one transaction: send the lights and report edges. */
+	bool Poll();
+
+	/* Set pfn to nullptr to stop callbacks; once that returns, none are running. */
+	void SetEdgeCallback( EdgeCallback pfn, void *pUser );
+
+	/* Sent with the next poll.  Safe to call from any thread. */
+	void SetLights( const std::uint8_t *pLights );
+
+	int GetNumPolls() const { return m_iNumPolls; }
+	int GetPollsPerSecond() const { return m_iPollsPerSecond; }
+
+	/* The board on /dev/piuio0, shared by everything that uses it.  Returns
+	 * nullptr if there isn't one.  Each Acquire needs a Release. */
+	static PIUIOBoard *Acquire();
+	static void Release();
+
+private:
+	static int PollThread_Start( void *p );
+	void PollThread();
+
+	Transport *m_pTransport;
+	int m_iPollsPerSecond;
+
+	std::atomic<std::uint64_t> m_iLights;
+	std::uint64_t m_iLastSentLights;
+	bool m_bSentLights;
+	std::uint8_t m_LastInputs[NUM_BUTTONS/8];
+
+	RageMutex m_CallbackLock;
+	EdgeCallback m_pfnEdge;
+	void *m_pEdgeUser;
+
+	RageThread m_PollThread;
+	bool m_bShutdown;
+	std::atomic<int> m_iNumPolls;
+};
+
+#endif
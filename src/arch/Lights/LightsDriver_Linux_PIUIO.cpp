@@ -1,45 +1,34 @@
 #include "global.h"
-#include <stdio.h>
-#if defined(HAVE_UNISTD_H)
-#include <unistd.h>
-#endif
-#include <sys/types.h>
-#include <sys/stat.h>
-
-#if defined(HAVE_FCNTL_H)
-#include <fcntl.h>
-#endif
-
-#include <errno.h>
 #include "LightsDriver_Linux_PIUIO.h"
+#include "arch/InputHandler/PIUIOBoard.h"
 #include "GameState.h"
 #include "Game.h"
 #include "RageLog.h"
 
+#include <cstdint>
+
 REGISTER_LIGHTS_DRIVER_CLASS2(PIUIO, Linux_PIUIO);
 
 LightsDriver_Linux_PIUIO::LightsDriver_Linux_PIUIO()
 {
-	// Open port
-	fd = open("/dev/piuio0", O_WRONLY);
-	if( fd < 0 )
-	{
-		LOG->Warn( "Error opening serial port for lights. Error: %d %s", errno, strerror(errno) );
-		return;
-	}
-	LOG->Info("Opened PIUIO device for lights");
+	// The board's poll thread sends the lights along with each input read.
+	m_pBoard = PIUIOBoard::Acquire();
+	if( m_pBoard != nullptr )
+		LOG->Info("Opened PIUIO device for lights");
 }
 
 LightsDriver_Linux_PIUIO::~LightsDriver_Linux_PIUIO()
 {
-	if( fd >= 0 )
-		close(fd);
+	if( m_pBoard != nullptr )
+		PIUIOBoard::Release();
 }
 
 void LightsDriver_Linux_PIUIO::Set( const LightsState *ls )
 {
-	unsigned char buf[8] = { 0, 0, 0, 0x08, 0x37, 0, 0, 0 };
-	static unsigned char oldbuf[8] = { 0, 0, 0, 0x08, 0x37, 0, 0, 0 };
+	if( m_pBoard == nullptr )
+		return;
+
+	std::uint8_t buf[PIUIOBoard::NUM_LIGHT_BYTES] = { 0, 0, 0, 0x08, 0x37, 0, 0, 0 };
 
 	if (ls->m_bCabinetLights[LIGHT_MARQUEE_UP_LEFT]) buf[2] |= 0x80;
 	if (ls->m_bCabinetLights[LIGHT_MARQUEE_UP_RIGHT]) buf[3] |= 0x04;
@@ -71,15 +60,9 @@ void LightsDriver_Linux_PIUIO::Set( const LightsState *ls )
 		if (ls->m_bGameButtonLights[GameController_2][PUMP_BUTTON_DOWNLEFT]) buf[2] |= 0x20;
 		if (ls->m_bGameButtonLights[GameController_2][PUMP_BUTTON_DOWNRIGHT]) buf[2] |= 0x40;
 	}
-	if (!memcmp(buf, oldbuf, 8))
-		return;
-	memcpy(oldbuf, buf, 8);
 
-	if (write(fd, buf, 8) != 8)
-	{
-		LOG->Warn( "Error setting lights state. Error: %d %s", errno, strerror(errno) );
-		return;
-	}
+	// Only goes out to the board if it changed.
+	m_pBoard->SetLights( buf );
 }
 
 /*
@@ -5,6 +5,8 @@
 
 #include "arch/Lights/LightsDriver.h"
 
+class PIUIOBoard;
+
 class LightsDriver_Linux_PIUIO : public LightsDriver
 {
 public:
@@ -13,7 +15,7 @@ public:
 
 	virtual void Set( const LightsState *ls );
 private:
-	int fd;
+	PIUIOBoard *m_pBoard;
 };
 
 #endif
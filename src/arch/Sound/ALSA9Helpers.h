@@ -46,6 +46,7 @@ public:
 	void Stop();
 	void SetVolume(float vol);
 	int GetSampleRate() const { return samplerate; }
+	int GetChunkSize() const { return chunksize; }
 
 	std::int64_t GetPosition() const;
 	std::int64_t GetPlayPos() const { return last_cursor_pos; }
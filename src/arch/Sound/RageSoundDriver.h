@@ -7,6 +7,7 @@
 #include "RageTimer.h"
 #include "RageUtil_CircularBuffer.h"
 
+#include <atomic>
 #include <cstdint>
 
 class RageSoundBase;
@@ -77,9 +78,14 @@ protected:
 	/* Call this before calling StartDecodeThread to set the desired decoding buffer
 	 * size.  This is the number of frames that Mix() will try to be able to return
 	 * at once.  This should generally be slightly larger than the sound writeahead,
-	 * to allow filling the buffer after an underrun.  The default is 4096 frames. */
+	 * to allow filling the buffer after an underrun.  The default is 4096 frames.
+	 * The SoundDecodeBufferFrames preference, if set, overrides this. */
 	void SetDecodeBufferSize( int frames );
 
+	/* The decoding buffer size to use when SoundLowLatency is on: about 3ms, but
+	 * at least two of the largest blocks the driver passes to Mix(). */
+	int GetLowLatencyDecodeBufferSize( int iMixFrames ) const;
+
 	/* Override this to set the priority of the decoding thread, which should be above
 	 * normal priority but not realtime. */
 	virtual void SetupDecodingThread() { }
@@ -144,10 +150,13 @@ private:
 	 *
 	 * The only state change made by the decoding thread is on EOF: the state is changed
 	 * from PLAYING to STOPPING.  This is done while m_Mutex is held, to prevent
-	 * races with other threads.
+	 * races with other threads.  The decoding thread and Update() hold m_Mutex for
+	 * one sound at a time, so neither waits long for the other.
 	 *
 	 * The only state change made by the mixing thread is from HALTING to STOPPED.
 	 * This is done with no locks; no other thread can take a sound out of the HALTING state.
+	 * m_State and m_bPaused are atomic, and the decoded blocks are passed to the mixing
+	 * thread through a CircBuf, so the mixing thread never waits on another thread.
 	 *
 	 * Do not allocate or deallocate memory in the mixing thread since allocating memory
 	 * involves taking a lock. Instead, push the deallocation to the main thread.
@@ -172,7 +181,7 @@ private:
 		RageTimer m_StartTime;
 		CircBuf<sound_block> m_Buffer;
 
-		bool m_bPaused;
+		std::atomic<bool> m_bPaused;
 
 		struct QueuedPosMap
 		{
@@ -183,7 +192,7 @@ private:
 
 		CircBuf<QueuedPosMap> m_PosMapQueue;
 
-		enum
+		enum State
 		{
 			AVAILABLE,
 			BUFFERING,
@@ -196,7 +205,8 @@ private:
 
 			HALTING,	/* stop immediately */
 			PLAYING
-		} m_State;
+		};
+		std::atomic<State> m_State;
 	};
 
 	/* List of currently playing sounds: XXX no vector */
@@ -12,6 +12,9 @@
 #include "archutils/Unix/GetSysInfo.h"
 
 #include <cstdint>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/time.h>
 #include <sys/resource.h>
 
@@ -24,6 +27,9 @@ static const int bytes_per_frame = sizeof(std::int16_t) * samples_per_frame;
 /* Linux 2.6 has a fine-grained scheduler.  We can almost always use a smaller buffer
  * size than in 2.4.  XXX: Some cards can handle smaller buffer sizes than others. */
 static const unsigned g_iMaxWriteahead_linux_26 = 512;
+/* With SoundLowLatency, the mixing thread runs with real-time priority and can
+ * keep a much smaller buffer filled. */
+static const unsigned g_iMaxWriteahead_low_latency = 256;
 static const unsigned safe_writeahead = 1024*4;
 static unsigned g_iMaxWriteahead;
 const int num_chunks = 8;
@@ -34,9 +40,29 @@ int RageSoundDriver_ALSA9_Software::MixerThread_start( void *p )
 	return 0;
 }
 
-void RageSoundDriver_ALSA9_Software::MixerThread()
+static void SetRealtimePriority()
 {
+	sched_param param;
+	memset( &param, 0, sizeof(param) );
+	param.sched_priority = sched_get_priority_max( SCHED_FIFO ) / 2;
+	int iRet = pthread_setschedparam( pthread_self(), SCHED_FIFO, &param );
+	if( iRet == 0 )
+	{
+		LOG->Info( "ALSA mixing thread running with real-time priority" );
+		return;
+	}
+
+	/* We need CAP_SYS_NICE or an rtprio limit for SCHED_FIFO. */
+	LOG->Info( "ALSA mixing thread couldn't get real-time priority: %s", strerror(iRet) );
 	setpriority( PRIO_PROCESS, 0, -15 );
+}
+
+void RageSoundDriver_ALSA9_Software::MixerThread()
+{
+	if( PREFSMAN->m_bSoundLowLatency )
+		SetRealtimePriority();
+	else
+		setpriority( PRIO_PROCESS, 0, -15 );
 
 	while( !m_bShutdown )
 	{
@@ -50,28 +76,17 @@ void RageSoundDriver_ALSA9_Software::MixerThread()
 /* Returns the number of frames processed */
 bool RageSoundDriver_ALSA9_Software::GetData()
 {
-	const int frames_to_fill = m_pPCM->GetNumFramesToFill();
+	/* GetNumFramesToFill asks for one chunk at a time.  If it ever asks for more,
+	 * fill what fits and come back for the rest, rather than allocate here. */
+	const int frames_to_fill = std::min( m_pPCM->GetNumFramesToFill(), m_iBufferFrames );
 	if( frames_to_fill <= 0 )
 		return false;
 
-	static std::int16_t *buf = nullptr;
-	static int bufsize = 0;
-	if( buf && bufsize < frames_to_fill )
-	{
-		delete[] buf;
-		buf = nullptr;
-	}
-	if( !buf )
-	{
-		buf = new std::int16_t[frames_to_fill*samples_per_frame];
-	        bufsize = frames_to_fill;
-	}
-
 	const std::int64_t play_pos = m_pPCM->GetPlayPos();
 	const std::int64_t cur_play_pos = m_pPCM->GetPosition();
 
-	this->Mix( buf, frames_to_fill, play_pos, cur_play_pos );
-	m_pPCM->Write( buf, frames_to_fill );
+	this->Mix( m_pBuffer, frames_to_fill, play_pos, cur_play_pos );
+	m_pPCM->Write( m_pBuffer, frames_to_fill );
 
 	return true;
 }
@@ -91,6 +106,8 @@ void RageSoundDriver_ALSA9_Software::SetupDecodingThread()
 RageSoundDriver_ALSA9_Software::RageSoundDriver_ALSA9_Software()
 {
 	m_pPCM = nullptr;
+	m_pBuffer = nullptr;
+	m_iBufferFrames = 0;
 	m_bShutdown = false;
 }
 
@@ -110,6 +127,8 @@ RString RageSoundDriver_ALSA9_Software::Init()
 
 	if( PREFSMAN->m_iSoundWriteAhead )
 		g_iMaxWriteahead = PREFSMAN->m_iSoundWriteAhead;
+	else if( PREFSMAN->m_bSoundLowLatency )
+		g_iMaxWriteahead = g_iMaxWriteahead_low_latency;
 
 	m_pPCM = new Alsa9Buf();
 	sError = m_pPCM->Init( channels,
@@ -121,6 +140,12 @@ RString RageSoundDriver_ALSA9_Software::Init()
 
 	m_iSampleRate = m_pPCM->GetSampleRate();
 
+	m_iBufferFrames = m_pPCM->GetChunkSize();
+	m_pBuffer = new std::int16_t[m_iBufferFrames*samples_per_frame];
+
+	if( PREFSMAN->m_bSoundLowLatency )
+		SetDecodeBufferSize( GetLowLatencyDecodeBufferSize(m_iBufferFrames) );
+
 	StartDecodeThread();
 
 	m_MixingThread.SetName( "RageSoundDriver_ALSA9_Software" );
@@ -141,6 +166,7 @@ RageSoundDriver_ALSA9_Software::~RageSoundDriver_ALSA9_Software()
 	}
 
 	delete m_pPCM;
+	delete[] m_pBuffer;
 
 	UnloadALSA();
 }
@@ -30,6 +30,10 @@ private:
 	bool m_bShutdown;
 	int m_iSampleRate;
 	Alsa9Buf *m_pPCM;
+
+	/* One chunk, mixed by the mixing thread; allocated by Init. */
+	std::int16_t *m_pBuffer;
+	int m_iBufferFrames;
 	RageThread m_MixingThread;
 };
 
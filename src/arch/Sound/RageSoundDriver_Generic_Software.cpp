@@ -2,6 +2,7 @@
 #include "RageSoundDriver.h"
 #include "PrefsManager.h"
 #include "RageLog.h"
+#include "RageLatency.h"
 #include "RageSound.h"
 #include "RageUtil.h"
 #include "RageSoundMixBuffer.h"
@@ -14,8 +15,16 @@ static const int channels = 2;
 
 static int frames_to_buffer;
 
-/* 512 is about 10ms, which is big enough for the tolerance of most schedulers. */
-static int chunksize() { return 512; }
+/* Frames decoded into each sound_block.  This is less than a full block when the
+ * decoding buffer is small, so it can still hold more than one block. */
+static int frames_per_block = samples_per_block / channels;
+
+/* 512 is about 10ms, which is big enough for the tolerance of most schedulers.
+ * Small decoding buffers need to be refilled more often than that. */
+static int chunksize() { return std::min( 512, std::max(frames_to_buffer/4, 1) ); }
+
+/* Mixed by the mixing thread; reserved in StartDecodeThread. */
+static RageSoundMixBuffer g_Mix;
 
 static int underruns = 0, logged_underruns = 0;
 
@@ -30,8 +39,7 @@ void RageSoundDriver::Sound::Allocate( int iFrames )
 {
 	/* Reserve enough blocks in the buffer to hold the buffer.  Add one, to account for
 	 * the fact that we may have a partial block due to a previous Mix() call. */
-	const int iFramesPerBlock = samples_per_block / channels;
-	const int iBlocksToPrebuffer = iFrames / iFramesPerBlock;
+	const int iBlocksToPrebuffer = iFrames / frames_per_block;
 	m_Buffer.reserve( iBlocksToPrebuffer + 1 );
 	m_PosMapQueue.reserve( 32 );
 }
@@ -60,8 +68,7 @@ RageSoundMixBuffer &RageSoundDriver::MixIntoBuffer( int iFrames, std::int64_t iF
 		g_iTotalAhead += (int) (iFrameNumber - iCurrentFrame + iFrames);
 		++g_iTotalAheadCount;
 	}
-
-	static RageSoundMixBuffer mix;
+	RageLatency::Record( LatencyStage_AudioBuffer, float(iFrameNumber - iCurrentFrame) / GetSampleRate() );
 
 	for( unsigned i = 0; i < ARRAYLEN(m_Sounds); ++i )
 	{
@@ -130,8 +137,8 @@ RageSoundMixBuffer &RageSoundDriver::MixIntoBuffer( int iFrames, std::int64_t iF
 
 			/* Note that, until we call advance_read_pointer, we can safely write to p[0]. */
 			const int frames_to_read = std::min( iFramesLeft, p[0]->m_FramesInBuffer );
-			mix.SetWriteOffset( iGotFrames*channels );
-			mix.write( p[0]->m_BufferNext, frames_to_read * channels );
+			g_Mix.SetWriteOffset( iGotFrames*channels );
+			g_Mix.write( p[0]->m_BufferNext, frames_to_read * channels );
 
 			{
 				Sound::QueuedPosMap pos;
@@ -158,7 +165,7 @@ RageSoundMixBuffer &RageSoundDriver::MixIntoBuffer( int iFrames, std::int64_t iF
 			++underruns;
 	}
 
-	return mix;
+	return g_Mix;
 }
 
 void RageSoundDriver::Mix( std::int16_t *pBuf, int iFrames, std::int64_t iFrameNumber, std::int64_t iCurrentFrame )
@@ -194,7 +201,6 @@ void RageSoundDriver::DecodeThread()
 			usleep( iUsecs );
 		}
 
-		LockMut( m_Mutex );
 //		LOG->Trace("begin mix");
 
 		for( unsigned i = 0; i < ARRAYLEN(m_Sounds); ++i )
@@ -202,6 +208,13 @@ void RageSoundDriver::DecodeThread()
 			if( m_Sounds[i].m_State != Sound::PLAYING )
 				continue;
 
+			/* Lock for one sound at a time, so the main thread never waits on more
+			 * than one sound being decoded.  It may have stopped the sound while we
+			 * waited. */
+			LockMut( m_Mutex );
+			if( m_Sounds[i].m_State != Sound::PLAYING )
+				continue;
+
 			Sound *pSound = &m_Sounds[i];
 
 			CHECKPOINT_M("Processing the sound while buffers are available.");
@@ -235,8 +248,7 @@ int RageSoundDriver::GetDataForSound( Sound &s )
 	ASSERT( psize[0] > 0 );
 
 	sound_block *pBlock = p[0];
-	int size = ARRAYLEN(pBlock->m_Buffer)/channels;
-	int iRet = s.m_pSound->GetDataToPlay( pBlock->m_Buffer, size, pBlock->m_iPosition, pBlock->m_FramesInBuffer );
+	int iRet = s.m_pSound->GetDataToPlay( pBlock->m_Buffer, frames_per_block, pBlock->m_iPosition, pBlock->m_FramesInBuffer );
 	if( iRet > 0 )
 	{
 		pBlock->m_BufferNext = pBlock->m_Buffer;
@@ -252,9 +264,11 @@ int RageSoundDriver::GetDataForSound( Sound &s )
 
 void RageSoundDriver::Update()
 {
-	m_Mutex.Lock();
 	for( unsigned i = 0; i < ARRAYLEN(m_Sounds); ++i )
 	{
+		/* As in DecodeThread, only lock for one sound at a time. */
+		LockMut( m_Mutex );
+
 		{
 			Sound::QueuedPosMap p;
 			while( m_Sounds[i].m_PosMapQueue.read( &p, 1 ) )
@@ -308,8 +322,6 @@ void RageSoundDriver::Update()
 			fNext = RageTimer::GetTimeSinceStart() + 1;
 		}
 	}
-
-	m_Mutex.Unlock();
 }
 
 void RageSoundDriver::StartMixing( RageSoundBase *pSound )
@@ -430,6 +442,16 @@ void RageSoundDriver::StartDecodeThread()
 {
 	ASSERT( !m_DecodeThread.IsCreated() );
 
+	if( PREFSMAN->m_iSoundDecodeBufferFrames > 0 )
+		frames_to_buffer = PREFSMAN->m_iSoundDecodeBufferFrames;
+	frames_per_block = clamp( frames_to_buffer/2, 1, samples_per_block/channels );
+	LOG->Info( "Sound decoding buffer: %i frames (%.1fms)",
+		frames_to_buffer, frames_to_buffer * 1000.0f / GetSampleRate() );
+
+	/* Drivers mix at most about a writeahead at a time.  Allocate for that now,
+	 * so the mixing thread doesn't have to. */
+	g_Mix.Reserve( std::max(frames_to_buffer, 8192) * channels );
+
 	m_DecodeThread.Create( DecodeThread_start, this );
 }
 
@@ -440,6 +462,11 @@ void RageSoundDriver::SetDecodeBufferSize( int iFrames )
 	frames_to_buffer = iFrames;
 }
 
+int RageSoundDriver::GetLowLatencyDecodeBufferSize( int iMixFrames ) const
+{
+	return std::max( GetSampleRate() * 3 / 1000, iMixFrames * 2 );
+}
+
 void RageSoundDriver::low_sample_count_workaround()
 {
 	if (soundDriverMaxSamples != 0) GetHardwareFrame(nullptr);
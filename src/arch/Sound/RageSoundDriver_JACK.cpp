@@ -45,6 +45,11 @@ RString RageSoundDriver_JACK::Init()
 	sample_rate = jack_get_sample_rate(client);
 	LOG->Trace("JACK connected at %u Hz", sample_rate);
 
+	// JACK runs our callback with real-time priority already; each call
+	// mixes one JACK period.
+	if (PREFSMAN->m_bSoundLowLatency)
+		SetDecodeBufferSize(GetLowLatencyDecodeBufferSize(jack_get_buffer_size(client)));
+
 	// Start this before callbacks
 	StartDecodeThread();
 
@@ -0,0 +1,151 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFileManager.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+#include "EnumHelper.h"
+#include "RageSoundMixKernels.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/* Check each set of mixer kernels this CPU supports against the scalar ones,
+ * at every alignment and with odd lengths, then time them. */
+
+static void RandBuffer( std::vector<float> &v )
+{
+	// Past -1..+1 now and then, to exercise the clamping.
+	for( float &f : v )
+		f = randomf( -1.2f, +1.2f );
+}
+
+static bool CheckKernels( MixKernels k )
+{
+	const int iMaxSamples = 1000;
+	std::vector<float> src( iMaxSamples + 8 ), dest( iMaxSamples + 8 ), ref( iMaxSamples + 8 );
+	std::vector<std::int16_t> out( iMaxSamples + 8 ), outRef( iMaxSamples + 8 );
+	std::vector<float> left( iMaxSamples ), right( iMaxSamples ), leftRef( iMaxSamples ), rightRef( iMaxSamples );
+	std::vector<float> corr( 8 ), corrRef( 8 );
+
+	for( int iOffset = 0; iOffset < 8; ++iOffset )
+	{
+		for( int iSamples = 0; iSamples < iMaxSamples; iSamples += 1 + iSamples/8 )
+		{
+			RandBuffer( src );
+			RandBuffer( dest );
+			ref = dest;
+
+			RageSoundMixKernels::SetActive( k );
+			RageSoundMixKernels::MixAdd( &dest[iOffset], &src[iOffset], iSamples );
+			RageSoundMixKernels::ConvertToInt16( &out[iOffset], &src[iOffset], iSamples );
+			float *pOut[2] = { &left[0], &right[0] };
+			RageSoundMixKernels::Deinterleave( pOut, &src[iOffset], iSamples/2, 2 );
+			RageSoundMixKernels::Correlate( &corr[0], &src[0], &dest[iOffset], iSamples/4, 8, 3 );
+
+			RageSoundMixKernels::SetActive( MixKernels_Scalar );
+			RageSoundMixKernels::MixAdd( &ref[iOffset], &src[iOffset], iSamples );
+			RageSoundMixKernels::ConvertToInt16( &outRef[iOffset], &src[iOffset], iSamples );
+			float *pRef[2] = { &leftRef[0], &rightRef[0] };
+			RageSoundMixKernels::Deinterleave( pRef, &src[iOffset], iSamples/2, 2 );
+			RageSoundMixKernels::Correlate( &corrRef[0], &src[0], &dest[iOffset], iSamples/4, 8, 3 );
+
+			const char *szFailed = nullptr;
+			if( memcmp(&dest[iOffset], &ref[iOffset], iSamples * sizeof(float)) )
+				szFailed = "MixAdd";
+			else if( memcmp(&out[iOffset], &outRef[iOffset], iSamples * sizeof(std::int16_t)) )
+				szFailed = "ConvertToInt16";
+			else if( memcmp(&left[0], &leftRef[0], iSamples/2 * sizeof(float)) ||
+				 memcmp(&right[0], &rightRef[0], iSamples/2 * sizeof(float)) )
+				szFailed = "Deinterleave";
+			else if( corr != corrRef )
+				szFailed = "Correlate";
+
+			if( szFailed != nullptr )
+			{
+				LOG->Warn( "%s %s differs from scalar: %i samples at offset %i",
+					MixKernelsToString(k).c_str(), szFailed, iSamples, iOffset );
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void TimeKernels( MixKernels k )
+{
+	// About what one driver update mixes.
+	const int iSamples = 2048;
+	const int iRuns = 100000;
+	const int iOffsets = 16;
+	std::vector<float> src( iSamples ), dest( iSamples );
+	std::vector<std::int16_t> out( iSamples );
+	std::vector<float> left( iSamples/2 ), right( iSamples/2 );
+	float *pOut[2] = { &left[0], &right[0] };
+	std::vector<float> corr( iOffsets );
+	RandBuffer( src );
+
+	RageSoundMixKernels::SetActive( k );
+
+	RageTimer timer;
+	for( int i = 0; i < iRuns; ++i )
+	{
+		memset( &dest[0], 0, iSamples * sizeof(float) );
+		RageSoundMixKernels::MixAdd( &dest[0], &src[0], iSamples );
+	}
+	const float fMixAdd = timer.GetDeltaTime();
+	for( int i = 0; i < iRuns; ++i )
+		RageSoundMixKernels::ConvertToInt16( &out[0], &src[0], iSamples );
+	const float fConvert = timer.GetDeltaTime();
+	for( int i = 0; i < iRuns; ++i )
+		RageSoundMixKernels::Deinterleave( pOut, &src[0], iSamples/2, 2 );
+	const float fDeinterleave = timer.GetDeltaTime();
+	for( int i = 0; i < iRuns / iOffsets; ++i )
+		RageSoundMixKernels::Correlate( &corr[0], &src[0], &src[iOffsets], iSamples - iOffsets, iOffsets, 1 );
+	const float fCorrelate = timer.GetDeltaTime();
+
+	const float fScale = 1000000000.0f / (float(iRuns) * iSamples);
+	LOG->Trace( "%-6s MixAdd %.2f  ConvertToInt16 %.2f  Deinterleave %.2f  Correlate %.2f ns/sample",
+		MixKernelsToString(k).c_str(), fMixAdd * fScale, fConvert * fScale, fDeinterleave * fScale, fCorrelate * fScale );
+}
+
+void run()
+{
+	LOG->Trace( "Using %s by default.", MixKernelsToString(RageSoundMixKernels::GetActive()).c_str() );
+
+	FOREACH_ENUM( MixKernels, k )
+	{
+		if( !RageSoundMixKernels::IsSupported(k) )
+		{
+			LOG->Trace( "%s isn't supported here.", MixKernelsToString(k).c_str() );
+			continue;
+		}
+		if( !CheckKernels(k) )
+			return;
+	}
+
+	FOREACH_ENUM( MixKernels, k )
+	{
+		if( RageSoundMixKernels::IsSupported(k) )
+			TimeKernels( k );
+	}
+
+	LOG->Trace( "Passed." );
+}
+
+int main( int argc, char *argv[] )
+{
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	run();
+
+	delete LOG;
+	delete FILEMAN;
+
+	exit(0);
+}
@@ -0,0 +1,170 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFileManager.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+#include "NoteData.h"
+
+#include <cstdlib>
+
+/* Compare NoteData's map storage against flat storage: check that both give the
+ * same answers, then time the lookups gameplay leans on. */
+
+static const int NUM_TRACKS = 4;
+static const int NUM_ROWS = BeatToNoteRow( 1000 );
+
+static void MakeChart( NoteData &nd )
+{
+	nd.SetNumTracks( NUM_TRACKS );
+	srand( 1 );
+
+	// A stream of 16ths with the odd jump, hold and mine.
+	for( int iRow = 0; iRow < NUM_ROWS; iRow += ROWS_PER_BEAT/4 )
+	{
+		const int iTrack = rand() % NUM_TRACKS;
+		switch( rand() % 16 )
+		{
+		case 0:
+			nd.AddHoldNote( iTrack, iRow, iRow + ROWS_PER_BEAT, TAP_ORIGINAL_HOLD_HEAD );
+			break;
+		case 1:
+			nd.SetTapNote( iTrack, iRow, TAP_ORIGINAL_MINE );
+			break;
+		case 2:
+			nd.SetTapNote( (iTrack+1) % NUM_TRACKS, iRow, TAP_ORIGINAL_TAP );
+			// fall through
+		default:
+			nd.SetTapNote( iTrack, iRow, TAP_ORIGINAL_TAP );
+			break;
+		}
+	}
+}
+
+static bool Compare( const NoteData &map, const NoteData &flat )
+{
+#define CHECK( call ) \
+	if( map.call != flat.call ) { \
+		LOG->Warn( "Line %i: %s differs at row %i, track %i", __LINE__, #call, iRow, iTrack ); \
+		return false; \
+	}
+
+	for( int iRow = -ROWS_PER_BEAT; iRow < NUM_ROWS + ROWS_PER_BEAT; ++iRow )
+	{
+		for( int iTrack = 0; iTrack < NUM_TRACKS; ++iTrack )
+		{
+			CHECK( GetTapNote(iTrack, iRow).type );
+			CHECK( IsHoldNoteAtRow(iTrack, iRow) );
+		}
+		const int iTrack = -1;
+		CHECK( IsRowEmpty(iRow) );
+		CHECK( GetNumTracksWithTapOrHoldHead(iRow) );
+		CHECK( GetFirstTrackWithTap(iRow) );
+		CHECK( GetLastTrackWithTapOrHoldHead(iRow) );
+
+		int iMapRow = iRow, iFlatRow = iRow;
+		if( map.GetNextTapNoteRowForAllTracks(iMapRow) != flat.GetNextTapNoteRowForAllTracks(iFlatRow) || iMapRow != iFlatRow )
+		{
+			LOG->Warn( "GetNextTapNoteRowForAllTracks differs at row %i", iRow );
+			return false;
+		}
+	}
+#undef CHECK
+	return true;
+}
+
+static void TimeFindTapNote( const NoteData &nd, const char *szName )
+{
+	RageTimer timer;
+	int iFound = 0;
+	for( int iPass = 0; iPass < 10; ++iPass )
+	{
+		for( int iRow = 0; iRow < NUM_ROWS; ++iRow )
+		{
+			for( int iTrack = 0; iTrack < NUM_TRACKS; ++iTrack )
+			{
+				if( nd.FindTapNote(iTrack, iRow) != nd.end(iTrack) )
+					++iFound;
+			}
+		}
+	}
+	LOG->Trace( "FindTapNote (%s): %i found in %f", szName, iFound, timer.GetDeltaTime() );
+}
+
+static void TimeRangeAllTracks( const NoteData &nd, const char *szName )
+{
+	// Like NoteField and Player: a few beats around the current row, every row.
+	RageTimer timer;
+	int iFound = 0;
+	for( int iRow = 0; iRow < NUM_ROWS; iRow += 4 )
+	{
+		NoteData::all_tracks_const_iterator iter = nd.GetTapNoteRangeAllTracks( iRow, iRow + 4*ROWS_PER_BEAT );
+		for( ; !iter.IsAtEnd(); ++iter )
+			++iFound;
+	}
+	LOG->Trace( "GetTapNoteRangeAllTracks (%s): %i found in %f", szName, iFound, timer.GetDeltaTime() );
+}
+
+static void TimeIteration( const NoteData &nd, const char *szName )
+{
+	RageTimer timer;
+	int iNotes = 0, iRows = 0;
+	for( int iPass = 0; iPass < 100; ++iPass )
+	{
+		NoteData::all_tracks_const_iterator iter = nd.GetTapNoteRangeAllTracks( 0, MAX_NOTE_ROW );
+		for( ; !iter.IsAtEnd(); ++iter )
+			++iNotes;
+
+		FOREACH_NONEMPTY_ROW_ALL_TRACKS( nd, iRow )
+		{
+			if( nd.GetNumTracksWithTapOrHoldHead(iRow) != 0 )
+				++iRows;
+		}
+	}
+	LOG->Trace( "Full iteration (%s): %i notes, %i rows in %f", szName, iNotes, iRows, timer.GetDeltaTime() );
+}
+
+void run()
+{
+	NoteData map;
+	MakeChart( map );
+
+	NoteData flat = map;
+	flat.SetFlatStorage( true );
+
+	if( !Compare(map, flat) )
+		return;
+
+	TimeFindTapNote( map, "map" );
+	TimeFindTapNote( flat, "flat" );
+	TimeRangeAllTracks( map, "map" );
+	TimeRangeAllTracks( flat, "flat" );
+	TimeIteration( map, "map" );
+	TimeIteration( flat, "flat" );
+
+	// Changing the notes drops flat storage until it's rebuilt.
+	flat.ClearRange( 0, BeatToNoteRow(100) );
+	map.ClearRange( 0, BeatToNoteRow(100) );
+	if( !Compare(map, flat) )
+		return;
+	flat.RevalidateATIs( std::vector<int>(), false );
+	if( !Compare(map, flat) )
+		return;
+
+	LOG->Trace( "Passed." );
+}
+
+int main( int argc, char *argv[] )
+{
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	run();
+
+	delete LOG;
+	delete FILEMAN;
+
+	exit(0);
+}
@@ -0,0 +1,184 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFileManager.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+#include "arch/InputHandler/PIUIOBoard.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <unistd.h>
+
+/* Drive PIUIOBoard with a fake board: check that button edges come out right
+ * and that lights go out with the polls, then see how steady the poll thread
+ * is. */
+
+class MockTransport: public PIUIOBoard::Transport
+{
+public:
+	MockTransport()
+	{
+		memset( m_Inputs, 0xFF, sizeof(m_Inputs) );
+		memset( m_LastLights, 0, sizeof(m_LastLights) );
+		m_iLightWrites = 0;
+	}
+
+	bool Transfer( const std::uint8_t *pLights, bool bLightsChanged, std::uint8_t *pInputs )
+	{
+		if( bLightsChanged )
+		{
+			memcpy( m_LastLights, pLights, sizeof(m_LastLights) );
+			++m_iLightWrites;
+		}
+		memcpy( pInputs, m_Inputs, sizeof(m_Inputs) );
+		return true;
+	}
+
+	// Press or release a button on one of the four sensor sets.
+	void SetSensor( int iSet, int iButton, bool bDown )
+	{
+		std::uint8_t &b = m_Inputs[iSet*8 + iButton/8];
+		const std::uint8_t iBit = 128 >> (iButton % 8);
+		if( bDown )
+			b &= ~iBit;
+		else
+			b |= iBit;
+	}
+
+	std::uint8_t m_Inputs[PIUIOBoard::NUM_INPUT_BYTES];
+	std::uint8_t m_LastLights[PIUIOBoard::NUM_LIGHT_BYTES];
+	int m_iLightWrites;
+};
+
+struct Edge
+{
+	int iButton;
+	bool bDown;
+	RageTimer ts;
+};
+static std::vector<Edge> g_Edges;
+
+static void OnEdge( void *, int iButton, bool bDown, const RageTimer &ts )
+{
+	Edge e = { iButton, bDown, ts };
+	g_Edges.push_back( e );
+}
+
+static bool ExpectEdges( int iLine, int iCount, int iButton = -1, bool bDown = false )
+{
+	bool bOK = (int) g_Edges.size() == iCount;
+	for( unsigned i = 0; bOK && i < g_Edges.size(); ++i )
+		bOK = g_Edges[i].iButton == iButton && g_Edges[i].bDown == bDown;
+	if( !bOK )
+		LOG->Warn( "Line %i: expected %i edges for button %i, got %i", iLine, iCount, iButton, (int) g_Edges.size() );
+	g_Edges.clear();
+	return bOK;
+}
+
+static bool TestEdges()
+{
+	MockTransport *pMock = new MockTransport;
+	PIUIOBoard board( pMock, 1000 );
+	board.SetEdgeCallback( OnEdge, nullptr );
+
+	// Nothing pressed, nothing reported.  The first poll sets the lights even
+	// though they're all off, since the board may have come up with some on.
+	board.Poll();
+	if( !ExpectEdges(__LINE__, 0) )
+		return false;
+	if( pMock->m_iLightWrites != 1 )
+	{
+		LOG->Warn( "First poll: %i light writes", pMock->m_iLightWrites );
+		return false;
+	}
+
+	// A press on any sensor set presses the button, once.
+	pMock->SetSensor( 2, 5, true );
+	board.Poll();
+	board.Poll();
+	if( !ExpectEdges(__LINE__, 1, 5, true) )
+		return false;
+
+	// Another sensor on the same panel doesn't make a second press ...
+	pMock->SetSensor( 0, 5, true );
+	pMock->SetSensor( 2, 5, false );
+	board.Poll();
+	if( !ExpectEdges(__LINE__, 0) )
+		return false;
+
+	// ... and the button is released when the last sensor is.
+	pMock->SetSensor( 0, 5, false );
+	board.Poll();
+	if( !ExpectEdges(__LINE__, 1, 5, false) )
+		return false;
+
+	// The last button maps through too.
+	pMock->SetSensor( 3, 63, true );
+	board.Poll();
+	if( !ExpectEdges(__LINE__, 1, 63, true) )
+		return false;
+
+	// Lights go out with the next poll, and only when they change.
+	const std::uint8_t lights[PIUIOBoard::NUM_LIGHT_BYTES] = { 0x04, 0, 0x80, 0x08, 0x37, 0, 0, 0 };
+	board.SetLights( lights );
+	if( pMock->m_iLightWrites != 1 )
+	{
+		LOG->Warn( "Lights were written before a poll" );
+		return false;
+	}
+	board.Poll();
+	board.Poll();
+	if( pMock->m_iLightWrites != 2 || memcmp(pMock->m_LastLights, lights, sizeof(lights)) )
+	{
+		LOG->Warn( "Lights: %i writes", pMock->m_iLightWrites );
+		return false;
+	}
+
+	// No callbacks once it's cleared.
+	board.SetEdgeCallback( nullptr, nullptr );
+	pMock->SetSensor( 1, 0, true );
+	board.Poll();
+	return ExpectEdges( __LINE__, 0 );
+}
+
+static void TimePollThread( int iPollsPerSecond )
+{
+	PIUIOBoard board( new MockTransport, iPollsPerSecond );
+	RageTimer timer;
+	board.StartThread();
+	usleep( 1000000 );
+	board.StopThread();
+
+	const float fSeconds = timer.GetDeltaTime();
+	LOG->Trace( "Asked for %i Hz: %i polls in %f (%.0f Hz)", iPollsPerSecond,
+		board.GetNumPolls(), fSeconds, board.GetNumPolls() / fSeconds );
+}
+
+void run()
+{
+	if( !TestEdges() )
+		return;
+
+	TimePollThread( 250 );
+	TimePollThread( 1000 );
+
+	LOG->Trace( "Passed." );
+}
+
+int main( int argc, char *argv[] )
+{
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	run();
+
+	delete LOG;
+	delete FILEMAN;
+
+	exit(0);
+}
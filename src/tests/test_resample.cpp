@@ -0,0 +1,245 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFileManager.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+#include "RageMath.h"
+#include "EnumHelper.h"
+#include "RageSoundReader_Resample_Good.h"
+#include "RageSoundMixKernels.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/* Check and time RageSoundReader_Resample_Good, 44.1kHz to 48kHz, with each
+ * set of kernels this CPU supports.  The stereo pass is checked against the
+ * scalar kernels and against resampling each channel on its own, which is how
+ * the resampler used to work; the output is fitted to the tone it should be
+ * to measure its quality. */
+
+const int SOURCE_RATE = 44100;
+const int DEST_RATE = 48000;
+const int SOURCE_SECONDS = 10;
+const float TONE_HZ[2] = { 1000.0f, 3000.0f };
+
+/* A tone in each channel, or one channel of it. */
+class RageSoundReader_Tone: public RageSoundReader
+{
+public:
+	RageSoundReader_Tone( int iChannels, int iOnlyChannel = -1 )
+	{
+		m_iChannels = iChannels;
+		m_iPosition = 0;
+		m_Data.resize( SOURCE_RATE * SOURCE_SECONDS * iChannels );
+		for( int i = 0; i < SOURCE_RATE * SOURCE_SECONDS; ++i )
+		{
+			for( int c = 0; c < iChannels; ++c )
+			{
+				const int iTone = iOnlyChannel == -1? c:iOnlyChannel;
+				m_Data[i*iChannels + c] = 0.5f * std::sin( 2.0*PI * TONE_HZ[iTone] * i / SOURCE_RATE );
+			}
+		}
+	}
+
+	int GetLength() const { return SOURCE_SECONDS * 1000; }
+	int SetPosition( int iFrame ) { m_iPosition = iFrame; return 1; }
+	int Read( float *pBuf, int iFrames )
+	{
+		const int iTotal = m_Data.size() / m_iChannels;
+		if( m_iPosition >= iTotal )
+			return END_OF_FILE;
+		iFrames = std::min( iFrames, iTotal - m_iPosition );
+		memcpy( pBuf, &m_Data[m_iPosition * m_iChannels], iFrames * m_iChannels * sizeof(float) );
+		m_iPosition += iFrames;
+		return iFrames;
+	}
+	RageSoundReader_Tone *Copy() const { return new RageSoundReader_Tone( *this ); }
+	int GetSampleRate() const { return SOURCE_RATE; }
+	unsigned GetNumChannels() const { return m_iChannels; }
+	int GetNextSourceFrame() const { return m_iPosition; }
+	float GetStreamToSourceRatio() const { return 1.0f; }
+	RString GetError() const { return RString(); }
+
+private:
+	std::vector<float> m_Data;
+	int m_iChannels;
+	int m_iPosition;
+};
+
+/* Resample all of pSource, in reads of varying size, as the mixer does. */
+static void Resample( RageSoundReader *pSource, std::vector<float> &out )
+{
+	RageSoundReader_Resample_Good resample( pSource, DEST_RATE );
+	const int iChannels = resample.GetNumChannels();
+	std::vector<float> buf( 1024 * iChannels );
+
+	out.clear();
+	for( int iRead = 0; ; ++iRead )
+	{
+		const int iFrames = 64 + (iRead * 97) % 960;
+		const int iGot = resample.Read( &buf[0], iFrames );
+		if( iGot < 0 )
+			break;
+		out.insert( out.end(), buf.begin(), buf.begin() + iGot * iChannels );
+	}
+}
+
+/* Fit a sine and cosine at fHz to one channel, past the start, and return
+ * how far the rest is below the tone, in dB. */
+static float GetSNR( const std::vector<float> &out, int iChannels, int iChannel, float fHz )
+{
+	const int iFrames = out.size() / iChannels;
+	const int iStart = DEST_RATE / 10;
+	double fSS = 0, fSC = 0, fCC = 0, fXS = 0, fXC = 0;
+	for( int i = iStart; i < iFrames; ++i )
+	{
+		const double s = std::sin( 2.0*PI * fHz * i / DEST_RATE );
+		const double c = std::cos( 2.0*PI * fHz * i / DEST_RATE );
+		const double x = out[i*iChannels + iChannel];
+		fSS += s*s; fSC += s*c; fCC += c*c;
+		fXS += x*s; fXC += x*c;
+	}
+	const double fDet = fSS*fCC - fSC*fSC;
+	const double a = (fXS*fCC - fXC*fSC) / fDet;
+	const double b = (fXC*fSS - fXS*fSC) / fDet;
+
+	double fSignal = 0, fNoise = 0;
+	for( int i = iStart; i < iFrames; ++i )
+	{
+		const double fFit = a * std::sin( 2.0*PI * fHz * i / DEST_RATE ) + b * std::cos( 2.0*PI * fHz * i / DEST_RATE );
+		const double fErr = out[i*iChannels + iChannel] - fFit;
+		fSignal += fFit*fFit;
+		fNoise += fErr*fErr;
+	}
+	return float( 10 * std::log10(fSignal / fNoise) );
+}
+
+static bool CheckKernels( MixKernels k, const std::vector<float> &ref )
+{
+	RageSoundMixKernels::SetActive( k );
+
+	std::vector<float> stereo;
+	Resample( new RageSoundReader_Tone(2), stereo );
+	if( stereo != ref )
+	{
+		LOG->Warn( "%s differs from scalar", MixKernelsToString(k).c_str() );
+		return false;
+	}
+
+	for( int c = 0; c < 2; ++c )
+	{
+		std::vector<float> mono;
+		Resample( new RageSoundReader_Tone(1, c), mono );
+		if( mono.size() * 2 != stereo.size() )
+		{
+			LOG->Warn( "%s: mono gave %i frames, stereo %i", MixKernelsToString(k).c_str(),
+				int(mono.size()), int(stereo.size() / 2) );
+			return false;
+		}
+		for( unsigned i = 0; i < mono.size(); ++i )
+		{
+			if( mono[i] != stereo[i*2 + c] )
+			{
+				LOG->Warn( "%s: channel %i differs when resampled on its own, at frame %u",
+					MixKernelsToString(k).c_str(), c, i );
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void TimeKernels( MixKernels k )
+{
+	RageSoundMixKernels::SetActive( k );
+
+	// Make the tones first, so only resampling is timed.
+	const int iRuns = 10;
+	std::vector<RageSoundReader *> apStereo, apMono;
+	for( int i = 0; i < iRuns; ++i )
+	{
+		apStereo.push_back( new RageSoundReader_Tone(2) );
+		apMono.push_back( new RageSoundReader_Tone(1, 0) );
+		apMono.push_back( new RageSoundReader_Tone(1, 1) );
+	}
+
+	std::vector<float> out;
+	RageTimer timer;
+	for( RageSoundReader *pSource : apStereo )
+		Resample( pSource, out );
+	const float fStereo = timer.GetDeltaTime();
+
+	for( RageSoundReader *pSource : apMono )
+		Resample( pSource, out );
+	const float fPerChannel = timer.GetDeltaTime();
+
+	const float fAudio = float( iRuns * SOURCE_SECONDS );
+	LOG->Trace( "%-6s stereo %.0fx realtime, one channel at a time %.0fx realtime",
+		MixKernelsToString(k).c_str(), fAudio / fStereo, fAudio / fPerChannel );
+}
+
+void run()
+{
+	LOG->Trace( "Using %s by default.", MixKernelsToString(RageSoundMixKernels::GetActive()).c_str() );
+
+	std::vector<float> ref;
+	RageSoundMixKernels::SetActive( MixKernels_Scalar );
+	Resample( new RageSoundReader_Tone(2), ref );
+
+	const int iExpected = DEST_RATE * SOURCE_SECONDS;
+	if( std::abs(int(ref.size() / 2) - iExpected) > 8 )
+	{
+		LOG->Warn( "Got %i frames, expected about %i", int(ref.size() / 2), iExpected );
+		return;
+	}
+
+	/* The filter is only 8 taps, so it's not much better than this. */
+	const float fMinSNR = 75.0f;
+	for( int c = 0; c < 2; ++c )
+	{
+		const float fSNR = GetSNR( ref, 2, c, TONE_HZ[c] );
+		LOG->Trace( "%.0fHz: %.1f dB", TONE_HZ[c], fSNR );
+		if( fSNR < fMinSNR )
+		{
+			LOG->Warn( "%.0fHz is only %.1f dB above the noise", TONE_HZ[c], fSNR );
+			return;
+		}
+	}
+
+	FOREACH_ENUM( MixKernels, k )
+	{
+		if( !RageSoundMixKernels::IsSupported(k) )
+		{
+			LOG->Trace( "%s isn't supported here.", MixKernelsToString(k).c_str() );
+			continue;
+		}
+		if( !CheckKernels(k, ref) )
+			return;
+	}
+
+	FOREACH_ENUM( MixKernels, k )
+	{
+		if( RageSoundMixKernels::IsSupported(k) )
+			TimeKernels( k );
+	}
+
+	LOG->Trace( "Passed." );
+}
+
+int main( int argc, char *argv[] )
+{
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	run();
+
+	delete LOG;
+	delete FILEMAN;
+
+	exit(0);
+}
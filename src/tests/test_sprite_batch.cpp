@@ -0,0 +1,186 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFileManager.h"
+#include "RageDisplay.h"
+#include "RageDisplay_Null.h"
+#include "RageMath.h"
+#include "LuaManager.h"
+#include "SpriteBatch.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/* Draw a note column the way NoteDisplay does, with SpriteBatch and a fake
+ * renderer: quantized tap sprites, which are offset into their color with a
+ * texture translate, mixed with a part that can't be batched, like a Model
+ * or ActorFrame from the noteskin.  Check that everything comes out in the
+ * order it was drawn, with each texture offset applied exactly once. */
+
+struct Quad
+{
+	std::uintptr_t iTexture;
+	float fU; // the texture coordinate of the upper-left corner, as drawn
+};
+
+/* Record quads as the hardware would see them, with the texture matrix
+ * applied, the way RageDisplay_OGL sends it with every draw. */
+class RecordingDisplay: public RageDisplay_Null
+{
+public:
+	RecordingDisplay(): m_iTexture(0) { }
+	void SetTexture( TextureUnit, std::uintptr_t iTexture ) { m_iTexture = iTexture; }
+
+	std::vector<Quad> m_Quads;
+
+protected:
+	void DrawQuadsInternal( const RageSpriteVertex v[], int iNumVerts )
+	{
+		for( int i = 0; i < iNumVerts; i += 4 )
+		{
+			RageVector3 t( v[i].t.x, v[i].t.y, 0 );
+			RageVec3TransformCoord( &t, &t, GetTextureTop() );
+			Quad q = { m_iTexture, t.x };
+			m_Quads.push_back( q );
+		}
+	}
+
+private:
+	std::uintptr_t m_iTexture;
+};
+
+static RecordingDisplay *g_pDisplay;
+
+static const std::uintptr_t TAP_TEXTURE = 1, MINE_TEXTURE = 2, MODEL_TEXTURE = 3;
+
+static void MakeQuad( RageSpriteVertex v[4] )
+{
+	const float aU[4] = { 0, 0, 0.125f, 0.125f };
+	const float aV[4] = { 0, 1, 1, 0 };
+	for( int i = 0; i < 4; ++i )
+	{
+		v[i].p = RageVector3( aU[i]*64, aV[i]*64, 0 );
+		v[i].t = RageVector2( aU[i], aV[i] );
+		v[i].c = RageColor( 1, 1, 1, 1 );
+	}
+}
+
+/* A note in one color: NoteDisplay::DrawActor translates the texture to the
+ * color, then Actor::Draw pushes the sprite's own texture translate. */
+static void DrawSprite( SpriteBatch &batch, std::uintptr_t iTexture, float fColorOffset, float fActorOffset )
+{
+	RageSpriteVertex v[4];
+	MakeQuad( v );
+
+	DISPLAY->TexturePushMatrix();
+	DISPLAY->TextureTranslate( fColorOffset, 0 );
+	batch.StartCollecting();
+	DISPLAY->TexturePushMatrix();
+	DISPLAY->TextureTranslate( fActorOffset, 0 );
+	SpriteBatch::GetCollecting()->AddDiffuse( iTexture, v );
+	DISPLAY->TexturePopMatrix();
+	batch.StopCollecting();
+	DISPLAY->TexturePopMatrix();
+}
+
+/* A part that isn't a plain sprite is drawn directly, under its color offset,
+ * after flushing what's been collected. */
+static void DrawModel( SpriteBatch &batch, float fColorOffset )
+{
+	RageSpriteVertex v[4];
+	MakeQuad( v );
+
+	DISPLAY->TexturePushMatrix();
+	DISPLAY->TextureTranslate( fColorOffset, 0 );
+	batch.Flush();
+	DISPLAY->SetTexture( TextureUnit_1, MODEL_TEXTURE );
+	DISPLAY->DrawQuads( v, 4 );
+	DISPLAY->TexturePopMatrix();
+}
+
+static bool ExpectQuads( int iLine, const Quad *pExpected, unsigned iCount )
+{
+	bool bOK = g_pDisplay->m_Quads.size() == iCount;
+	for( unsigned i = 0; bOK && i < iCount; ++i )
+	{
+		const Quad &q = g_pDisplay->m_Quads[i];
+		bOK = q.iTexture == pExpected[i].iTexture && std::abs( q.fU - pExpected[i].fU ) < 0.0001f;
+	}
+
+	if( !bOK )
+	{
+		LOG->Warn( "Line %i: expected %u quads, got %u:", iLine, iCount, unsigned(g_pDisplay->m_Quads.size()) );
+		for( Quad const &q : g_pDisplay->m_Quads )
+			LOG->Warn( "    texture %u at %f", unsigned(q.iTexture), q.fU );
+	}
+	g_pDisplay->m_Quads.clear();
+	return bOK;
+}
+
+static bool TestMixedParts()
+{
+	SpriteBatch batch;
+	batch.Open();
+
+	// Two taps in different colors share a texture and a draw call.
+	DrawSprite( batch, TAP_TEXTURE, 0.25f, 0 );
+	DrawSprite( batch, TAP_TEXTURE, 0.5f, 0 );
+	// A model part goes on top of them, with only its own offset.
+	DrawModel( batch, 0.125f );
+	// A mine, then a tap scrolled by its actor's texturetranslate, go on top
+	// of the model.
+	DrawSprite( batch, MINE_TEXTURE, 0, 0 );
+	DrawSprite( batch, TAP_TEXTURE, 0.25f, 0.0625f );
+	batch.Draw();
+
+	const Quad expected[] =
+	{
+		{ TAP_TEXTURE, 0.25f },
+		{ TAP_TEXTURE, 0.5f },
+		{ MODEL_TEXTURE, 0.125f },
+		{ MINE_TEXTURE, 0 },
+		{ TAP_TEXTURE, 0.3125f },
+	};
+	if( !ExpectQuads(__LINE__, expected, ARRAYLEN(expected)) )
+		return false;
+
+	// Whatever was pushed has been popped.
+	RageMatrix identity;
+	RageMatrixIdentity( &identity );
+	if( memcmp(DISPLAY->GetTextureTop(), &identity, sizeof(identity)) )
+	{
+		LOG->Warn( "The texture matrix wasn't restored" );
+		return false;
+	}
+	return true;
+}
+
+static void run()
+{
+	if( !TestMixedParts() )
+		return;
+	LOG->Trace( "Passed." );
+}
+
+int main( int argc, char *argv[] )
+{
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+	LUA			= new LuaManager;
+	g_pDisplay		= new RecordingDisplay;
+	DISPLAY			= g_pDisplay;
+
+	run();
+
+	delete DISPLAY;
+	delete LUA;
+	delete LOG;
+	delete FILEMAN;
+
+	exit(0);
+}
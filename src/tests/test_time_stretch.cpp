@@ -0,0 +1,269 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFileManager.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+#include "RageMath.h"
+#include "RageSoundReader_SpeedChange.h"
+#include "RageSoundReader_WSOLA.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/* Check and time RageSoundReader_WSOLA against RageSoundReader_SpeedChange
+ * at the rates people play at.  Each is checked for how long its output is,
+ * how clean a stretched tone is, and how closely GetNextSourceFrame follows
+ * what's actually playing: stretching a ramp whose value is its own position
+ * shows exactly where in the source each output frame came from. */
+
+const int SOURCE_RATE = 44100;
+const int SOURCE_SECONDS = 10;
+const int SOURCE_FRAMES = SOURCE_RATE * SOURCE_SECONDS;
+const float TONE_HZ = 440.0f;
+const float SPEEDS[] = { 0.75f, 1.0f, 1.1f, 1.25f, 1.5f, 2.0f };
+
+/* A tone, or a ramp of each frame's position in seconds, in every channel. */
+class RageSoundReader_Signal: public RageSoundReader
+{
+public:
+	RageSoundReader_Signal( int iChannels, bool bRamp )
+	{
+		m_iChannels = iChannels;
+		m_iPosition = 0;
+		m_Data.resize( SOURCE_FRAMES * iChannels );
+		for( int i = 0; i < SOURCE_FRAMES; ++i )
+		{
+			const float f = bRamp? float(i) / SOURCE_RATE:
+				float( 0.5 * std::sin(2.0*PI * TONE_HZ * i / SOURCE_RATE) );
+			for( int c = 0; c < iChannels; ++c )
+				m_Data[i*iChannels + c] = f;
+		}
+	}
+
+	int GetLength() const { return SOURCE_SECONDS * 1000; }
+	int SetPosition( int iFrame ) { m_iPosition = iFrame; return 1; }
+	int Read( float *pBuf, int iFrames )
+	{
+		if( m_iPosition >= SOURCE_FRAMES )
+			return END_OF_FILE;
+		iFrames = std::min( iFrames, SOURCE_FRAMES - m_iPosition );
+		memcpy( pBuf, &m_Data[m_iPosition * m_iChannels], iFrames * m_iChannels * sizeof(float) );
+		m_iPosition += iFrames;
+		return iFrames;
+	}
+	RageSoundReader_Signal *Copy() const { return new RageSoundReader_Signal( *this ); }
+	int GetSampleRate() const { return SOURCE_RATE; }
+	unsigned GetNumChannels() const { return m_iChannels; }
+	int GetNextSourceFrame() const { return m_iPosition; }
+	float GetStreamToSourceRatio() const { return 1.0f; }
+	RString GetError() const { return RString(); }
+
+private:
+	std::vector<float> m_Data;
+	int m_iChannels;
+	int m_iPosition;
+};
+
+static RageSoundReader_TimeStretch *MakeStretch( bool bWSOLA, RageSoundReader *pSource )
+{
+	if( bWSOLA )
+		return new RageSoundReader_WSOLA( pSource );
+	return new RageSoundReader_SpeedChange( pSource );
+}
+
+static const char *GetName( bool bWSOLA )
+{
+	return bWSOLA? "WSOLA":"SpeedChange";
+}
+
+/* Stretch all of pSource, in reads of varying size as the mixer does, and
+ * note the source frame reported for each output frame, as RageSound does. */
+static void Stretch( RageSoundReader_TimeStretch *pStretch, float fSpeed,
+	std::vector<float> &out, std::vector<double> &aSourceFrames )
+{
+	pStretch->SetSpeedRatio( fSpeed );
+	const int iChannels = pStretch->GetNumChannels();
+	std::vector<float> buf( 1024 * iChannels );
+
+	out.clear();
+	aSourceFrames.clear();
+	for( int iRead = 0; ; ++iRead )
+	{
+		const int iFrames = 64 + (iRead * 97) % 960;
+		int iSourceFrame;
+		float fRate;
+		const int iGot = pStretch->RetriedRead( &buf[0], iFrames, &iSourceFrame, &fRate );
+		if( iGot < 0 )
+			break;
+		out.insert( out.end(), buf.begin(), buf.begin() + iGot * iChannels );
+		for( int i = 0; i < iGot; ++i )
+			aSourceFrames.push_back( iSourceFrame + i * double(fRate) );
+	}
+	delete pStretch;
+}
+
+/* Fit a sine and cosine at fHz to each 50ms of the output, past the start,
+ * and return how far the rest is below the tone, in dB.  Splicing may drift
+ * the phase a little over the whole sound; that's inaudible, so fit locally. */
+static float GetSNR( const std::vector<float> &out, int iChannels, float fHz )
+{
+	const int iFrames = out.size() / iChannels;
+	const int iWindow = SOURCE_RATE / 20;
+	double fSignal = 0, fNoise = 0;
+	for( int iStart = SOURCE_RATE / 10; iStart + iWindow <= iFrames; iStart += iWindow )
+	{
+		double fSS = 0, fSC = 0, fCC = 0, fXS = 0, fXC = 0;
+		for( int i = iStart; i < iStart + iWindow; ++i )
+		{
+			const double s = std::sin( 2.0*PI * fHz * i / SOURCE_RATE );
+			const double c = std::cos( 2.0*PI * fHz * i / SOURCE_RATE );
+			const double x = out[i*iChannels];
+			fSS += s*s; fSC += s*c; fCC += c*c;
+			fXS += x*s; fXC += x*c;
+		}
+		const double fDet = fSS*fCC - fSC*fSC;
+		const double a = (fXS*fCC - fXC*fSC) / fDet;
+		const double b = (fXC*fSS - fXS*fSC) / fDet;
+
+		for( int i = iStart; i < iStart + iWindow; ++i )
+		{
+			const double fFit = a * std::sin( 2.0*PI * fHz * i / SOURCE_RATE ) + b * std::cos( 2.0*PI * fHz * i / SOURCE_RATE );
+			const double fErr = out[i*iChannels] - fFit;
+			fSignal += fFit*fFit;
+			fNoise += fErr*fErr;
+		}
+	}
+	return float( 10 * std::log10(fSignal / fNoise) );
+}
+
+static bool CheckStretch( bool bWSOLA, float fSpeed )
+{
+	std::vector<float> out;
+	std::vector<double> aSourceFrames;
+
+	Stretch( MakeStretch(bWSOLA, new RageSoundReader_Signal(2, false)), fSpeed, out, aSourceFrames );
+	const int iExpected = int( SOURCE_FRAMES / fSpeed );
+	const int iGot = out.size() / 2;
+	const float fSNR = GetSNR( out, 2, TONE_HZ );
+
+	/* Stretch a ramp, and see where each output frame really came from.  The
+	 * last block or two may be cut short, so stop a little before the end. */
+	Stretch( MakeStretch(bWSOLA, new RageSoundReader_Signal(1, true)), fSpeed, out, aSourceFrames );
+	double fMaxError = 0;
+	for( unsigned i = 0; i + SOURCE_RATE/10 < out.size(); ++i )
+	{
+		const double fActual = double(out[i]) * SOURCE_RATE;
+		fMaxError = std::max( fMaxError, std::abs(aSourceFrames[i] - fActual) );
+	}
+	const float fMaxErrorMs = float( fMaxError * 1000 / SOURCE_RATE );
+
+	LOG->Trace( "%-11s %.2fx: %i frames (expected %i), %.1f dB, position within %.2fms",
+		GetName(bWSOLA), fSpeed, iGot, iExpected, fSNR, fMaxErrorMs );
+
+	if( !bWSOLA )
+		return true;
+
+	/* Allow for the last, partial segment. */
+	if( std::abs(iGot - iExpected) > SOURCE_RATE / 20 )
+	{
+		LOG->Warn( "WSOLA %.2fx gave %i frames, expected about %i", fSpeed, iGot, iExpected );
+		return false;
+	}
+	if( fSNR < 40 )
+	{
+		LOG->Warn( "WSOLA %.2fx: the tone is only %.1f dB above the noise", fSpeed, fSNR );
+		return false;
+	}
+	if( fMaxErrorMs > 0.1f )
+	{
+		LOG->Warn( "WSOLA %.2fx: reported position is off by up to %.2fms", fSpeed, fMaxErrorMs );
+		return false;
+	}
+	return true;
+}
+
+/* At 1x, once the buffer has data, WSOLA should pass the source through. */
+static bool CheckUnity()
+{
+	RageSoundReader_WSOLA stretch( new RageSoundReader_Signal(2, false) );
+	RageSoundReader_Signal source( 2, false );
+	std::vector<float> buf( 1000 * 2 ), ref( 1000 * 2 );
+
+	// Start at another speed, so the buffer isn't empty, then go back to 1x
+	// and start a new block.
+	stretch.SetSpeedRatio( 1.5f );
+	for( int i = 0; i < 50; ++i )
+		stretch.RetriedRead( &buf[0], 1000 );
+	stretch.SetSpeedRatio( 1.0f );
+	while( !stretch.NextReadWillStep() )
+		stretch.Read( &buf[0], 1000 );
+	stretch.Read( &buf[0], 1000 );
+
+	source.SetPosition( stretch.GetNextSourceFrame() );
+	for( int i = 0; i < 100; ++i )
+	{
+		const int iGot = stretch.RetriedRead( &buf[0], 1000 );
+		if( iGot <= 0 || source.Read(&ref[0], iGot) != iGot )
+			break;
+		if( memcmp(&buf[0], &ref[0], iGot * 2 * sizeof(float)) )
+		{
+			LOG->Warn( "WSOLA at 1x changed the source" );
+			return false;
+		}
+	}
+	return true;
+}
+
+static void TimeStretch( bool bWSOLA )
+{
+	// Make the sources first, so only stretching is timed.
+	const int iRuns = 5;
+	std::vector<RageSoundReader_TimeStretch *> apStretch;
+	for( int i = 0; i < iRuns; ++i )
+		apStretch.push_back( MakeStretch(bWSOLA, new RageSoundReader_Signal(2, false)) );
+
+	std::vector<float> out;
+	std::vector<double> aSourceFrames;
+	RageTimer timer;
+	for( RageSoundReader_TimeStretch *pStretch : apStretch )
+		Stretch( pStretch, 1.5f, out, aSourceFrames );
+	const float fTime = timer.GetDeltaTime();
+
+	LOG->Trace( "%-11s 1.5x stereo: %.0fx realtime", GetName(bWSOLA), iRuns * SOURCE_SECONDS / fTime );
+}
+
+void run()
+{
+	for( float fSpeed : SPEEDS )
+	{
+		CheckStretch( false, fSpeed );
+		if( !CheckStretch(true, fSpeed) )
+			return;
+	}
+
+	if( !CheckUnity() )
+		return;
+
+	TimeStretch( false );
+	TimeStretch( true );
+
+	LOG->Trace( "Passed." );
+}
+
+int main( int argc, char *argv[] )
+{
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	run();
+
+	delete LOG;
+	delete FILEMAN;
+
+	exit(0);
+}
@@ -19,7 +19,7 @@ void run()
 }
 
 	TimingData test;
-	test.AddBPMSegment( BPMSegment(0, 60) );
+	test.AddSegment( BPMSegment(BeatToNoteRow(0), 60) );
 
 	/* First, trivial sanity checks. */
 	CHECK( test.GetBeatFromElapsedTime(60), 60.0f );
@@ -38,9 +38,9 @@ void run()
 	CHECK( test.GetBPMAtBeat(100000), 60.0f );
 	CHECK( test.GetBPMAtBeat(-100000), 60.0f );
 
-	/* 120BPM at beat 10: */
-	test.AddBPMSegment( BPMSegment(10, 120) );
-	CHECK( test.GetBPMAtBeat(9.99), 60.0f );
+	/* 120BPM at beat 10.  Beats are rounded to rows, so 9.99 would be beat 10. */
+	test.AddSegment( BPMSegment(BeatToNoteRow(10), 120) );
+	CHECK( test.GetBPMAtBeat(9.9), 60.0f );
 	CHECK( test.GetBPMAtBeat(10), 120.0f );
 
 	CHECK( test.GetBeatFromElapsedTime(9), 9.0f );
@@ -52,10 +52,10 @@ void run()
 	CHECK( test.GetElapsedTimeFromBeat(11), 10.5f );
 
 	/* Add a 5-second stop at beat 10. */
-	test.AddStopSegment( StopSegment(10, 5) );
+	test.AddSegment( StopSegment(BeatToNoteRow(10), 5) );
 
 	/* The stop shouldn't affect GetBPMAtBeat at all. */
-	CHECK( test.GetBPMAtBeat(9.99), 60.0f );
+	CHECK( test.GetBPMAtBeat(9.9), 60.0f );
 	CHECK( test.GetBPMAtBeat(10), 120.0f );
 
 	CHECK( test.GetBeatFromElapsedTime(9), 9.0f );
@@ -70,10 +70,14 @@ void run()
 	CHECK( test.GetElapsedTimeFromBeat(11), 15.5f );
 
 	/* Add a 2-second stop at beat 5 and a 5-second stop at beat 15. */
-	test.m_StopSegments.clear();
-	test.AddStopSegment( StopSegment(5, 2) );
-	test.AddStopSegment( StopSegment(15, 5) );
-	CHECK( test.GetBPMAtBeat(9.99), 60.0f );
+	std::vector<TimingSegment *> &vStops = test.GetTimingSegments( SEGMENT_STOP );
+	for( TimingSegment *pStop : vStops )
+		delete pStop;
+	vStops.clear();
+	test.InvalidateLookup();
+	test.AddSegment( StopSegment(BeatToNoteRow(5), 2) );
+	test.AddSegment( StopSegment(BeatToNoteRow(15), 5) );
+	CHECK( test.GetBPMAtBeat(9.9), 60.0f );
 	CHECK( test.GetBPMAtBeat(10), 120.0f );
 
 	CHECK( test.GetBeatFromElapsedTime(1), 1.0f );
@@ -125,8 +129,8 @@ int q = 0;
 LOG->Trace("... %i in %f", q, foobar.GetDeltaTime());
 
 	TimingData test2;
-	test2.AddBPMSegment( BPMSegment(0, 60) );
-	test2.AddStopSegment( StopSegment(0, 1) );
+	test2.AddSegment( BPMSegment(BeatToNoteRow(0), 60) );
+	test2.AddSegment( StopSegment(BeatToNoteRow(0), 1) );
 	//test2.AddWarpSegment( WarpSegment() );
 	CHECK( test2.GetBeatFromElapsedTime(-1), -1.0f );
 	CHECK( test2.GetBeatFromElapsedTime(0), 0.0f );
@@ -136,6 +140,22 @@ LOG->Trace("... %i in %f", q, foobar.GetDeltaTime());
 	CHECK( test2.GetElapsedTimeFromBeat(0), 0.0f );
 	CHECK( test2.GetElapsedTimeFromBeat(1), 2.0f );
 	CHECK( test2.GetElapsedTimeFromBeat(2), 3.0f );
+
+	/* Jumping between segments, as the editor does, from rows before, on
+	 * and after them. */
+	TimingData test3;
+	test3.AddSegment( BPMSegment(0, 60) );
+	test3.AddSegment( StopSegment(BeatToNoteRow(4), 1) );
+	test3.AddSegment( StopSegment(BeatToNoteRow(8), 1) );
+	CHECK( test3.GetNextSegmentBeatAtRow(SEGMENT_STOP, BeatToNoteRow(0)), 4.0f );
+	CHECK( test3.GetNextSegmentBeatAtRow(SEGMENT_STOP, BeatToNoteRow(4)), 8.0f );
+	CHECK( test3.GetNextSegmentBeatAtRow(SEGMENT_STOP, BeatToNoteRow(6)), 8.0f );
+	CHECK( test3.GetNextSegmentBeatAtRow(SEGMENT_STOP, BeatToNoteRow(10)), 10.0f );
+	CHECK( test3.GetPreviousSegmentBeatAtRow(SEGMENT_STOP, BeatToNoteRow(2)), 2.0f );
+	CHECK( test3.GetPreviousSegmentBeatAtRow(SEGMENT_STOP, BeatToNoteRow(4)), 4.0f );
+	CHECK( test3.GetPreviousSegmentBeatAtRow(SEGMENT_STOP, BeatToNoteRow(6)), 4.0f );
+	CHECK( test3.GetPreviousSegmentBeatAtRow(SEGMENT_STOP, BeatToNoteRow(8)), 4.0f );
+	CHECK( test3.GetPreviousSegmentBeatAtRow(SEGMENT_STOP, BeatToNoteRow(10)), 8.0f );
 }
 
 int main( int argc, char *argv[] )